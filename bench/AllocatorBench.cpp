@@ -0,0 +1,60 @@
+#include "utils/Allocators.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace alloy::utils;
+
+namespace
+{
+    // range(0) mixed-size allocations, then freed in random order so
+    // neighbouring blocks have to be coalesced.
+    void BM_FreeListAllocator(benchmark::State& state) {
+        auto count = (std::uint32_t)state.range(0);
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<std::uint64_t> sizeDist(1, 64);
+        std::vector<std::uint64_t> sizes(count);
+        for(auto& size : sizes) size = sizeDist(rng);
+
+        std::vector<std::uint32_t> freeOrder(count);
+        for(std::uint32_t i = 0; i < count; i++) freeOrder[i] = i;
+        std::shuffle(freeOrder.begin(), freeOrder.end(), rng);
+
+        FreeListAllocator allocator(count * 64);
+        std::vector<FreeListAllocator::Allocation*> allocs(count);
+
+        for(auto _ : state) {
+            for(std::uint32_t i = 0; i < count; i++) {
+                allocs[i] = allocator.Allocate(sizes[i]);
+            }
+            for(auto i : freeOrder) {
+                allocator.Free(allocs[i]);
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * count);
+    }
+    BENCHMARK(BM_FreeListAllocator)->Arg(64)->Arg(1024);
+
+    // Fill the bitmap slot by slot through Find(), then release everything.
+    void BM_BitmapFindSet(benchmark::State& state) {
+        auto bitCnt = (std::uint32_t)state.range(0);
+        Bitmap bitmap(bitCnt);
+
+        for(auto _ : state) {
+            std::uint32_t bit;
+            while(bitmap.Find(bit)) {
+                bitmap.Set(bit);
+            }
+            for(std::uint32_t i = 0; i < bitCnt; i++) {
+                bitmap.Clear(i);
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * bitCnt);
+    }
+    BENCHMARK(BM_BitmapFindSet)->Arg(64)->Arg(4096);
+
+}
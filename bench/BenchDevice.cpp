@@ -0,0 +1,213 @@
+#include "BenchDevice.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+namespace alloy::bench
+{
+    namespace {
+
+        struct _State {
+            Backend backend = Backend::Null;
+            std::string vsPath, psPath;
+
+            common::sp<IContext> ctx;
+            common::sp<IGraphicsDevice> dev;
+            common::sp<ITrackingDevice> trackingDev;
+            common::sp<IEvent> fence;
+            std::uint64_t fenceValue = 0;
+
+            bool shadersLoaded = false;
+            std::vector<std::uint8_t> vs, ps;
+        };
+
+        _State& _GetState() {
+            static _State state;
+            return state;
+        }
+
+        std::vector<std::uint8_t> _ReadFile(const std::string& path) {
+            std::ifstream file(path, std::ios::binary);
+            if(!file) {
+                std::fprintf(stderr, "alloy_bench: can't open %s\n", path.c_str());
+                std::exit(1);
+            }
+            return { std::istreambuf_iterator<char>(file), {} };
+        }
+
+        void _LoadShaders() {
+            auto& s = _GetState();
+            if(s.shadersLoaded) return;
+            s.shadersLoaded = true;
+
+            if(!s.vsPath.empty() && !s.psPath.empty()) {
+                s.vs = _ReadFile(s.vsPath);
+                s.ps = _ReadFile(s.psPath);
+            } else if(s.backend == Backend::Null) {
+                s.vs = { 0, 0, 0, 0 };
+                s.ps = { 0, 0, 0, 0 };
+            }
+        }
+
+    }
+
+    void ParseArgs(int& argc, char** argv) {
+        auto& s = _GetState();
+
+        int out = 1;
+        for(int i = 1; i < argc; i++) {
+            std::string_view arg = argv[i];
+            auto value = [&](std::string_view name) -> std::string_view {
+                return arg.substr(name.size());
+            };
+
+            if(arg.starts_with("--alloy_backend=")) {
+                auto name = value("--alloy_backend=");
+                if(name == "null") s.backend = Backend::Null;
+                else if(name == "vulkan") s.backend = Backend::Vulkan;
+                else if(name == "dx12") s.backend = Backend::DX12;
+                else if(name == "metal") s.backend = Backend::Metal;
+                else {
+                    std::fprintf(stderr, "alloy_bench: unknown backend '%.*s'\n",
+                        (int)name.size(), name.data());
+                    std::exit(1);
+                }
+            } else if(arg.starts_with("--alloy_vs=")) {
+                s.vsPath = value("--alloy_vs=");
+            } else if(arg.starts_with("--alloy_ps=")) {
+                s.psPath = value("--alloy_ps=");
+            } else {
+                argv[out++] = argv[i];
+            }
+        }
+        argc = out;
+    }
+
+    Backend GetBackend() { return _GetState().backend; }
+
+    IGraphicsDevice* GetDevice() {
+        auto& s = _GetState();
+        if(!s.dev) {
+            s.ctx = IContext::Create(s.backend);
+            if(!s.ctx) {
+                std::fprintf(stderr, "alloy_bench: backend not available in this build\n");
+                std::exit(1);
+            }
+
+            IGraphicsDevice::Options opts{};
+            s.dev = s.ctx->CreateDefaultDevice(opts);
+            if(!s.dev) {
+                std::fprintf(stderr, "alloy_bench: failed to create a device\n");
+                std::exit(1);
+            }
+            s.fence = s.dev->GetResourceFactory().CreateSyncEvent();
+
+            auto& info = s.dev->GetAdapter().GetAdapterInfo();
+            benchmark::AddCustomContext("alloy_api", (std::string)info.apiVersion);
+            benchmark::AddCustomContext("alloy_device", info.deviceName);
+        }
+        return s.dev.get();
+    }
+
+    ITrackingDevice* GetTrackingDevice() {
+        auto& s = _GetState();
+        if(!s.trackingDev) {
+            s.trackingDev = ITrackingDevice::Make(common::ref_sp(GetDevice()));
+        }
+        return s.trackingDev.get();
+    }
+
+    const std::vector<std::uint8_t>& GetVertexShader() {
+        _LoadShaders();
+        return _GetState().vs;
+    }
+
+    const std::vector<std::uint8_t>& GetPixelShader() {
+        _LoadShaders();
+        return _GetState().ps;
+    }
+
+    common::sp<IBuffer> CreateBuffer(
+        ResourceFactory& factory,
+        std::uint32_t sizeInBytes,
+        HostAccess hostAccess
+    ) {
+        IBuffer::Description desc{};
+        desc.sizeInBytes = sizeInBytes;
+        desc.usage.vertexBuffer = 1;
+        desc.usage.uniformBuffer = 1;
+        desc.usage.structuredBufferReadOnly = 1;
+        desc.hostAccess = hostAccess;
+        return factory.CreateBuffer(desc);
+    }
+
+    common::sp<ITextureView> CreateRenderTarget(
+        ResourceFactory& factory,
+        std::uint32_t width, std::uint32_t height
+    ) {
+        ITexture::Description desc{};
+        desc.type = ITexture::Description::Type::Texture2D;
+        desc.width = width;
+        desc.height = height;
+        desc.depth = 1;
+        desc.mipLevels = 1;
+        desc.arrayLayers = 1;
+        desc.format = PixelFormat::R8_G8_B8_A8_UNorm;
+        desc.usage.renderTarget = 1;
+        desc.sampleCount = SampleCount::x1;
+        return factory.CreateTextureView(factory.CreateTexture(desc));
+    }
+
+    common::sp<IGfxPipeline> CreateGraphicsPipeline(ResourceFactory& factory) {
+        auto& vsCode = GetVertexShader();
+        auto& psCode = GetPixelShader();
+        if(vsCode.empty() || psCode.empty()) return nullptr;
+
+        IShader::Description vsDesc{};
+        vsDesc.stage = IShader::Stage::Vertex;
+        vsDesc.entryPoint = "VSMain";
+        IShader::Description psDesc{};
+        psDesc.stage = IShader::Stage::Fragment;
+        psDesc.entryPoint = "PSMain";
+
+        GraphicsPipelineDescription desc{};
+        desc.resourceLayout = factory.CreateResourceLayout({});
+        desc.attachmentState.colorAttachments = {
+            AttachmentStateDescription::ColorAttachment::MakeOverrideBlend()
+        };
+        desc.attachmentState.colorAttachments.front().format = PixelFormat::R8_G8_B8_A8_UNorm;
+        desc.attachmentState.sampleCount = SampleCount::x1;
+        desc.rasterizerState.cullMode = RasterizerStateDescription::FaceCullMode::None;
+        desc.rasterizerState.fillMode = RasterizerStateDescription::PolygonFillMode::Solid;
+        desc.rasterizerState.frontFace = RasterizerStateDescription::FrontFace::Clockwise;
+        desc.rasterizerState.depthClipEnabled = true;
+        desc.primitiveTopology = PrimitiveTopology::TriangleList;
+        // VSMain is expected to derive positions from SV_VertexID
+        desc.shaderSet.vertexShader = factory.CreateShader(vsDesc, vsCode);
+        desc.shaderSet.fragmentShader = factory.CreateShader(psDesc, psCode);
+
+        return factory.CreateGraphicsPipeline(desc);
+    }
+
+    void SubmitAndWait(ICommandList* cmd) {
+        auto& s = _GetState();
+        auto* q = s.dev->GetGfxCommandQueue();
+        q->SubmitCommand(cmd);
+        q->EncodeSignalEvent(s.fence.get(), ++s.fenceValue);
+        s.fence->WaitFromCPU(s.fenceValue);
+    }
+
+    void SubmitAndWait(ITrackingCommandList* cmd) {
+        auto* q = GetTrackingDevice()->GetGfxCommandQueue();
+        auto value = q->SubmitCommand(cmd);
+        q->GetTrackingEvent().WaitFromCPU(value);
+    }
+
+} // namespace alloy::bench
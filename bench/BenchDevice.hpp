@@ -0,0 +1,46 @@
+#pragma once
+
+#include "alloy/alloy.hpp"
+#include "alloy/layers/AutoResourceUsageTracking/ITrackingDevice.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace alloy::bench
+{
+    // Consumes the --alloy_* flags and leaves the rest for Google Benchmark:
+    //   --alloy_backend=null|vulkan|dx12|metal   (default: null)
+    //   --alloy_vs=<file> --alloy_ps=<file>      compiled VSMain/PSMain blobs,
+    //                                            needed by pipeline benchmarks
+    //                                            on real backends
+    void ParseArgs(int& argc, char** argv);
+
+    Backend GetBackend();
+
+    // Created on first use and shared by every benchmark
+    IGraphicsDevice* GetDevice();
+    // Wraps the same device
+    ITrackingDevice* GetTrackingDevice();
+
+    // Empty if no shader blobs are available for the selected backend.
+    // The null backend accepts any bytes.
+    const std::vector<std::uint8_t>& GetVertexShader();
+    const std::vector<std::uint8_t>& GetPixelShader();
+
+    common::sp<IBuffer> CreateBuffer(
+        ResourceFactory& factory,
+        std::uint32_t sizeInBytes,
+        HostAccess hostAccess = HostAccess::None);
+
+    common::sp<ITextureView> CreateRenderTarget(
+        ResourceFactory& factory,
+        std::uint32_t width, std::uint32_t height);
+
+    // A minimal pipeline rendering to an RGBA8 target. Null if there
+    // are no shaders for the selected backend.
+    common::sp<IGfxPipeline> CreateGraphicsPipeline(ResourceFactory& factory);
+
+    void SubmitAndWait(ICommandList* cmd);
+    void SubmitAndWait(ITrackingCommandList* cmd);
+
+} // namespace alloy::bench
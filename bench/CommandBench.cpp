@@ -0,0 +1,103 @@
+#include "BenchDevice.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace alloy;
+
+namespace
+{
+    constexpr std::uint32_t kTargetSize = 256;
+
+    RenderPassAction _MakePassAction(const common::sp<ITextureView>& target) {
+        RenderPassAction action{};
+        auto& color = action.colorTargetActions.emplace_back();
+        color.target = target;
+        color.loadAction = LoadAction::Clear;
+        color.storeAction = StoreAction::Store;
+        color.clearColor = { 0.f, 0.f, 0.f, 1.f };
+        return action;
+    }
+
+    // Draw recording, every draw rebinds its vertex buffer the way a
+    // naive renderer would. Run on the bare device and through
+    // AutoResourceUsageTracking, which records every command into a
+    // deferred list and tracks buffer state per bind.
+    template<typename GetDevFn>
+    void BM_RecordDraws(benchmark::State& state, GetDevFn getDev) {
+        auto* dev = getDev();
+        auto& factory = dev->GetResourceFactory();
+
+        auto pipeline = bench::CreateGraphicsPipeline(factory);
+        if(!pipeline) {
+            state.SkipWithError("needs --alloy_vs/--alloy_ps on this backend");
+            return;
+        }
+        auto target = bench::CreateRenderTarget(factory, kTargetSize, kTargetSize);
+        auto vb = bench::CreateBuffer(factory, 64 * 1024);
+        auto action = _MakePassAction(target);
+
+        auto drawCount = (std::uint32_t)state.range(0);
+        auto cmd = dev->GetGfxCommandQueue()->CreateCommandList();
+
+        for(auto _ : state) {
+            cmd->Begin();
+            auto& enc = cmd->BeginRenderPass(action, {});
+            enc.SetPipeline(pipeline);
+            enc.SetFullViewport();
+            enc.SetFullScissorRect();
+            for(std::uint32_t i = 0; i < drawCount; i++) {
+                enc.SetVertexBuffer(0, vb.get(), (i % 1024) * 64);
+                enc.Draw(3, 1, 0, 0);
+            }
+            cmd->EndPass();
+            cmd->End();
+
+            // Only recording is timed, the list is reused once it finished
+            state.PauseTiming();
+            bench::SubmitAndWait(cmd.get());
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * drawCount);
+    }
+    BENCHMARK_CAPTURE(BM_RecordDraws, Bare, bench::GetDevice)->Arg(256)->Arg(4096);
+    BENCHMARK_CAPTURE(BM_RecordDraws, Tracked, bench::GetTrackingDevice)->Arg(256)->Arg(4096);
+
+    // One Barrier() call carrying range(0) buffer transitions, flipping
+    // between copy-dest and shader-read each iteration.
+    void BM_BarrierBatch(benchmark::State& state) {
+        auto* dev = bench::GetDevice();
+        auto& factory = dev->GetResourceFactory();
+
+        auto batchSize = (std::uint32_t)state.range(0);
+
+        ResourceState copyDst{ PipelineStage::Copy, ResourceAccess::CopyDest };
+        ResourceState shaderRead{
+            PipelineStage::AllShaders, ResourceAccess::ShaderResourceRead };
+
+        std::vector<BarrierOp> toRead, toWrite;
+        for(std::uint32_t i = 0; i < batchSize; i++) {
+            auto range = BufferRange::MakeByteBuffer(bench::CreateBuffer(factory, 256));
+            toRead.push_back(BufferBarrierOp{ range, copyDst, shaderRead });
+            toWrite.push_back(BufferBarrierOp{ range, shaderRead, copyDst });
+        }
+
+        auto cmd = dev->GetGfxCommandQueue()->CreateCommandList();
+
+        for(auto _ : state) {
+            cmd->Begin();
+            cmd->Barrier(toRead);
+            cmd->Barrier(toWrite);
+            cmd->End();
+
+            // Only recording is timed, the list is reused once it finished
+            state.PauseTiming();
+            bench::SubmitAndWait(cmd.get());
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * batchSize * 2);
+    }
+    BENCHMARK(BM_BarrierBatch)->Arg(1)->Arg(16)->Arg(128);
+
+}
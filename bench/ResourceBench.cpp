@@ -0,0 +1,92 @@
+#include "BenchDevice.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace alloy;
+
+namespace
+{
+    // Bindless descriptor updates, range(0) descriptors per WriteRange().
+    void BM_DescriptorHeapWriteRange(benchmark::State& state) {
+        auto* dev = bench::GetDevice();
+        if(dev->GetAdapter().GetAdapterInfo().resourceBindingModel
+            != ResourceBindingModel::DescriptorHeap
+        ) {
+            state.SkipWithError("descriptor heaps not supported");
+            return;
+        }
+        auto& factory = dev->GetResourceFactory();
+
+        auto count = (std::uint32_t)state.range(0);
+        constexpr std::uint32_t kCapacity = 4096;
+
+        auto heap = factory.CreateResourceDescriptorHeap({ .capacity = kCapacity });
+        auto buffer = bench::CreateBuffer(factory, count * 256);
+
+        std::vector<ResourceDescriptorWrite> writes;
+        writes.reserve(count);
+        for(std::uint32_t i = 0; i < count; i++) {
+            writes.push_back(UniformBufferDescriptor{
+                BufferRange::MakeByteBuffer(buffer, i * 256, 256) });
+        }
+
+        std::uint32_t base = 0;
+        for(auto _ : state) {
+            heap->WriteRange(ResourceDescriptorIndex{ base }, writes);
+            base = (base + count) % (kCapacity - count + 1);
+        }
+        state.SetItemsProcessed(state.iterations() * count);
+    }
+    BENCHMARK(BM_DescriptorHeapWriteRange)->Arg(1)->Arg(64)->Arg(1024);
+
+    // Host write into a staging buffer followed by a GPU copy into a
+    // device-local buffer, waited on every iteration.
+    void BM_BufferUpload(benchmark::State& state) {
+        auto* dev = bench::GetDevice();
+        auto& factory = dev->GetResourceFactory();
+
+        auto size = (std::uint32_t)state.range(0);
+        auto staging = bench::CreateBuffer(factory, size, HostAccess::SystemMemoryPreferWrite);
+        auto dst = bench::CreateBuffer(factory, size);
+        auto src = BufferRange::MakeByteBuffer(staging);
+        auto dstRange = BufferRange::MakeByteBuffer(dst);
+
+        std::vector<std::uint8_t> payload(size, 0x5a);
+        auto cmd = dev->GetGfxCommandQueue()->CreateCommandList();
+
+        for(auto _ : state) {
+            auto* ptr = staging->MapToCPU();
+            std::memcpy(ptr, payload.data(), size);
+            staging->UnMap();
+
+            cmd->Begin();
+            auto& enc = cmd->BeginTransferPass();
+            enc.CopyBuffer(src, dstRange, size);
+            cmd->EndPass();
+            cmd->End();
+            bench::SubmitAndWait(cmd.get());
+        }
+        state.SetBytesProcessed(state.iterations() * size);
+    }
+    BENCHMARK(BM_BufferUpload)->Arg(64 << 10)->Arg(1 << 20)->Arg(16 << 20);
+
+    void BM_GraphicsPipelineCreate(benchmark::State& state) {
+        auto* dev = bench::GetDevice();
+        auto& factory = dev->GetResourceFactory();
+
+        if(bench::GetVertexShader().empty()) {
+            state.SkipWithError("needs --alloy_vs/--alloy_ps on this backend");
+            return;
+        }
+
+        for(auto _ : state) {
+            auto pipeline = bench::CreateGraphicsPipeline(factory);
+            benchmark::DoNotOptimize(pipeline.get());
+        }
+    }
+    BENCHMARK(BM_GraphicsPipelineCreate)->Unit(benchmark::kMicrosecond);
+
+}
@@ -0,0 +1,76 @@
+#include "alloy/common/Waitable.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace alloy::common;
+
+namespace
+{
+    // The job system's fork/join: range(0) workers are woken through a
+    // semaphore, each one completes a launch and the caller waits for all.
+    void BM_ForkJoin(benchmark::State& state) {
+        auto workerCnt = (int)state.range(0);
+
+        CountingSemaphore start;
+        MultiObjectLatch done;
+        std::atomic<bool> stop{false};
+
+        std::vector<std::thread> workers;
+        for(int i = 0; i < workerCnt; i++) {
+            workers.emplace_back([&]() {
+                for(;;) {
+                    start.Acquire();
+                    if(stop.load()) return;
+                    done.LaunchComplete();
+                }
+            });
+        }
+
+        for(auto _ : state) {
+            done.AddLaunch(workerCnt);
+            start.Release(workerCnt);
+            done.Wait();
+        }
+
+        stop = true;
+        start.Release(workerCnt);
+        for(auto& t : workers) t.join();
+
+        state.SetItemsProcessed(state.iterations() * workerCnt);
+    }
+    BENCHMARK(BM_ForkJoin)->RangeMultiplier(2)->Range(2, 64)->UseRealTime();
+
+    // Every thread adds and completes launches on one shared latch, nobody
+    // waits. Measures the signal path under contention.
+    MultiObjectLatch g_sharedLatch;
+
+    void BM_LaunchCompleteContended(benchmark::State& state) {
+        for(auto _ : state) {
+            g_sharedLatch.AddLaunch();
+            g_sharedLatch.LaunchComplete();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_LaunchCompleteContended)->ThreadRange(2, 64)->UseRealTime();
+
+    // Like BM_ForkJoin with a fresh single use latch per round.
+    void BM_CountdownLatch(benchmark::State& state) {
+        auto workerCnt = (int)state.range(0);
+
+        for(auto _ : state) {
+            CountdownLatch done(workerCnt);
+            std::vector<std::thread> workers;
+            for(int i = 0; i < workerCnt; i++)
+                workers.emplace_back([&]() { done.CountDown(); });
+            done.Wait();
+            for(auto& t : workers) t.join();
+        }
+        state.SetItemsProcessed(state.iterations() * workerCnt);
+    }
+    BENCHMARK(BM_CountdownLatch)->RangeMultiplier(4)->Range(2, 64)->UseRealTime();
+
+}
@@ -0,0 +1,20 @@
+#include "BenchDevice.hpp"
+
+#include <benchmark/benchmark.h>
+
+// For regression tracking, write JSON next to the console output:
+//   alloy_bench --benchmark_out=results.json --benchmark_out_format=json
+// and compare two runs with Google Benchmark's tools/compare.py.
+int main(int argc, char** argv) {
+    alloy::bench::ParseArgs(argc, argv);
+
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    // Create the device up front so its name lands in the report context
+    alloy::bench::GetDevice();
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "alloy/common/Macros.h"
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/SyncObjects.hpp"
+#include "alloy/UploadManager.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace alloy
+{
+    class IGraphicsDevice;
+    class ICommandQueue;
+    class ICommandList;
+}
+
+// Awaitables for GPU completion, usable from any coroutine type.
+//
+// A suspended coroutine registers an IEvent::OnReached callback instead
+// of blocking a thread, so any number of them can wait at once. They
+// resume on the backend's completion thread, or through a Scheduler.
+// A coroutine waiting on an event keeps it alive until it's reached.
+namespace alloy::async
+{
+    class Scheduler {
+    public:
+        virtual ~Scheduler() = default;
+
+        virtual void Post(std::coroutine_handle<> handle) = 0;
+    };
+
+    // Resumes coroutines on its own worker threads, keeping long running
+    // continuations off the backend's completion thread.
+    class ThreadPoolScheduler : public Scheduler {
+        DISABLE_COPY_AND_ASSIGN(ThreadPoolScheduler);
+
+        std::mutex _m;
+        std::condition_variable _cv;
+        std::deque<std::coroutine_handle<>> _ready;
+        std::vector<std::thread> _workers;
+        bool _stop;
+
+        void _WorkerMain();
+
+    public:
+        explicit ThreadPoolScheduler(std::uint32_t threadCnt = 1);
+
+        // Resumes what was already posted, then joins the workers
+        ~ThreadPoolScheduler() override;
+
+        virtual void Post(std::coroutine_handle<> handle) override;
+    };
+
+    // co_await Reached(event, value)
+    class EventAwaiter {
+        common::sp<IEvent> _event;
+        std::uint64_t _value;
+        Scheduler* _scheduler;
+
+        std::coroutine_handle<> _handle;
+        // Set by the first of await_suspend and the callback, the second
+        // one resumes
+        std::atomic<bool> _armed;
+
+        void _Resume() {
+            if(_scheduler) _scheduler->Post(_handle);
+            else _handle.resume();
+        }
+
+    public:
+        EventAwaiter(common::sp<IEvent> event, std::uint64_t value, Scheduler* scheduler)
+            : _event(std::move(event))
+            , _value(value)
+            , _scheduler(scheduler)
+            , _armed(false)
+        { }
+
+        bool await_ready() const { return _event->GetSignaledValue() >= _value; }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            _handle = handle;
+            // Resumes on destruction of the event too, never leaves the
+            // coroutine hanging
+            _event->OnReached(_value, [this](bool) {
+                if(_armed.exchange(true)) _Resume();
+            });
+            // Reached in the meantime, carry on without suspending
+            return !_armed.exchange(true);
+        }
+
+        void await_resume() const { }
+    };
+
+    inline EventAwaiter Reached(
+        common::sp<IEvent> event,
+        std::uint64_t value,
+        Scheduler* scheduler = nullptr
+    ) {
+        return EventAwaiter(std::move(event), value, scheduler);
+    }
+
+    // Completes once the upload's ticket is done. The uploader still needs
+    // its Update() calls to get there.
+    inline EventAwaiter Uploaded(
+        const UploadManager& uploader,
+        UploadManager::Ticket ticket,
+        Scheduler* scheduler = nullptr
+    ) {
+        return EventAwaiter(uploader.GetCompletionEvent(), ticket, scheduler);
+    }
+
+    // A command queue with its own completion event, for
+    // co_await queue.Submit(cmd).
+    class Queue {
+        DISABLE_COPY_AND_ASSIGN(Queue);
+
+        ICommandQueue* _queue;
+        common::sp<IEvent> _event;
+        std::uint64_t _lastSignaled;
+        std::mutex _m_submit;
+
+    public:
+        Queue(IGraphicsDevice& dev, ICommandQueue* queue);
+
+        // Submits and completes once the GPU finished the command list
+        EventAwaiter Submit(ICommandList* cmd, Scheduler* scheduler = nullptr);
+
+        ICommandQueue* GetQueue() const { return _queue; }
+        const common::sp<IEvent>& GetEvent() const { return _event; }
+    };
+
+} // namespace alloy::async
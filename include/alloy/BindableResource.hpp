@@ -83,6 +83,12 @@ namespace alloy
             // If this is set, shaderResources is ignored. We only support
             // full bindless mode.
             bool useGlobalHeaps = false;
+
+            // Hint that resources of this layout are few and rebound per
+            // draw with SetGraphicsResources/SetComputeResources. Backends
+            // that can write them inline may pick a layout that can't back
+            // mutable resource sets.
+            bool inlineResources = false;
         };
 
         struct HeapRangeLocation {
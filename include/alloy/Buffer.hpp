@@ -56,6 +56,11 @@ namespace alloy
                     /// </summary>
                     std::uint8_t indirectBuffer : 1;
                     /// <summary>
+                    /// Indicates that shaders can access a <see cref="DeviceBuffer"/> through its GetDeviceAddress().
+                    /// Requires Features::bufferDeviceAddress.
+                    /// </summary>
+                    std::uint8_t deviceAddress : 1;
+                    /// <summary>
                     /// Indicates that a <see cref="DeviceBuffer"/> will be updated with new data very frequently. Dynamic Buffers can be
                     /// mapped with <see cref="MapMode.Write"/>. This flag cannot be combined with <see cref="StructuredBufferReadWrite"/>
                     /// or <see cref="IndirectBuffer"/>.
@@ -84,6 +89,10 @@ namespace alloy
         virtual void UnMap() = 0;
 
         virtual uint64_t GetNativeHandle() const {return 0;}
+
+        // GPU virtual address of the first byte, for pointer access from
+        // shaders. 0 unless created with usage.deviceAddress.
+        virtual std::uint64_t GetDeviceAddress() const {return 0;}
         
         virtual void SetDebugName(const std::string& ) = 0;
         virtual std::string GetDebugName() = 0;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace alloy
+{
+    // Incremental compaction of device local buffer memory.
+    //
+    // Start() begins a run. Each Update() moves a batch of buffers into
+    // fuller memory blocks with GPU copies, within the budget, and frees
+    // the blocks emptied by an earlier batch once its copies finished.
+    // Moved buffers keep their IBuffer object, only the native handle
+    // behind it changes.
+    //
+    // Buffers only. There's no indirection that would repoint resource
+    // sets, descriptor heaps, texture views or device addresses, so only
+    // buffers with HostAccess::None used as vertex, index, indirect or
+    // copy buffers are moved. Everything else, textures included, stays
+    // where it was allocated.
+    //
+    // Call Update() from the submitting thread between frames: after the
+    // frame's command lists are submitted, before recording the next one.
+    // A command list recorded before an Update() that moved buffers can't
+    // be submitted after it, the queue refuses it.
+    //
+    // Get one from IGraphicsDevice::GetBufferDefragmenter(), null if the
+    // backend can't move resources.
+    class IBufferDefragmenter {
+    public:
+        struct Budget {
+            // 0 for no limit
+            std::uint64_t maxBytesPerUpdate = 64ull << 20;
+            std::uint32_t maxMovesPerUpdate = 256;
+            // The first move of an update always goes through
+            std::chrono::microseconds maxTimePerUpdate{500};
+        };
+
+        // Totals of the current run, or the last one if none is running
+        struct Stats {
+            bool running;
+            std::uint32_t updates;
+            std::uint32_t allocationsMoved;
+            std::uint64_t bytesMoved;
+            // Known once the run finished
+            std::uint64_t bytesFreed;
+            std::uint32_t blocksFreed;
+        };
+
+        virtual ~IBufferDefragmenter() = default;
+
+        // Takes effect on the next Start()
+        virtual void SetBudget(const Budget& budget) = 0;
+
+        // Does nothing if a run is in progress
+        virtual void Start() = 0;
+
+        // Call once per frame, returns quickly when idle.
+        virtual void Update() = 0;
+
+        virtual bool IsRunning() const = 0;
+
+        virtual Stats GetStats() const = 0;
+    };
+
+} // namespace alloy
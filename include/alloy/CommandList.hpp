@@ -6,6 +6,7 @@
 #include "alloy/Buffer.hpp"
 //#include "alloy/BindableResource.hpp"
 #include "alloy/Types.hpp"
+#include "alloy/FixedFunctions.hpp"
 #include "alloy/SyncObjects.hpp"
 #include "alloy/ResourceBarrier.hpp"
 #include "alloy/RenderPass.hpp"
@@ -55,11 +56,45 @@ namespace alloy
         virtual void SetIndexBuffer(
             const common::sp<BufferRange>& buffer, IndexFormat format) = 0;
 
+        // Non-owning bind fast path. The encoder doesn't retain the buffer, so
+        // no BufferRange allocation and no refcount traffic per bind. Caller
+        // must keep the buffer alive until the command list is submitted, the
+        // device defers destroying native objects until GPU is done with them.
+        // Backends without a fast path fall back to the owning version.
+        virtual void SetVertexBuffer(
+            std::uint32_t index, IBuffer* buffer, std::uint64_t offsetInBytes
+        ) {
+            auto sizeInBytes = buffer->GetDesc().sizeInBytes - offsetInBytes;
+            SetVertexBuffer(index, BufferRange::MakeByteBuffer(
+                common::ref_sp(buffer), offsetInBytes, sizeInBytes));
+        }
+
+        virtual void SetIndexBuffer(
+            IBuffer* buffer, IndexFormat format, std::uint64_t offsetInBytes
+        ) {
+            auto sizeInBytes = buffer->GetDesc().sizeInBytes - offsetInBytes;
+            SetIndexBuffer(BufferRange::MakeByteBuffer(
+                common::ref_sp(buffer), offsetInBytes, sizeInBytes), format);
+        }
+
         virtual void SetPushConstants(
             std::uint32_t pushConstantIndex,
             std::span<const uint32_t> data,
             std::uint32_t destOffsetIn32BitValues) = 0;
 
+        // Writes a 64-bit value such as IBuffer::GetDeviceAddress() as two
+        // dwords, low first. Keep destOffsetIn32BitValues even so shaders
+        // can read it as one 8-byte aligned value.
+        void SetPushConstantAddress(
+            std::uint32_t pushConstantIndex,
+            std::uint64_t address,
+            std::uint32_t destOffsetIn32BitValues
+        ) {
+            const std::uint32_t data[2] = {
+                (std::uint32_t)address, (std::uint32_t)(address >> 32) };
+            SetPushConstants(pushConstantIndex, data, destOffsetIn32BitValues);
+        }
+
         // Sets the active <see cref="ResourceSet"/> for the given index. This ResourceSet is only active for the graphics
         // Pipeline.
         // <param name="slot">The resource slot.</param>
@@ -75,9 +110,24 @@ namespace alloy
             const common::sp<IResourceSet>& rs
             /*const std::vector<std::uint32_t>& dynamicOffsets*/) = 0;
 
+        // Non-owning version, same lifetime rule as the raw SetVertexBuffer
+        virtual void SetGraphicsResourceSet(IResourceSet* rs) {
+            SetGraphicsResourceSet(common::ref_sp(rs));
+        }
+
         virtual void SetGraphicsMutableResourceSet(
             const common::sp<IMutableResourceSet>& rs) = 0;
 
+        // Binds resources without a resource set. layout is the bound
+        // pipeline's, resources are ordered like
+        // IResourceSet::Description::boundResources. Layouts created with
+        // inlineResources are written straight into the command list, no
+        // descriptor allocation. Same lifetime rule as the raw
+        // SetVertexBuffer. Check Features::inlineResources.
+        virtual void SetGraphicsResources(
+            IResourceLayout* /*layout*/,
+            std::span<const common::sp<IBindableResource>> /*resources*/) {}
+
         // The T2 bindless heap, reflects almost 1:1 to DX12.
         // either can be null pointer, which will be clearing the bound heaps.
         // Should be called **BEFORE** setting a T2 bindless pipeline. According to
@@ -128,6 +178,25 @@ namespace alloy
         // Only index 0 scissor rect is set
         virtual void SetFullScissorRect() = 0;
 
+
+        // Extended dynamic state, for pipelines created with the matching
+        // DynamicStateDescription flag. Set before drawing, and again after
+        // binding a pipeline that bakes the state. Backends without
+        // IGraphicsDevice::Features::dynamicRasterState ignore these.
+        virtual void SetCullMode(RasterizerStateDescription::FaceCullMode) {}
+
+        virtual void SetDepthTest(
+            bool /*testEnabled*/, bool /*writeEnabled*/, ComparisonKind /*comparison*/) {}
+
+        virtual void SetPrimitiveTopology(PrimitiveTopology) {}
+
+        virtual void SetStencilOp(
+            bool /*testEnabled*/,
+            const DepthStencilStateDescription::StencilBehavior& /*front*/,
+            const DepthStencilStateDescription::StencilBehavior& /*back*/) {}
+
+        // Needs IGraphicsDevice::Features::dynamicBlendEnable
+        virtual void SetBlendEnabled(std::uint32_t /*attachment*/, bool /*enabled*/) {}
         
         // Draws primitives from the currently-bound state in this CommandList. 
         // An index Buffer is not used.
@@ -198,9 +267,19 @@ namespace alloy
             const common::sp<IResourceSet>& rs
             /*const std::vector<std::uint32_t>& dynamicOffsets*/) = 0;
 
+        // Non-owning version, see IRenderCommandEncoder::SetVertexBuffer
+        virtual void SetComputeResourceSet(IResourceSet* rs) {
+            SetComputeResourceSet(common::ref_sp(rs));
+        }
+
         virtual void SetComputeMutableResourceSet(
             const common::sp<IMutableResourceSet>& rs) = 0;
 
+        // See IRenderCommandEncoder::SetGraphicsResources
+        virtual void SetComputeResources(
+            IResourceLayout* /*layout*/,
+            std::span<const common::sp<IBindableResource>> /*resources*/) {}
+
         virtual void SetDescriptorHeaps(
             const common::sp<IResourceDescriptorHeap>& resourceHeap,
             const common::sp<ISamplerDescriptorHeap>& samplerHeap) = 0;
@@ -210,6 +289,19 @@ namespace alloy
             std::span<const uint32_t> data,
             std::uint32_t destOffsetIn32BitValues) = 0;
 
+        // Writes a 64-bit value such as IBuffer::GetDeviceAddress() as two
+        // dwords, low first. Keep destOffsetIn32BitValues even so shaders
+        // can read it as one 8-byte aligned value.
+        void SetPushConstantAddress(
+            std::uint32_t pushConstantIndex,
+            std::uint64_t address,
+            std::uint32_t destOffsetIn32BitValues
+        ) {
+            const std::uint32_t data[2] = {
+                (std::uint32_t)address, (std::uint32_t)(address >> 32) };
+            SetPushConstants(pushConstantIndex, data, destOffsetIn32BitValues);
+        }
+
         /// <summary>
         /// Dispatches a compute operation from the currently-bound compute state of this Pipeline.
         /// </summary>
@@ -353,12 +445,14 @@ namespace alloy
         }
         #endif
 
-        // Generates mipmaps for the given <see cref="Texture"/>. The largest mipmap is used to generate all of the lower mipmap
-        // levels contained in the Texture. The previous contents of all lower mipmap levels are overwritten by this operation.
-        // The target Texture must have been created with <see cref="TextureUsage"/>.<see cref="TextureUsage.GenerateMipmaps"/>.
-        // <param name="texture">The <see cref="Texture"/> to generate mipmaps for. This Texture must have been created with
-        // <see cref="TextureUsage"/>.<see cref="TextureUsage.GenerateMipmaps"/>.</param>
-        virtual void GenerateMipmaps(const common::sp<ITexture>& texture) = 0;
+        // Fills every level of the view by downsampling its base level.
+        // All levels and layers of the view must be in CopyDest layout and
+        // are left in CopySource layout. Color textures only. Needs a queue
+        // with graphics support on Vulkan. Returns false if the backend
+        // can't downsample the format, see
+        // IGraphicsDevice::CanGenerateMipmaps(). Nothing is recorded then
+        // and the levels and their layouts are left untouched.
+        virtual bool GenerateMipmaps(const common::sp<ITextureView>& texture) = 0;
     };
 
     class ICommandList : public common::RefCntBase{
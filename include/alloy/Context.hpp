@@ -50,6 +50,10 @@ namespace alloy {
         /// OpenGL ES.
         /// </summary>
         //OpenGLES,
+        /// <summary>
+        /// No GPU, commands complete instantly. For measuring CPU overhead.
+        /// </summary>
+        Null,
     };
 
     struct MemorySegmentProperties {
@@ -81,6 +85,7 @@ namespace alloy {
                 case Backend::DX12: ss << "DirectX "; break;
                 case Backend::Vulkan: ss << "Vulkan "; break;
                 case Backend::Metal: ss << "Metal "; break;
+                case Backend::Null: ss << "Null "; break;
             }
             ss << major << "." << minor << "." << subminor << "." << patch;
             return ss.str();
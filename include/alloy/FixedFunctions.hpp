@@ -314,6 +314,32 @@ namespace alloy
         bool scissorTestEnabled;
     };
     
+    // Pipeline states taken from the render encoder instead of the
+    // pipeline description, see IRenderCommandEncoder::SetCullMode and
+    // friends. The matching description fields are ignored.
+    struct DynamicStateDescription{
+
+        bool cullMode;
+
+        // Depth test, write and comparison
+        bool depthTest;
+
+        // Within the class (point, line or triangle) of the pipeline's
+        // primitiveTopology
+        bool primitiveTopology;
+
+        // Stencil test enable and operations. Masks and reference stay
+        // in the pipeline.
+        bool stencilOp;
+
+        // Needs IGraphicsDevice::Features::dynamicBlendEnable
+        bool blendEnable;
+
+        bool Any() const {
+            return cullMode || depthTest || primitiveTopology || stencilOp || blendEnable;
+        }
+    };
+    
     // The <see cref="PrimitiveTopology"/> to use, which controls how a series of input vertices is interpreted by the
     enum class PrimitiveTopology : std::uint8_t
     {
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace alloy
+{
+    // Opt-in GPU timing of command list passes and debug groups.
+    //
+    // While enabled, every render/compute/transfer pass and every
+    // PushDebugGroup/PopDebugGroup pair recorded by a command list gets a
+    // timestamp at its boundaries. Results are resolved once the
+    // submission carrying them has finished on GPU.
+    //
+    // Get one from IGraphicsDevice::GetGpuProfiler(), null if the backend
+    // doesn't support timestamps.
+    class IGpuProfiler {
+    public:
+        static constexpr std::uint32_t kNoParent = 0xffffffffu;
+
+        struct Scope {
+            std::string name;
+            // Index into Frame::scopes, kNoParent for command list roots
+            std::uint32_t parent;
+            std::uint32_t depth;
+            // Queue the scope ran on: 0 graphics, 1 copy, 2 compute
+            std::uint32_t queue;
+            // GPU clock, in nanoseconds
+            std::uint64_t beginNs;
+            std::uint64_t endNs;
+        };
+
+        struct Frame {
+            std::uint64_t frameIdx;
+            // Pre-order: each scope follows its parent
+            std::vector<Scope> scopes;
+        };
+
+        virtual ~IGpuProfiler() = default;
+
+        // Affects command lists begun afterwards.
+        virtual void SetEnabled(bool enabled) = 0;
+        virtual bool IsEnabled() const = 0;
+
+        // Closes the current frame. Command lists submitted afterwards
+        // belong to the next one.
+        virtual void EndFrame() = 0;
+
+        // Returns closed frames whose submissions all finished, oldest
+        // first. Each frame is returned once.
+        virtual std::vector<Frame> CollectFrames() = 0;
+    };
+
+    // Chrome trace event JSON, loadable in chrome://tracing and Perfetto.
+    // One track per queue.
+    std::string ExportChromeTrace(std::span<const IGpuProfiler::Frame> frames);
+
+} // namespace alloy
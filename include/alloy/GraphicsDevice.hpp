@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -8,6 +12,7 @@
 #include "alloy/common/RefCnt.hpp"
 
 #include "alloy/Types.hpp"
+#include "alloy/SyncObjects.hpp"
 //#include "alloy/ResourceFactory.hpp"
 //#include "alloy/CommandQueue.hpp"
 #include "alloy/SwapChain.hpp"
@@ -17,6 +22,8 @@ namespace alloy
     class IPhysicalAdapter;
     class ResourceFactory;
     class ICommandQueue;
+    class IGpuProfiler;
+    class IBufferDefragmenter;
     //class SwapChain;
 
     
@@ -50,8 +57,19 @@ namespace alloy
             std::uint32_t commandListDebugMarkers  : 1;
             std::uint32_t bufferRangeBinding       : 1;
             std::uint32_t shaderFloat64            : 1;
-
-            std::uint32_t reserved : 13;    
+            // DynamicStateDescription, all but blendEnable
+            std::uint32_t dynamicRasterState       : 1;
+            std::uint32_t dynamicBlendEnable       : 1;
+            // SetGraphicsResources/SetComputeResources
+            std::uint32_t inlineResources          : 1;
+            // IBuffer::Description::Usage::deviceAddress
+            std::uint32_t bufferDeviceAddress      : 1;
+            // ResourceFactory::CreateMemoryHeap and placed resources
+            std::uint32_t placedResources          : 1;
+            // ITransferCmdEnc::GenerateMipmaps
+            std::uint32_t generateMipmaps          : 1;
+
+            std::uint32_t reserved : 7;    
         };
 
         struct Options{
@@ -67,6 +85,33 @@ namespace alloy
 
         enum class UVOrigin{ TopLeft, TopRight, BottomLeft, BottomRight };
 
+        struct MemoryHeapStats {
+            bool deviceLocal;
+            // What the process may use before the OS starts evicting or
+            // failing allocations, and what it uses now, other allocators
+            // included. Usage is an estimate without OS budget queries.
+            std::uint64_t budgetBytes;
+            std::uint64_t usageBytes;
+            // Memory blocks taken from the heap, and the part of them
+            // handed out to resources
+            std::uint32_t blockCount;
+            std::uint32_t allocationCount;
+            std::uint64_t blockBytes;
+            std::uint64_t allocationBytes;
+            // Free ranges inside the blocks. Only filled by detailed queries.
+            std::uint32_t unusedRangeCount;
+            std::uint64_t largestUnusedRangeBytes;
+        };
+
+        struct MemoryStats {
+            std::vector<MemoryHeapStats> heaps;
+        };
+
+        // Called on the allocating thread once each time a heap's usage
+        // goes from within to over its budget.
+        using MemoryBudgetCallback = std::function<void(
+            std::uint32_t heapIndex, const MemoryHeapStats& heap)>;
+
         //struct SubmitBatch{
         //    const std::vector<CommandList*>& cmd;
         //    const std::vector<Semaphore*>& waitSemaphores;
@@ -94,6 +139,40 @@ namespace alloy
 
         virtual ICommandQueue* GetGfxCommandQueue() = 0;
         virtual ICommandQueue* GetCopyCommandQueue() = 0;
+        // Async compute queue, runs alongside the graphics queue.
+        // Null if the adapter has no separate compute queue.
+        virtual ICommandQueue* GetComputeCommandQueue() = 0;
+
+        // Null if the backend can't time GPU work
+        virtual IGpuProfiler* GetGpuProfiler() { return nullptr; }
+
+        // Null if the backend can't move buffers
+        virtual IBufferDefragmenter* GetBufferDefragmenter() { return nullptr; }
+
+        // Whether ITransferCommandEncoder::GenerateMipmaps() can fill
+        // textures of this format
+        virtual bool CanGenerateMipmaps(PixelFormat /*format*/) const {
+            return GetFeatures().generateMipmaps;
+        }
+
+        // False if the backend doesn't track its memory. detailed walks
+        // every block for the free range numbers, not for every frame.
+        virtual bool GetMemoryStats(MemoryStats& /*stats*/, bool /*detailed*/ = false) { return false; }
+
+        // The allocator's JSON statistics dump, for offline fragmentation
+        // analysis. detailed lists every allocation. Empty if unsupported.
+        virtual std::string DumpMemoryStats(bool /*detailed*/) { return {}; }
+
+        // Null clears it
+        virtual void SetMemoryBudgetCallback(MemoryBudgetCallback /*callback*/) { }
+
+        // One wait for every event reaching its value, or for the first
+        // one with waitAll unset. False on timeout. Backends without a
+        // native multi wait build it from IEvent::OnReached.
+        virtual bool WaitForEvents(std::span<const EventWait> waits, bool waitAll, uint32_t timeoutMs);
+        bool WaitForEvents(std::span<const EventWait> waits, bool waitAll) {
+            return WaitForEvents(waits, waitAll, (std::numeric_limits<std::uint32_t>::max)());
+        }
                
         virtual void WaitForIdle() = 0;
 
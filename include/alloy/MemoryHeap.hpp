@@ -0,0 +1,49 @@
+#pragma once
+
+#include "alloy/common/Macros.h"
+#include "alloy/common/RefCnt.hpp"
+
+#include <cstdint>
+
+namespace alloy
+{
+    // Device memory that buffers and textures are placed into at explicit
+    // offsets, see ResourceFactory::CreatePlacedBuffer/CreatePlacedTexture.
+    //
+    // Placed resources may overlap when their lifetimes don't, e.g.
+    // transient render targets of different passes. Only the resource
+    // used last holds valid content. Put a barrier between the last use
+    // of one and the first use of the next, textures starting from
+    // TextureLayout::Undefined.
+    //
+    // Placed resources are device only and keep their heap alive.
+    class IMemoryHeap : public common::RefCntBase {
+
+    public:
+        // Resources a heap may hold, like D3D12 heap flags. Some devices
+        // keep buffers, textures and render targets in different memory
+        // types, creating an All heap fails there.
+        enum class ResourceClass : std::uint8_t {
+            All,
+            Buffers,
+            // Textures without renderTarget or depthStencil usage
+            Textures,
+            // Textures with renderTarget or depthStencil usage
+            RenderTargets,
+        };
+
+        struct Description {
+            std::uint64_t sizeInBytes;
+            ResourceClass resourceClass;
+        };
+
+        // Room a resource takes in a heap. Its offset must be aligned.
+        struct Placement {
+            std::uint64_t sizeInBytes;
+            std::uint64_t alignment;
+        };
+
+        virtual const Description& GetDesc() const = 0;
+    };
+
+} // namespace alloy
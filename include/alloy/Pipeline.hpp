@@ -12,6 +12,17 @@
 namespace alloy
 {
 
+    // HLSL has no specialization constants. Shaders read them from a
+    // constant buffer at register(b0, space<SpecializationConstantSpace>),
+    // the 32 bit word at byte offset 4 * id holding the constant id. On
+    // Vulkan the translated SPIR-V turns those reads into specialization
+    // constants. Only 32 bit and smaller types, and every word the shader
+    // reads needs a constant in the pipeline description. Reads must use
+    // constant offsets, pipeline creation fails otherwise. Backends
+    // without specialization constants (DX12, Metal) don't bind the
+    // buffer, shaders using it are Vulkan only.
+    constexpr std::uint32_t SpecializationConstantSpace = 1000;
+
     struct SpecializationConstant{
         // The constant variable ID, as defined in the <see cref="Shader"/>.
         std::uint32_t id;
@@ -125,6 +136,10 @@ namespace alloy
         
         // The <see cref="PrimitiveTopology"/> to use, which controls how a series of input vertices is interpreted by the
         PrimitiveTopology primitiveTopology;
+
+        // States set on the render encoder instead, needs
+        // IGraphicsDevice::Features::dynamicRasterState
+        DynamicStateDescription dynamicStates;
         /// <summary>
         /// A description of the shader set to be used.
         /// </summary>
@@ -134,7 +149,9 @@ namespace alloy
             //std::vector<sp<Shader>> shaders;
             common::sp<IShader> vertexShader;
             common::sp<IShader> fragmentShader;
-            //std::vector<SpecializationConstant> specializations;
+            // Applied to every stage. Ignored by backends without
+            // specialization constants (DX12, Metal).
+            std::vector<SpecializationConstant> specializations;
 
         } shaderSet;
         
@@ -171,11 +188,10 @@ namespace alloy
         //// The Z dimension of the thread group size.
         //std::uint32_t threadGroupSizeZ;
         //
-        //// An array of <see cref="SpecializationConstant"/> used to override specialization constants in the created
-        //// <see cref="Pipeline"/>. Each element in this array describes a single ID-value pair, which will be matched with the
-        //// constants specified in the <see cref="Shader"/>.
-        //
-        //std::vector<SpecializationConstant*> specializations;
+        // An array of <see cref="SpecializationConstant"/> used to override specialization constants in the created
+        // <see cref="Pipeline"/>. Each element in this array describes a single ID-value pair, which will be matched with the
+        // constants specified in the <see cref="Shader"/>. Ignored by backends without specialization constants.
+        std::vector<SpecializationConstant> specializations;
 
     };
 
@@ -193,6 +209,9 @@ namespace alloy
         common::sp<IShader> meshShader;
         common::sp<IShader> fragmentShader;
 
+        // Applied to every stage, see GraphicsPipelineDescription
+        std::vector<SpecializationConstant> specializations;
+
         common::sp<IResourceLayout> resourceLayout;
     };
     
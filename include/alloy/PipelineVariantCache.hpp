@@ -0,0 +1,70 @@
+#pragma once
+
+#include "alloy/common/Macros.h"
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/Pipeline.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+namespace alloy
+{
+    class IGraphicsDevice;
+
+    // Pipelines of one base description that only differ in
+    // specialization constant values, created on first use. Lets
+    // shaders drop feature branches at pipeline compile time.
+    //
+    // Constants passed to Get() override those of the base with the
+    // same id, see SpecializationConstantSpace for reading them. Variants
+    // are matched by value, order doesn't matter. On Vulkan all variants
+    // share the SPIR-V translated for the first.
+    template<typename Desc, typename Pipeline>
+    class PipelineVariantCache : public common::RefCntBase {
+        DISABLE_COPY_AND_ASSIGN(PipelineVariantCache);
+
+        common::sp<IGraphicsDevice> _dev;
+        Desc _base;
+
+        struct _Variant {
+            common::sp<Pipeline> pipeline;
+            // Set once the first getter finished compiling, later getters
+            // of the key wait on _cvVariants until then. Null pipeline if
+            // that failed, the next getter retries.
+            bool ready = false;
+        };
+
+        std::mutex _m_variants;
+        std::condition_variable _cvVariants;
+        std::unordered_map<std::string, _Variant> _variants;
+
+        PipelineVariantCache(const common::sp<IGraphicsDevice>& dev, const Desc& base);
+
+    public:
+        ~PipelineVariantCache() override;
+
+        static common::sp<PipelineVariantCache> Make(
+            const common::sp<IGraphicsDevice>& dev,
+            const Desc& base);
+
+        // Null if creation failed, retried on the next call. Variants
+        // compile outside the lock, concurrently with each other.
+        common::sp<Pipeline> Get(std::span<const SpecializationConstant> constants);
+
+        const Desc& GetBaseDesc() const { return _base; }
+
+        std::size_t GetVariantCount();
+    };
+
+    using GfxPipelineVariants =
+        PipelineVariantCache<GraphicsPipelineDescription, IGfxPipeline>;
+    using ComputePipelineVariants =
+        PipelineVariantCache<ComputePipelineDescription, IComputePipeline>;
+    using MeshShaderPipelineVariants =
+        PipelineVariantCache<MeshShaderPipelineDescription, IMeshShaderPipeline>;
+
+} // namespace alloy
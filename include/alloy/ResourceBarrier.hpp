@@ -75,6 +75,8 @@
 
 namespace alloy
 {
+    class ICommandQueue;
+
     enum class PipelineStage {
         // Umbrella scopes / coarse aliases.
         AllCommands,
@@ -168,10 +170,21 @@ namespace alloy
         ResourceState to;
     };
 
+    // Moves texture ownership between queues of different families.
+    // Record the barrier on srcQueue (release) and again with the same
+    // layouts on dstQueue (acquire), waiting on the release submission.
+    // Backends without queue ownership transition in the acquire half only.
+    struct QueueTransfer {
+        ICommandQueue* srcQueue = nullptr;
+        ICommandQueue* dstQueue = nullptr;
+    };
+
     struct TextureBarrierOp {
         common::sp<ITextureView> texture;
         TextureState from;
         TextureState to;
+        // Both null for barriers within one queue
+        QueueTransfer queueTransfer{};
     };
 
     using BarrierOp = std::variant<BufferBarrierOp, TextureBarrierOp>;
@@ -8,6 +8,7 @@
 #include "alloy/Texture.hpp"
 #include "alloy/Sampler.hpp"
 #include "alloy/Buffer.hpp"
+#include "alloy/MemoryHeap.hpp"
 #include "alloy/Pipeline.hpp"
 #include "alloy/Shader.hpp"
 #include "alloy/CommandList.hpp"
@@ -80,6 +81,27 @@ namespace alloy
         //Why don't call CreateSemaphore? because there is a WinBase #define 
         // called CreateSemaphore!!!
 
+        // Placed resources, see IMemoryHeap. Requires
+        // Features::placedResources. Placing fails with null when the
+        // offset is misaligned, the resource overruns the heap or is
+        // outside the heap's resource class.
+        virtual common::sp<IMemoryHeap> CreateMemoryHeap(
+            const IMemoryHeap::Description& /*description*/) { return nullptr; }
+
+        virtual IMemoryHeap::Placement GetPlacement(
+            const IBuffer::Description& /*description*/) { return {}; }
+        virtual IMemoryHeap::Placement GetPlacement(
+            const ITexture::Description& /*description*/) { return {}; }
+
+        virtual common::sp<IBuffer> CreatePlacedBuffer(
+            const common::sp<IMemoryHeap>& /*heap*/,
+            std::uint64_t /*offset*/,
+            const IBuffer::Description& /*description*/) { return nullptr; }
+        virtual common::sp<ITexture> CreatePlacedTexture(
+            const common::sp<IMemoryHeap>& /*heap*/,
+            std::uint64_t /*offset*/,
+            const ITexture::Description& /*description*/) { return nullptr; }
+
     };
 
     //#undef VLD_RF_FOR_EACH_RES
@@ -5,6 +5,7 @@
 #include "alloy/common/RefCnt.hpp"
 
 #include <cstdint>
+#include <functional>
 #include <limits>
 
 namespace alloy{
@@ -20,6 +21,8 @@ namespace alloy{
     class IEvent : public common::RefCntBase{
 
     public:
+        using ReachedCallback = std::function<void(bool reached)>;
+
         virtual uint64_t GetSignaledValue() = 0;
 
         virtual void SignalFromCPU(uint64_t signalValue) = 0;
@@ -28,6 +31,19 @@ namespace alloy{
             return WaitFromCPU(expectedValue, (std::numeric_limits<std::uint32_t>::max)());
         }
 
+        // Runs callback(true) once the event reaches value, on a backend
+        // owned thread, or right away on this one if it already has. Keep
+        // it short, it holds up other callbacks. Callbacks still pending
+        // when the event is destroyed run with false on the destroying
+        // thread, nothing is dropped.
+        virtual void OnReached(uint64_t value, ReachedCallback callback) = 0;
+
+    };
+
+    // Events of one device, see IGraphicsDevice::WaitForEvents
+    struct EventWait {
+        IEvent* event;
+        uint64_t value;
     };
 
 }
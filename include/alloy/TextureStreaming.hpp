@@ -0,0 +1,186 @@
+#pragma once
+
+#include "alloy/common/Macros.h"
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/Buffer.hpp"
+#include "alloy/Texture.hpp"
+#include "alloy/DescriptorHeap.hpp"
+#include "alloy/SyncObjects.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace alloy
+{
+    class IGraphicsDevice;
+    class ICommandQueue;
+    class ICommandList;
+
+    // Streams texture mip chains in and out of a range of slots in a T2
+    // resource descriptor heap, under a memory budget.
+    //
+    // Every registered texture owns one heap slot. The slot always holds
+    // a sampled view of the best resident mip range; shaders index the
+    // heap with the slot returned by Register as usual.
+    //
+    // Shaders report the finest mip they wanted by InterlockedMin-ing the
+    // level into the feedback buffer, one uint per slot, indexed by
+    // slot - firstSlot. Update() reads and clears the feedback, retires
+    // finished uploads, patches descriptors and schedules new uploads
+    // by deficit, demoting unused textures to stay under budget.
+    //
+    // Uploads go through the copy queue and are released to the graphics
+    // queue, which is the queue expected to sample the heap. Devices
+    // without a copy queue copy on the graphics queue. A texture with a
+    // different resident range is a new texture; the old one is kept
+    // alive for framesInFlight updates after its slot is repatched.
+    //
+    // Not thread safe. Call everything from the thread driving Update().
+    class TextureStreamer : public common::RefCntBase {
+        DISABLE_COPY_AND_ASSIGN(TextureStreamer);
+
+    public:
+        struct Description {
+            common::sp<IResourceDescriptorHeap> heap;
+            ResourceDescriptorIndex firstSlot;
+            std::uint32_t slotCount;
+
+            // Budget for resident textures, including in-flight replacements
+            // and replaced textures kept alive for framesInFlight updates.
+            std::uint64_t memoryBudgetInBytes;
+            std::uint32_t maxUploadsPerUpdate;
+            std::uint32_t framesInFlight;
+        };
+
+        // Fills one subresource of the full-size source texture.
+        // dst is laid out with the given row and depth pitch.
+        using MipLoader = std::function<void(
+            std::uint32_t mipLevel,
+            std::uint32_t arrayLayer,
+            void* dst,
+            std::uint32_t rowPitch,
+            std::uint32_t depthPitch)>;
+
+        struct TextureDescription {
+            // Full mip chain description, as if fully resident.
+            ITexture::Description texture;
+            MipLoader loader;
+            // Number of smallest mips that are never evicted.
+            std::uint32_t minResidentMips;
+        };
+
+        struct Stats {
+            std::uint64_t residentBytes;
+            // Replaced or unregistered, kept for frames in flight
+            std::uint64_t retiredBytes;
+            std::uint64_t budgetBytes;
+            std::uint32_t registeredTextures;
+            std::uint32_t pendingUploads;
+            std::uint64_t uploadedBytes;
+            std::uint64_t promotions;
+            std::uint64_t demotions;
+        };
+
+        // Feedback value meaning "not sampled since last update"
+        static constexpr std::uint32_t kNoRequest = 0xffffffffu;
+
+    private:
+        struct _Entry {
+            bool used = false;
+            // Bumped on Unregister so stale uploads can be told apart
+            std::uint32_t generation = 0;
+            TextureDescription desc;
+
+            // First resident mip, desc.texture.mipLevels when nothing is resident yet
+            std::uint32_t residentMip;
+            common::sp<ITextureView> view;
+
+            std::uint32_t requestedMip;
+            std::uint64_t lastRequestedUpdate;
+
+            bool uploading = false;
+        };
+
+        struct _Upload {
+            std::uint32_t entryIdx;
+            std::uint32_t generation;
+            std::uint32_t firstMip;
+            // Taken at enqueue, the entry may be re-registered meanwhile
+            std::uint64_t sizeInBytes;
+            std::uint64_t signalValue;
+            common::sp<IBuffer> staging;
+            common::sp<ITextureView> view;
+            // Pending until the upload event reaches signalValue
+            common::sp<ICommandList> copyCmd;
+            common::sp<ICommandList> acquireCmd;
+        };
+
+        struct _Retired {
+            std::uint64_t retireAfterUpdate;
+            std::uint64_t sizeInBytes;
+            common::sp<ITextureView> view;
+        };
+
+        common::sp<IGraphicsDevice> _dev;
+        Description _desc;
+
+        std::vector<_Entry> _entries;
+        std::vector<std::uint32_t> _freeEntries;
+
+        ICommandQueue* _copyQueue;
+        ICommandQueue* _gfxQueue;
+
+        common::sp<IBuffer> _feedback;
+        // Signaled on the copy queue, waited by the graphics queue
+        common::sp<IEvent> _copyEvent;
+        // Signaled on the graphics queue once the texture is acquired
+        common::sp<IEvent> _uploadEvent;
+        std::uint64_t _uploadSignalValue;
+        std::deque<_Upload> _uploads;
+        std::deque<_Retired> _retired;
+
+        std::uint64_t _updateIdx;
+        std::uint64_t _residentBytes;
+        std::uint64_t _retiredBytes;
+        std::uint64_t _pendingBytes;
+        std::uint64_t _uploadedBytes;
+        std::uint64_t _promotions;
+        std::uint64_t _demotions;
+
+        TextureStreamer(const common::sp<IGraphicsDevice>& dev, const Description& desc);
+
+        static std::uint64_t _GetSizeInBytes(
+            const ITexture::Description& desc, std::uint32_t firstMip);
+
+        std::uint32_t _GetTailMip(const _Entry& entry) const;
+        std::uint32_t _GetWantedMip(const _Entry& entry) const;
+
+        void _ReadFeedback();
+        void _RetireView(_Entry& entry);
+        void _RetireUploads();
+        void _ScheduleUploads();
+        void _StartUpload(std::uint32_t entryIdx, std::uint32_t firstMip);
+
+    public:
+        ~TextureStreamer() override;
+
+        static common::sp<TextureStreamer> Make(
+            const common::sp<IGraphicsDevice>& dev,
+            const Description& desc);
+
+        // Returns the heap slot for the texture. The slot is cleared until
+        // the mip tail finishes uploading, then always holds a valid view.
+        ResourceDescriptorIndex Register(const TextureDescription& desc);
+        void Unregister(ResourceDescriptorIndex slot);
+
+        const common::sp<IBuffer>& GetFeedbackBuffer() const { return _feedback; }
+
+        // Call once per frame.
+        void Update();
+
+        Stats GetStats() const;
+    };
+
+} // namespace alloy
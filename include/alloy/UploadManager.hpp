@@ -0,0 +1,201 @@
+#pragma once
+
+#include "alloy/common/Macros.h"
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/Buffer.hpp"
+#include "alloy/Texture.hpp"
+#include "alloy/ResourceBarrier.hpp"
+#include "alloy/SyncObjects.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace alloy
+{
+    class IGraphicsDevice;
+    class ICommandQueue;
+    class ICommandList;
+
+    // Batches buffer and texture uploads onto the copy queue.
+    //
+    // Requests are queued from any thread. Update() stages them in request
+    // order into pooled host-visible pages until the per-update byte or
+    // staging time budget is spent, records the copies into one command
+    // list and submits it. Pages are recycled once the copies complete.
+    //
+    // Textures are released by the copy queue and acquired by the
+    // destination queue in ShaderReadOnly layout. Textures uploaded with
+    // a current layout are first released by the destination queue to
+    // the copy queue. Work submitted to the destination queue after the
+    // Update() that staged a request sees its data. Devices without a
+    // copy queue copy on the destination queue.
+    //
+    // Update() and the destructor must be called from one thread,
+    // GetStats() from any.
+    class UploadManager : public common::RefCntBase {
+        DISABLE_COPY_AND_ASSIGN(UploadManager);
+
+    public:
+        struct Description {
+            // Null for the graphics queue
+            ICommandQueue* dstQueue = nullptr;
+
+            std::uint64_t stagingPageSize = 4ull << 20;
+            // Idle pages kept for reuse, the rest are released
+            std::uint32_t maxIdleStagingPages = 4;
+
+            // 0 for no limit. The first request of an update always goes
+            // through, so an oversized request can't stall the queue.
+            std::uint64_t maxBytesPerUpdate = 0;
+            std::chrono::microseconds maxStagingTimePerUpdate{0};
+        };
+
+        // Fills size bytes at dst
+        using BufferLoader = std::function<void(void* dst)>;
+
+        // Fills one subresource, laid out with the given row and depth
+        // pitch. Levels and layers are those of the texture, not the view.
+        using SubresourceLoader = std::function<void(
+            std::uint32_t mipLevel,
+            std::uint32_t arrayLayer,
+            void* dst,
+            std::uint32_t rowPitch,
+            std::uint32_t depthPitch)>;
+
+        // Increasing per request, complete once the completion event
+        // reaches it.
+        using Ticket = std::uint64_t;
+
+        struct Stats {
+            std::uint32_t pendingRequests;
+            std::uint64_t pendingBytes;
+            std::uint64_t uploadedBytes;
+            std::uint64_t lastUpdateBytes;
+            std::uint32_t stagingPages;
+            std::uint32_t idleStagingPages;
+        };
+
+    private:
+        struct _Request {
+            Ticket ticket;
+            std::uint64_t stagingSize;
+
+            common::sp<IBuffer> buffer;
+            std::uint64_t bufferOffset;
+            BufferLoader bufferLoader;
+
+            common::sp<ITextureView> texture;
+            TextureLayout textureLayout;
+            SubresourceLoader textureLoader;
+        };
+
+        struct _StagingPage {
+            common::sp<IBuffer> buffer;
+            std::uint64_t size;
+        };
+
+        // Handed back by the completion event once it reaches the ticket,
+        // which the destination queue signals after the copies and acquires
+        struct _Batch {
+            Ticket ticket;
+            std::vector<_StagingPage> pages;
+            // Backends don't retain submitted command lists
+            common::sp<ICommandList> releaseCmd;
+            common::sp<ICommandList> copyCmd;
+            common::sp<ICommandList> acquireCmd;
+        };
+
+        common::sp<IGraphicsDevice> _dev;
+        Description _desc;
+        ICommandQueue* _copyQueue;
+        ICommandQueue* _dstQueue;
+
+        std::mutex _m_requests;
+        std::deque<_Request> _requests;
+        Ticket _lastTicket;
+        std::uint64_t _pendingBytes;
+
+        // Signaled on the destination queue after releasing textures to
+        // the copy queue, waited by the copy queue
+        common::sp<IEvent> _releaseEvent;
+        std::uint64_t _releaseSignalValue;
+        // Signaled on the copy queue, waited by the destination queue
+        common::sp<IEvent> _copyEvent;
+        std::uint64_t _copySignalValue;
+        // Signaled with tickets on the destination queue
+        common::sp<IEvent> _completionEvent;
+        Ticket _lastSubmittedTicket;
+
+        // Submitted batches and the ones the completion event handed
+        // back. Recycled by Update(), command pools are bound to its
+        // thread.
+        std::mutex _m_batches;
+        std::condition_variable _cvBatches;
+        std::deque<_Batch> _batches;
+        std::vector<_Batch> _retiredBatches;
+
+        // Also under _m_batches, GetStats() reads them from any thread
+        std::vector<_StagingPage> _idlePages;
+        std::uint32_t _stagingPages;
+
+        std::uint64_t _uploadedBytes;
+        std::uint64_t _lastUpdateBytes;
+
+        UploadManager(const common::sp<IGraphicsDevice>& dev, const Description& desc);
+
+        Ticket _Enqueue(_Request&& request);
+
+        bool _PopRequest(_Request& request, std::uint64_t budgetLeft);
+        void _OnTicketReached(Ticket ticket);
+        void _RecycleBatches();
+        _StagingPage _AcquirePage(std::uint64_t size);
+
+    public:
+        ~UploadManager() override;
+
+        static common::sp<UploadManager> Make(
+            const common::sp<IGraphicsDevice>& dev,
+            const Description& desc);
+
+        Ticket UploadBuffer(
+            const common::sp<IBuffer>& dst,
+            std::uint64_t dstOffset,
+            std::uint64_t size,
+            BufferLoader loader);
+
+        // Copies data right away
+        Ticket UploadBuffer(
+            const common::sp<IBuffer>& dst,
+            std::uint64_t dstOffset,
+            std::span<const std::uint8_t> data);
+
+        // Uploads every subresource of the view. Content outside the view
+        // is kept only if currentLayout isn't Undefined.
+        Ticket UploadTexture(
+            const common::sp<ITextureView>& dst,
+            SubresourceLoader loader,
+            TextureLayout currentLayout = TextureLayout::Undefined);
+
+        // Call once per frame.
+        void Update();
+
+        bool IsComplete(Ticket ticket) const {
+            return _completionEvent->GetSignaledValue() >= ticket;
+        }
+        bool WaitFromCPU(Ticket ticket) {
+            return _completionEvent->WaitFromCPU(ticket);
+        }
+
+        // Lets other queues wait on a ticket
+        const common::sp<IEvent>& GetCompletionEvent() const { return _completionEvent; }
+
+        Stats GetStats();
+    };
+
+} // namespace alloy
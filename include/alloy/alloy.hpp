@@ -12,13 +12,20 @@
 #include "FixedFunctions.hpp"
 #include "GraphicsDevice.hpp"
 #include "Helpers.hpp"
+#include "MemoryHeap.hpp"
 #include "Pipeline.hpp"
+#include "PipelineVariantCache.hpp"
 #include "ResourceFactory.hpp"
 #include "Sampler.hpp"
 #include "Shader.hpp"
 #include "SwapChain.hpp"
 #include "SwapChainSources.hpp"
 #include "Texture.hpp"
+#include "TextureStreaming.hpp"
+#include "UploadManager.hpp"
+#include "GpuProfiler.hpp"
+#include "BufferDefragmenter.hpp"
+#include "Async.hpp"
 #include "Types.hpp"
 
 /* Coordinate systems: 
@@ -20,6 +20,10 @@ namespace alloy
         const IGraphicsDevice::Options& options
     );
 
+    common::sp<IGraphicsDevice> CreateNullGraphicsDevice(
+        const IGraphicsDevice::Options& options
+    );
+
     common::sp<IGraphicsDevice> CreateDefaultGraphicsDevice(
         const IGraphicsDevice::Options& options
     );
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "alloy/GraphicsDevice.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Null backend (Backend::Null)
+//
+// Implements every interface on host memory without touching a driver:
+// buffers and textures are plain allocations, copies and mipmap
+// generation run on the CPU at submission, and every submission has
+// completed by the time
+// SubmitCommand() returns. Useful for measuring alloy's own CPU cost and
+// for running on machines with no GPU.
+//
+// GetGpuProfiler() times passes and debug groups on the host clock,
+// spanning the copies recorded inside them.
+//
+// Optionally, recorded commands are appended to a compact log at
+// submission. Each command is a header word, op << 16 | argument count,
+// followed by that many 32-bit arguments.
+
+namespace alloy
+{
+    enum class NullCommandOp : std::uint16_t {
+        Begin,
+        End,
+        BeginRenderPass,    // color target count
+        BeginComputePass,
+        BeginTransferPass,
+        EndPass,
+        Barrier,            // barrier count
+        PushDebugGroup,
+        PopDebugGroup,
+        InsertDebugMarker,
+
+        SetPipeline,
+        SetVertexBuffer,    // index
+        SetIndexBuffer,     // index format
+        SetPushConstants,   // push constant index, dword count, dword offset
+        SetResourceSet,
+        SetMutableResourceSet,
+        SetResources,       // resource count
+        SetDescriptorHeaps,
+        SetViewports,       // count
+        SetScissorRects,    // count
+        Draw,               // vertex count, instance count, first vertex, first instance
+        DrawIndexed,        // index count, instance count, first index, vertex offset, first instance
+        DispatchMesh,       // group counts
+        Dispatch,           // group counts
+
+        CopyBuffer,         // size in bytes
+        CopyBufferToTexture,// width, height, depth
+        CopyTextureToBuffer,// width, height, depth
+        CopyTexture,        // width, height, depth
+        GenerateMipmaps,
+    };
+
+    const char* GetNullCommandOpName(NullCommandOp op);
+
+    // Both are no-ops when dev wasn't created by the null backend.
+    void SetNullCommandLogEnabled(IGraphicsDevice* dev, bool enabled);
+    // Returns and clears the log of everything submitted so far.
+    std::vector<std::uint32_t> TakeNullCommandLog(IGraphicsDevice* dev);
+
+    // One command per line, for debugging.
+    std::string DumpNullCommandLog(std::span<const std::uint32_t> log);
+
+} // namespace alloy
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// CPU side tracing of alloy internals.
+//
+// VLD_TRACE_ZONE / VLD_TRACE_COUNT only compile to something when the
+// library is built with VLD_ENABLE_TRACING (ALLOY_ENABLE_TRACING in
+// CMake). Even then nothing is recorded until trace::SetEnabled(true).
+//
+// Each thread records zones into its own fixed size ring, which is
+// drained by Drain*() / FlushChromeTrace() from any one thread at a time.
+// Recording never locks; a full ring drops zones and counts them.
+
+namespace alloy::common::trace
+{
+    enum class Counter : std::uint32_t {
+        Allocations,
+        Barriers,
+        Submits,
+        DescriptorWrites,
+
+        Count
+    };
+
+    constexpr std::uint32_t kCounterCount = (std::uint32_t)Counter::Count;
+
+    struct Zone {
+        // Must outlive the trace, use string literals
+        const char* name;
+        std::uint32_t threadId;
+        std::uint64_t beginNs;
+        std::uint64_t endNs;
+    };
+
+    struct FrameCounters {
+        std::uint64_t frameIdx;
+        // Time EndFrame() was called
+        std::uint64_t endNs;
+        std::uint64_t values[kCounterCount];
+    };
+
+    namespace _detail {
+        extern std::atomic<bool> enabled;
+    }
+
+    inline bool IsEnabled() {
+        return _detail::enabled.load(std::memory_order_relaxed);
+    }
+    void SetEnabled(bool enabled);
+
+    // Steady clock, in nanoseconds
+    std::uint64_t Now();
+
+    void RecordZone(const char* name, std::uint64_t beginNs, std::uint64_t endNs);
+    void AddCount(Counter counter, std::uint64_t n = 1);
+
+    // Snapshots counters accumulated since the previous call.
+    void EndFrame();
+
+    std::vector<Zone> DrainZones();
+    std::vector<FrameCounters> DrainFrameCounters();
+    // Zones lost to full rings since startup
+    std::uint64_t GetDroppedZoneCount();
+
+    // Chrome trace event JSON, loadable in chrome://tracing and Perfetto.
+    // Zones go to one track per thread, counters to counter tracks.
+    std::string ExportChromeTrace(
+        std::span<const Zone> zones,
+        std::span<const FrameCounters> frames);
+
+    inline std::string FlushChromeTrace() {
+        auto zones = DrainZones();
+        auto frames = DrainFrameCounters();
+        return ExportChromeTrace(zones, frames);
+    }
+
+    class ScopedZone {
+        const char* _name;
+        std::uint64_t _beginNs;
+
+    public:
+        explicit ScopedZone(const char* name)
+            : _name(IsEnabled() ? name : nullptr)
+            , _beginNs(_name ? Now() : 0)
+        { }
+
+        ~ScopedZone() {
+            if(_name) RecordZone(_name, _beginNs, Now());
+        }
+
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+    };
+
+} // namespace alloy::common::trace
+
+#if defined(VLD_ENABLE_TRACING) && VLD_ENABLE_TRACING
+    #define VLD_TRACE_CONCAT_IMPL(a, b) a##b
+    #define VLD_TRACE_CONCAT(a, b) VLD_TRACE_CONCAT_IMPL(a, b)
+
+    #define VLD_TRACE_ZONE(name) \
+        ::alloy::common::trace::ScopedZone VLD_TRACE_CONCAT(_vldTraceZone, __LINE__){name}
+
+    #define VLD_TRACE_COUNT(counter, n) \
+        do { \
+            if(::alloy::common::trace::IsEnabled()) \
+                ::alloy::common::trace::AddCount( \
+                    ::alloy::common::trace::Counter::counter, (n)); \
+        } while(0)
+#else
+    #define VLD_TRACE_ZONE(name) ((void)0)
+    #define VLD_TRACE_COUNT(counter, n) ((void)0)
+#endif
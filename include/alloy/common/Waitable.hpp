@@ -1,7 +1,18 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <mutex>
 #include <condition_variable>
 
+// The latches keep all of their state in a single 32 bit word. Waiters
+// spin for a short while, then park on its address (futex,
+// WaitOnAddress). Signalers change the word and learn whether anyone is
+// parked in the same atomic operation, so signaling with nobody parked
+// never takes a lock or makes a syscall. After that operation a signaler
+// only passes the word's address to the wake call and never touches the
+// latch again: a waiter may return and destroy it right away.
+
 namespace alloy::common {
 	// AutoResetWaitableEvent ------------------------------------------------------
 
@@ -23,7 +34,7 @@ namespace alloy::common {
 		//   call to |Signal()|.
 		// * A |Signal()|, followed by a |Reset()|, may cause *no* waiting thread to
 		//   be unblocked.
-		// * We rely on pthreads's queueing for picking which waiting thread to
+		// * We rely on the OS's queueing for picking which waiting thread to
 		//   unblock, rather than enforcing FIFO ordering.
 		void Signal();
 
@@ -48,11 +59,13 @@ namespace alloy::common {
 		bool IsSignaledForTest();
 
 	private:
-		std::condition_variable cv_;
-		std::mutex mutex_;
+		static constexpr uint32_t kSignaled = 1u;
+
+		bool WaitImpl(const std::chrono::steady_clock::time_point* deadline);
 
-		// True if this event is in the signaled state.
-		bool signaled_ = false;
+		// kSignaled if this event is in the signaled state, plus the bit
+		// telling |Signal()| someone may be parked.
+		std::atomic<uint32_t> state_{0};
 
 		//Disable copy and assign
 		AutoResetLatch(const AutoResetLatch&) = delete;
@@ -94,20 +107,18 @@ namespace alloy::common {
 		bool IsSignaledForTest();
 
 	private:
-		std::condition_variable cv_;
-		std::mutex mutex_;
+		static constexpr uint32_t kSignaled = 1u;
+		static constexpr uint32_t kSignalIdStep = 2u;
 
-		// True if this event is in the signaled state.
-		bool signaled_ = false;
+		bool WaitImpl(const std::chrono::steady_clock::time_point* deadline);
 
-		// While |std::condition_variable::notify_all()| (|pthread_cond_broadcast()|)
-		// will wake all waiting threads, one has to deal with spurious wake-ups.
-		// Checking |signaled_| isn't sufficient, since another thread may have been
-		// awoken and (manually) reset |signaled_|. This is a counter that is
-		// incremented in |Signal()| before calling
-		// |std::condition_variable::notify_all()|. A waiting thread knows it was
-		// awoken if |signal_id_| is different from when it started waiting.
-		unsigned signal_id_ = 0u;
+		// The signaled bit, with a signal id above it and the parked bit on
+		// top. Checking the signaled bit isn't sufficient, since another
+		// thread may have been awoken and (manually) reset it. The id is
+		// incremented in |Signal()|, so a waiting thread knows it was awoken
+		// if the state differs from when it started waiting: |Reset()| alone
+		// can't change an unsignaled state.
+		std::atomic<uint32_t> state_{0};
 
 		//Disable copy and assign
 		ManualResetLatch(const ManualResetLatch&) = delete;
@@ -123,9 +134,10 @@ namespace alloy::common {
 	class MultiObjectLatch
 	{
 
-		int _launchCnt;
-		std::condition_variable _cv;
-		std::mutex _m;
+		// The count, plus the parked bit
+		std::atomic<uint32_t> _launchCnt;
+
+		bool _WaitImpl(const std::chrono::steady_clock::time_point* deadline);
 
 	public:
 
@@ -149,7 +161,8 @@ namespace alloy::common {
 
 		/**
 		 * \brief Notify thread finished. Latch would
-		 * be released when no thread is being waited
+		 * be released when no thread is being waited,
+		 * only that last one wakes the waiters
 		 * \param count Finished threads
 		 */
         void LaunchComplete(int count = 1);
@@ -164,5 +177,100 @@ namespace alloy::common {
 		MultiObjectLatch& operator=(const MultiObjectLatch&) = delete;
 	};
 
+
+	/**
+	 * \brief Counting semaphore. Release() hands out permits,
+	 * Acquire() blocks until it can take one
+	 */
+	class CountingSemaphore final
+	{
+
+		static constexpr uint32_t kPermitBits = 20;
+		static constexpr uint32_t kPermitMask = (1u << kPermitBits) - 1;
+		static constexpr uint32_t kWaiterOne = 1u << kPermitBits;
+
+		// Permits in the low bits, parked waiters above them, so Release()
+		// knows how many to wake from its own fetch_add
+		std::atomic<uint32_t> _state;
+
+		bool _Acquire(const std::chrono::steady_clock::time_point* deadline);
+
+	public:
+
+		explicit CountingSemaphore(int initialCount = 0);
+
+		~CountingSemaphore() = default;
+
+		/**
+		 * \brief Add permits, up to 2^20 in total. Wakes at most
+		 * one waiter per core, those wake more while permits are left
+		 * \param count Permit count
+		 */
+		void Release(int count = 1);
+
+		void Acquire();
+
+		/**
+		 * \brief Take a permit if one is available, never blocks
+		 */
+		bool TryAcquire();
+
+		/**
+		 * \brief Like Acquire(), returns true if |timeout|
+		 * expired without getting a permit
+		 */
+		bool AcquireWithTimeout(std::chrono::steady_clock::duration timeout);
+
+	private:
+		CountingSemaphore(const CountingSemaphore&) = delete;
+		CountingSemaphore& operator=(const CountingSemaphore&) = delete;
+	};
+
+
+	/**
+	 * \brief Single use fork/join barrier, like std::latch. Unlike
+	 * MultiObjectLatch the count is fixed up front, counting down
+	 * is a single fetch_sub
+	 */
+	class CountdownLatch final
+	{
+
+		// The count, plus the parked bit
+		std::atomic<uint32_t> _count;
+
+		bool _WaitImpl(const std::chrono::steady_clock::time_point* deadline);
+
+	public:
+
+		explicit CountdownLatch(int count);
+
+		~CountdownLatch() = default;
+
+		/**
+		 * \brief Releases the waiters once the count gets to 0
+		 * \param count At most what is left of the count
+		 */
+		void CountDown(int count = 1);
+
+		/**
+		 * \brief Whether the count got to 0, never blocks
+		 */
+		bool TryWait();
+
+		void Wait();
+
+		/**
+		 * \brief Like Wait(), returns true if |timeout|
+		 * expired before the count got to 0
+		 */
+		bool WaitWithTimeout(std::chrono::steady_clock::duration timeout);
+
+		void CountDownAndWait(int count = 1);
+
+	private:
+		CountdownLatch(const CountdownLatch&) = delete;
+		CountdownLatch& operator=(const CountdownLatch&) = delete;
+	};
+
     
 }
@@ -22,6 +22,7 @@ namespace alloy {
 
         virtual ITrackingCommandQueue* GetGfxCommandQueue() = 0;
         virtual ITrackingCommandQueue* GetCopyCommandQueue() = 0;
+        virtual ITrackingCommandQueue* GetComputeCommandQueue() = 0;
                
         virtual void WaitForIdle() = 0;
 
@@ -40,6 +41,8 @@ namespace alloy {
             return WaitFromCPU(expectedValue, (std::numeric_limits<std::uint32_t>::max)());
         }
 
+        virtual void OnReached(uint64_t value, IEvent::ReachedCallback callback) = 0;
+
     };
 
     class ITrackingCommandQueue {
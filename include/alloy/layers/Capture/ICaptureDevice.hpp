@@ -0,0 +1,37 @@
+#pragma once
+
+#include "alloy/GraphicsDevice.hpp"
+
+#include <string>
+
+namespace alloy {
+
+    // Records everything issued through it into a capture file: resource
+    // creation and destruction, uploads, descriptor writes, command lists,
+    // submissions, CPU/GPU syncs and presents. Use it in place of the device
+    // it wraps, then re-execute the file with ICaptureReplayer or the
+    // alloy_replay tool.
+    //
+    // Every object it creates wraps one from the inner device, so objects
+    // of the two devices can't be mixed.
+    //
+    // Buffer uploads are found by comparing mapped buffers against a shadow
+    // copy at every submit, present and UnMap(). Capturing costs a second
+    // copy of each host-writable buffer plus reads of mapped memory.
+    class ICaptureDevice : public IGraphicsDevice {
+    public:
+
+        // Null if the file can't be created
+        static common::sp<ICaptureDevice> Make(
+            const common::sp<IGraphicsDevice>& dev,
+            const std::string& path);
+
+        // Frame boundary for applications that don't present.
+        // PresentToSwapChain() marks one implicitly.
+        virtual void EndFrame() = 0;
+
+        // Writes buffered records out. Also done on destruction.
+        virtual void Flush() = 0;
+    };
+
+} // namespace alloy
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/GraphicsDevice.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace alloy {
+
+    // Re-executes a file written by ICaptureDevice on any device, one frame
+    // at a time. Swap chains are replaced by offscreen render targets of
+    // the same size and format, so no window is needed.
+    //
+    // For GPU time per pass, enable the device's IGpuProfiler before
+    // replaying; frame boundaries are forwarded to it.
+    class ICaptureReplayer : public common::RefCntBase {
+    public:
+
+        struct PassStats {
+            // Innermost debug group around the pass, else the pass type
+            std::string name;
+            // CPU time spent re-recording the pass
+            std::uint64_t recordNs;
+        };
+
+        struct FrameStats {
+            std::uint64_t frameIdx;
+            // From the previous frame boundary, including CPU waits on GPU
+            std::uint64_t wallNs;
+            // Re-recording and submitting command lists
+            std::uint64_t recordNs;
+            std::uint32_t submits;
+            std::uint32_t draws;
+            std::uint32_t dispatches;
+            std::vector<PassStats> passes;
+        };
+
+        // Null if the file can't be opened or isn't a capture
+        static common::sp<ICaptureReplayer> Make(
+            const common::sp<IGraphicsDevice>& dev,
+            const std::string& path);
+
+        // Replays up to and including the next frame boundary. Records
+        // after the last boundary come back as a final partial frame.
+        // Returns false once the capture is exhausted, or on a malformed
+        // record or a failed object creation, see GetError().
+        virtual bool ReplayFrame(FrameStats& stats) = 0;
+
+        // Empty unless replay stopped on an error
+        virtual const std::string& GetError() const = 0;
+    };
+
+} // namespace alloy
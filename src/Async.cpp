@@ -0,0 +1,67 @@
+#include "alloy/Async.hpp"
+
+#include "alloy/CommandQueue.hpp"
+#include "alloy/GraphicsDevice.hpp"
+#include "alloy/ResourceFactory.hpp"
+
+namespace alloy::async
+{
+    ThreadPoolScheduler::ThreadPoolScheduler(std::uint32_t threadCnt)
+        : _stop(false)
+    {
+        if(threadCnt == 0) threadCnt = 1;
+        for(std::uint32_t i = 0; i < threadCnt; i++)
+            _workers.emplace_back([this]() { _WorkerMain(); });
+    }
+
+    ThreadPoolScheduler::~ThreadPoolScheduler() {
+        {
+            std::scoped_lock lk{_m};
+            _stop = true;
+        }
+        _cv.notify_all();
+        for(auto& t : _workers)
+            t.join();
+    }
+
+    void ThreadPoolScheduler::Post(std::coroutine_handle<> handle) {
+        {
+            std::scoped_lock lk{_m};
+            _ready.push_back(handle);
+        }
+        _cv.notify_one();
+    }
+
+    void ThreadPoolScheduler::_WorkerMain() {
+        std::unique_lock lk{_m};
+        for(;;) {
+            _cv.wait(lk, [&]() { return _stop || !_ready.empty(); });
+            if(_ready.empty()) return;
+
+            auto handle = _ready.front();
+            _ready.pop_front();
+
+            lk.unlock();
+            handle.resume();
+            lk.lock();
+        }
+    }
+
+    Queue::Queue(IGraphicsDevice& dev, ICommandQueue* queue)
+        : _queue(queue)
+        , _event(dev.GetResourceFactory().CreateSyncEvent())
+        , _lastSignaled(0)
+    { }
+
+    EventAwaiter Queue::Submit(ICommandList* cmd, Scheduler* scheduler) {
+        std::uint64_t value;
+        {
+            std::scoped_lock lk{_m_submit};
+            value = ++_lastSignaled;
+            _queue->SubmitCommand(cmd);
+            _queue->EncodeSignalEvent(_event.get(), value);
+        }
+        return EventAwaiter(_event, value, scheduler);
+    }
+
+} // namespace alloy::async
@@ -31,6 +31,15 @@ namespace alloy
     }
 #endif
 
+#ifndef VLD_BACKEND_NULL
+    common::sp<IGraphicsDevice> CreateNullGraphicsDevice(
+        const IGraphicsDevice::Options& options
+    ){
+        assert(false);
+        return nullptr;
+    }
+#endif
+
     common::sp<IGraphicsDevice> CreateDefaultGraphicsDevice(
         const IGraphicsDevice::Options& options
     ){
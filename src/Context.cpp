@@ -25,6 +25,13 @@ namespace alloy {
     ;
 #endif
 
+    common::sp<IContext> CreateNullContext( const IContext::Options& opts)
+#ifndef VLD_BACKEND_NULL
+    { return nullptr; }
+#else
+    ;
+#endif
+
 
     common::sp<IContext> IContext::CreateDefault(const IContext::Options& opts) {
 
@@ -44,6 +51,7 @@ namespace alloy {
         case Backend::DX12:   return CreateDX12Context(opts);
         case Backend::Vulkan: return CreateVulkanContext(opts);
         case Backend::Metal:  return CreateMetalContext(opts);
+        case Backend::Null:   return CreateNullContext(opts);
         default: return nullptr;
         }
     }
@@ -0,0 +1,36 @@
+#include "alloy/GpuProfiler.hpp"
+
+#include "utils/ChromeTraceWriter.hpp"
+
+namespace alloy
+{
+    namespace {
+        const char* GetQueueName(std::uint32_t queue) {
+            switch(queue) {
+            case 0: return "Graphics queue";
+            case 1: return "Copy queue";
+            case 2: return "Compute queue";
+            default: return "Queue";
+            }
+        }
+    }
+
+    std::string ExportChromeTrace(std::span<const IGpuProfiler::Frame> frames) {
+        utils::ChromeTraceWriter writer;
+
+        for(std::uint32_t queue = 0; queue < 3; ++queue) {
+            writer.TrackName(queue, GetQueueName(queue));
+        }
+
+        for(auto& frame : frames) {
+            for(auto& scope : frame.scopes) {
+                writer.Complete(
+                    scope.name, scope.queue, scope.beginNs, scope.endNs,
+                    "frame", frame.frameIdx);
+            }
+        }
+
+        return writer.Finish();
+    }
+
+} // namespace alloy
@@ -1,8 +1,49 @@
 #include "alloy/GraphicsDevice.hpp"
 
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
 namespace alloy
 {
+    bool IGraphicsDevice::WaitForEvents(
+        std::span<const EventWait> waits,
+        bool waitAll,
+        uint32_t timeoutMs
+    ) {
+        if(waits.empty()) return true;
+        if(waits.size() == 1) return waits[0].event->WaitFromCPU(waits[0].value, timeoutMs);
 
+        // Callbacks may outlive a timed out wait
+        struct State {
+            std::mutex m;
+            std::condition_variable cv;
+            size_t reached = 0;
+        };
+        auto state = std::make_shared<State>();
 
-} // namespace alloy
+        for(auto& w : waits) {
+            w.event->OnReached(w.value, [state](bool reached) {
+                // Destroyed before reaching it, that one never completes
+                if(!reached) return;
+                {
+                    std::scoped_lock lk{state->m};
+                    state->reached++;
+                }
+                state->cv.notify_all();
+            });
+        }
+
+        const size_t needed = waitAll ? waits.size() : 1;
+        auto done = [&]() { return state->reached >= needed; };
 
+        std::unique_lock lk{state->m};
+        if(timeoutMs == (std::numeric_limits<std::uint32_t>::max)()) {
+            state->cv.wait(lk, done);
+            return true;
+        }
+        return state->cv.wait_for(lk, std::chrono::milliseconds(timeoutMs), done);
+    }
+
+} // namespace alloy
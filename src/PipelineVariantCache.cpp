@@ -0,0 +1,141 @@
+#include "alloy/PipelineVariantCache.hpp"
+
+#include "alloy/GraphicsDevice.hpp"
+#include "alloy/ResourceFactory.hpp"
+#include "alloy/Helpers.hpp"
+#include "alloy/common/Trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace alloy
+{
+    namespace {
+
+        std::vector<SpecializationConstant>& _Specializations(GraphicsPipelineDescription& desc) {
+            return desc.shaderSet.specializations;
+        }
+        std::vector<SpecializationConstant>& _Specializations(ComputePipelineDescription& desc) {
+            return desc.specializations;
+        }
+        std::vector<SpecializationConstant>& _Specializations(MeshShaderPipelineDescription& desc) {
+            return desc.specializations;
+        }
+
+        common::sp<IGfxPipeline> _Create(
+            ResourceFactory& factory, const GraphicsPipelineDescription& desc
+        ) {
+            return factory.CreateGraphicsPipeline(desc);
+        }
+        common::sp<IComputePipeline> _Create(
+            ResourceFactory& factory, const ComputePipelineDescription& desc
+        ) {
+            return factory.CreateComputePipeline(desc);
+        }
+        common::sp<IMeshShaderPipeline> _Create(
+            ResourceFactory& factory, const MeshShaderPipelineDescription& desc
+        ) {
+            return factory.CreateMeshShaderPipeline(desc);
+        }
+
+        // Overrides applied on top of the base, sorted by id
+        std::vector<SpecializationConstant> _Merge(
+            const std::vector<SpecializationConstant>& base,
+            std::span<const SpecializationConstant> overrides
+        ) {
+            std::vector<SpecializationConstant> res { overrides.begin(), overrides.end() };
+            for(auto& c : base) {
+                auto it = std::find_if(res.begin(), res.end(),
+                    [&](auto& o) { return o.id == c.id; });
+                if(it == res.end()) res.push_back(c);
+            }
+            std::sort(res.begin(), res.end(),
+                [](auto& a, auto& b) { return a.id < b.id; });
+            return res;
+        }
+
+        // Only the bytes of the value's type, the rest of data is unused
+        std::string _MakeKey(const std::vector<SpecializationConstant>& constants) {
+            std::string key;
+            for(auto& c : constants) {
+                std::uint64_t value = 0;
+                std::memcpy(&value, &c.data, FormatHelpers::GetSizeInBytes(c.type));
+                key.append((const char*)&c.id, sizeof(c.id));
+                key.append((const char*)&c.type, sizeof(c.type));
+                key.append((const char*)&value, sizeof(value));
+            }
+            return key;
+        }
+    }
+
+    template<typename Desc, typename Pipeline>
+    PipelineVariantCache<Desc, Pipeline>::PipelineVariantCache(
+        const common::sp<IGraphicsDevice>& dev,
+        const Desc& base
+    )
+        : _dev(dev)
+        , _base(base)
+    { }
+
+    template<typename Desc, typename Pipeline>
+    PipelineVariantCache<Desc, Pipeline>::~PipelineVariantCache() { }
+
+    template<typename Desc, typename Pipeline>
+    common::sp<PipelineVariantCache<Desc, Pipeline>> PipelineVariantCache<Desc, Pipeline>::Make(
+        const common::sp<IGraphicsDevice>& dev,
+        const Desc& base
+    ) {
+        return common::sp(new PipelineVariantCache(dev, base));
+    }
+
+    template<typename Desc, typename Pipeline>
+    common::sp<Pipeline> PipelineVariantCache<Desc, Pipeline>::Get(
+        std::span<const SpecializationConstant> constants
+    ) {
+        auto merged = _Merge(_Specializations(_base), constants);
+        auto key = _MakeKey(merged);
+
+        std::unique_lock lk{_m_variants};
+        auto [it, inserted] = _variants.try_emplace(std::move(key));
+        // Map nodes don't move and variants are never erased, the entry
+        // stays put while unlocked
+        auto& variant = it->second;
+        if(!inserted) {
+            _cvVariants.wait(lk, [&]() { return variant.ready; });
+            if(variant.pipeline)
+                return variant.pipeline;
+            // Failed before, this call retries
+            variant.ready = false;
+        }
+        lk.unlock();
+
+        common::sp<Pipeline> pipeline;
+        {
+            VLD_TRACE_ZONE("PipelineVariantCache::Create");
+            auto desc = _base;
+            _Specializations(desc) = std::move(merged);
+            pipeline = _Create(_dev->GetResourceFactory(), desc);
+        }
+
+        lk.lock();
+        variant.pipeline = pipeline;
+        variant.ready = true;
+        lk.unlock();
+        _cvVariants.notify_all();
+
+        return pipeline;
+    }
+
+    template<typename Desc, typename Pipeline>
+    std::size_t PipelineVariantCache<Desc, Pipeline>::GetVariantCount() {
+        std::scoped_lock lk{_m_variants};
+        return std::count_if(_variants.begin(), _variants.end(),
+            [](auto& v) { return v.second.pipeline != nullptr; });
+    }
+
+    template class PipelineVariantCache<GraphicsPipelineDescription, IGfxPipeline>;
+    template class PipelineVariantCache<ComputePipelineDescription, IComputePipeline>;
+    template class PipelineVariantCache<MeshShaderPipelineDescription, IMeshShaderPipeline>;
+
+} // namespace alloy
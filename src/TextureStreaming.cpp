@@ -0,0 +1,453 @@
+#include "alloy/TextureStreaming.hpp"
+
+#include "alloy/GraphicsDevice.hpp"
+#include "alloy/CommandQueue.hpp"
+#include "alloy/ResourceFactory.hpp"
+#include "alloy/ResourceBarrier.hpp"
+#include "alloy/Helpers.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace alloy
+{
+    namespace {
+        // D3D12 placement and row pitch alignment, also fine for Vulkan
+        constexpr std::uint64_t kStagingOffsetAlignment = 512;
+        constexpr std::uint32_t kStagingRowPitchAlignment = 256;
+
+        template<typename T>
+        T AlignUp(T value, T alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        std::uint32_t MipDim(std::uint32_t dim, std::uint32_t mipLevel) {
+            return std::max(1u, dim >> mipLevel);
+        }
+    }
+
+    TextureStreamer::TextureStreamer(
+        const common::sp<IGraphicsDevice>& dev,
+        const Description& desc
+    )
+        : _dev(dev)
+        , _desc(desc)
+        , _uploadSignalValue(0)
+        , _updateIdx(0)
+        , _residentBytes(0)
+        , _retiredBytes(0)
+        , _pendingBytes(0)
+        , _uploadedBytes(0)
+        , _promotions(0)
+        , _demotions(0)
+    {
+        _gfxQueue = _dev->GetGfxCommandQueue();
+        _copyQueue = _dev->GetCopyCommandQueue();
+        if(!_copyQueue) _copyQueue = _gfxQueue;
+
+        auto& factory = _dev->GetResourceFactory();
+
+        IBuffer::Description feedbackDesc{};
+        feedbackDesc.sizeInBytes = _desc.slotCount * sizeof(std::uint32_t);
+        feedbackDesc.usage.structuredBufferReadWrite = 1;
+        feedbackDesc.hostAccess = HostAccess::SystemMemoryPreferRead;
+        _feedback = factory.CreateBuffer(feedbackDesc);
+
+        auto feedbackPtr = static_cast<std::uint32_t*>(_feedback->MapToCPU());
+        std::fill_n(feedbackPtr, _desc.slotCount, kNoRequest);
+        _feedback->UnMap();
+
+        _copyEvent = factory.CreateSyncEvent();
+        _uploadEvent = factory.CreateSyncEvent();
+
+        _entries.resize(_desc.slotCount);
+        _freeEntries.reserve(_desc.slotCount);
+        for(std::uint32_t i = _desc.slotCount; i > 0; --i) {
+            _freeEntries.push_back(i - 1);
+        }
+    }
+
+    TextureStreamer::~TextureStreamer() {
+        // Staging buffers and command lists must outlive the uploads
+        _uploadEvent->WaitFromCPU(_uploadSignalValue);
+    }
+
+    common::sp<TextureStreamer> TextureStreamer::Make(
+        const common::sp<IGraphicsDevice>& dev,
+        const Description& desc
+    ) {
+        assert(desc.heap);
+        assert(desc.firstSlot.IsValid());
+        assert(desc.firstSlot.value + desc.slotCount <= desc.heap->GetDesc().capacity);
+
+        return common::sp(new TextureStreamer(dev, desc));
+    }
+
+    std::uint64_t TextureStreamer::_GetSizeInBytes(
+        const ITexture::Description& desc,
+        std::uint32_t firstMip
+    ) {
+        std::uint64_t size = 0;
+        for(std::uint32_t mip = firstMip; mip < desc.mipLevels; ++mip) {
+            size += std::uint64_t(FormatHelpers::GetRegionSize(
+                MipDim(desc.width, mip),
+                MipDim(desc.height, mip),
+                MipDim(desc.depth, mip),
+                desc.format)) * desc.arrayLayers;
+        }
+        return size;
+    }
+
+    std::uint32_t TextureStreamer::_GetTailMip(const _Entry& entry) const {
+        auto mipLevels = entry.desc.texture.mipLevels;
+        auto tailMips = std::clamp(entry.desc.minResidentMips, 1u, mipLevels);
+        return mipLevels - tailMips;
+    }
+
+    std::uint32_t TextureStreamer::_GetWantedMip(const _Entry& entry) const {
+        auto tailMip = _GetTailMip(entry);
+        // Requests older than the frames in flight are stale
+        bool recentlyRequested = entry.requestedMip != kNoRequest
+            && _updateIdx - entry.lastRequestedUpdate <= _desc.framesInFlight;
+        if(!recentlyRequested) return tailMip;
+
+        return std::min(entry.requestedMip, tailMip);
+    }
+
+    ResourceDescriptorIndex TextureStreamer::Register(const TextureDescription& desc) {
+        assert(!_freeEntries.empty());
+        assert(desc.texture.mipLevels > 0);
+        assert(desc.loader);
+
+        auto idx = _freeEntries.back();
+        _freeEntries.pop_back();
+
+        auto& entry = _entries[idx];
+        entry.used = true;
+        entry.desc = desc;
+        entry.residentMip = desc.texture.mipLevels;
+        entry.view = nullptr;
+        entry.requestedMip = kNoRequest;
+        entry.lastRequestedUpdate = 0;
+        entry.uploading = false;
+
+        auto slot = _desc.firstSlot + idx;
+        _desc.heap->Clear(slot);
+
+        // The tail is always resident, regardless of the budget
+        _StartUpload(idx, _GetTailMip(entry));
+
+        return slot;
+    }
+
+    void TextureStreamer::Unregister(ResourceDescriptorIndex slot) {
+        auto idx = slot.value - _desc.firstSlot.value;
+        assert(idx < _desc.slotCount && _entries[idx].used);
+
+        auto& entry = _entries[idx];
+        if(entry.view) _RetireView(entry);
+
+        _desc.heap->Clear(slot);
+
+        entry.used = false;
+        entry.generation++;
+        entry.desc.loader = nullptr;
+        _freeEntries.push_back(idx);
+    }
+
+    void TextureStreamer::_RetireView(_Entry& entry) {
+        auto size = _GetSizeInBytes(entry.desc.texture, entry.residentMip);
+        _residentBytes -= size;
+        // Frames in flight may still sample the old texture, it holds its
+        // memory until dropped
+        _retiredBytes += size;
+        _retired.push_back({_updateIdx + _desc.framesInFlight, size, std::move(entry.view)});
+    }
+
+    void TextureStreamer::_StartUpload(std::uint32_t entryIdx, std::uint32_t firstMip) {
+        auto& entry = _entries[entryIdx];
+        auto& srcDesc = entry.desc.texture;
+        auto& factory = _dev->GetResourceFactory();
+
+        ITexture::Description texDesc = srcDesc;
+        texDesc.width = MipDim(srcDesc.width, firstMip);
+        texDesc.height = MipDim(srcDesc.height, firstMip);
+        texDesc.depth = MipDim(srcDesc.depth, firstMip);
+        texDesc.mipLevels = srcDesc.mipLevels - firstMip;
+        texDesc.usage.sampled = 1;
+        texDesc.hostAccess = HostAccess::PreferDeviceMemory;
+
+        auto texture = factory.CreateTexture(texDesc);
+        auto view = factory.CreateTextureView(texture);
+
+        struct _Region {
+            std::uint64_t offset;
+            std::uint32_t rowPitch;
+            std::uint32_t depthPitch;
+            Size3D size;
+        };
+
+        std::vector<_Region> regions;
+        regions.reserve(texDesc.mipLevels * texDesc.arrayLayers);
+
+        std::uint64_t stagingSize = 0;
+        for(std::uint32_t mip = 0; mip < texDesc.mipLevels; ++mip) {
+            Size3D size {
+                MipDim(texDesc.width, mip),
+                MipDim(texDesc.height, mip),
+                MipDim(texDesc.depth, mip)
+            };
+            auto rowPitch = AlignUp(
+                FormatHelpers::GetRowPitch(size.width, texDesc.format),
+                kStagingRowPitchAlignment);
+            auto depthPitch = FormatHelpers::GetDepthPitch(rowPitch, size.height, texDesc.format);
+
+            for(std::uint32_t layer = 0; layer < texDesc.arrayLayers; ++layer) {
+                stagingSize = AlignUp(stagingSize, kStagingOffsetAlignment);
+                regions.push_back({stagingSize, rowPitch, depthPitch, size});
+                stagingSize += std::uint64_t(depthPitch) * size.depth;
+            }
+        }
+
+        IBuffer::Description stagingDesc{};
+        stagingDesc.sizeInBytes = stagingSize;
+        stagingDesc.usage.structuredBufferReadOnly = 1;
+        stagingDesc.hostAccess = HostAccess::SystemMemoryPreferWrite;
+        auto staging = factory.CreateBuffer(stagingDesc);
+
+        auto stagingPtr = static_cast<std::uint8_t*>(staging->MapToCPU());
+        for(std::uint32_t mip = 0; mip < texDesc.mipLevels; ++mip) {
+            for(std::uint32_t layer = 0; layer < texDesc.arrayLayers; ++layer) {
+                auto& region = regions[mip * texDesc.arrayLayers + layer];
+                entry.desc.loader(
+                    firstMip + mip, layer,
+                    stagingPtr + region.offset,
+                    region.rowPitch, region.depthPitch);
+            }
+        }
+        staging->UnMap();
+
+        BarrierOp barrier[1] = {{TextureBarrierOp{
+            .texture = view,
+            .from = {
+                .stages = {},
+                .access = {},
+                .layout = TextureLayout::Undefined,
+            },
+            .to = {
+                .stages = PipelineStage::Copy,
+                .access = ResourceAccess::CopyDest,
+                .layout = TextureLayout::CopyDest,
+            }
+        }}};
+
+        auto cmd = _copyQueue->CreateCommandList();
+        cmd->Begin();
+        cmd->Barrier(barrier);
+
+        auto& pass = cmd->BeginTransferPass();
+        for(std::uint32_t mip = 0; mip < texDesc.mipLevels; ++mip) {
+            for(std::uint32_t layer = 0; layer < texDesc.arrayLayers; ++layer) {
+                auto& region = regions[mip * texDesc.arrayLayers + layer];
+                pass.CopyBufferToTexture(
+                    BufferRange::MakeByteBuffer(
+                        staging, region.offset, std::uint64_t(region.depthPitch) * region.size.depth),
+                    region.rowPitch,
+                    region.depthPitch,
+                    view,
+                    {0, 0, 0},
+                    mip,
+                    layer,
+                    region.size);
+            }
+        }
+        cmd->EndPass();
+
+        // Released by the copy queue, acquired by the graphics queue
+        TextureBarrierOp release {
+            .texture = view,
+            .from = {
+                .stages = PipelineStage::Copy,
+                .access = ResourceAccess::CopyDest,
+                .layout = TextureLayout::CopyDest,
+            },
+            .to = {
+                .stages = PipelineStage::AllShaders,
+                .access = ResourceAccess::ShaderResourceRead,
+                .layout = TextureLayout::ShaderReadOnly,
+            }
+        };
+        bool separateQueues = _copyQueue != _gfxQueue;
+        if(separateQueues) release.queueTransfer = { _copyQueue, _gfxQueue };
+        barrier[0] = release;
+        cmd->Barrier(barrier);
+        cmd->End();
+
+        ++_uploadSignalValue;
+        _copyQueue->SubmitCommand(cmd.get());
+
+        common::sp<ICommandList> acquireCmd;
+        if(separateQueues) {
+            _copyQueue->EncodeSignalEvent(_copyEvent.get(), _uploadSignalValue);
+            _gfxQueue->EncodeWaitForEvent(_copyEvent.get(), _uploadSignalValue);
+
+            acquireCmd = _gfxQueue->CreateCommandList();
+            acquireCmd->Begin();
+            acquireCmd->Barrier(barrier);
+            acquireCmd->End();
+            _gfxQueue->SubmitCommand(acquireCmd.get());
+        }
+        _gfxQueue->EncodeSignalEvent(_uploadEvent.get(), _uploadSignalValue);
+
+        auto textureSize = _GetSizeInBytes(srcDesc, firstMip);
+        _pendingBytes += textureSize;
+        _uploadedBytes += textureSize;
+
+        entry.uploading = true;
+
+        _uploads.push_back({
+            entryIdx, entry.generation, firstMip, textureSize, _uploadSignalValue,
+            std::move(staging), std::move(view), std::move(cmd), std::move(acquireCmd)});
+    }
+
+    void TextureStreamer::_ReadFeedback() {
+        auto feedbackPtr = static_cast<std::uint32_t*>(_feedback->MapToCPU());
+        // GPU may still be writing frames in flight. Feedback is advisory,
+        // a lost request is simply seen again next frame.
+        for(std::uint32_t i = 0; i < _desc.slotCount; ++i) {
+            auto requested = feedbackPtr[i];
+            feedbackPtr[i] = kNoRequest;
+
+            auto& entry = _entries[i];
+            if(!entry.used || requested == kNoRequest) continue;
+
+            entry.requestedMip = std::min(requested, entry.desc.texture.mipLevels - 1);
+            entry.lastRequestedUpdate = _updateIdx;
+        }
+        _feedback->UnMap();
+    }
+
+    void TextureStreamer::_RetireUploads() {
+        auto signaled = _uploadEvent->GetSignaledValue();
+
+        while(!_uploads.empty() && _uploads.front().signalValue <= signaled) {
+            auto upload = std::move(_uploads.front());
+            _uploads.pop_front();
+
+            _pendingBytes -= upload.sizeInBytes;
+
+            // Unregistered while uploading
+            auto& entry = _entries[upload.entryIdx];
+            if(!entry.used || entry.generation != upload.generation) continue;
+
+            _desc.heap->Write(
+                _desc.firstSlot + upload.entryIdx,
+                SampledTextureDescriptor{upload.view});
+
+            if(entry.view) {
+                if(upload.firstMip < entry.residentMip) _promotions++;
+                else                                    _demotions++;
+
+                _RetireView(entry);
+            }
+
+            _residentBytes += upload.sizeInBytes;
+            entry.view = std::move(upload.view);
+            entry.residentMip = upload.firstMip;
+            entry.uploading = false;
+        }
+
+        while(!_retired.empty() && _retired.front().retireAfterUpdate <= _updateIdx) {
+            _retiredBytes -= _retired.front().sizeInBytes;
+            _retired.pop_front();
+        }
+    }
+
+    void TextureStreamer::_ScheduleUploads() {
+        std::vector<std::uint32_t> promotions;
+        std::vector<std::uint32_t> demotions;
+
+        for(std::uint32_t i = 0; i < _desc.slotCount; ++i) {
+            auto& entry = _entries[i];
+            if(!entry.used || entry.uploading) continue;
+
+            auto wanted = _GetWantedMip(entry);
+            if(wanted < entry.residentMip)      promotions.push_back(i);
+            else if(wanted > entry.residentMip) demotions.push_back(i);
+        }
+
+        // Largest mip deficit first
+        std::sort(promotions.begin(), promotions.end(), [&](auto a, auto b) {
+            auto deficitA = _entries[a].residentMip - _GetWantedMip(_entries[a]);
+            auto deficitB = _entries[b].residentMip - _GetWantedMip(_entries[b]);
+            return deficitA > deficitB;
+        });
+
+        // Least recently requested first
+        std::sort(demotions.begin(), demotions.end(), [&](auto a, auto b) {
+            return _entries[a].lastRequestedUpdate < _entries[b].lastRequestedUpdate;
+        });
+
+        std::uint32_t uploads = 0;
+        bool outOfBudget = false;
+
+        for(auto idx : promotions) {
+            if(uploads >= _desc.maxUploadsPerUpdate) break;
+
+            auto& entry = _entries[idx];
+            // Old texture stays resident until the new one lands, so both count,
+            // and so do retired ones still held for frames in flight. Settle
+            // for a partial promotion if the full one doesn't fit.
+            bool started = false;
+            for(auto mip = _GetWantedMip(entry); mip < entry.residentMip; ++mip) {
+                auto need = _GetSizeInBytes(entry.desc.texture, mip);
+                if(_residentBytes + _retiredBytes + _pendingBytes + need
+                    <= _desc.memoryBudgetInBytes
+                ) {
+                    _StartUpload(idx, mip);
+                    uploads++;
+                    started = true;
+                    break;
+                }
+            }
+
+            if(!started) {
+                outOfBudget = true;
+                break;
+            }
+        }
+
+        if(!outOfBudget && _residentBytes + _pendingBytes <= _desc.memoryBudgetInBytes)
+            return;
+
+        // Make room for the next updates
+        for(auto idx : demotions) {
+            if(uploads >= _desc.maxUploadsPerUpdate) break;
+
+            _StartUpload(idx, _GetWantedMip(_entries[idx]));
+            uploads++;
+        }
+    }
+
+    void TextureStreamer::Update() {
+        _updateIdx++;
+
+        _RetireUploads();
+        _ReadFeedback();
+        _ScheduleUploads();
+    }
+
+    TextureStreamer::Stats TextureStreamer::GetStats() const {
+        Stats stats{};
+        stats.residentBytes = _residentBytes;
+        stats.retiredBytes = _retiredBytes;
+        stats.budgetBytes = _desc.memoryBudgetInBytes;
+        stats.registeredTextures = _desc.slotCount - _freeEntries.size();
+        stats.pendingUploads = _uploads.size();
+        stats.uploadedBytes = _uploadedBytes;
+        stats.promotions = _promotions;
+        stats.demotions = _demotions;
+        return stats;
+    }
+
+} // namespace alloy
@@ -0,0 +1,450 @@
+#include "alloy/UploadManager.hpp"
+
+#include "alloy/GraphicsDevice.hpp"
+#include "alloy/CommandQueue.hpp"
+#include "alloy/ResourceFactory.hpp"
+#include "alloy/Helpers.hpp"
+#include "alloy/common/Trace.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace alloy
+{
+    namespace {
+        // D3D12 placement and row pitch alignment, also fine for Vulkan
+        constexpr std::uint64_t kStagingOffsetAlignment = 512;
+        constexpr std::uint32_t kStagingRowPitchAlignment = 256;
+
+        template<typename T>
+        T AlignUp(T value, T alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        std::uint32_t MipDim(std::uint32_t dim, std::uint32_t mipLevel) {
+            return std::max(1u, dim >> mipLevel);
+        }
+
+        // Calls fn(mipLevel, arrayLayer, offset, rowPitch, depthPitch, size)
+        // for every subresource of the view, levels and layers relative to
+        // the view. Returns the staging size.
+        template<typename Fn>
+        std::uint64_t ForEachSubresource(const ITextureView& view, Fn&& fn) {
+            auto& viewDesc = view.GetDesc();
+            auto& texDesc = view.GetTextureObject()->GetDesc();
+
+            std::uint64_t offset = 0;
+            for(std::uint32_t mip = 0; mip < viewDesc.mipLevels; ++mip) {
+                auto texMip = viewDesc.baseMipLevel + mip;
+                Size3D size {
+                    MipDim(texDesc.width, texMip),
+                    MipDim(texDesc.height, texMip),
+                    MipDim(texDesc.depth, texMip)
+                };
+                auto rowPitch = AlignUp(
+                    FormatHelpers::GetRowPitch(size.width, texDesc.format),
+                    kStagingRowPitchAlignment);
+                auto depthPitch = FormatHelpers::GetDepthPitch(rowPitch, size.height, texDesc.format);
+
+                for(std::uint32_t layer = 0; layer < viewDesc.arrayLayers; ++layer) {
+                    offset = AlignUp(offset, kStagingOffsetAlignment);
+                    fn(mip, layer, offset, rowPitch, depthPitch, size);
+                    offset += std::uint64_t(depthPitch) * size.depth;
+                }
+            }
+            return offset;
+        }
+    }
+
+    UploadManager::UploadManager(
+        const common::sp<IGraphicsDevice>& dev,
+        const Description& desc
+    )
+        : _dev(dev)
+        , _desc(desc)
+        , _lastTicket(0)
+        , _pendingBytes(0)
+        , _releaseSignalValue(0)
+        , _copySignalValue(0)
+        , _lastSubmittedTicket(0)
+        , _stagingPages(0)
+        , _uploadedBytes(0)
+        , _lastUpdateBytes(0)
+    {
+        _dstQueue = _desc.dstQueue ? _desc.dstQueue : _dev->GetGfxCommandQueue();
+        _copyQueue = _dev->GetCopyCommandQueue();
+        if(!_copyQueue) _copyQueue = _dstQueue;
+
+        auto& factory = _dev->GetResourceFactory();
+        _releaseEvent = factory.CreateSyncEvent();
+        _copyEvent = factory.CreateSyncEvent();
+        _completionEvent = factory.CreateSyncEvent();
+    }
+
+    UploadManager::~UploadManager() {
+        // Staging pages and command lists must outlive the uploads, and
+        // the callbacks must be done with this
+        std::unique_lock lock(_m_batches);
+        _cvBatches.wait(lock, [this]() { return _batches.empty(); });
+    }
+
+    common::sp<UploadManager> UploadManager::Make(
+        const common::sp<IGraphicsDevice>& dev,
+        const Description& desc
+    ) {
+        assert(desc.stagingPageSize > 0);
+        return common::sp(new UploadManager(dev, desc));
+    }
+
+    UploadManager::Ticket UploadManager::_Enqueue(_Request&& request) {
+        std::lock_guard lock(_m_requests);
+        request.ticket = ++_lastTicket;
+        _pendingBytes += request.stagingSize;
+        _requests.push_back(std::move(request));
+        return _lastTicket;
+    }
+
+    UploadManager::Ticket UploadManager::UploadBuffer(
+        const common::sp<IBuffer>& dst,
+        std::uint64_t dstOffset,
+        std::uint64_t size,
+        BufferLoader loader
+    ) {
+        assert(dst && loader);
+        assert(dstOffset + size <= dst->GetDesc().sizeInBytes);
+        // Copies take 32-bit sizes
+        assert(size <= std::numeric_limits<std::uint32_t>::max());
+
+        _Request request{};
+        request.stagingSize = size;
+        request.buffer = dst;
+        request.bufferOffset = dstOffset;
+        request.bufferLoader = std::move(loader);
+        return _Enqueue(std::move(request));
+    }
+
+    UploadManager::Ticket UploadManager::UploadBuffer(
+        const common::sp<IBuffer>& dst,
+        std::uint64_t dstOffset,
+        std::span<const std::uint8_t> data
+    ) {
+        return UploadBuffer(dst, dstOffset, data.size(),
+            [bytes = std::vector<std::uint8_t>(data.begin(), data.end())](void* ptr) {
+                std::memcpy(ptr, bytes.data(), bytes.size());
+            });
+    }
+
+    UploadManager::Ticket UploadManager::UploadTexture(
+        const common::sp<ITextureView>& dst,
+        SubresourceLoader loader,
+        TextureLayout currentLayout
+    ) {
+        assert(dst && loader);
+
+        _Request request{};
+        request.stagingSize = ForEachSubresource(*dst, [](auto&&...) {});
+        request.texture = dst;
+        request.textureLayout = currentLayout;
+        request.textureLoader = std::move(loader);
+        return _Enqueue(std::move(request));
+    }
+
+    bool UploadManager::_PopRequest(_Request& request, std::uint64_t budgetLeft) {
+        std::lock_guard lock(_m_requests);
+        if(_requests.empty() || _requests.front().stagingSize > budgetLeft)
+            return false;
+
+        request = std::move(_requests.front());
+        _requests.pop_front();
+        _pendingBytes -= request.stagingSize;
+        return true;
+    }
+
+    void UploadManager::_OnTicketReached(Ticket ticket) {
+        std::lock_guard lock(_m_batches);
+        while(!_batches.empty() && _batches.front().ticket <= ticket) {
+            _retiredBatches.push_back(std::move(_batches.front()));
+            _batches.pop_front();
+        }
+        // Under the lock, the destructor may run as soon as it's released
+        _cvBatches.notify_all();
+    }
+
+    void UploadManager::_RecycleBatches() {
+        std::vector<_Batch> retired;
+        {
+            std::lock_guard lock(_m_batches);
+            retired.swap(_retiredBatches);
+
+            for(auto& batch : retired) {
+                for(auto& page : batch.pages) {
+                    // Dedicated pages of oversized requests aren't pooled
+                    if(page.size == _desc.stagingPageSize
+                        && _idlePages.size() < _desc.maxIdleStagingPages
+                    ) {
+                        _idlePages.push_back(std::move(page));
+                    } else {
+                        _stagingPages--;
+                    }
+                }
+            }
+        }
+        // Dropped pages and command lists are released here, outside the lock
+    }
+
+    UploadManager::_StagingPage UploadManager::_AcquirePage(std::uint64_t size) {
+        {
+            std::lock_guard lock(_m_batches);
+            if(size <= _desc.stagingPageSize && !_idlePages.empty()) {
+                auto page = std::move(_idlePages.back());
+                _idlePages.pop_back();
+                return page;
+            }
+            _stagingPages++;
+        }
+
+        IBuffer::Description stagingDesc{};
+        stagingDesc.sizeInBytes = std::max(size, _desc.stagingPageSize);
+        stagingDesc.usage.structuredBufferReadOnly = 1;
+        stagingDesc.hostAccess = HostAccess::SystemMemoryPreferWrite;
+
+        return {
+            _dev->GetResourceFactory().CreateBuffer(stagingDesc),
+            stagingDesc.sizeInBytes
+        };
+    }
+
+    void UploadManager::Update() {
+        VLD_TRACE_ZONE("UploadManager::Update");
+        using Clock = std::chrono::steady_clock;
+
+        _RecycleBatches();
+
+        struct _Staged {
+            _Request request;
+            common::sp<IBuffer> staging;
+            std::uint64_t offset;
+        };
+        std::vector<_Staged> staged;
+
+        _Batch batch{};
+        std::uint8_t* pagePtr = nullptr;
+        std::uint64_t pageOffset = 0;
+        std::uint64_t stagedBytes = 0;
+
+        auto start = Clock::now();
+        while(true) {
+            auto budgetLeft = std::numeric_limits<std::uint64_t>::max();
+            if(!staged.empty()) {
+                auto timeBudget = _desc.maxStagingTimePerUpdate;
+                if(timeBudget.count() > 0 && Clock::now() - start >= timeBudget) break;
+                if(_desc.maxBytesPerUpdate > 0) {
+                    budgetLeft = _desc.maxBytesPerUpdate > stagedBytes
+                        ? _desc.maxBytesPerUpdate - stagedBytes : 0;
+                }
+            }
+
+            _Request request;
+            if(!_PopRequest(request, budgetLeft)) break;
+
+            auto offset = AlignUp(pageOffset, kStagingOffsetAlignment);
+            if(!pagePtr || offset + request.stagingSize > batch.pages.back().size) {
+                if(pagePtr) batch.pages.back().buffer->UnMap();
+                batch.pages.push_back(_AcquirePage(request.stagingSize));
+                pagePtr = static_cast<std::uint8_t*>(batch.pages.back().buffer->MapToCPU());
+                offset = 0;
+            }
+            pageOffset = offset + request.stagingSize;
+            stagedBytes += request.stagingSize;
+
+            auto dst = pagePtr + offset;
+            if(request.texture) {
+                auto& viewDesc = request.texture->GetDesc();
+                ForEachSubresource(*request.texture,
+                    [&](auto mip, auto layer, auto regionOffset, auto rowPitch, auto depthPitch, auto&) {
+                        request.textureLoader(
+                            viewDesc.baseMipLevel + mip,
+                            viewDesc.baseArrayLayer + layer,
+                            dst + regionOffset,
+                            rowPitch, depthPitch);
+                    });
+            } else {
+                request.bufferLoader(dst);
+            }
+
+            staged.push_back({std::move(request), batch.pages.back().buffer, offset});
+        }
+        if(pagePtr) batch.pages.back().buffer->UnMap();
+
+        {
+            std::lock_guard lock(_m_batches);
+            _lastUpdateBytes = stagedBytes;
+        }
+        if(staged.empty()) return;
+
+        bool separateQueues = _copyQueue != _dstQueue;
+
+        std::vector<BarrierOp> release;
+        std::vector<BarrierOp> preCopy;
+        std::vector<BarrierOp> postCopy;
+        for(auto& s : staged) {
+            auto& request = s.request;
+            if(request.texture) {
+                bool keepContent = request.textureLayout != TextureLayout::Undefined;
+                TextureBarrierOp pre {
+                    .texture = request.texture,
+                    .from = {
+                        // Earlier work may still read what is kept
+                        .stages = keepContent ? PipelineStage::AllCommands : PipelineStages{},
+                        .access = {},
+                        .layout = request.textureLayout,
+                    },
+                    .to = {
+                        .stages = PipelineStage::Copy,
+                        .access = ResourceAccess::CopyDest,
+                        .layout = TextureLayout::CopyDest,
+                    }
+                };
+                // Released by the destination queue, acquired by the copy
+                // queue. Undefined content has no owner to release it.
+                if(keepContent && separateQueues) {
+                    pre.queueTransfer = { _dstQueue, _copyQueue };
+                    release.push_back(pre);
+                }
+                preCopy.push_back(std::move(pre));
+                // Recorded as release on the copy queue and acquire on the
+                // destination queue when they differ
+                TextureBarrierOp post {
+                    .texture = request.texture,
+                    .from = {
+                        .stages = PipelineStage::Copy,
+                        .access = ResourceAccess::CopyDest,
+                        .layout = TextureLayout::CopyDest,
+                    },
+                    .to = {
+                        .stages = PipelineStage::AllShaders,
+                        .access = ResourceAccess::ShaderResourceRead,
+                        .layout = TextureLayout::ShaderReadOnly,
+                    }
+                };
+                if(separateQueues) post.queueTransfer = { _copyQueue, _dstQueue };
+                postCopy.push_back(std::move(post));
+            } else if(!separateQueues) {
+                // Across queues the event wait makes the copy visible
+                using common::operator|;
+                postCopy.push_back(BufferBarrierOp{
+                    .buffer = BufferRange::MakeByteBuffer(
+                        request.buffer, request.bufferOffset, request.stagingSize),
+                    .from = {
+                        .stages = PipelineStage::Copy,
+                        .access = ResourceAccess::CopyDest,
+                    },
+                    .to = {
+                        .stages = PipelineStage::AllCommands,
+                        .access = ResourceAccess::VertexBufferRead
+                            | ResourceAccess::IndexBufferRead
+                            | ResourceAccess::ConstantBufferRead
+                            | ResourceAccess::ShaderResourceRead
+                            | ResourceAccess::IndirectArgumentRead,
+                    }
+                });
+            }
+        }
+
+        if(!release.empty()) {
+            batch.releaseCmd = _dstQueue->CreateCommandList();
+            batch.releaseCmd->Begin();
+            batch.releaseCmd->Barrier(release);
+            batch.releaseCmd->End();
+            _dstQueue->SubmitCommand(batch.releaseCmd.get());
+            _dstQueue->EncodeSignalEvent(_releaseEvent.get(), ++_releaseSignalValue);
+            _copyQueue->EncodeWaitForEvent(_releaseEvent.get(), _releaseSignalValue);
+        }
+
+        auto cmd = _copyQueue->CreateCommandList();
+        cmd->Begin();
+        if(!preCopy.empty()) cmd->Barrier(preCopy);
+
+        auto& pass = cmd->BeginTransferPass();
+        for(auto& s : staged) {
+            auto& request = s.request;
+            if(request.texture) {
+                ForEachSubresource(*request.texture,
+                    [&](auto mip, auto layer, auto regionOffset, auto rowPitch, auto depthPitch, auto& size) {
+                        pass.CopyBufferToTexture(
+                            BufferRange::MakeByteBuffer(
+                                s.staging,
+                                s.offset + regionOffset,
+                                std::uint64_t(depthPitch) * size.depth),
+                            rowPitch,
+                            depthPitch,
+                            request.texture,
+                            {0, 0, 0},
+                            mip,
+                            layer,
+                            size);
+                    });
+            } else {
+                pass.CopyBuffer(
+                    BufferRange::MakeByteBuffer(s.staging, s.offset, request.stagingSize),
+                    BufferRange::MakeByteBuffer(
+                        request.buffer, request.bufferOffset, request.stagingSize),
+                    request.stagingSize);
+            }
+        }
+        cmd->EndPass();
+
+        if(!postCopy.empty()) cmd->Barrier(postCopy);
+        cmd->End();
+
+        _copyQueue->SubmitCommand(cmd.get());
+        batch.copyCmd = std::move(cmd);
+
+        if(separateQueues) {
+            _copyQueue->EncodeSignalEvent(_copyEvent.get(), ++_copySignalValue);
+            _dstQueue->EncodeWaitForEvent(_copyEvent.get(), _copySignalValue);
+            if(!postCopy.empty()) {
+                batch.acquireCmd = _dstQueue->CreateCommandList();
+                batch.acquireCmd->Begin();
+                batch.acquireCmd->Barrier(postCopy);
+                batch.acquireCmd->End();
+                _dstQueue->SubmitCommand(batch.acquireCmd.get());
+            }
+        }
+
+        _lastSubmittedTicket = staged.back().request.ticket;
+        _dstQueue->EncodeSignalEvent(_completionEvent.get(), _lastSubmittedTicket);
+
+        batch.ticket = _lastSubmittedTicket;
+        {
+            std::lock_guard lock(_m_batches);
+            _uploadedBytes += stagedBytes;
+            _batches.push_back(std::move(batch));
+        }
+        // May run right away, don't hold the lock
+        auto ticket = _lastSubmittedTicket;
+        // The destructor waits for every batch, the event is never
+        // destroyed with the callback pending
+        _completionEvent->OnReached(ticket, [this, ticket](bool) { _OnTicketReached(ticket); });
+    }
+
+    UploadManager::Stats UploadManager::GetStats() {
+        Stats stats{};
+        {
+            std::lock_guard lock(_m_requests);
+            stats.pendingRequests = _requests.size();
+            stats.pendingBytes = _pendingBytes;
+        }
+        {
+            std::lock_guard lock(_m_batches);
+            stats.uploadedBytes = _uploadedBytes;
+            stats.lastUpdateBytes = _lastUpdateBytes;
+            stats.stagingPages = _stagingPages;
+            stats.idleStagingPages = _idlePages.size();
+        }
+        return stats;
+    }
+
+} // namespace alloy
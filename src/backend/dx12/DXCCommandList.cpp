@@ -1221,8 +1221,11 @@ namespace alloy::dxc
                                    &srcSubresource, &srcRegion);
     }
 
-    void DXCTransferCmdEnc::GenerateMipmaps(const common::sp<ITexture>& texture){
-        ///#TODO: remove this function as mipmap generation needs more flexiblity in infcanvas
+    bool DXCTransferCmdEnc::GenerateMipmaps(const common::sp<ITextureView>& /*texture*/){
+        // D3D12 has no blit and the library doesn't ship a compute
+        // downsampler yet. Features::generateMipmaps is off, so callers
+        // fill the levels themselves. Nothing is recorded.
+        return false;
     }
 
 #pragma endregion XferCmdEnc
@@ -1611,6 +1614,19 @@ namespace alloy::dxc
         barrier.Transition.StateAfter= _EnnhancedToLegacyBarrierFlags(data.SyncAfter, data.AccessAfter);
     }
 
+    // Queues share resources without ownership, so a queue transfer only
+    // transitions in its acquire half, where the target state is supported.
+    static bool _IsQueueReleaseHalf(
+        const alloy::TextureBarrierOp& desc,
+        D3D12_COMMAND_LIST_TYPE listType
+    ) {
+        auto& transfer = desc.queueTransfer;
+        if(!transfer.srcQueue || !transfer.dstQueue) return false;
+        auto srcType = common::PtrCast<DXCCommandQueue>(transfer.srcQueue)->GetType();
+        auto dstType = common::PtrCast<DXCCommandQueue>(transfer.dstQueue)->GetType();
+        return srcType != dstType && srcType == listType;
+    }
+
     void DXCCommandList::Barrier(std::span<const alloy::BarrierOp> descs) {
 
         std::vector<D3D12_RESOURCE_BARRIER> barriers{};
@@ -1641,6 +1657,7 @@ namespace alloy::dxc
             }
             else {
                 auto& texDesc = std::get<alloy::TextureBarrierOp>(desc);
+                if(_IsQueueReleaseHalf(texDesc, _cmdList->GetType())) continue;
 
                 auto view = texDesc.texture;
                 auto texture = view->GetTextureObject();
@@ -1781,9 +1798,10 @@ namespace alloy::dxc
                 barrier.Size = rangeDesc.GetSizeInBytes();
             }
             else {
+                auto& texDesc = std::get<alloy::TextureBarrierOp>(desc);
+                if(_IsQueueReleaseHalf(texDesc, _cmdList->GetType())) continue;
                 texBarrier.emplace_back();
                 auto& barrier = texBarrier.back();
-                auto& texDesc = std::get<alloy::TextureBarrierOp>(desc);
 
                 auto view = texDesc.texture;
                 auto texture = view->GetTextureObject();
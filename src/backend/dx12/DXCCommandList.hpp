@@ -367,7 +367,7 @@ namespace alloy::dxc
 
         //virtual void ResolveTexture(const common::sp<ITexture>& source, const common::sp<ITexture>& destination) override;
 
-        virtual void GenerateMipmaps(const common::sp<ITexture>& texture) override;
+        virtual bool GenerateMipmaps(const common::sp<ITextureView>& texture) override;
     };
 
     class DXCCommandList6 : public DXCCommandList {
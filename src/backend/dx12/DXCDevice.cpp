@@ -249,6 +249,7 @@ namespace alloy::dxc {
     DXCDevice::~DXCDevice() {
         delete _gfxQ;
         delete _copyQ;
+        delete _computeQ;
 
         if (_sysMemUploadPool) {
             _sysMemUploadPool->Release();
@@ -284,6 +285,47 @@ namespace alloy::dxc {
 
     }
 
+    bool DXCDevice::GetMemoryStats(MemoryStats& stats, bool detailed) {
+        D3D12MA::Budget budgets[2];
+        _alloc->GetBudget(&budgets[0], &budgets[1]);
+
+        const std::uint32_t heapCnt = _alloc->IsUMA() ? 1 : 2;
+        stats.heaps.resize(heapCnt);
+        for(std::uint32_t i = 0; i < heapCnt; i++) {
+            auto& heap = stats.heaps[i];
+            heap = {};
+            heap.deviceLocal = i == 0;
+            heap.budgetBytes = budgets[i].BudgetBytes;
+            heap.usageBytes = budgets[i].UsageBytes;
+            heap.blockCount = budgets[i].Stats.BlockCount;
+            heap.allocationCount = budgets[i].Stats.AllocationCount;
+            heap.blockBytes = budgets[i].Stats.BlockBytes;
+            heap.allocationBytes = budgets[i].Stats.AllocationBytes;
+        }
+
+        if(detailed) {
+            D3D12MA::TotalStatistics total;
+            _alloc->CalculateStatistics(&total);
+            for(std::uint32_t i = 0; i < heapCnt; i++) {
+                stats.heaps[i].unusedRangeCount = total.MemorySegmentGroup[i].UnusedRangeCount;
+                stats.heaps[i].largestUnusedRangeBytes = total.MemorySegmentGroup[i].UnusedRangeSizeMax;
+            }
+        }
+        return true;
+    }
+
+    std::string DXCDevice::DumpMemoryStats(bool detailed) {
+        WCHAR* json = nullptr;
+        _alloc->BuildStatsString(&json, detailed);
+        // Debug names may leave ASCII
+        int len = WideCharToMultiByte(CP_UTF8, 0, json, -1, nullptr, 0, nullptr, nullptr);
+        std::string res(len > 0 ? len - 1 : 0, '\0');
+        if(len > 1)
+            WideCharToMultiByte(CP_UTF8, 0, json, -1, res.data(), len, nullptr, nullptr);
+        _alloc->FreeStatsString(json);
+        return res;
+    }
+
     common::sp<IGraphicsDevice> DXCDevice::Make(
         const common::sp<DXCAdapter>& adp,
         const IGraphicsDevice::Options &options
@@ -342,6 +384,7 @@ namespace alloy::dxc {
         //dev->_q = std::move(queue);
         dev->_gfxQ = new DXCCommandQueue(dev.get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
         dev->_copyQ = new DXCCommandQueue(dev.get(), D3D12_COMMAND_LIST_TYPE_COPY);
+        dev->_computeQ = new DXCCommandQueue(dev.get(), D3D12_COMMAND_LIST_TYPE_COMPUTE);
         //dev->_cmdAlloc = std::move(cmdAlloc);
         dev->_waitIdleFence.Init(std::move(waitIdleFence));
         dev->_alloc = allocator;
@@ -468,6 +511,15 @@ namespace alloy::dxc {
         dev->_commonFeat.structuredBuffer = true;
         dev->_commonFeat.subsetTextureView = true;
         dev->_commonFeat.shaderFloat64 = devCaps.options.DoublePrecisionFloatShaderOps;  
+        // No dynamic cull, depth or blend state in D3D12
+        dev->_commonFeat.dynamicRasterState = false;
+        dev->_commonFeat.dynamicBlendEnable = false;
+        dev->_commonFeat.inlineResources = false;
+        // GPU virtual addresses exist, but DXIL can't dereference them
+        dev->_commonFeat.bufferDeviceAddress = false;
+        dev->_commonFeat.placedResources = false;
+        // No blit, and no compute downsampler shipped yet
+        dev->_commonFeat.generateMipmaps = false;
 
         dev->_dbgCookie = adp->GetContext().InstallDebugCallBack(dev->_dev);
 
@@ -503,6 +555,41 @@ namespace alloy::dxc {
     ICommandQueue* DXCDevice::GetCopyCommandQueue() {
         return _copyQ;
     }
+    ICommandQueue* DXCDevice::GetComputeCommandQueue() {
+        return _computeQ;
+    }
+
+    bool DXCDevice::WaitForEvents(
+        std::span<const EventWait> waits,
+        bool waitAll,
+        uint32_t timeoutMs
+    ) {
+        Microsoft::WRL::ComPtr<ID3D12Device1> dev1;
+        if(waits.size() <= 1 || FAILED(_dev->QueryInterface(IID_PPV_ARGS(&dev1))))
+            return IGraphicsDevice::WaitForEvents(waits, waitAll, timeoutMs);
+
+        std::vector<ID3D12Fence*> fences;
+        std::vector<UINT64> values;
+        fences.reserve(waits.size());
+        values.reserve(waits.size());
+        for(auto& w : waits) {
+            fences.push_back(static_cast<DXCFence*>(w.event)->GetHandle());
+            values.push_back(w.value);
+        }
+
+        HANDLE evt = CreateEvent(nullptr, false, false, nullptr);
+        if(evt == nullptr) {
+            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+        }
+        ThrowIfFailed(dev1->SetEventOnMultipleFenceCompletion(
+            fences.data(), values.data(), (UINT)fences.size(),
+            waitAll ? D3D12_MULTIPLE_FENCE_WAIT_FLAG_ALL : D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY,
+            evt));
+
+        auto waitResult = WaitForSingleObjectEx(evt, timeoutMs, false);
+        CloseHandle(evt);
+        return waitResult == WAIT_OBJECT_0;
+    }
 
     void DXCDevice::WaitForIdle()
     {
@@ -696,7 +783,69 @@ namespace alloy::dxc {
         _f->Signal(signalValue);
     }
 
+    void DXCFence::OnReached(uint64_t value, ReachedCallback callback) {
+        if(_f->GetCompletedValue() >= value) {
+            callback(true);
+            return;
+        }
+
+        auto* w = new _ReachedWait{ this, nullptr, nullptr, std::move(callback) };
+        w->event = CreateEvent(nullptr, false, false, nullptr);
+        w->wait = CreateThreadpoolWait(&DXCFence::_OnReachedWait, w, nullptr);
+        if(w->event == nullptr || w->wait == nullptr) {
+            _FreeWait(w);
+            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+        }
+
+        {
+            std::scoped_lock lk{_m_waits};
+            _waits.push_back(w);
+        }
+        ThrowIfFailed(_f->SetEventOnCompletion(value, w->event));
+        SetThreadpoolWait(w->wait, w->event, nullptr);
+    }
+
+    void CALLBACK DXCFence::_OnReachedWait(
+        PTP_CALLBACK_INSTANCE instance,
+        PVOID context,
+        PTP_WAIT wait,
+        TP_WAIT_RESULT result
+    ) {
+        auto* w = static_cast<_ReachedWait*>(context);
+        {
+            // Lost to the destructor, which frees it
+            std::scoped_lock lk{w->fence->_m_waits};
+            auto& waits = w->fence->_waits;
+            auto it = std::find(waits.begin(), waits.end(), w);
+            if(it == waits.end()) return;
+            waits.erase(it);
+        }
+
+        w->callback(true);
+        _FreeWait(w);
+    }
+
+    void DXCFence::_FreeWait(_ReachedWait* w) {
+        // Closing from its own callback is allowed, it's freed once that returns
+        if(w->wait) CloseThreadpoolWait(w->wait);
+        if(w->event) CloseHandle(w->event);
+        delete w;
+    }
+
     DXCFence::~DXCFence() {
+        std::vector<_ReachedWait*> waits;
+        {
+            std::scoped_lock lk{_m_waits};
+            waits.swap(_waits);
+        }
+        for(auto* w : waits) {
+            SetThreadpoolWait(w->wait, nullptr, nullptr);
+            WaitForThreadpoolWaitCallbacks(w->wait, true);
+            // Never reached through this fence
+            w->callback(false);
+            _FreeWait(w);
+        }
+
         CloseHandle(_fenceEventHandle);
         _f->Release();
     }
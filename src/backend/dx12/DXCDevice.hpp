@@ -20,6 +20,7 @@
 #include <atomic>
 #include <queue>
 #include <unordered_map>
+#include <vector>
 //backend specific headers
 
 //platform specific headers
@@ -51,6 +52,7 @@ namespace alloy::dxc{
         DXCCommandQueue(DXCDevice* pDev, D3D12_COMMAND_LIST_TYPE cmdQType);
 
         ID3D12CommandQueue* GetHandle() const {return _q;}
+        D3D12_COMMAND_LIST_TYPE GetType() const { return _qType; }
 
         virtual ~DXCCommandQueue() override;
 
@@ -115,6 +117,7 @@ namespace alloy::dxc{
 
         DXCCommandQueue* _gfxQ;
         DXCCommandQueue* _copyQ;
+        DXCCommandQueue* _computeQ;
 
         //Microsoft::WRL::ComPtr<ID3D12CommandAllocator> _cmdAlloc;
         DXCAutoFence _waitIdleFence;
@@ -189,6 +192,15 @@ namespace alloy::dxc{
                
         virtual ICommandQueue* GetGfxCommandQueue() override;
         virtual ICommandQueue* GetCopyCommandQueue() override;
+        virtual ICommandQueue* GetComputeCommandQueue() override;
+
+        // Local and non-local segment groups, just local on UMA
+        virtual bool GetMemoryStats(MemoryStats& stats, bool detailed) override;
+        virtual std::string DumpMemoryStats(bool detailed) override;
+
+        // SetEventOnMultipleFenceCompletion, one event wait
+        virtual bool WaitForEvents(std::span<const EventWait> waits, bool waitAll, uint32_t timeoutMs) override;
+        using IGraphicsDevice::WaitForEvents;
 
         virtual void WaitForIdle() override;
 
@@ -202,6 +214,23 @@ namespace alloy::dxc{
         //SetEventOnCompletion will block until complete if handle is null
         HANDLE _fenceEventHandle;
 
+        // OnReached callbacks, each waited on by the thread pool
+        struct _ReachedWait {
+            DXCFence* fence;
+            HANDLE event;
+            PTP_WAIT wait;
+            ReachedCallback callback;
+        };
+        std::mutex _m_waits;
+        std::vector<_ReachedWait*> _waits;
+
+        static void CALLBACK _OnReachedWait(
+            PTP_CALLBACK_INSTANCE instance,
+            PVOID context,
+            PTP_WAIT wait,
+            TP_WAIT_RESULT result);
+        static void _FreeWait(_ReachedWait* w);
+
     public:
 
         DXCFence(DXCDevice* dev);
@@ -223,6 +252,7 @@ namespace alloy::dxc{
         }
         virtual void SignalFromCPU(uint64_t signalValue) override;
         virtual bool WaitFromCPU(uint64_t expectedValue, uint32_t timeoutMs) override;
+        virtual void OnReached(uint64_t value, ReachedCallback callback) override;
     };
 
     
@@ -262,6 +292,9 @@ namespace alloy::dxc{
         virtual const Description& GetDesc() const override { return _desc;}
         
         virtual uint64_t GetNativeHandle() const {return GetHandle()->GetGPUVirtualAddress();}
+        virtual std::uint64_t GetDeviceAddress() const override {
+            return _desc.usage.deviceAddress ? GetHandle()->GetGPUVirtualAddress() : 0;
+        }
 
         ID3D12Resource* GetHandle() const {return _buffer->GetResource();}
 
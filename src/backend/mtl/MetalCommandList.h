@@ -497,12 +497,7 @@ public:
                 1);
         }*/
 
-        // Generates mipmaps for the given <see cref="Texture"/>. The largest mipmap is used to generate all of the lower mipmap
-        // levels contained in the Texture. The previous contents of all lower mipmap levels are overwritten by this operation.
-        // The target Texture must have been created with <see cref="TextureUsage"/>.<see cref="TextureUsage.GenerateMipmaps"/>.
-        // <param name="texture">The <see cref="Texture"/> to generate mipmaps for. This Texture must have been created with
-        // <see cref="TextureUsage"/>.<see cref="TextureUsage.GenerateMipmaps"/>.</param>
-        virtual void GenerateMipmaps(const common::sp<ITexture>& texture) override;
+        virtual bool GenerateMipmaps(const common::sp<ITextureView>& texture) override;
 
 
         /// Resolves a multisampled source <see cref="Texture"/> into a non-multisampled destination <see cref="Texture"/>.
@@ -1220,16 +1220,33 @@ void MetalTransferCmdEnc::CopyBuffer(
                 1);
         }*/
 
-        // Generates mipmaps for the given <see cref="Texture"/>. The largest mipmap is used to generate all of the lower mipmap
-        // levels contained in the Texture. The previous contents of all lower mipmap levels are overwritten by this operation.
-        // The target Texture must have been created with <see cref="TextureUsage"/>.<see cref="TextureUsage.GenerateMipmaps"/>.
-        // <param name="texture">The <see cref="Texture"/> to generate mipmaps for. This Texture must have been created with
-        // <see cref="TextureUsage"/>.<see cref="TextureUsage.GenerateMipmaps"/>.</param>
-    void MetalTransferCmdEnc::GenerateMipmaps(const common::sp<ITexture>& texture) {
+    bool MetalTransferCmdEnc::GenerateMipmaps(const common::sp<ITextureView>& texture) {
         resources.insert(texture);
-        auto texImpl = static_cast<MetalTexture*>(texture.get());
+        auto texImpl = static_cast<MetalTexture*>(texture->GetTextureObject().get());
+        const auto& viewDesc = texture->GetDesc();
+        const auto& texDesc = texImpl->GetDesc();
 
-        [_mtlEnc generateMipmapsForTexture:texImpl->GetHandle()];
+        auto layerCount = viewDesc.arrayLayers;
+        if (texDesc.usage.cubemap) {
+            layerCount *= 6;
+        }
+
+        id<MTLTexture> mtlTex = texImpl->GetHandle();
+        if (viewDesc.baseMipLevel == 0 && viewDesc.mipLevels == texDesc.mipLevels
+            && viewDesc.baseArrayLayer == 0 && viewDesc.arrayLayers == texDesc.arrayLayers) {
+            [_mtlEnc generateMipmapsForTexture:mtlTex];
+            return true;
+        }
+
+        // generateMipmapsForTexture always covers the whole texture, so
+        // narrow it with a view. The command buffer retains it.
+        id<MTLTexture> subTex = [mtlTex newTextureViewWithPixelFormat:[mtlTex pixelFormat]
+                                                          textureType:[mtlTex textureType]
+                                                               levels:NSMakeRange(viewDesc.baseMipLevel, viewDesc.mipLevels)
+                                                               slices:NSMakeRange(viewDesc.baseArrayLayer, layerCount)];
+        [_mtlEnc generateMipmapsForTexture:subTex];
+        [subTex release];
+        return true;
     }
 
 } // namespace alloy::mtl
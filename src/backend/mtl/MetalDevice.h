@@ -3,7 +3,10 @@
 #include <Metal/Metal.h>
 #include <QuartzCore/QuartzCore.h>
 
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include "alloy/Context.hpp"
 #include "alloy/GraphicsDevice.hpp"
@@ -90,7 +93,7 @@ namespace alloy::mtl
 
         AdapterInfo _info;
 
-        MetalCmdQ* _gfxQ, * _copyQ;
+        MetalCmdQ* _gfxQ, * _copyQ, * _computeQ;
 
         MetalDevice() = default;
 
@@ -114,6 +117,7 @@ namespace alloy::mtl
 
         virtual ICommandQueue* GetGfxCommandQueue() override;
         virtual ICommandQueue* GetCopyCommandQueue() override;
+        virtual ICommandQueue* GetComputeCommandQueue() override;
 
         virtual ISwapChain::State PresentToSwapChain(ISwapChain* sc) override;
 
@@ -171,7 +175,16 @@ namespace alloy::mtl
         common::sp<MetalDevice> _dev;
 
         id<MTLSharedEvent> _mtlEvt;
-        //MTLSharedEventListener* _listener;
+        // Notifies OnReached callbacks on its own dispatch queue
+        MTLSharedEventListener* _listener;
+        // Callbacks not notified yet. The destructor runs what's left,
+        // notifications may still arrive after and find theirs gone.
+        struct _PendingCallbacks {
+            std::mutex m;
+            uint64_t nextId = 0;
+            std::unordered_map<uint64_t, ReachedCallback> callbacks;
+        };
+        std::shared_ptr<_PendingCallbacks> _pending;
 
         MetalEvent(const common::sp<MetalDevice>& dev) : _dev(dev) {}
 
@@ -187,6 +200,7 @@ namespace alloy::mtl
 
         virtual bool WaitFromCPU(uint64_t waitForValue, uint32_t timeoutMs) override;
         virtual void SignalFromCPU(uint64_t signalValue) override;
+        virtual void OnReached(uint64_t value, ReachedCallback callback) override;
 
     };
 } // namespace alloy
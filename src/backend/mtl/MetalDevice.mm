@@ -447,6 +447,7 @@ namespace alloy::mtl
     MetalDevice::~MetalDevice(){
         delete _gfxQ;
         delete _copyQ;
+        delete _computeQ;
     }
 
 
@@ -521,6 +522,12 @@ namespace alloy::mtl
             _features.commandListDebugMarkers = true;
             _features.bufferRangeBinding = true;
             _features.shaderFloat64 = false;
+            _features.dynamicRasterState = false;
+            _features.dynamicBlendEnable = false;
+            _features.inlineResources = false;
+            _features.bufferDeviceAddress = false;
+            _features.placedResources = false;
+            _features.generateMipmaps = true;
             //    ResourceBindingModel = options.ResourceBindingModel;
 
             MTLCommandBufferHandler _completionHandler;
@@ -590,6 +597,7 @@ namespace alloy::mtl
 
             mtlDev->_gfxQ = new MetalCmdQ(*mtlDev);
             mtlDev->_copyQ = new MetalCmdQ(*mtlDev);
+            mtlDev->_computeQ = new MetalCmdQ(*mtlDev);
 
             return common::sp(mtlDev);
 
@@ -608,6 +616,9 @@ namespace alloy::mtl
     ICommandQueue* MetalDevice::GetCopyCommandQueue() {
         return _copyQ;
     }
+    ICommandQueue* MetalDevice::GetComputeCommandQueue() {
+        return _computeQ;
+    }
 
     ISwapChain::State MetalDevice::PresentToSwapChain(ISwapChain* sc) {
         auto mtlSC = common::PtrCast<MetalSwapChain>(sc);
@@ -765,7 +776,16 @@ MetalBuffer::~MetalBuffer() {
     }
 
     MetalEvent::~MetalEvent() {
-        //[_listener release];
+        std::unordered_map<uint64_t, ReachedCallback> left;
+        {
+            std::scoped_lock lk{_pending->m};
+            left.swap(_pending->callbacks);
+        }
+        // Never reached through this event
+        for(auto& [cbId, fn] : left)
+            fn(false);
+
+        [_listener release];
         [_mtlEvt release];
     }
 
@@ -778,7 +798,8 @@ MetalBuffer::~MetalBuffer() {
             auto evtImpl = new MetalEvent(dev);
 
             evtImpl->_mtlEvt = mtlEvt;
-            //evtImpl->_listener = [MTLSharedEventListener new];
+            evtImpl->_listener = [MTLSharedEventListener new];
+            evtImpl->_pending = std::make_shared<_PendingCallbacks>();
 
             return common::sp(evtImpl);
         }
@@ -817,6 +838,33 @@ MetalBuffer::~MetalBuffer() {
         _mtlEvt.signaledValue = signalValue;
     }
 
+    void MetalEvent::OnReached(uint64_t value, ReachedCallback callback){
+        if(_mtlEvt.signaledValue >= value) {
+            callback(true);
+            return;
+        }
+
+        auto pending = _pending;
+        uint64_t cbId;
+        {
+            std::scoped_lock lk{pending->m};
+            cbId = pending->nextId++;
+            pending->callbacks.emplace(cbId, std::move(callback));
+        }
+        [_mtlEvt notifyListener:_listener atValue:value block:^(id<MTLSharedEvent> evt, uint64_t value){
+            ReachedCallback fn;
+            {
+                std::scoped_lock lk{pending->m};
+                auto it = pending->callbacks.find(cbId);
+                // Already run by the destructor
+                if(it == pending->callbacks.end()) return;
+                fn = std::move(it->second);
+                pending->callbacks.erase(it);
+            }
+            fn(true);
+        }];
+    }
+
 
 
 
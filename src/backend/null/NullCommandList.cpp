@@ -0,0 +1,473 @@
+#include "NullCommandList.hpp"
+
+#include "alloy/common/Common.hpp"
+#include "alloy/common/Trace.hpp"
+#include "alloy/Helpers.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+#include "NullDevice.hpp"
+#include "NullResources.hpp"
+
+namespace alloy::null
+{
+    void NullRenderCmdEnc::SetPipeline(const common::sp<IGfxPipeline>&) {
+        _cmdList->_Log(NullCommandOp::SetPipeline);
+    }
+
+    void NullRenderCmdEnc::SetPipeline(const common::sp<IMeshShaderPipeline>&) {
+        _cmdList->_Log(NullCommandOp::SetPipeline);
+    }
+
+    void NullRenderCmdEnc::SetVertexBuffer(
+        std::uint32_t index, const common::sp<BufferRange>& buffer
+    ) {
+        _cmdList->_Log(NullCommandOp::SetVertexBuffer, { index });
+    }
+
+    void NullRenderCmdEnc::SetIndexBuffer(
+        const common::sp<BufferRange>& buffer, IndexFormat format
+    ) {
+        _cmdList->_Log(NullCommandOp::SetIndexBuffer, { (std::uint32_t)format });
+    }
+
+    void NullRenderCmdEnc::SetVertexBuffer(
+        std::uint32_t index, IBuffer* buffer, std::uint64_t offsetInBytes
+    ) {
+        _cmdList->_Log(NullCommandOp::SetVertexBuffer, { index });
+    }
+
+    void NullRenderCmdEnc::SetIndexBuffer(
+        IBuffer* buffer, IndexFormat format, std::uint64_t offsetInBytes
+    ) {
+        _cmdList->_Log(NullCommandOp::SetIndexBuffer, { (std::uint32_t)format });
+    }
+
+    void NullRenderCmdEnc::SetPushConstants(
+        std::uint32_t pushConstantIndex,
+        std::span<const uint32_t> data,
+        std::uint32_t destOffsetIn32BitValues
+    ) {
+        _cmdList->_Log(NullCommandOp::SetPushConstants,
+            { pushConstantIndex, (std::uint32_t)data.size(), destOffsetIn32BitValues });
+    }
+
+    void NullRenderCmdEnc::SetGraphicsResourceSet(const common::sp<IResourceSet>& rs) {
+        _cmdList->_Log(NullCommandOp::SetResourceSet);
+    }
+
+    void NullRenderCmdEnc::SetGraphicsResourceSet(IResourceSet* rs) {
+        _cmdList->_Log(NullCommandOp::SetResourceSet);
+    }
+
+    void NullRenderCmdEnc::SetGraphicsMutableResourceSet(
+        const common::sp<IMutableResourceSet>& rs
+    ) {
+        _cmdList->_Log(NullCommandOp::SetMutableResourceSet);
+    }
+
+    void NullRenderCmdEnc::SetGraphicsResources(
+        IResourceLayout* layout,
+        std::span<const common::sp<IBindableResource>> resources
+    ) {
+        _cmdList->_Log(NullCommandOp::SetResources, { (std::uint32_t)resources.size() });
+    }
+
+    void NullRenderCmdEnc::SetDescriptorHeaps(
+        const common::sp<IResourceDescriptorHeap>& resourceHeap,
+        const common::sp<ISamplerDescriptorHeap>& samplerHeap
+    ) {
+        _cmdList->_Log(NullCommandOp::SetDescriptorHeaps);
+    }
+
+    void NullRenderCmdEnc::SetViewports(std::span<const Viewport> viewport) {
+        _cmdList->_Log(NullCommandOp::SetViewports, { (std::uint32_t)viewport.size() });
+    }
+
+    void NullRenderCmdEnc::SetFullViewport() {
+        _cmdList->_Log(NullCommandOp::SetViewports, { 1 });
+    }
+
+    void NullRenderCmdEnc::SetScissorRects(std::span<const Rect> rects) {
+        _cmdList->_Log(NullCommandOp::SetScissorRects, { (std::uint32_t)rects.size() });
+    }
+
+    void NullRenderCmdEnc::SetFullScissorRect() {
+        _cmdList->_Log(NullCommandOp::SetScissorRects, { 1 });
+    }
+
+    void NullRenderCmdEnc::Draw(
+        std::uint32_t vertexCount, std::uint32_t instanceCount,
+        std::uint32_t vertexStart, std::uint32_t instanceStart
+    ) {
+        VLD_TRACE_ZONE("NullRenderCmdEnc::Draw");
+        _cmdList->_Log(NullCommandOp::Draw,
+            { vertexCount, instanceCount, vertexStart, instanceStart });
+    }
+
+    void NullRenderCmdEnc::DrawIndexed(
+        std::uint32_t indexCount, std::uint32_t instanceCount,
+        std::uint32_t indexStart, std::uint32_t vertexOffset,
+        std::uint32_t instanceStart
+    ) {
+        VLD_TRACE_ZONE("NullRenderCmdEnc::DrawIndexed");
+        _cmdList->_Log(NullCommandOp::DrawIndexed,
+            { indexCount, instanceCount, indexStart, vertexOffset, instanceStart });
+    }
+
+    void NullRenderCmdEnc::DispatchMesh(
+        std::uint32_t groupCountX,
+        std::uint32_t groupCountY,
+        std::uint32_t groupCountZ
+    ) {
+        _cmdList->_Log(NullCommandOp::DispatchMesh, { groupCountX, groupCountY, groupCountZ });
+    }
+
+    void NullComputeCmdEnc::SetPipeline(const common::sp<IComputePipeline>&) {
+        _cmdList->_Log(NullCommandOp::SetPipeline);
+    }
+
+    void NullComputeCmdEnc::SetComputeResourceSet(const common::sp<IResourceSet>& rs) {
+        _cmdList->_Log(NullCommandOp::SetResourceSet);
+    }
+
+    void NullComputeCmdEnc::SetComputeResourceSet(IResourceSet* rs) {
+        _cmdList->_Log(NullCommandOp::SetResourceSet);
+    }
+
+    void NullComputeCmdEnc::SetComputeMutableResourceSet(
+        const common::sp<IMutableResourceSet>& rs
+    ) {
+        _cmdList->_Log(NullCommandOp::SetMutableResourceSet);
+    }
+
+    void NullComputeCmdEnc::SetComputeResources(
+        IResourceLayout* layout,
+        std::span<const common::sp<IBindableResource>> resources
+    ) {
+        _cmdList->_Log(NullCommandOp::SetResources, { (std::uint32_t)resources.size() });
+    }
+
+    void NullComputeCmdEnc::SetDescriptorHeaps(
+        const common::sp<IResourceDescriptorHeap>& resourceHeap,
+        const common::sp<ISamplerDescriptorHeap>& samplerHeap
+    ) {
+        _cmdList->_Log(NullCommandOp::SetDescriptorHeaps);
+    }
+
+    void NullComputeCmdEnc::SetPushConstants(
+        std::uint32_t pushConstantIndex,
+        std::span<const uint32_t> data,
+        std::uint32_t destOffsetIn32BitValues
+    ) {
+        _cmdList->_Log(NullCommandOp::SetPushConstants,
+            { pushConstantIndex, (std::uint32_t)data.size(), destOffsetIn32BitValues });
+    }
+
+    void NullComputeCmdEnc::Dispatch(
+        std::uint32_t groupCountX,
+        std::uint32_t groupCountY,
+        std::uint32_t groupCountZ
+    ) {
+        VLD_TRACE_ZONE("NullComputeCmdEnc::Dispatch");
+        _cmdList->_Log(NullCommandOp::Dispatch, { groupCountX, groupCountY, groupCountZ });
+    }
+
+    void NullTransferCmdEnc::CopyBuffer(
+        const common::sp<BufferRange>& source,
+        const common::sp<BufferRange>& destination,
+        std::uint32_t sizeInBytes
+    ) {
+        _cmdList->_Log(NullCommandOp::CopyBuffer, { sizeInBytes });
+
+        NullCommandList::_Copy copy{};
+        copy.kind = NullCommandList::_Copy::Kind::Buffer;
+        copy.buffer = source;
+        copy.dstBuffer = destination;
+        copy.sizeInBytes = sizeInBytes;
+        _cmdList->_copies.push_back(std::move(copy));
+    }
+
+    void NullTransferCmdEnc::CopyBufferToTexture(
+        const common::sp<BufferRange>& src,
+        std::uint32_t srcBytesPerRow,
+        std::uint32_t srcBytesPerImage,
+        const common::sp<ITextureView>& dst,
+        const Point3D& dstOrigin,
+        std::uint32_t dstMipLevel,
+        std::uint32_t dstBaseArrayLayer,
+        const Size3D& copySize
+    ) {
+        _cmdList->_Log(NullCommandOp::CopyBufferToTexture,
+            { copySize.width, copySize.height, copySize.depth });
+
+        NullCommandList::_Copy copy{};
+        copy.kind = NullCommandList::_Copy::Kind::BufferToTexture;
+        copy.buffer = src;
+        copy.bytesPerRow = srcBytesPerRow;
+        copy.bytesPerImage = srcBytesPerImage;
+        copy.dstTex = dst;
+        copy.dstOrigin = dstOrigin;
+        copy.dstMipLevel = dstMipLevel;
+        copy.dstArrayLayer = dstBaseArrayLayer;
+        copy.size = copySize;
+        _cmdList->_copies.push_back(std::move(copy));
+    }
+
+    void NullTransferCmdEnc::CopyTextureToBuffer(
+        const common::sp<ITextureView>& src,
+        const Point3D& srcOrigin,
+        std::uint32_t srcMipLevel,
+        std::uint32_t srcBaseArrayLayer,
+        const common::sp<BufferRange>& dst,
+        std::uint32_t srcBytesPerRow,
+        std::uint32_t srcBytesPerImage,
+        const Size3D& copySize
+    ) {
+        _cmdList->_Log(NullCommandOp::CopyTextureToBuffer,
+            { copySize.width, copySize.height, copySize.depth });
+
+        NullCommandList::_Copy copy{};
+        copy.kind = NullCommandList::_Copy::Kind::TextureToBuffer;
+        copy.srcTex = src;
+        copy.srcOrigin = srcOrigin;
+        copy.srcMipLevel = srcMipLevel;
+        copy.srcArrayLayer = srcBaseArrayLayer;
+        copy.buffer = dst;
+        copy.bytesPerRow = srcBytesPerRow;
+        copy.bytesPerImage = srcBytesPerImage;
+        copy.size = copySize;
+        _cmdList->_copies.push_back(std::move(copy));
+    }
+
+    void NullTransferCmdEnc::CopyTexture(
+        const common::sp<ITextureView>& src,
+        const Point3D& srcOrigin,
+        std::uint32_t srcMipLevel,
+        std::uint32_t srcBaseArrayLayer,
+        const common::sp<ITextureView>& dst,
+        const Point3D& dstOrigin,
+        std::uint32_t dstMipLevel,
+        std::uint32_t dstBaseArrayLayer,
+        const Size3D& copySize
+    ) {
+        _cmdList->_Log(NullCommandOp::CopyTexture,
+            { copySize.width, copySize.height, copySize.depth });
+
+        NullCommandList::_Copy copy{};
+        copy.kind = NullCommandList::_Copy::Kind::Texture;
+        copy.srcTex = src;
+        copy.srcOrigin = srcOrigin;
+        copy.srcMipLevel = srcMipLevel;
+        copy.srcArrayLayer = srcBaseArrayLayer;
+        copy.dstTex = dst;
+        copy.dstOrigin = dstOrigin;
+        copy.dstMipLevel = dstMipLevel;
+        copy.dstArrayLayer = dstBaseArrayLayer;
+        copy.size = copySize;
+        _cmdList->_copies.push_back(std::move(copy));
+    }
+
+    bool NullTransferCmdEnc::GenerateMipmaps(const common::sp<ITextureView>& texture) {
+        const auto& texDesc = texture->GetTextureObject()->GetDesc();
+        if(texDesc.usage.depthStencil || FormatHelpers::IsCompressedFormat(texDesc.format))
+            return false;
+
+        _cmdList->_Log(NullCommandOp::GenerateMipmaps);
+
+        NullCommandList::_Copy copy{};
+        copy.kind = NullCommandList::_Copy::Kind::Mipmaps;
+        copy.dstTex = texture;
+        _cmdList->_copies.push_back(std::move(copy));
+        return true;
+    }
+
+    NullCommandList::NullCommandList(const common::sp<NullDevice>& dev)
+        : _dev(dev)
+        , _renderEnc(this)
+        , _computeEnc(this)
+        , _transferEnc(this)
+        , _inPass(false)
+        , _logging(false)
+        , _profiling(false)
+    { }
+
+    void NullCommandList::Execute(std::uint32_t queueIdx) {
+        VLD_TRACE_ZONE("NullCommandList::Execute");
+
+        auto texOf = [](const common::sp<ITextureView>& view) {
+            return common::PtrCast<NullTexture>(view->GetTextureObject().get());
+        };
+        auto bufOf = [](const common::sp<BufferRange>& range) {
+            auto* buf = common::PtrCast<NullBuffer>(range->GetBufferObject().get());
+            return buf->GetData() + range->GetShape().GetOffsetInBytes();
+        };
+
+        // Clock at each mark, the last one after all copies
+        std::vector<std::uint64_t> markNs;
+        auto readClock = [&] {
+            if(!_profiling) return;
+            markNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        };
+
+        for(auto& copy : _copies) {
+            readClock();
+            switch(copy.kind) {
+            case _Copy::Kind::Buffer:
+                std::memmove(bufOf(copy.dstBuffer), bufOf(copy.buffer), copy.sizeInBytes);
+                break;
+            case _Copy::Kind::BufferToTexture: {
+                auto* tex = texOf(copy.dstTex);
+                auto& viewDesc = copy.dstTex->GetDesc();
+                tex->WriteSubresource(
+                    viewDesc.baseMipLevel + copy.dstMipLevel,
+                    viewDesc.baseArrayLayer + copy.dstArrayLayer,
+                    copy.dstOrigin, copy.size,
+                    bufOf(copy.buffer), copy.bytesPerRow, copy.bytesPerImage);
+            } break;
+            case _Copy::Kind::TextureToBuffer: {
+                auto* tex = texOf(copy.srcTex);
+                auto& viewDesc = copy.srcTex->GetDesc();
+                tex->ReadSubresource(
+                    bufOf(copy.buffer), copy.bytesPerRow, copy.bytesPerImage,
+                    viewDesc.baseMipLevel + copy.srcMipLevel,
+                    viewDesc.baseArrayLayer + copy.srcArrayLayer,
+                    copy.srcOrigin, copy.size);
+            } break;
+            case _Copy::Kind::Texture: {
+                auto* srcTex = texOf(copy.srcTex);
+                auto* dstTex = texOf(copy.dstTex);
+                auto& srcView = copy.srcTex->GetDesc();
+                auto& dstView = copy.dstTex->GetDesc();
+                auto format = srcTex->GetDesc().format;
+
+                // Bounce through a tightly packed staging copy
+                auto rowPitch = FormatHelpers::GetRowPitch(copy.size.width, format);
+                auto depthPitch = FormatHelpers::GetDepthPitch(rowPitch, copy.size.height, format);
+                std::vector<std::uint8_t> staging((std::size_t)depthPitch * copy.size.depth);
+                srcTex->ReadSubresource(
+                    staging.data(), rowPitch, depthPitch,
+                    srcView.baseMipLevel + copy.srcMipLevel,
+                    srcView.baseArrayLayer + copy.srcArrayLayer,
+                    copy.srcOrigin, copy.size);
+                dstTex->WriteSubresource(
+                    dstView.baseMipLevel + copy.dstMipLevel,
+                    dstView.baseArrayLayer + copy.dstArrayLayer,
+                    copy.dstOrigin, copy.size,
+                    staging.data(), rowPitch, depthPitch);
+            } break;
+            case _Copy::Kind::Mipmaps: {
+                auto* tex = texOf(copy.dstTex);
+                auto& viewDesc = copy.dstTex->GetDesc();
+                auto layers = tex->GetDesc().usage.cubemap
+                    ? viewDesc.arrayLayers * 6 : viewDesc.arrayLayers;
+                tex->GenerateMipmaps(
+                    viewDesc.baseMipLevel, viewDesc.mipLevels,
+                    viewDesc.baseArrayLayer, layers);
+            } break;
+            }
+        }
+        readClock();
+        _copies.clear();
+
+        if(_profiling) {
+            _dev->GetNullGpuProfiler().OnSubmit(_profile, queueIdx, markNs);
+            _profile.Reset();
+        }
+
+        if(!_log.empty()) {
+            _dev->AppendCommandLog(_log);
+            _log.clear();
+        }
+    }
+
+    void NullCommandList::Begin() {
+        VLD_TRACE_ZONE("NullCommandList::Begin");
+        _inPass = false;
+        _copies.clear();
+        _log.clear();
+        _logging = _dev->IsCommandLogEnabled();
+        _profile.Reset();
+        _profiling = _dev->GetNullGpuProfiler().IsEnabled();
+        _Log(NullCommandOp::Begin);
+    }
+
+    void NullCommandList::End() {
+        VLD_TRACE_ZONE("NullCommandList::End");
+        assert(!_inPass);
+        if(_profiling) {
+            _dev->GetNullGpuProfiler().EndAllScopes(_profile, _copies.size());
+        }
+        _Log(NullCommandOp::End);
+    }
+
+    IRenderCommandEncoder& NullCommandList::BeginRenderPass(
+        const RenderPassAction& action, const PassResourceUsage& usage
+    ) {
+        assert(!_inPass);
+        _inPass = true;
+        if(_profiling) {
+            _dev->GetNullGpuProfiler().BeginScope(_profile, "Render pass", true, _copies.size());
+        }
+        _Log(NullCommandOp::BeginRenderPass,
+            { (std::uint32_t)action.colorTargetActions.size() });
+        return _renderEnc;
+    }
+
+    IComputeCommandEncoder& NullCommandList::BeginComputePass(const PassResourceUsage& usage) {
+        assert(!_inPass);
+        _inPass = true;
+        if(_profiling) {
+            _dev->GetNullGpuProfiler().BeginScope(_profile, "Compute pass", true, _copies.size());
+        }
+        _Log(NullCommandOp::BeginComputePass);
+        return _computeEnc;
+    }
+
+    ITransferCommandEncoder& NullCommandList::BeginTransferPass() {
+        assert(!_inPass);
+        _inPass = true;
+        if(_profiling) {
+            _dev->GetNullGpuProfiler().BeginScope(_profile, "Transfer pass", true, _copies.size());
+        }
+        _Log(NullCommandOp::BeginTransferPass);
+        return _transferEnc;
+    }
+
+    void NullCommandList::EndPass() {
+        assert(_inPass);
+        _inPass = false;
+        if(_profiling) {
+            _dev->GetNullGpuProfiler().EndPassScope(_profile, _copies.size());
+        }
+        _Log(NullCommandOp::EndPass);
+    }
+
+    void NullCommandList::Barrier(std::span<const alloy::BarrierOp> barriers) {
+        VLD_TRACE_ZONE("NullCommandList::Barrier");
+        VLD_TRACE_COUNT(Barriers, barriers.size());
+        _Log(NullCommandOp::Barrier, { (std::uint32_t)barriers.size() });
+    }
+
+    void NullCommandList::PushDebugGroup(const std::string& name, const Color4f&) {
+        if(_profiling) {
+            _dev->GetNullGpuProfiler().BeginScope(_profile, name, false, _copies.size());
+        }
+        _Log(NullCommandOp::PushDebugGroup);
+    }
+
+    void NullCommandList::PopDebugGroup() {
+        if(_profiling) {
+            _dev->GetNullGpuProfiler().EndGroupScope(_profile, _copies.size());
+        }
+        _Log(NullCommandOp::PopDebugGroup);
+    }
+
+    void NullCommandList::InsertDebugMarker(const std::string& name, const Color4f&) {
+        _Log(NullCommandOp::InsertDebugMarker);
+    }
+
+}
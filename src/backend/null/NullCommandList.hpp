@@ -0,0 +1,230 @@
+#pragma once
+
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/CommandList.hpp"
+#include "alloy/backend/NullBackend.hpp"
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "NullGpuProfiler.hpp"
+
+namespace alloy::null
+{
+    class NullDevice;
+    class NullCommandList;
+
+    class NullRenderCmdEnc : public IRenderCommandEncoder {
+
+        NullCommandList* _cmdList;
+
+    public:
+        NullRenderCmdEnc(NullCommandList* cmdList) : _cmdList(cmdList) { }
+
+        virtual void SetPipeline(const common::sp<IGfxPipeline>&) override;
+        virtual void SetPipeline(const common::sp<IMeshShaderPipeline>&) override;
+
+        virtual void SetVertexBuffer(
+            std::uint32_t index, const common::sp<BufferRange>& buffer) override;
+        virtual void SetIndexBuffer(
+            const common::sp<BufferRange>& buffer, IndexFormat format) override;
+        virtual void SetVertexBuffer(
+            std::uint32_t index, IBuffer* buffer, std::uint64_t offsetInBytes) override;
+        virtual void SetIndexBuffer(
+            IBuffer* buffer, IndexFormat format, std::uint64_t offsetInBytes) override;
+
+        virtual void SetPushConstants(
+            std::uint32_t pushConstantIndex,
+            std::span<const uint32_t> data,
+            std::uint32_t destOffsetIn32BitValues) override;
+
+        virtual void SetGraphicsResourceSet(const common::sp<IResourceSet>& rs) override;
+        virtual void SetGraphicsResourceSet(IResourceSet* rs) override;
+        virtual void SetGraphicsMutableResourceSet(
+            const common::sp<IMutableResourceSet>& rs) override;
+        virtual void SetGraphicsResources(
+            IResourceLayout* layout,
+            std::span<const common::sp<IBindableResource>> resources) override;
+
+        virtual void SetDescriptorHeaps(
+            const common::sp<IResourceDescriptorHeap>& resourceHeap,
+            const common::sp<ISamplerDescriptorHeap>& samplerHeap) override;
+
+        virtual void SetViewports(std::span<const Viewport> viewport) override;
+        virtual void SetFullViewport() override;
+        virtual void SetScissorRects(std::span<const Rect>) override;
+        virtual void SetFullScissorRect() override;
+
+        virtual void Draw(
+            std::uint32_t vertexCount, std::uint32_t instanceCount,
+            std::uint32_t vertexStart, std::uint32_t instanceStart) override;
+        virtual void DrawIndexed(
+            std::uint32_t indexCount, std::uint32_t instanceCount,
+            std::uint32_t indexStart, std::uint32_t vertexOffset,
+            std::uint32_t instanceStart) override;
+
+        virtual void DispatchMesh(std::uint32_t groupCountX,
+                                  std::uint32_t groupCountY,
+                                  std::uint32_t groupCountZ) override;
+    };
+
+    class NullComputeCmdEnc : public IComputeCommandEncoder {
+
+        NullCommandList* _cmdList;
+
+    public:
+        NullComputeCmdEnc(NullCommandList* cmdList) : _cmdList(cmdList) { }
+
+        virtual void SetPipeline(const common::sp<IComputePipeline>&) override;
+
+        virtual void SetComputeResourceSet(const common::sp<IResourceSet>& rs) override;
+        virtual void SetComputeResourceSet(IResourceSet* rs) override;
+        virtual void SetComputeMutableResourceSet(
+            const common::sp<IMutableResourceSet>& rs) override;
+        virtual void SetComputeResources(
+            IResourceLayout* layout,
+            std::span<const common::sp<IBindableResource>> resources) override;
+
+        virtual void SetDescriptorHeaps(
+            const common::sp<IResourceDescriptorHeap>& resourceHeap,
+            const common::sp<ISamplerDescriptorHeap>& samplerHeap) override;
+
+        virtual void SetPushConstants(
+            std::uint32_t pushConstantIndex,
+            std::span<const uint32_t> data,
+            std::uint32_t destOffsetIn32BitValues) override;
+
+        virtual void Dispatch(
+            std::uint32_t groupCountX,
+            std::uint32_t groupCountY,
+            std::uint32_t groupCountZ) override;
+    };
+
+    class NullTransferCmdEnc : public ITransferCommandEncoder {
+
+        NullCommandList* _cmdList;
+
+    public:
+        NullTransferCmdEnc(NullCommandList* cmdList) : _cmdList(cmdList) { }
+
+        virtual void CopyBuffer(
+            const common::sp<BufferRange>& source,
+            const common::sp<BufferRange>& destination,
+            std::uint32_t sizeInBytes) override;
+
+        virtual void CopyBufferToTexture(
+            const common::sp<BufferRange>& src,
+            std::uint32_t srcBytesPerRow,
+            std::uint32_t srcBytesPerImage,
+            const common::sp<ITextureView>& dst,
+            const Point3D& dstOrigin,
+            std::uint32_t dstMipLevel,
+            std::uint32_t dstBaseArrayLayer,
+            const Size3D& copySize) override;
+
+        virtual void CopyTextureToBuffer(
+            const common::sp<ITextureView>& src,
+            const Point3D& srcOrigin,
+            std::uint32_t srcMipLevel,
+            std::uint32_t srcBaseArrayLayer,
+            const common::sp<BufferRange>& dst,
+            std::uint32_t srcBytesPerRow,
+            std::uint32_t srcBytesPerImage,
+            const Size3D& copySize) override;
+
+        virtual void CopyTexture(
+            const common::sp<ITextureView>& src,
+            const Point3D& srcOrigin,
+            std::uint32_t srcMipLevel,
+            std::uint32_t srcBaseArrayLayer,
+            const common::sp<ITextureView>& dst,
+            const Point3D& dstOrigin,
+            std::uint32_t dstMipLevel,
+            std::uint32_t dstBaseArrayLayer,
+            const Size3D& copySize) override;
+
+        virtual bool GenerateMipmaps(const common::sp<ITextureView>& texture) override;
+    };
+
+    class NullCommandList : public ICommandList {
+        friend class NullRenderCmdEnc;
+        friend class NullComputeCmdEnc;
+        friend class NullTransferCmdEnc;
+
+        // Copies run on the CPU once the list is submitted
+        struct _Copy {
+            enum class Kind { Buffer, BufferToTexture, TextureToBuffer, Texture, Mipmaps } kind;
+
+            common::sp<BufferRange> buffer;
+            std::uint32_t bytesPerRow;
+            std::uint32_t bytesPerImage;
+
+            common::sp<BufferRange> dstBuffer;
+            std::uint32_t sizeInBytes;
+
+            common::sp<ITextureView> srcTex;
+            Point3D srcOrigin;
+            std::uint32_t srcMipLevel;
+            std::uint32_t srcArrayLayer;
+
+            common::sp<ITextureView> dstTex;
+            Point3D dstOrigin;
+            std::uint32_t dstMipLevel;
+            std::uint32_t dstArrayLayer;
+
+            Size3D size;
+        };
+
+        common::sp<NullDevice> _dev;
+
+        NullRenderCmdEnc _renderEnc;
+        NullComputeCmdEnc _computeEnc;
+        NullTransferCmdEnc _transferEnc;
+        bool _inPass;
+
+        std::vector<_Copy> _copies;
+
+        bool _logging;
+        std::vector<std::uint32_t> _log;
+
+        // Marks are indices into _copies
+        bool _profiling;
+        NullGpuProfileRecording _profile;
+
+        std::string _debugName;
+
+        void _Log(NullCommandOp op, std::initializer_list<std::uint32_t> args = {}) {
+            if(!_logging) return;
+            _log.push_back(((std::uint32_t)op << 16) | (std::uint32_t)args.size());
+            _log.insert(_log.end(), args.begin(), args.end());
+        }
+
+    public:
+        NullCommandList(const common::sp<NullDevice>& dev);
+
+        // Called by the queue on submission, queueIdx as in
+        // IGpuProfiler::Scope::queue
+        void Execute(std::uint32_t queueIdx);
+
+        virtual void Begin() override;
+        virtual void End() override;
+
+        virtual IRenderCommandEncoder& BeginRenderPass(
+            const RenderPassAction&, const PassResourceUsage&) override;
+        virtual IComputeCommandEncoder& BeginComputePass(const PassResourceUsage&) override;
+        virtual ITransferCommandEncoder& BeginTransferPass() override;
+
+        virtual void SetDebugName(const std::string& name) override { _debugName = name; }
+
+        virtual void EndPass() override;
+
+        virtual void Barrier(std::span<const alloy::BarrierOp> barriers) override;
+
+        virtual void PushDebugGroup(const std::string& name, const Color4f&) override;
+        virtual void PopDebugGroup() override;
+        virtual void InsertDebugMarker(const std::string& name, const Color4f&) override;
+    };
+
+}
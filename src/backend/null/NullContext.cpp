@@ -0,0 +1,133 @@
+#include "NullContext.hpp"
+
+#include "NullDevice.hpp"
+
+namespace alloy
+{
+    common::sp<IContext> CreateNullContext(const IContext::Options& opts) {
+        return alloy::null::NullContext::Make(opts);
+    }
+
+    common::sp<IGraphicsDevice> CreateNullGraphicsDevice(
+        const IGraphicsDevice::Options& options
+    ){
+        auto ctx = CreateNullContext({});
+        return ctx->CreateDefaultDevice(options);
+    }
+
+} // namespace alloy
+
+namespace alloy::null
+{
+    NullAdapter::NullAdapter(const common::sp<NullContext>& ctx)
+        : _ctx(ctx)
+    {
+        // Nothing is really limited, report values at least as large as
+        // any real backend so callers don't clamp their workloads.
+        auto& limits = info.limits;
+        limits.maxImageDimension1D = 16384;
+        limits.maxImageDimension2D = 16384;
+        limits.maxImageDimension3D = 2048;
+        limits.maxImageDimensionCube = 16384;
+        limits.maxImageArrayLayers = 2048;
+        limits.maxTexelBufferElements = 1u << 27;
+        limits.maxUniformBufferRange = 1u << 16;
+        limits.maxStorageBufferRange = 1u << 31;
+        limits.maxPushConstantsSize = 256;
+        limits.maxMemoryAllocationCount = 0xffffffffu;
+        limits.maxSamplerAllocationCount = 0xffffffffu;
+        limits.bufferImageGranularity = 1;
+        limits.sparseAddressSpaceSize = 0;
+        limits.maxBoundDescriptorSets = 32;
+        limits.maxPerStageDescriptorSamplers = 1u << 20;
+        limits.maxPerStageDescriptorUniformBuffers = 1u << 20;
+        limits.maxPerStageDescriptorStorageBuffers = 1u << 20;
+        limits.maxPerStageDescriptorSampledImages = 1u << 20;
+        limits.maxPerStageDescriptorStorageImages = 1u << 20;
+        limits.maxPerStageDescriptorInputAttachments = 1u << 20;
+        limits.maxPerStageResources = 1u << 20;
+        limits.maxVertexInputAttributes = 32;
+        limits.maxVertexInputBindings = 32;
+        limits.maxVertexInputAttributeOffset = 2047;
+        limits.maxVertexInputBindingStride = 2048;
+        limits.maxVertexOutputComponents = 128;
+        limits.maxFragmentInputComponents = 128;
+        limits.maxFragmentOutputAttachments = 8;
+        limits.maxFragmentDualSrcAttachments = 1;
+        limits.maxFragmentCombinedOutputResources = 1u << 20;
+        limits.maxComputeSharedMemorySize = 1u << 16;
+        for(auto& c : limits.maxComputeWorkGroupCount) c = 65535;
+        limits.maxComputeWorkGroupInvocations = 1024;
+        limits.maxComputeWorkGroupSize[0] = 1024;
+        limits.maxComputeWorkGroupSize[1] = 1024;
+        limits.maxComputeWorkGroupSize[2] = 64;
+        limits.maxDrawIndexedIndexValue = 0xffffffffu;
+        limits.maxDrawIndirectCount = 0xffffffffu;
+        limits.maxSamplerLodBias = 16.f;
+        limits.maxSamplerAnisotropy = 16.f;
+        limits.maxViewports = 16;
+        limits.maxViewportDimensions[0] = 16384;
+        limits.maxViewportDimensions[1] = 16384;
+        limits.minMemoryMapAlignment = 64;
+        limits.minTexelBufferOffsetAlignment = 16;
+        limits.minUniformBufferOffsetAlignment = 256;
+        limits.minStorageBufferOffsetAlignment = 16;
+        limits.maxFramebufferWidth = 16384;
+        limits.maxFramebufferHeight = 16384;
+        limits.maxFramebufferLayers = 2048;
+        limits.maxColorAttachments = 8;
+        limits.timestampPeriod = 1.f;
+        limits.maxClipDistances = 8;
+        limits.maxCullDistances = 8;
+        limits.maxCombinedClipAndCullDistances = 8;
+        limits.pointSizeGranularity = 1.f;
+        limits.lineWidthGranularity = 1.f;
+        limits.maxMSAASampleCount = SampleCount::x8;
+        limits.minStructuredBufferStride = 4;
+
+        auto& caps = info.capabilities;
+        caps.supportMeshShader = 1;
+        caps.supportRayTracing = 0;
+        caps.supportDedicatedTransferQueue = 0;
+        caps.isUMA = 1;
+        caps.supportResizableBar = 1;
+        caps.supportNonUniformResourceIndexing = 1;
+
+        info.resourceBindingModel = ResourceBindingModel::DescriptorHeap;
+
+        MemorySegmentProperties sysMem {};
+        sysMem.flags.isInSysMem = 1;
+        sysMem.flags.isCPUVisible = 1;
+        sysMem.sizeInBytes = 0;
+        info.memSegments.push_back(sysMem);
+
+        info.apiVersion = { Backend::Null, 1, 0, 0, 0 };
+        info.driverVersion = 0;
+        info.vendorID = 0;
+        info.deviceID = 0;
+        info.deviceName = "Null device";
+    }
+
+    common::sp<IGraphicsDevice> NullAdapter::RequestDevice(
+        const IGraphicsDevice::Options& options
+    ) {
+        return NullDevice::Make(common::ref_sp(this), options);
+    }
+
+    common::sp<IContext> NullContext::Make(const IContext::Options& opts) {
+        return common::sp<IContext>(new NullContext(opts));
+    }
+
+    common::sp<IGraphicsDevice> NullContext::CreateDefaultDevice(
+        const IGraphicsDevice::Options& options
+    ) {
+        auto adps = EnumerateAdapters();
+        return adps.front()->RequestDevice(options);
+    }
+
+    std::vector<common::sp<IPhysicalAdapter>> NullContext::EnumerateAdapters() {
+        auto adp = new NullAdapter(common::ref_sp(this));
+        return { common::sp<IPhysicalAdapter>(adp) };
+    }
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/Context.hpp"
+
+#include <vector>
+
+namespace alloy::null
+{
+    class NullContext;
+
+    class NullAdapter : public IPhysicalAdapter {
+
+        common::sp<NullContext> _ctx;
+
+    public:
+        NullAdapter(const common::sp<NullContext>& ctx);
+
+        virtual common::sp<IGraphicsDevice> RequestDevice(
+            const IGraphicsDevice::Options& options) override;
+    };
+
+    class NullContext : public IContext {
+
+        IContext::Options _opts;
+
+        NullContext(const IContext::Options& opts) : _opts(opts) { }
+
+    public:
+        static common::sp<IContext> Make(const IContext::Options& opts);
+
+        virtual common::sp<IGraphicsDevice> CreateDefaultDevice(
+            const IGraphicsDevice::Options& options) override;
+
+        virtual std::vector<common::sp<IPhysicalAdapter>> EnumerateAdapters() override;
+    };
+
+}
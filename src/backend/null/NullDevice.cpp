@@ -0,0 +1,327 @@
+#include "NullDevice.hpp"
+
+#include "alloy/common/Common.hpp"
+#include "alloy/backend/NullBackend.hpp"
+#include "alloy/Helpers.hpp"
+
+#include <chrono>
+#include <limits>
+#include <sstream>
+
+#include "NullCommandList.hpp"
+#include "NullResources.hpp"
+
+namespace alloy
+{
+    const char* GetNullCommandOpName(NullCommandOp op) {
+        switch(op) {
+        case NullCommandOp::Begin: return "Begin";
+        case NullCommandOp::End: return "End";
+        case NullCommandOp::BeginRenderPass: return "BeginRenderPass";
+        case NullCommandOp::BeginComputePass: return "BeginComputePass";
+        case NullCommandOp::BeginTransferPass: return "BeginTransferPass";
+        case NullCommandOp::EndPass: return "EndPass";
+        case NullCommandOp::Barrier: return "Barrier";
+        case NullCommandOp::PushDebugGroup: return "PushDebugGroup";
+        case NullCommandOp::PopDebugGroup: return "PopDebugGroup";
+        case NullCommandOp::InsertDebugMarker: return "InsertDebugMarker";
+        case NullCommandOp::SetPipeline: return "SetPipeline";
+        case NullCommandOp::SetVertexBuffer: return "SetVertexBuffer";
+        case NullCommandOp::SetIndexBuffer: return "SetIndexBuffer";
+        case NullCommandOp::SetPushConstants: return "SetPushConstants";
+        case NullCommandOp::SetResourceSet: return "SetResourceSet";
+        case NullCommandOp::SetMutableResourceSet: return "SetMutableResourceSet";
+        case NullCommandOp::SetResources: return "SetResources";
+        case NullCommandOp::SetDescriptorHeaps: return "SetDescriptorHeaps";
+        case NullCommandOp::SetViewports: return "SetViewports";
+        case NullCommandOp::SetScissorRects: return "SetScissorRects";
+        case NullCommandOp::Draw: return "Draw";
+        case NullCommandOp::DrawIndexed: return "DrawIndexed";
+        case NullCommandOp::DispatchMesh: return "DispatchMesh";
+        case NullCommandOp::Dispatch: return "Dispatch";
+        case NullCommandOp::CopyBuffer: return "CopyBuffer";
+        case NullCommandOp::CopyBufferToTexture: return "CopyBufferToTexture";
+        case NullCommandOp::CopyTextureToBuffer: return "CopyTextureToBuffer";
+        case NullCommandOp::CopyTexture: return "CopyTexture";
+        case NullCommandOp::GenerateMipmaps: return "GenerateMipmaps";
+        default: return "Unknown";
+        }
+    }
+
+    void SetNullCommandLogEnabled(IGraphicsDevice* dev, bool enabled) {
+        if(auto nullDev = dynamic_cast<null::NullDevice*>(dev)) {
+            nullDev->SetCommandLogEnabled(enabled);
+        }
+    }
+
+    std::vector<std::uint32_t> TakeNullCommandLog(IGraphicsDevice* dev) {
+        if(auto nullDev = dynamic_cast<null::NullDevice*>(dev)) {
+            return nullDev->TakeCommandLog();
+        }
+        return {};
+    }
+
+    std::string DumpNullCommandLog(std::span<const std::uint32_t> log) {
+        std::ostringstream out;
+        for(std::size_t i = 0; i < log.size();) {
+            auto op = (NullCommandOp)(log[i] >> 16);
+            std::uint32_t argCnt = log[i] & 0xffffu;
+            out << GetNullCommandOpName(op);
+            for(std::uint32_t arg = 0; arg < argCnt && i + 1 + arg < log.size(); ++arg) {
+                out << (arg == 0 ? " " : ", ") << log[i + 1 + arg];
+            }
+            out << '\n';
+            i += 1 + argCnt;
+        }
+        return out.str();
+    }
+
+} // namespace alloy
+
+namespace alloy::null
+{
+    void NullCommandQueue::EncodeSignalEvent(IEvent* evt, uint64_t value) {
+        evt->SignalFromCPU(value);
+    }
+
+    void NullCommandQueue::SubmitCommand(ICommandList* cmd) {
+        auto* nullCmd = common::PtrCast<NullCommandList>(cmd);
+        nullCmd->Execute(_queueIdx);
+    }
+
+    common::sp<ICommandList> NullCommandQueue::CreateCommandList() {
+        return common::sp<ICommandList>(new NullCommandList(common::ref_sp(_dev)));
+    }
+
+    NullDevice::NullDevice(const common::sp<NullAdapter>& adp)
+        : _adp(adp)
+        , _features{}
+        , _logEnabled(false)
+    {
+        _features.computeShader = 1;
+        _features.geometryShader = 1;
+        _features.tessellationShaders = 1;
+        _features.multipleViewports = 1;
+        _features.samplerLodBias = 1;
+        _features.drawBaseVertex = 1;
+        _features.drawBaseInstance = 1;
+        _features.drawIndirect = 1;
+        _features.drawIndirectBaseInstance = 1;
+        _features.fillModeWireframe = 1;
+        _features.samplerAnisotropy = 1;
+        _features.depthClipDisable = 1;
+        _features.texture1D = 1;
+        _features.independentBlend = 1;
+        _features.structuredBuffer = 1;
+        _features.subsetTextureView = 1;
+        _features.commandListDebugMarkers = 1;
+        _features.bufferRangeBinding = 1;
+        _features.shaderFloat64 = 1;
+        _features.dynamicRasterState = 1;
+        _features.dynamicBlendEnable = 1;
+        _features.inlineResources = 1;
+        _features.bufferDeviceAddress = 1;
+        _features.placedResources = 1;
+        _features.generateMipmaps = 1;
+
+        _gfxQ = std::make_unique<NullCommandQueue>(this, 0);
+        _copyQ = std::make_unique<NullCommandQueue>(this, 1);
+        _computeQ = std::make_unique<NullCommandQueue>(this, 2);
+    }
+
+    NullDevice::~NullDevice() = default;
+
+    common::sp<IGraphicsDevice> NullDevice::Make(
+        const common::sp<NullAdapter>& adp,
+        const IGraphicsDevice::Options& options
+    ) {
+        return common::sp<IGraphicsDevice>(new NullDevice(adp));
+    }
+
+    bool NullDevice::CanGenerateMipmaps(PixelFormat format) const {
+        return !FormatHelpers::IsCompressedFormat(format);
+    }
+
+    void NullDevice::AppendCommandLog(std::span<const std::uint32_t> words) {
+        std::scoped_lock l{_m_log};
+        _log.insert(_log.end(), words.begin(), words.end());
+    }
+
+    std::vector<std::uint32_t> NullDevice::TakeCommandLog() {
+        std::scoped_lock l{_m_log};
+        return std::exchange(_log, {});
+    }
+
+    ISwapChain::State NullDevice::PresentToSwapChain(ISwapChain* sc) {
+        common::PtrCast<NullSwapChain>(sc)->AdvanceBackBuffer();
+        return ISwapChain::State::Optimal;
+    }
+
+    common::sp<ITexture> NullDevice::CreateTexture(const ITexture::Description& description) {
+        return common::sp<ITexture>(new NullTexture(common::ref_sp(this), description));
+    }
+
+    common::sp<IBuffer> NullDevice::CreateBuffer(const IBuffer::Description& description) {
+        return common::sp<IBuffer>(new NullBuffer(common::ref_sp(this), description));
+    }
+
+    common::sp<ISampler> NullDevice::CreateSampler(const ISampler::Description& description) {
+        return common::sp<ISampler>(new NullSampler(description));
+    }
+
+    common::sp<IResourceSet> NullDevice::CreateResourceSet(
+        const IResourceSet::Description& description
+    ) {
+        return common::sp<IResourceSet>(new NullResourceSet(description));
+    }
+
+    common::sp<IMutableResourceSet> NullDevice::CreateMutableResourceSet(
+        const IMutableResourceSet::Description& description
+    ) {
+        return common::sp<IMutableResourceSet>(new NullMutableResourceSet(description));
+    }
+
+    common::sp<IResourceDescriptorHeap> NullDevice::CreateResourceDescriptorHeap(
+        const IResourceDescriptorHeap::Description& description
+    ) {
+        return common::sp<IResourceDescriptorHeap>(new NullResourceDescriptorHeap(description));
+    }
+
+    common::sp<ISamplerDescriptorHeap> NullDevice::CreateSamplerDescriptorHeap(
+        const ISamplerDescriptorHeap::Description& description
+    ) {
+        return common::sp<ISamplerDescriptorHeap>(new NullSamplerDescriptorHeap(description));
+    }
+
+    common::sp<IResourceLayout> NullDevice::CreateResourceLayout(
+        const IResourceLayout::Description& description
+    ) {
+        return common::sp<IResourceLayout>(new NullResourceLayout(description));
+    }
+
+    common::sp<ISwapChain> NullDevice::CreateSwapChain(const ISwapChain::Description& description) {
+        return common::sp<ISwapChain>(new NullSwapChain(common::ref_sp(this), description));
+    }
+
+    common::sp<IShader> NullDevice::CreateShader(
+        const IShader::Description& description,
+        const std::span<const std::uint8_t>& il
+    ) {
+        return common::sp<IShader>(new NullShader(description, il));
+    }
+
+    common::sp<IGfxPipeline> NullDevice::CreateGraphicsPipeline(
+        const GraphicsPipelineDescription& description
+    ) {
+        return common::sp<IGfxPipeline>(new NullGraphicsPipeline(description));
+    }
+
+    common::sp<IComputePipeline> NullDevice::CreateComputePipeline(
+        const ComputePipelineDescription& description
+    ) {
+        return common::sp<IComputePipeline>(new NullComputePipeline(description));
+    }
+
+    common::sp<IMeshShaderPipeline> NullDevice::CreateMeshShaderPipeline(
+        const MeshShaderPipelineDescription& description
+    ) {
+        return common::sp<IMeshShaderPipeline>(new NullMeshShaderPipeline(description));
+    }
+
+    common::sp<ITextureView> NullDevice::CreateTextureView(
+        const common::sp<ITexture>& texture,
+        const ITextureView::Description& description
+    ) {
+        return common::sp<ITextureView>(new NullTextureView(texture, description));
+    }
+
+    common::sp<IEvent> NullDevice::CreateSyncEvent() {
+        return common::sp<IEvent>(new NullEvent());
+    }
+
+    common::sp<IMemoryHeap> NullDevice::CreateMemoryHeap(const IMemoryHeap::Description& description) {
+        return common::sp<IMemoryHeap>(new NullMemoryHeap(description));
+    }
+
+    IMemoryHeap::Placement NullDevice::GetPlacement(const IBuffer::Description& description) {
+        return { description.sizeInBytes, NullMemoryHeap::kPlacementAlignment };
+    }
+
+    IMemoryHeap::Placement NullDevice::GetPlacement(const ITexture::Description& description) {
+        return { NullTexture::ComputeSizeInBytes(description), NullMemoryHeap::kPlacementAlignment };
+    }
+
+    common::sp<IBuffer> NullDevice::CreatePlacedBuffer(
+        const common::sp<IMemoryHeap>& heap,
+        std::uint64_t offset,
+        const IBuffer::Description& description
+    ) {
+        auto nullHeap = common::PtrCast<NullMemoryHeap>(heap.get());
+        if(description.hostAccess != HostAccess::None
+            || !nullHeap->CanHold(description)
+            || !nullHeap->CanPlace(GetPlacement(description), offset))
+            return nullptr;
+        return CreateBuffer(description);
+    }
+
+    common::sp<ITexture> NullDevice::CreatePlacedTexture(
+        const common::sp<IMemoryHeap>& heap,
+        std::uint64_t offset,
+        const ITexture::Description& description
+    ) {
+        auto nullHeap = common::PtrCast<NullMemoryHeap>(heap.get());
+        if(description.hostAccess != HostAccess::None
+            || !nullHeap->CanHold(description)
+            || !nullHeap->CanPlace(GetPlacement(description), offset))
+            return nullptr;
+        return CreateTexture(description);
+    }
+
+    uint64_t NullEvent::GetSignaledValue() {
+        std::scoped_lock l{_m};
+        return _value;
+    }
+
+    void NullEvent::SignalFromCPU(uint64_t signalValue) {
+        std::vector<ReachedCallback> ready;
+        {
+            std::scoped_lock l{_m};
+            _value = signalValue;
+            std::erase_if(_callbacks, [&](auto& cb) {
+                if(cb.first > signalValue) return false;
+                ready.push_back(std::move(cb.second));
+                return true;
+            });
+        }
+        _cv.notify_all();
+        for(auto& fn : ready)
+            fn(true);
+    }
+
+    bool NullEvent::WaitFromCPU(uint64_t expectedValue, uint32_t timeoutMs) {
+        std::unique_lock l{_m};
+        auto reached = [&]() { return _value >= expectedValue; };
+        if(timeoutMs == (std::numeric_limits<std::uint32_t>::max)()) {
+            _cv.wait(l, reached);
+            return true;
+        }
+        return _cv.wait_for(l, std::chrono::milliseconds(timeoutMs), reached);
+    }
+
+    void NullEvent::OnReached(uint64_t value, ReachedCallback callback) {
+        {
+            std::scoped_lock l{_m};
+            if(_value < value) {
+                _callbacks.emplace_back(value, std::move(callback));
+                return;
+            }
+        }
+        callback(true);
+    }
+
+    NullEvent::~NullEvent() {
+        for(auto& cb : _callbacks)
+            cb.second(false);
+    }
+
+}
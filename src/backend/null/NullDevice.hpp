@@ -0,0 +1,178 @@
+#pragma once
+
+#include "alloy/common/Macros.h"
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/GraphicsDevice.hpp"
+#include "alloy/ResourceFactory.hpp"
+#include "alloy/CommandQueue.hpp"
+#include "alloy/SyncObjects.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "NullContext.hpp"
+#include "NullGpuProfiler.hpp"
+
+namespace alloy::null
+{
+    class NullDevice;
+
+    class NullCommandQueue : public ICommandQueue {
+
+        NullDevice* _dev;
+        // As in IGpuProfiler::Scope::queue
+        std::uint32_t _queueIdx;
+
+    public:
+        NullCommandQueue(NullDevice* dev, std::uint32_t queueIdx)
+            : _dev(dev), _queueIdx(queueIdx) { }
+
+        /*ICommandQueue implementations*/
+        // Work completes as soon as it's submitted, so signals happen
+        // right away and waits are already satisfied.
+        virtual void EncodeSignalEvent(IEvent* evt, uint64_t value) override;
+        virtual void EncodeWaitForEvent(IEvent* evt, uint64_t value) override { }
+
+        virtual void SubmitCommand(ICommandList* cmd) override;
+
+        virtual common::sp<ICommandList> CreateCommandList() override;
+
+        virtual void* GetNativeHandle() const override { return nullptr; }
+    };
+
+    class NullDevice : public IGraphicsDevice
+                     , public ResourceFactory
+    {
+        common::sp<NullAdapter> _adp;
+        IGraphicsDevice::Features _features;
+
+        std::unique_ptr<NullCommandQueue> _gfxQ;
+        std::unique_ptr<NullCommandQueue> _copyQ;
+        std::unique_ptr<NullCommandQueue> _computeQ;
+
+        std::atomic<bool> _logEnabled;
+        std::mutex _m_log;
+        std::vector<std::uint32_t> _log;
+
+        NullGpuProfiler _gpuProfiler;
+
+        NullDevice(const common::sp<NullAdapter>& adp);
+
+    public:
+        ~NullDevice() override;
+
+        static common::sp<IGraphicsDevice> Make(
+            const common::sp<NullAdapter>& adp,
+            const IGraphicsDevice::Options& options);
+
+        bool IsCommandLogEnabled() const {
+            return _logEnabled.load(std::memory_order_relaxed);
+        }
+        void SetCommandLogEnabled(bool enabled) {
+            _logEnabled.store(enabled, std::memory_order_relaxed);
+        }
+        void AppendCommandLog(std::span<const std::uint32_t> words);
+        std::vector<std::uint32_t> TakeCommandLog();
+
+        NullGpuProfiler& GetNullGpuProfiler() { return _gpuProfiler; }
+
+    //IGraphicsDevice
+    public:
+        virtual const Features& GetFeatures() const override { return _features; }
+        virtual IPhysicalAdapter& GetAdapter() const override { return *_adp; }
+
+        virtual void* GetNativeHandle() const override { return nullptr; }
+
+        virtual ResourceFactory& GetResourceFactory() override { return *this; }
+
+        virtual ISwapChain::State PresentToSwapChain(ISwapChain* sc) override;
+
+        virtual ICommandQueue* GetGfxCommandQueue() override { return _gfxQ.get(); }
+        virtual ICommandQueue* GetCopyCommandQueue() override { return _copyQ.get(); }
+        virtual ICommandQueue* GetComputeCommandQueue() override { return _computeQ.get(); }
+
+        virtual void WaitForIdle() override { }
+
+        virtual IGpuProfiler* GetGpuProfiler() override { return &_gpuProfiler; }
+
+        virtual bool CanGenerateMipmaps(PixelFormat format) const override;
+
+    //ResourceFactory
+    public:
+        #define NULL_DECL_RF_CREATE_WITH_DESC(ResType) \
+            virtual common::sp<I##ResType> Create##ResType ( \
+                const I##ResType ::Description& description) override;
+
+        VLD_RF_FOR_EACH_RES(NULL_DECL_RF_CREATE_WITH_DESC)
+
+        #undef NULL_DECL_RF_CREATE_WITH_DESC
+
+        virtual common::sp<IShader> CreateShader(
+            const IShader::Description& description,
+            const std::span<const std::uint8_t>& il) override;
+
+        virtual common::sp<IGfxPipeline> CreateGraphicsPipeline(
+            const GraphicsPipelineDescription& description) override;
+
+        virtual common::sp<IComputePipeline> CreateComputePipeline(
+            const ComputePipelineDescription& description) override;
+
+        virtual common::sp<IMeshShaderPipeline> CreateMeshShaderPipeline(
+            const MeshShaderPipelineDescription& description) override;
+
+        // There are no native objects to wrap
+        virtual common::sp<ITexture> WrapNativeTexture(
+            void* nativeHandle,
+            const ITexture::Description& description) override { return nullptr; }
+
+        using ResourceFactory::CreateTextureView;
+        virtual common::sp<ITextureView> CreateTextureView(
+            const common::sp<ITexture>& texture,
+            const ITextureView::Description& description) override;
+
+        virtual common::sp<IEvent> CreateSyncEvent() override;
+
+        virtual common::sp<IMemoryHeap> CreateMemoryHeap(
+            const IMemoryHeap::Description& description) override;
+
+        virtual IMemoryHeap::Placement GetPlacement(
+            const IBuffer::Description& description) override;
+        virtual IMemoryHeap::Placement GetPlacement(
+            const ITexture::Description& description) override;
+
+        virtual common::sp<IBuffer> CreatePlacedBuffer(
+            const common::sp<IMemoryHeap>& heap,
+            std::uint64_t offset,
+            const IBuffer::Description& description) override;
+        virtual common::sp<ITexture> CreatePlacedTexture(
+            const common::sp<IMemoryHeap>& heap,
+            std::uint64_t offset,
+            const ITexture::Description& description) override;
+    };
+
+    class NullEvent : public IEvent {
+
+        std::mutex _m;
+        std::condition_variable _cv;
+        uint64_t _value = 0;
+        // Run by the signaling thread, or the destroying one
+        std::vector<std::pair<uint64_t, ReachedCallback>> _callbacks;
+
+    public:
+        virtual ~NullEvent() override;
+
+        virtual uint64_t GetSignaledValue() override;
+
+        virtual void SignalFromCPU(uint64_t signalValue) override;
+        virtual bool WaitFromCPU(uint64_t expectedValue, uint32_t timeoutMs) override;
+        using IEvent::WaitFromCPU;
+        virtual void OnReached(uint64_t value, ReachedCallback callback) override;
+    };
+
+}
@@ -0,0 +1,89 @@
+#include "NullGpuProfiler.hpp"
+
+#include <cassert>
+#include <utility>
+
+namespace alloy::null
+{
+    NullGpuProfiler::NullGpuProfiler()
+        : _enabled(false)
+        , _current{0, {}}
+    { }
+
+    void NullGpuProfiler::BeginScope(
+        NullGpuProfileRecording& rec,
+        const std::string& name,
+        bool isPass,
+        std::uint32_t mark
+    ) {
+        std::uint32_t parent = rec.stack.empty() ? kNoParent : rec.stack.back();
+        std::uint32_t scopeIdx = rec.scopes.size();
+
+        rec.scopes.push_back({ name, parent, (std::uint32_t)rec.stack.size(), mark, mark });
+
+        if(isPass) rec.passDepth = rec.stack.size();
+        rec.stack.push_back(scopeIdx);
+    }
+
+    void NullGpuProfiler::EndGroupScope(NullGpuProfileRecording& rec, std::uint32_t mark) {
+        // Unbalanced pop, or pop of the pass scope itself
+        if(rec.stack.empty()) return;
+        if(rec.passDepth != kNoParent && rec.stack.size() - 1 == rec.passDepth) return;
+
+        rec.scopes[rec.stack.back()].endMark = mark;
+        rec.stack.pop_back();
+    }
+
+    void NullGpuProfiler::EndPassScope(NullGpuProfileRecording& rec, std::uint32_t mark) {
+        if(rec.passDepth == kNoParent) return;
+
+        // Groups left open inside the pass end with it
+        while(rec.stack.size() > rec.passDepth) {
+            rec.scopes[rec.stack.back()].endMark = mark;
+            rec.stack.pop_back();
+        }
+        rec.passDepth = kNoParent;
+    }
+
+    void NullGpuProfiler::EndAllScopes(NullGpuProfileRecording& rec, std::uint32_t mark) {
+        for(auto scopeIdx : rec.stack) {
+            rec.scopes[scopeIdx].endMark = mark;
+        }
+        rec.stack.clear();
+        rec.passDepth = kNoParent;
+    }
+
+    void NullGpuProfiler::OnSubmit(
+        const NullGpuProfileRecording& rec,
+        std::uint32_t queueIdx,
+        std::span<const std::uint64_t> markNs
+    ) {
+        if(rec.scopes.empty()) return;
+
+        std::scoped_lock l{_m_frames};
+        std::uint32_t base = _current.scopes.size();
+        for(auto& scope : rec.scopes) {
+            assert(scope.endMark < markNs.size());
+            _current.scopes.push_back({
+                scope.name,
+                scope.parent == kNoParent ? kNoParent : base + scope.parent,
+                scope.depth,
+                queueIdx,
+                markNs[scope.beginMark],
+                markNs[scope.endMark]
+            });
+        }
+    }
+
+    void NullGpuProfiler::EndFrame() {
+        std::scoped_lock l{_m_frames};
+        auto nextIdx = _current.frameIdx + 1;
+        _ended.push_back(std::exchange(_current, Frame{nextIdx, {}}));
+    }
+
+    std::vector<IGpuProfiler::Frame> NullGpuProfiler::CollectFrames() {
+        std::scoped_lock l{_m_frames};
+        return std::exchange(_ended, {});
+    }
+
+}
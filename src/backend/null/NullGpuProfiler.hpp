@@ -0,0 +1,87 @@
+#pragma once
+
+#include "alloy/common/Macros.h"
+#include "alloy/GpuProfiler.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+// IGpuProfiler on the host clock.
+//
+// Scope boundaries are recorded as positions in the command list's copy
+// stream. Execute() reads the clock around each copy as it runs them and
+// hands the readings over, so a scope spans exactly the work recorded
+// inside it. Submissions finish before SubmitCommand() returns, a frame
+// is ready as soon as it's ended.
+
+namespace alloy::null
+{
+    struct NullGpuProfileRecording {
+        struct Scope {
+            std::string name;
+            std::uint32_t parent;
+            std::uint32_t depth;
+            // Index of the first copy inside the scope, and of the first
+            // one after it
+            std::uint32_t beginMark;
+            std::uint32_t endMark;
+        };
+
+        std::vector<Scope> scopes;
+        // Open scopes, innermost last
+        std::vector<std::uint32_t> stack;
+        // Stack depth of the open pass scope, if any
+        std::uint32_t passDepth = IGpuProfiler::kNoParent;
+
+        void Reset() {
+            scopes.clear();
+            stack.clear();
+            passDepth = IGpuProfiler::kNoParent;
+        }
+    };
+
+    class NullGpuProfiler : public IGpuProfiler {
+        DISABLE_COPY_AND_ASSIGN(NullGpuProfiler);
+
+        std::atomic<bool> _enabled;
+
+        std::mutex _m_frames;
+        Frame _current;
+        std::vector<Frame> _ended;
+
+    public:
+        NullGpuProfiler();
+
+        void BeginScope(
+            NullGpuProfileRecording& rec,
+            const std::string& name,
+            bool isPass,
+            std::uint32_t mark);
+        // Closes the innermost debug group, never the pass scope
+        void EndGroupScope(NullGpuProfileRecording& rec, std::uint32_t mark);
+        // Closes the pass scope and debug groups left open in it
+        void EndPassScope(NullGpuProfileRecording& rec, std::uint32_t mark);
+        void EndAllScopes(NullGpuProfileRecording& rec, std::uint32_t mark);
+
+        // markNs holds the clock, in nanoseconds, at every mark
+        void OnSubmit(
+            const NullGpuProfileRecording& rec,
+            std::uint32_t queueIdx,
+            std::span<const std::uint64_t> markNs);
+
+        /*IGpuProfiler implementations*/
+        virtual void SetEnabled(bool enabled) override {
+            _enabled.store(enabled, std::memory_order_relaxed);
+        }
+        virtual bool IsEnabled() const override {
+            return _enabled.load(std::memory_order_relaxed);
+        }
+        virtual void EndFrame() override;
+        virtual std::vector<Frame> CollectFrames() override;
+    };
+
+}
@@ -0,0 +1,383 @@
+#include "NullResources.hpp"
+
+#include "alloy/common/Common.hpp"
+#include "alloy/Helpers.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+#include "NullDevice.hpp"
+
+namespace alloy::null
+{
+    namespace {
+        enum class _MipChannel { Point, UNorm8, UNorm16, Float32 };
+
+        _MipChannel _GetMipChannel(PixelFormat format) {
+            switch(format) {
+            case PixelFormat::R8_UNorm:
+            case PixelFormat::R8_G8_UNorm:
+            case PixelFormat::R8_G8_B8_A8_UNorm:
+            case PixelFormat::B8_G8_R8_A8_UNorm:
+            // Averaged as stored, not in linear space
+            case PixelFormat::R8_G8_B8_A8_UNorm_SRgb:
+            case PixelFormat::B8_G8_R8_A8_UNorm_SRgb:
+                return _MipChannel::UNorm8;
+            case PixelFormat::R16_UNorm:
+            case PixelFormat::R16_G16_UNorm:
+            case PixelFormat::R16_G16_B16_A16_UNorm:
+                return _MipChannel::UNorm16;
+            case PixelFormat::R32_Float:
+            case PixelFormat::R32_G32_Float:
+            case PixelFormat::R32_G32_B32_A32_Float:
+                return _MipChannel::Float32;
+            default:
+                return _MipChannel::Point;
+            }
+        }
+
+        template<typename T, typename Sum>
+        void _AverageTexels(
+            std::uint8_t* dst,
+            const std::uint8_t* const* srcs,
+            std::uint32_t srcCnt,
+            std::uint32_t texelSize
+        ) {
+            for(std::uint32_t offset = 0; offset < texelSize; offset += sizeof(T)) {
+                Sum sum{};
+                for(std::uint32_t i = 0; i < srcCnt; i++) {
+                    T v;
+                    std::memcpy(&v, srcs[i] + offset, sizeof(T));
+                    sum += v;
+                }
+                T avg;
+                if constexpr (std::is_floating_point_v<T>)
+                    avg = T(sum / srcCnt);
+                else
+                    avg = T((sum + srcCnt / 2) / srcCnt);
+                std::memcpy(dst + offset, &avg, sizeof(T));
+            }
+        }
+    }
+
+    NullBuffer::NullBuffer(const common::sp<NullDevice>& dev, const Description& desc)
+        : _dev(dev)
+        , _desc(desc)
+        , _data(new std::uint8_t[desc.sizeInBytes]())
+    { }
+
+    std::uint64_t NullTexture::_LayOutMipChain(const Description& desc, SubresourceLayout* mips) {
+        std::uint64_t layerSize = 0;
+        for(std::uint32_t mip = 0; mip < desc.mipLevels; mip++) {
+            auto mipW = std::max(1u, desc.width >> mip);
+            auto mipH = std::max(1u, desc.height >> mip);
+            auto mipD = std::max(1u, desc.depth >> mip);
+
+            SubresourceLayout layout{};
+            layout.offset = layerSize;
+            layout.rowPitch = FormatHelpers::GetRowPitch(mipW, desc.format);
+            layout.depthPitch = FormatHelpers::GetDepthPitch(
+                (std::uint32_t)layout.rowPitch, mipH, desc.format);
+            layerSize += layout.depthPitch * mipD;
+            if(mips) mips[mip] = layout;
+        }
+        return layerSize;
+    }
+
+    std::uint64_t NullTexture::ComputeSizeInBytes(const Description& desc) {
+        return _LayOutMipChain(desc, nullptr) * GetArrayLayerCount(desc);
+    }
+
+    NullTexture::NullTexture(const common::sp<NullDevice>& dev, const Description& desc)
+        : _dev(dev)
+        , _desc(desc)
+    {
+        auto layers = GetArrayLayerCount();
+        _subresources.resize(layers * desc.mipLevels);
+
+        // Lay out one layer's mip chain, then repeat it per layer
+        auto layerSize = _LayOutMipChain(desc, _subresources.data());
+
+        for(std::uint32_t layer = 0; layer < layers; layer++) {
+            for(std::uint32_t mip = 0; mip < desc.mipLevels; mip++) {
+                auto& layout = _subresources[layer * desc.mipLevels + mip];
+                layout = _subresources[mip];
+                layout.offset += layer * layerSize;
+                layout.arrayPitch = layerSize;
+            }
+        }
+
+        _data.resize(layerSize * layers);
+    }
+
+    void NullTexture::WriteSubresource(
+        uint32_t mipLevel,
+        uint32_t arrayLayer,
+        Point3D dstOrigin,
+        Size3D writeSize,
+        const void* src,
+        uint32_t srcRowPitch,
+        uint32_t srcDepthPitch
+    ) {
+        auto layout = GetSubresourceLayout(mipLevel, arrayLayer);
+        auto rowBytes = FormatHelpers::GetRowPitch(writeSize.width, _desc.format);
+        auto numRows = FormatHelpers::GetNumRows(writeSize.height, _desc.format);
+
+        auto* dstBase = _data.data() + layout.offset
+            + FormatHelpers::GetNumRows(dstOrigin.y, _desc.format) * layout.rowPitch
+            + FormatHelpers::GetRowPitch(dstOrigin.x, _desc.format);
+        auto* srcBase = (const std::uint8_t*)src;
+
+        for(std::uint32_t z = 0; z < writeSize.depth; z++) {
+            for(std::uint32_t row = 0; row < numRows; row++) {
+                std::memcpy(
+                    dstBase + (dstOrigin.z + z) * layout.depthPitch + row * layout.rowPitch,
+                    srcBase + z * srcDepthPitch + row * srcRowPitch,
+                    rowBytes);
+            }
+        }
+    }
+
+    void NullTexture::ReadSubresource(
+        void* dst,
+        uint32_t dstRowPitch,
+        uint32_t dstDepthPitch,
+        uint32_t mipLevel,
+        uint32_t arrayLayer,
+        Point3D srcOrigin,
+        Size3D readSize
+    ) {
+        auto layout = GetSubresourceLayout(mipLevel, arrayLayer);
+        auto rowBytes = FormatHelpers::GetRowPitch(readSize.width, _desc.format);
+        auto numRows = FormatHelpers::GetNumRows(readSize.height, _desc.format);
+
+        auto* srcBase = _data.data() + layout.offset
+            + FormatHelpers::GetNumRows(srcOrigin.y, _desc.format) * layout.rowPitch
+            + FormatHelpers::GetRowPitch(srcOrigin.x, _desc.format);
+        auto* dstBase = (std::uint8_t*)dst;
+
+        for(std::uint32_t z = 0; z < readSize.depth; z++) {
+            for(std::uint32_t row = 0; row < numRows; row++) {
+                std::memcpy(
+                    dstBase + z * dstDepthPitch + row * dstRowPitch,
+                    srcBase + (srcOrigin.z + z) * layout.depthPitch + row * layout.rowPitch,
+                    rowBytes);
+            }
+        }
+    }
+
+    ITexture::SubresourceLayout NullTexture::GetSubresourceLayout(
+        uint32_t mipLevel,
+        uint32_t arrayLayer,
+        SubresourceAspect aspect
+    ) {
+        assert(mipLevel < _desc.mipLevels && arrayLayer < GetArrayLayerCount());
+        return _subresources[arrayLayer * _desc.mipLevels + mipLevel];
+    }
+
+    void NullTexture::GenerateMipmaps(
+        uint32_t baseMipLevel,
+        uint32_t mipLevels,
+        uint32_t baseArrayLayer,
+        uint32_t arrayLayers
+    ) {
+        assert(!FormatHelpers::IsCompressedFormat(_desc.format));
+        const auto texelSize = FormatHelpers::GetSizeInBytes(_desc.format);
+        const auto channel = _GetMipChannel(_desc.format);
+
+        for(auto layer = baseArrayLayer; layer < baseArrayLayer + arrayLayers; layer++) {
+            for(auto mip = baseMipLevel + 1; mip < baseMipLevel + mipLevels; mip++) {
+                auto src = GetSubresourceLayout(mip - 1, layer);
+                auto dst = GetSubresourceLayout(mip, layer);
+                auto srcW = std::max(1u, _desc.width >> (mip - 1));
+                auto srcH = std::max(1u, _desc.height >> (mip - 1));
+                auto srcD = std::max(1u, _desc.depth >> (mip - 1));
+                auto dstW = std::max(1u, _desc.width >> mip);
+                auto dstH = std::max(1u, _desc.height >> mip);
+                auto dstD = std::max(1u, _desc.depth >> mip);
+
+                for(std::uint32_t z = 0; z < dstD; z++)
+                for(std::uint32_t y = 0; y < dstH; y++)
+                for(std::uint32_t x = 0; x < dstW; x++) {
+                    // The 2x2x2 block above, clamped on odd or unit sizes
+                    const std::uint8_t* srcs[8];
+                    std::uint32_t srcCnt = 0;
+                    for(std::uint32_t dz = 0; dz < 2; dz++)
+                    for(std::uint32_t dy = 0; dy < 2; dy++)
+                    for(std::uint32_t dx = 0; dx < 2; dx++) {
+                        auto sx = std::min(x * 2 + dx, srcW - 1);
+                        auto sy = std::min(y * 2 + dy, srcH - 1);
+                        auto sz = std::min(z * 2 + dz, srcD - 1);
+                        srcs[srcCnt++] = _data.data() + src.offset
+                            + sz * src.depthPitch + sy * src.rowPitch + sx * texelSize;
+                    }
+
+                    auto* out = _data.data() + dst.offset
+                        + z * dst.depthPitch + y * dst.rowPitch + x * texelSize;
+                    switch(channel) {
+                    case _MipChannel::UNorm8:
+                        _AverageTexels<std::uint8_t, std::uint32_t>(out, srcs, srcCnt, texelSize);
+                        break;
+                    case _MipChannel::UNorm16:
+                        _AverageTexels<std::uint16_t, std::uint32_t>(out, srcs, srcCnt, texelSize);
+                        break;
+                    case _MipChannel::Float32:
+                        _AverageTexels<float, float>(out, srcs, srcCnt, texelSize);
+                        break;
+                    default:
+                        std::memcpy(out, srcs[0], texelSize);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    NullResourceLayout::NullResourceLayout(const Description& desc)
+        : IResourceLayout(desc)
+        , _resourceCount(0)
+    {
+        _slotOffsets.reserve(desc.shaderResources.size());
+        for(auto& res : desc.shaderResources) {
+            _slotOffsets.push_back(_resourceCount);
+            _resourceCount += res.bindingCount;
+        }
+    }
+
+    NullResourceSet::NullResourceSet(const Description& desc)
+        : _layout(common::SPCast<NullResourceLayout>(desc.layout))
+        , _resources(_layout->GetResourceCount())
+    {
+        auto count = std::min(desc.boundResources.size(), _resources.size());
+        std::copy_n(desc.boundResources.begin(), count, _resources.begin());
+    }
+
+    IBindableResource* NullResourceSet::GetBoundResource(
+        uint32_t layoutSlot,
+        uint32_t firstArrayElement
+    ) {
+        return _resources[_layout->GetSlotOffset(layoutSlot) + firstArrayElement].get();
+    }
+
+    NullMutableResourceSet::NullMutableResourceSet(const Description& desc)
+        : _layout(common::SPCast<NullResourceLayout>(desc.layout))
+        , _resources(_layout->GetResourceCount())
+    {
+        Update(desc.initialWrites);
+    }
+
+    IBindableResource* NullMutableResourceSet::GetBoundResource(
+        uint32_t layoutSlot,
+        uint32_t firstArrayElement
+    ) {
+        return _resources[_layout->GetSlotOffset(layoutSlot) + firstArrayElement].get();
+    }
+
+    void NullMutableResourceSet::Update(const std::span<const WriteBinding>& writes) {
+        for(auto& write : writes) {
+            auto base = _layout->GetSlotOffset(write.layoutSlot) + write.firstArrayElement;
+            assert(base + write.resources.size() <= _resources.size());
+            std::copy(write.resources.begin(), write.resources.end(), _resources.begin() + base);
+        }
+    }
+
+    void NullResourceDescriptorHeap::Write(
+        ResourceDescriptorIndex index,
+        const ResourceDescriptorWrite& write
+    ) {
+        _entries.at(index.value) = write;
+    }
+
+    void NullResourceDescriptorHeap::WriteRange(
+        ResourceDescriptorIndex firstIndex,
+        std::span<const ResourceDescriptorWrite> writes
+    ) {
+        assert(firstIndex.value + writes.size() <= _entries.size());
+        std::copy(writes.begin(), writes.end(), _entries.begin() + firstIndex.value);
+    }
+
+    void NullResourceDescriptorHeap::Clear(ResourceDescriptorIndex index) {
+        _entries.at(index.value).reset();
+    }
+
+    void NullResourceDescriptorHeap::ClearRange(
+        ResourceDescriptorIndex firstIndex,
+        std::uint32_t count
+    ) {
+        assert(firstIndex.value + count <= _entries.size());
+        std::fill_n(_entries.begin() + firstIndex.value, count, std::nullopt);
+    }
+
+    void NullSamplerDescriptorHeap::Write(
+        SamplerDescriptorIndex index,
+        const SamplerDescriptorWrite& sampler
+    ) {
+        _entries.at(index.value) = sampler;
+    }
+
+    void NullSamplerDescriptorHeap::WriteRange(
+        SamplerDescriptorIndex firstIndex,
+        std::span<const SamplerDescriptorWrite> samplers
+    ) {
+        assert(firstIndex.value + samplers.size() <= _entries.size());
+        std::copy(samplers.begin(), samplers.end(), _entries.begin() + firstIndex.value);
+    }
+
+    void NullSamplerDescriptorHeap::Clear(SamplerDescriptorIndex index) {
+        _entries.at(index.value) = nullptr;
+    }
+
+    void NullSamplerDescriptorHeap::ClearRange(
+        SamplerDescriptorIndex firstIndex,
+        std::uint32_t count
+    ) {
+        assert(firstIndex.value + count <= _entries.size());
+        std::fill_n(_entries.begin() + firstIndex.value, count, nullptr);
+    }
+
+    NullSwapChain::NullSwapChain(const common::sp<NullDevice>& dev, const Description& desc)
+        : _dev(dev)
+        , _desc(desc)
+        , _width(desc.initialWidth)
+        , _height(desc.initialHeight)
+        , _currentImage(0)
+    {
+        _CreateBackBuffers();
+    }
+
+    void NullSwapChain::_CreateBackBuffers() {
+        ITexture::Description texDesc{};
+        texDesc.type = ITexture::Description::Type::Texture2D;
+        texDesc.width = _width;
+        texDesc.height = _height;
+        texDesc.depth = 1;
+        texDesc.mipLevels = 1;
+        texDesc.arrayLayers = 1;
+        texDesc.format = _desc.colorSrgb ? PixelFormat::R8_G8_B8_A8_UNorm_SRgb
+                                         : PixelFormat::R8_G8_B8_A8_UNorm;
+        texDesc.usage.renderTarget = 1;
+        texDesc.sampleCount = SampleCount::x1;
+
+        ITextureView::Description viewDesc{};
+        viewDesc.mipLevels = 1;
+        viewDesc.arrayLayers = 1;
+
+        _backBuffers.clear();
+        auto count = std::max(2u, _desc.backBufferCnt);
+        for(std::uint32_t i = 0; i < count; i++) {
+            auto tex = _dev->CreateTexture(texDesc);
+            _backBuffers.push_back(_dev->CreateTextureView(tex, viewDesc));
+        }
+        _currentImage = 0;
+    }
+
+    void NullSwapChain::Resize(std::uint32_t width, std::uint32_t height) {
+        if(width == _width && height == _height) return;
+        _width = width;
+        _height = height;
+        _CreateBackBuffers();
+    }
+
+}
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "alloy/common/Macros.h"
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/Buffer.hpp"
+#include "alloy/MemoryHeap.hpp"
+#include "alloy/Texture.hpp"
+#include "alloy/Sampler.hpp"
+#include "alloy/Shader.hpp"
+#include "alloy/Pipeline.hpp"
+#include "alloy/BindableResource.hpp"
+#include "alloy/DescriptorHeap.hpp"
+#include "alloy/SwapChain.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace alloy::null
+{
+    class NullDevice;
+
+    // Only validates placements. Placed resources get storage of their
+    // own, so aliasing resources never see each other's content.
+    class NullMemoryHeap : public IMemoryHeap {
+
+        Description _desc;
+
+    public:
+        static constexpr std::uint64_t kPlacementAlignment = 256;
+
+        NullMemoryHeap(const Description& desc) : _desc(desc) { }
+
+        bool CanPlace(const Placement& placement, std::uint64_t offset) const {
+            return offset % placement.alignment == 0
+                && offset + placement.sizeInBytes <= _desc.sizeInBytes;
+        }
+
+        bool CanHold(const IBuffer::Description&) const {
+            return _desc.resourceClass == ResourceClass::All
+                || _desc.resourceClass == ResourceClass::Buffers;
+        }
+
+        bool CanHold(const ITexture::Description& desc) const {
+            auto cls = desc.usage.renderTarget || desc.usage.depthStencil
+                ? ResourceClass::RenderTargets : ResourceClass::Textures;
+            return _desc.resourceClass == ResourceClass::All
+                || _desc.resourceClass == cls;
+        }
+
+        virtual const Description& GetDesc() const override { return _desc; }
+    };
+
+    class NullBuffer : public IBuffer {
+
+        common::sp<NullDevice> _dev;
+        Description _desc;
+        std::unique_ptr<std::uint8_t[]> _data;
+        std::string _debugName;
+
+    public:
+        NullBuffer(const common::sp<NullDevice>& dev, const Description& desc);
+
+        std::uint8_t* GetData() const { return _data.get(); }
+
+        virtual const Description& GetDesc() const override { return _desc; }
+
+        // Always host memory, regardless of hostAccess
+        virtual void* MapToCPU() override { return _data.get(); }
+        virtual void UnMap() override { }
+
+        // Host pointer stands in for the GPU address
+        virtual std::uint64_t GetDeviceAddress() const override {
+            return _desc.usage.deviceAddress ? (std::uint64_t)_data.get() : 0;
+        }
+
+        virtual void SetDebugName(const std::string& name) override { _debugName = name; }
+        virtual std::string GetDebugName() override { return _debugName; }
+    };
+
+    class NullTexture : public ITexture {
+
+        common::sp<NullDevice> _dev;
+        Description _desc;
+        std::vector<std::uint8_t> _data;
+        // Layer major, layer * mipLevels + mip
+        std::vector<SubresourceLayout> _subresources;
+
+        // Fills mips with one layer's chain unless null, returns its size
+        static std::uint64_t _LayOutMipChain(const Description& desc, SubresourceLayout* mips);
+
+    public:
+        NullTexture(const common::sp<NullDevice>& dev, const Description& desc);
+
+        static std::uint32_t GetArrayLayerCount(const Description& desc) {
+            return desc.usage.cubemap ? desc.arrayLayers * 6 : desc.arrayLayers;
+        }
+        std::uint32_t GetArrayLayerCount() const { return GetArrayLayerCount(_desc); }
+
+        // What a texture of desc allocates, without creating one
+        static std::uint64_t ComputeSizeInBytes(const Description& desc);
+
+        virtual const Description& GetDesc() const override { return _desc; }
+
+        std::uint64_t GetSizeInBytes() const { return _data.size(); }
+
+        virtual void* GetNativeHandle() const override { return (void*)_data.data(); }
+
+        virtual void SetDebugName(const std::string&) override { }
+
+        virtual void WriteSubresource(
+            uint32_t mipLevel,
+            uint32_t arrayLayer,
+            Point3D dstOrigin,
+            Size3D writeSize,
+            const void* src,
+            uint32_t srcRowPitch,
+            uint32_t srcDepthPitch
+        ) override;
+
+        virtual void ReadSubresource(
+            void* dst,
+            uint32_t dstRowPitch,
+            uint32_t dstDepthPitch,
+            uint32_t mipLevel,
+            uint32_t arrayLayer,
+            Point3D srcOrigin,
+            Size3D readSize
+        ) override;
+
+        virtual SubresourceLayout GetSubresourceLayout(
+            uint32_t mipLevel,
+            uint32_t arrayLayer,
+            SubresourceAspect aspect = SubresourceAspect::Color) override;
+
+        // Box filters each level from the one above, point samples formats
+        // it can't average. Uncompressed formats only.
+        void GenerateMipmaps(
+            uint32_t baseMipLevel,
+            uint32_t mipLevels,
+            uint32_t baseArrayLayer,
+            uint32_t arrayLayers);
+    };
+
+    class NullTextureView : public ITextureView {
+
+        common::sp<ITexture> _tex;
+        Description _desc;
+
+    public:
+        NullTextureView(const common::sp<ITexture>& tex, const Description& desc)
+            : _tex(tex), _desc(desc) { }
+
+        virtual const Description& GetDesc() const override { return _desc; }
+        virtual common::sp<ITexture> GetTextureObject() const override { return _tex; }
+    };
+
+    class NullSampler : public ISampler {
+
+    public:
+        NullSampler(const Description& desc) : ISampler(desc) { }
+
+        virtual void SetDebugName(const std::string&) override { }
+    };
+
+    class NullShader : public IShader {
+
+        std::vector<std::uint8_t> _il;
+
+    public:
+        NullShader(const Description& desc, std::span<const std::uint8_t> il)
+            : IShader(desc), _il(il.begin(), il.end()) { }
+
+        virtual const std::span<uint8_t> GetByteCode() override { return _il; }
+    };
+
+    class NullResourceLayout : public IResourceLayout {
+
+        // Linear offset of each shaderResources entry
+        std::vector<std::uint32_t> _slotOffsets;
+        std::uint32_t _resourceCount;
+
+    public:
+        NullResourceLayout(const Description& desc);
+
+        std::uint32_t GetSlotOffset(std::uint32_t layoutSlot) const {
+            return _slotOffsets.at(layoutSlot);
+        }
+        std::uint32_t GetResourceCount() const { return _resourceCount; }
+    };
+
+    class NullResourceSet : public IResourceSet {
+
+        common::sp<NullResourceLayout> _layout;
+        std::vector<common::sp<IBindableResource>> _resources;
+
+    public:
+        NullResourceSet(const Description& desc);
+
+        virtual const IResourceLayout& GetLayout() const override { return *_layout; }
+
+        virtual IBindableResource* GetBoundResource(
+            uint32_t layoutSlot,
+            uint32_t firstArrayElement
+        ) override;
+    };
+
+    class NullMutableResourceSet : public IMutableResourceSet {
+
+        common::sp<NullResourceLayout> _layout;
+        std::vector<common::sp<IBindableResource>> _resources;
+
+    public:
+        NullMutableResourceSet(const Description& desc);
+
+        virtual const IResourceLayout& GetLayout() const override { return *_layout; }
+
+        virtual IBindableResource* GetBoundResource(
+            uint32_t layoutSlot,
+            uint32_t firstArrayElement
+        ) override;
+
+        virtual void Update(const std::span<const WriteBinding>& writes) override;
+    };
+
+    class NullResourceDescriptorHeap : public IResourceDescriptorHeap {
+
+        Description _desc;
+        std::vector<std::optional<ResourceDescriptorWrite>> _entries;
+
+    public:
+        NullResourceDescriptorHeap(const Description& desc)
+            : _desc(desc), _entries(desc.capacity) { }
+
+        virtual const Description& GetDesc() const override { return _desc; }
+
+        virtual void Write(
+            ResourceDescriptorIndex index,
+            const ResourceDescriptorWrite& write) override;
+        virtual void WriteRange(
+            ResourceDescriptorIndex firstIndex,
+            std::span<const ResourceDescriptorWrite> writes) override;
+        virtual void Clear(ResourceDescriptorIndex index) override;
+        virtual void ClearRange(ResourceDescriptorIndex firstIndex, std::uint32_t count) override;
+    };
+
+    class NullSamplerDescriptorHeap : public ISamplerDescriptorHeap {
+
+        Description _desc;
+        std::vector<common::sp<ISampler>> _entries;
+
+    public:
+        NullSamplerDescriptorHeap(const Description& desc)
+            : _desc(desc), _entries(desc.capacity) { }
+
+        virtual const Description& GetDesc() const override { return _desc; }
+
+        virtual void Write(
+            SamplerDescriptorIndex index,
+            const SamplerDescriptorWrite& sampler) override;
+        virtual void WriteRange(
+            SamplerDescriptorIndex firstIndex,
+            std::span<const SamplerDescriptorWrite> samplers) override;
+        virtual void Clear(SamplerDescriptorIndex index) override;
+        virtual void ClearRange(SamplerDescriptorIndex firstIndex, std::uint32_t count) override;
+    };
+
+    class NullGraphicsPipeline : public IGfxPipeline {
+        GraphicsPipelineDescription _desc;
+    public:
+        NullGraphicsPipeline(const GraphicsPipelineDescription& desc) : _desc(desc) { }
+    };
+
+    class NullComputePipeline : public IComputePipeline {
+        ComputePipelineDescription _desc;
+    public:
+        NullComputePipeline(const ComputePipelineDescription& desc) : _desc(desc) { }
+    };
+
+    class NullMeshShaderPipeline : public IMeshShaderPipeline {
+        MeshShaderPipelineDescription _desc;
+    public:
+        NullMeshShaderPipeline(const MeshShaderPipelineDescription& desc) : _desc(desc) { }
+    };
+
+    class NullSwapChain : public ISwapChain {
+
+        common::sp<NullDevice> _dev;
+        Description _desc;
+        std::uint32_t _width, _height;
+        std::uint32_t _currentImage;
+        std::vector<common::sp<ITextureView>> _backBuffers;
+
+        void _CreateBackBuffers();
+
+    public:
+        NullSwapChain(const common::sp<NullDevice>& dev, const Description& desc);
+
+        // Called on present
+        void AdvanceBackBuffer() {
+            _currentImage = (_currentImage + 1) % _backBuffers.size();
+        }
+
+        virtual common::sp<ITextureView> GetBackBuffer() override {
+            return _backBuffers[_currentImage];
+        }
+
+        virtual const Description& GetDesc() const override { return _desc; }
+
+        virtual uint32_t GetBackBufferIndex() override { return _currentImage; }
+
+        virtual void Resize(std::uint32_t width, std::uint32_t height) override;
+
+        virtual bool IsSyncToVerticalBlank() const override { return _desc.syncToVerticalBlank; }
+        virtual void SetSyncToVerticalBlank(bool sync) override { _desc.syncToVerticalBlank = sync; }
+
+        virtual std::uint32_t GetWidth() const override { return _width; }
+        virtual std::uint32_t GetHeight() const override { return _height; }
+    };
+
+}
@@ -0,0 +1,252 @@
+#include "VkDeferredDestroyQueue.hpp"
+
+#include "VkCommon.hpp"
+#include "VulkanDevice.hpp"
+
+namespace alloy::vk {
+
+    _DeferredDestroyQueue::_DeferredDestroyQueue()
+        : _dev(nullptr)
+        , _queues{}
+        , _queueCnt(0)
+        , _armed(false)
+        , _stopped(false)
+        , _pendingObjects(0)
+        , _pendingBytes(0)
+        , _destroyedObjects(0)
+    { }
+
+    _DeferredDestroyQueue::~_DeferredDestroyQueue() {
+        //Shutdown() should be called by device before queues are gone
+        assert(!_armed);
+        assert(_pending.empty());
+    }
+
+    void _DeferredDestroyQueue::Init(
+        VulkanDevice* dev,
+        std::span<VulkanCommandQueue* const> queues
+    ) {
+        assert(queues.size() <= kMaxQueues);
+        _dev = dev;
+        _queueCnt = 0;
+        for(auto* q : queues) {
+            if(q) _queues[_queueCnt++] = q;
+        }
+        _stopped = false;
+    }
+
+    void _DeferredDestroyQueue::Shutdown() {
+        std::vector<_PendingObject> objs;
+        {
+            // The device is idle, a registered callback is reached and
+            // runs soon
+            std::unique_lock lk{_m_pending};
+            _stopped = true;
+            _cvPending.wait(lk, [this]() { return !_armed; });
+
+            objs.reserve(_pending.size());
+            for(auto& o : _pending)
+                objs.push_back(std::move(o));
+            _pending.clear();
+        }
+        _DestroyAll(objs);
+    }
+
+    _DeferredDestroyQueue::FenceSnapshot
+    _DeferredDestroyQueue::SnapshotLastSubmitted() const {
+        FenceSnapshot snapshot {};
+        for(uint32_t i = 0; i < _queueCnt; i++) {
+            snapshot[i] = _queues[i]->GetLastSubmittedValue();
+        }
+        return snapshot;
+    }
+
+    _DeferredDestroyQueue::FenceSnapshot
+    _DeferredDestroyQueue::_QueryCompleted() const {
+        FenceSnapshot completed {};
+        for(uint32_t i = 0; i < _queueCnt; i++) {
+            completed[i] = _queues[i]->GetCompletedValue();
+        }
+        return completed;
+    }
+
+    bool _DeferredDestroyQueue::IsRetired(const FenceSnapshot& snapshot) const {
+        for(uint32_t i = 0; i < _queueCnt; i++) {
+            if(snapshot[i] > _queues[i]->GetCompletedValue()) return false;
+        }
+        return true;
+    }
+
+    void _DeferredDestroyQueue::_Push(_PendingObject&& obj) {
+        _pendingObjects.fetch_add(1, std::memory_order_relaxed);
+        _pendingBytes.fetch_add(obj.sizeInBytes, std::memory_order_relaxed);
+        {
+            std::scoped_lock lk{_m_pending};
+            if(!_stopped) {
+                obj.retireAfter = SnapshotLastSubmitted();
+                _pending.push_back(std::move(obj));
+                _Arm();
+                return;
+            }
+        }
+
+        // Past Shutdown() the device is idle, nothing references it
+        std::vector<_PendingObject> objs;
+        objs.push_back(std::move(obj));
+        _DestroyAll(objs);
+    }
+
+    void _DeferredDestroyQueue::Enqueue(
+        VkObjectType type,
+        uint64_t handle,
+        VmaAllocation allocation
+    ) {
+        _PendingObject obj {};
+        obj.type = type;
+        obj.handle = handle;
+        obj.allocation = allocation;
+        obj.sizeInBytes = 0;
+        if(allocation != VK_NULL_HANDLE) {
+            VmaAllocationInfo allocInfo {};
+            vmaGetAllocationInfo(_dev->Allocator(), allocation, &allocInfo);
+            obj.sizeInBytes = allocInfo.size;
+        }
+        _Push(std::move(obj));
+    }
+
+    void _DeferredDestroyQueue::Enqueue(std::vector<_DescriptorSet>&& sets) {
+        if(sets.empty()) return;
+
+        _PendingObject obj {};
+        obj.type = VK_OBJECT_TYPE_DESCRIPTOR_SET;
+        obj.handle = 0;
+        obj.allocation = VK_NULL_HANDLE;
+        obj.sizeInBytes = 0;
+        obj.descSets = std::move(sets);
+        _Push(std::move(obj));
+    }
+
+    void _DeferredDestroyQueue::_Destroy(_PendingObject& obj) {
+        auto dev = _dev->LogicalDev();
+        switch(obj.type) {
+        case VK_OBJECT_TYPE_BUFFER:
+            if(obj.allocation != VK_NULL_HANDLE)
+                vmaDestroyBuffer(_dev->Allocator(), (VkBuffer)obj.handle, obj.allocation);
+            else
+                VK_DEV_CALL(_dev, vkDestroyBuffer(dev, (VkBuffer)obj.handle, nullptr));
+            break;
+        case VK_OBJECT_TYPE_IMAGE:
+            if(obj.allocation != VK_NULL_HANDLE)
+                vmaDestroyImage(_dev->Allocator(), (VkImage)obj.handle, obj.allocation);
+            else
+                VK_DEV_CALL(_dev, vkDestroyImage(dev, (VkImage)obj.handle, nullptr));
+            break;
+        case VK_OBJECT_TYPE_DEVICE_MEMORY:
+            vmaFreeMemory(_dev->Allocator(), obj.allocation);
+            break;
+        case VK_OBJECT_TYPE_IMAGE_VIEW:
+            VK_DEV_CALL(_dev, vkDestroyImageView(dev, (VkImageView)obj.handle, nullptr));
+            break;
+        case VK_OBJECT_TYPE_SAMPLER:
+            VK_DEV_CALL(_dev, vkDestroySampler(dev, (VkSampler)obj.handle, nullptr));
+            break;
+        case VK_OBJECT_TYPE_PIPELINE:
+            VK_DEV_CALL(_dev, vkDestroyPipeline(dev, (VkPipeline)obj.handle, nullptr));
+            break;
+        case VK_OBJECT_TYPE_PIPELINE_LAYOUT:
+            VK_DEV_CALL(_dev, vkDestroyPipelineLayout(dev, (VkPipelineLayout)obj.handle, nullptr));
+            break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT:
+            VK_DEV_CALL(_dev, vkDestroyDescriptorSetLayout(dev, (VkDescriptorSetLayout)obj.handle, nullptr));
+            break;
+        case VK_OBJECT_TYPE_SEMAPHORE:
+            VK_DEV_CALL(_dev, vkDestroySemaphore(dev, (VkSemaphore)obj.handle, nullptr));
+            break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_SET:
+            // Pool refs are released by _DescriptorSet dtor
+            obj.descSets.clear();
+            break;
+        default:
+            assert(false);
+            break;
+        }
+    }
+
+    void _DeferredDestroyQueue::_DestroyAll(std::vector<_PendingObject>& objs) {
+        uint64_t bytes = 0;
+        for(auto& o : objs) {
+            _Destroy(o);
+            bytes += o.sizeInBytes;
+        }
+        _pendingBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        _pendingObjects.fetch_sub(objs.size(), std::memory_order_relaxed);
+        _destroyedObjects.fetch_add(objs.size(), std::memory_order_relaxed);
+        objs.clear();
+    }
+
+    void _DeferredDestroyQueue::_Arm() {
+        if(_armed || _stopped || _pending.empty()) return;
+
+        // Entries are pushed in submission order, so the front one always
+        // retires first. Wait for the first of its queues that isn't
+        // there yet. If all are, the callback runs on the next wait.
+        auto& oldest = _pending.front().retireAfter;
+        uint32_t waitQ = 0;
+        for(uint32_t i = 0; i < _queueCnt; i++) {
+            if(oldest[i] > _queues[i]->GetCompletedValue()) {
+                waitQ = i;
+                break;
+            }
+        }
+
+        // The completion thread never calls back under its lock
+        _armed = true;
+        _dev->GetEventCompletionThread().Add(
+            _queues[waitQ]->GetTimelineHandle(),
+            oldest[waitQ],
+            [this](bool) { _OnReached(); });
+    }
+
+    void _DeferredDestroyQueue::_OnReached() {
+        std::vector<_PendingObject> retired;
+
+        std::unique_lock lk{_m_pending};
+        if(!_stopped) {
+            auto completed = _QueryCompleted();
+            while(!_pending.empty()) {
+                auto& front = _pending.front();
+                bool isRetired = true;
+                for(uint32_t i = 0; i < _queueCnt; i++) {
+                    if(front.retireAfter[i] > completed[i]) {
+                        isRetired = false;
+                        break;
+                    }
+                }
+                if(!isRetired) break;
+
+                retired.push_back(std::move(front));
+                _pending.pop_front();
+            }
+
+            // Destroy outside the lock, don't block releasing threads.
+            // Still armed, so pushes meanwhile leave arming to us.
+            lk.unlock();
+            _DestroyAll(retired);
+            lk.lock();
+        }
+
+        _armed = false;
+        _Arm();
+        // Under the lock, Shutdown() may return as soon as it's released
+        _cvPending.notify_all();
+    }
+
+    _DeferredDestroyQueue::Stats _DeferredDestroyQueue::GetStats() const {
+        Stats stats {};
+        stats.pendingObjects = _pendingObjects.load(std::memory_order_relaxed);
+        stats.pendingBytes = _pendingBytes.load(std::memory_order_relaxed);
+        stats.destroyedObjects = _destroyedObjects.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <volk.h>
+#include <vk_mem_alloc.h>
+
+#include "alloy/common/Macros.h"
+
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <array>
+#include <span>
+#include <mutex>
+#include <condition_variable>
+
+#include "VkDescriptorPoolMgr.hpp"
+
+// Fence gated object destruction.
+//
+// When the last reference of a Vulkan backed object drops, the object
+// may still be referenced by command buffers in flight. Instead of
+// destroying the native handle right away, the handle is queued with a
+// snapshot of every queue's last submitted timeline value. The oldest
+// snapshot is handed to the device's event completion thread, which
+// destroys everything retired in bulk once it's reached and then waits
+// for the next one.
+//
+// Anything dropped after the command list using it got submitted is safe.
+// Dropping it between recording and submission is not, the command list
+// still has to keep it alive (or the caller has to, for non-owning binds).
+// Command lists keep what they use until re-recorded or destroyed, so
+// every submit of theirs is in the snapshot taken when it's released.
+//
+// Objects dropped after Shutdown() are destroyed right away.
+
+namespace alloy::vk {
+
+    class VulkanDevice;
+    class VulkanCommandQueue;
+
+    class _DeferredDestroyQueue {
+        DISABLE_COPY_AND_ASSIGN(_DeferredDestroyQueue);
+
+    public:
+        // gfx, copy & compute
+        constexpr static uint32_t kMaxQueues = 3;
+
+        using FenceSnapshot = std::array<uint64_t, kMaxQueues>;
+
+        struct Stats {
+            uint64_t pendingObjects;
+            uint64_t pendingBytes;
+            uint64_t destroyedObjects;
+        };
+
+    private:
+        struct _PendingObject {
+            FenceSnapshot retireAfter;
+
+            VkObjectType type;
+            uint64_t handle;
+            VmaAllocation allocation;
+            uint64_t sizeInBytes;
+
+            // Only for VK_OBJECT_TYPE_DESCRIPTOR_SET, keeps the owning
+            // pools referenced until the GPU is done with them.
+            std::vector<_DescriptorSet> descSets;
+        };
+
+        VulkanDevice* _dev;
+        std::array<VulkanCommandQueue*, kMaxQueues> _queues;
+        uint32_t _queueCnt;
+
+        std::deque<_PendingObject> _pending;
+        std::mutex _m_pending;
+        std::condition_variable _cvPending;
+
+        // A completion callback is registered or running
+        bool _armed;
+        bool _stopped;
+
+        std::atomic<uint64_t> _pendingObjects;
+        std::atomic<uint64_t> _pendingBytes;
+        std::atomic<uint64_t> _destroyedObjects;
+
+        FenceSnapshot _QueryCompleted() const;
+
+        void _Push(_PendingObject&& obj);
+        void _Destroy(_PendingObject& obj);
+        void _DestroyAll(std::vector<_PendingObject>& objs);
+
+        // Under _m_pending
+        void _Arm();
+        // On the completion thread
+        void _OnReached();
+
+    public:
+        _DeferredDestroyQueue();
+        ~_DeferredDestroyQueue();
+
+        // Must be called once queues are created
+        void Init(VulkanDevice* dev, std::span<VulkanCommandQueue* const> queues);
+
+        // Waits for the pending completion callback and destroys everything
+        // left immediately, later enqueues too. Caller makes sure the
+        // device is idle, and the completion thread is still running.
+        void Shutdown();
+
+        void Enqueue(VkObjectType type, uint64_t handle, VmaAllocation allocation);
+        void Enqueue(std::vector<_DescriptorSet>&& sets);
+
+        Stats GetStats() const;
+
+        FenceSnapshot SnapshotLastSubmitted() const;
+
+        // Every queue has finished the work submitted before the snapshot
+        bool IsRetired(const FenceSnapshot& snapshot) const;
+    };
+
+}
@@ -0,0 +1,300 @@
+#include "VkDefragmenter.hpp"
+
+#include "alloy/common/Trace.hpp"
+
+#include <cassert>
+#include <chrono>
+
+#include "VkCommon.hpp"
+#include "VulkanDevice.hpp"
+
+namespace alloy::vk {
+
+    _VkDefragmenter::_VkDefragmenter()
+        : _dev(nullptr)
+        , _copyQ(nullptr)
+        , _cmdPool(VK_NULL_HANDLE)
+        , _cmdBuf(VK_NULL_HANDLE)
+        , _pool(VK_NULL_HANDLE)
+        , _stats{}
+        , _ctx(VK_NULL_HANDLE)
+        , _pass{}
+        , _passPending(false)
+        , _passRetireAfter{}
+        , _moveEpoch(0)
+    { }
+
+    _VkDefragmenter::~_VkDefragmenter() {
+        assert(_pool == VK_NULL_HANDLE);
+        assert(_ctx == VK_NULL_HANDLE);
+        assert(_cmdPool == VK_NULL_HANDLE);
+    }
+
+    void _VkDefragmenter::Init(
+        VulkanDevice* dev,
+        VulkanCommandQueue* copyQ,
+        std::span<VulkanCommandQueue* const> queues
+    ) {
+        _dev = dev;
+        _copyQ = copyQ;
+        for(auto* q : queues) {
+            if(q) _queues.push_back(q);
+        }
+
+        // Usages of the buffers CanMove() accepts
+        VkBufferCreateInfo bufferInfo { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        bufferInfo.size = 1;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+            | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+            | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+            | VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+            | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+        VmaAllocationCreateInfo allocInfo {};
+        allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+        uint32_t memoryTypeIdx;
+        if(vmaFindMemoryTypeIndexForBufferInfo(
+            _dev->Allocator(), &bufferInfo, &allocInfo, &memoryTypeIdx) != VK_SUCCESS)
+            return;
+
+        VmaPoolCreateInfo poolInfo {};
+        poolInfo.memoryTypeIndex = memoryTypeIdx;
+        if(vmaCreatePool(_dev->Allocator(), &poolInfo, &_pool) != VK_SUCCESS) {
+            _pool = VK_NULL_HANDLE;
+            return;
+        }
+
+        // Recorded once per pass, after the previous one retired
+        VkCommandPoolCreateInfo cmdPoolInfo { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+        cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        cmdPoolInfo.queueFamilyIndex = _copyQ->GetQueueFamily();
+        VK_CHECK(VK_DEV_CALL(_dev,
+            vkCreateCommandPool(_dev->LogicalDev(), &cmdPoolInfo, nullptr, &_cmdPool)));
+
+        VkCommandBufferAllocateInfo cmdBufInfo { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        cmdBufInfo.commandPool = _cmdPool;
+        cmdBufInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        cmdBufInfo.commandBufferCount = 1;
+        VK_CHECK(VK_DEV_CALL(_dev,
+            vkAllocateCommandBuffers(_dev->LogicalDev(), &cmdBufInfo, &_cmdBuf)));
+    }
+
+    void _VkDefragmenter::Shutdown() {
+        std::scoped_lock lk{_m};
+        if(_passPending) {
+            vmaEndDefragmentationPass(_dev->Allocator(), _ctx, &_pass);
+            _passPending = false;
+            _passBuffers.clear();
+        }
+        if(_ctx != VK_NULL_HANDLE) {
+            _Finish();
+        }
+        if(_pool != VK_NULL_HANDLE) {
+            vmaDestroyPool(_dev->Allocator(), _pool);
+            _pool = VK_NULL_HANDLE;
+        }
+        if(_cmdPool != VK_NULL_HANDLE) {
+            // Frees _cmdBuf with it
+            VK_DEV_CALL(_dev, vkDestroyCommandPool(_dev->LogicalDev(), _cmdPool, nullptr));
+            _cmdPool = VK_NULL_HANDLE;
+            _cmdBuf = VK_NULL_HANDLE;
+        }
+    }
+
+    bool _VkDefragmenter::CanMove(const IBuffer::Description& desc) const {
+        // Descriptors and device addresses would keep the old location
+        return _pool != VK_NULL_HANDLE
+            && desc.hostAccess == HostAccess::None
+            && !desc.usage.uniformBuffer
+            && !desc.usage.structuredBufferReadOnly
+            && !desc.usage.structuredBufferReadWrite
+            && !desc.usage.deviceAddress;
+    }
+
+    void _VkDefragmenter::Track(VulkanBuffer* buffer) {
+        std::scoped_lock lk{_m};
+        vmaSetAllocationUserData(_dev->Allocator(), buffer->GetAllocation(), buffer);
+    }
+
+    bool _VkDefragmenter::Untrack(VulkanBuffer* buffer) {
+        std::scoped_lock lk{_m};
+        vmaSetAllocationUserData(_dev->Allocator(), buffer->GetAllocation(), nullptr);
+        if(!_passPending) return false;
+
+        for(uint32_t i = 0; i < _pass.moveCount; i++) {
+            if(_passBuffers[i] != buffer) continue;
+
+            _pass.pMoves[i].operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+            _passBuffers[i] = nullptr;
+            // Both ranges go at the end of the pass. Work submitted since
+            // the swap may still use the new one.
+            _passRetireAfter = _dev->GetDeferredDestroyQueue().SnapshotLastSubmitted();
+            return true;
+        }
+        return false;
+    }
+
+    void _VkDefragmenter::SetBudget(const Budget& budget) {
+        std::scoped_lock lk{_m};
+        _budget = budget;
+    }
+
+    void _VkDefragmenter::Start() {
+        std::scoped_lock lk{_m};
+        if(_pool == VK_NULL_HANDLE || _ctx != VK_NULL_HANDLE) return;
+
+        VmaDefragmentationInfo info {};
+        info.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+        info.pool = _pool;
+        info.maxBytesPerPass = _budget.maxBytesPerUpdate;
+        info.maxAllocationsPerPass = _budget.maxMovesPerUpdate;
+
+        if(vmaBeginDefragmentation(_dev->Allocator(), &info, &_ctx) != VK_SUCCESS) {
+            _ctx = VK_NULL_HANDLE;
+            return;
+        }
+        _stats = {};
+        _stats.running = true;
+    }
+
+    void _VkDefragmenter::Update() {
+        VLD_TRACE_ZONE("_VkDefragmenter::Update");
+
+        std::scoped_lock lk{_m};
+        if(_ctx == VK_NULL_HANDLE) return;
+
+        if(_passPending) {
+            if(!_dev->GetDeferredDestroyQueue().IsRetired(_passRetireAfter)) return;
+            _EndPass();
+            if(_ctx == VK_NULL_HANDLE) return;
+        }
+        _BeginPass();
+    }
+
+    void _VkDefragmenter::_BeginPass() {
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+
+        auto res = vmaBeginDefragmentationPass(_dev->Allocator(), _ctx, &_pass);
+        if(res != VK_INCOMPLETE) {
+            // VK_SUCCESS when nothing is left to move
+            _Finish();
+            return;
+        }
+
+        _passPending = true;
+        _stats.updates++;
+        _passBuffers.assign(_pass.moveCount, nullptr);
+
+        std::vector<VkBuffer> oldHandles;
+
+        for(uint32_t i = 0; i < _pass.moveCount; i++) {
+            auto& move = _pass.pMoves[i];
+
+            VmaAllocationInfo allocInfo {};
+            vmaGetAllocationInfo(_dev->Allocator(), move.srcAllocation, &allocInfo);
+            auto* buffer = static_cast<VulkanBuffer*>(allocInfo.pUserData);
+            _passBuffers[i] = buffer;
+
+            const bool overTime = _budget.maxTimePerUpdate.count() > 0
+                && !oldHandles.empty()
+                && Clock::now() - start > _budget.maxTimePerUpdate;
+            if(!buffer || overTime) {
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                continue;
+            }
+
+            VkBuffer oldHandle;
+            if(!buffer->_MoveTo(move.dstTmpAllocation, oldHandle)) {
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                continue;
+            }
+
+            if(oldHandles.empty()) {
+                // The last pass retired, nothing executes _cmdBuf anymore
+                VK_DEV_CALL(_dev, vkResetCommandPool(_dev->LogicalDev(), _cmdPool, 0));
+
+                VkCommandBufferBeginInfo beginInfo { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+                beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                VK_DEV_CALL(_dev, vkBeginCommandBuffer(_cmdBuf, &beginInfo));
+
+                // Whatever wrote the sources before, on this queue
+                VkMemoryBarrier barrier { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+                barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                VK_DEV_CALL(_dev, vkCmdPipelineBarrier(_cmdBuf,
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0, 1, &barrier, 0, nullptr, 0, nullptr));
+            }
+
+            VkBufferCopy region {};
+            region.size = buffer->GetDesc().sizeInBytes;
+            VK_DEV_CALL(_dev, vkCmdCopyBuffer(_cmdBuf, oldHandle, buffer->GetHandle(), 1, &region));
+
+            oldHandles.push_back(oldHandle);
+            _stats.allocationsMoved++;
+            _stats.bytesMoved += region.size;
+        }
+
+        if(!oldHandles.empty()) {
+            VkMemoryBarrier barrier { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            VK_DEV_CALL(_dev, vkCmdPipelineBarrier(_cmdBuf,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                0, 1, &barrier, 0, nullptr, 0, nullptr));
+            VK_DEV_CALL(_dev, vkEndCommandBuffer(_cmdBuf));
+
+            // Sources may have been written on the other queues, and those
+            // read the moved buffers from now on. Sharing is concurrent,
+            // the semaphores are all the handoff there is.
+            for(auto* q : _queues) {
+                if(q == _copyQ) continue;
+                if(auto value = q->GetLastSubmittedValue())
+                    _copyQ->EncodeWaitForQueue(*q, value);
+            }
+            const auto copyValue = _copyQ->SubmitCommandBuffer(_cmdBuf);
+            for(auto* q : _queues) {
+                if(q != _copyQ)
+                    q->EncodeWaitForQueue(*_copyQ, copyValue);
+            }
+            // Lists recorded so far may hold the old handles
+            _moveEpoch.fetch_add(1, std::memory_order_release);
+
+            // Old handles only alias the source ranges, VMA frees those
+            for(auto h : oldHandles)
+                _dev->DeferDestroy(VK_OBJECT_TYPE_BUFFER, (uint64_t)h);
+        }
+
+        _passRetireAfter = _dev->GetDeferredDestroyQueue().SnapshotLastSubmitted();
+    }
+
+    void _VkDefragmenter::_EndPass() {
+        auto res = vmaEndDefragmentationPass(_dev->Allocator(), _ctx, &_pass);
+        _passPending = false;
+        _passBuffers.clear();
+        if(res == VK_SUCCESS) _Finish();
+    }
+
+    void _VkDefragmenter::_Finish() {
+        VmaDefragmentationStats vmaStats {};
+        vmaEndDefragmentation(_dev->Allocator(), _ctx, &vmaStats);
+        _ctx = VK_NULL_HANDLE;
+
+        _stats.running = false;
+        _stats.bytesFreed = vmaStats.bytesFreed;
+        _stats.blocksFreed = vmaStats.deviceMemoryBlocksFreed;
+    }
+
+    bool _VkDefragmenter::IsRunning() const {
+        std::scoped_lock lk{_m};
+        return _ctx != VK_NULL_HANDLE;
+    }
+
+    IBufferDefragmenter::Stats _VkDefragmenter::GetStats() const {
+        std::scoped_lock lk{_m};
+        return _stats;
+    }
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <volk.h>
+#include <vk_mem_alloc.h>
+
+#include "alloy/common/Macros.h"
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/Buffer.hpp"
+#include "alloy/BufferDefragmenter.hpp"
+
+#include "VkDeferredDestroyQueue.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+// VMA defragmentation for IBufferDefragmenter.
+//
+// Movable buffers are allocated from their own VMA pool and only that
+// pool is defragmented, so every allocation in a pass belongs to a
+// buffer we can repoint. Each pass binds a new VkBuffer to the move
+// target, copies into it on the copy queue and swaps it into the
+// VulkanBuffer. The copy waits for the work already submitted to the
+// other queues, and they wait for the copy. Buffers are created with
+// concurrent sharing across queue families, so no ownership transfer is
+// needed. The pass is ended, freeing the source ranges, once every queue
+// finished the work submitted up to the swap.
+//
+// Each pass that swapped handles bumps the move epoch. Command lists
+// remember the epoch at Begin() and the queue refuses to submit them
+// once it changed.
+//
+// Buffers dying mid pass turn their move into a destroy, the allocation
+// is freed by the pass instead of the deferred destroy queue.
+
+namespace alloy::vk {
+
+    class VulkanDevice;
+    class VulkanCommandQueue;
+    class VulkanBuffer;
+
+    class _VkDefragmenter : public IBufferDefragmenter {
+        DISABLE_COPY_AND_ASSIGN(_VkDefragmenter);
+
+        VulkanDevice* _dev;
+        std::vector<VulkanCommandQueue*> _queues;
+        // Runs the copies, with a command buffer from our own pool
+        VulkanCommandQueue* _copyQ;
+        VkCommandPool _cmdPool;
+        VkCommandBuffer _cmdBuf;
+
+        VmaPool _pool;
+
+        mutable std::mutex _m;
+        Budget _budget;
+        Stats _stats;
+
+        VmaDefragmentationContext _ctx;
+        VmaDefragmentationPassMoveInfo _pass;
+        bool _passPending;
+        // Per move of the pending pass, null once the buffer is gone
+        std::vector<VulkanBuffer*> _passBuffers;
+        _DeferredDestroyQueue::FenceSnapshot _passRetireAfter;
+
+        std::atomic<std::uint64_t> _moveEpoch;
+
+        void _BeginPass();
+        void _EndPass();
+        void _Finish();
+
+    public:
+        _VkDefragmenter();
+        ~_VkDefragmenter();
+
+        // After the allocator and queues. copyQ is one of queues.
+        void Init(
+            VulkanDevice* dev,
+            VulkanCommandQueue* copyQ,
+            std::span<VulkanCommandQueue* const> queues
+        );
+
+        // Abandons a run and destroys the pools. Every buffer is gone and
+        // the device is idle by now.
+        void Shutdown();
+
+        // Null if no memory type fits movable buffers
+        VmaPool GetPool() const { return _pool; }
+
+        bool CanMove(const IBuffer::Description& desc) const;
+
+        // Changes whenever a pass swapped buffer handles
+        std::uint64_t GetMoveEpoch() const {
+            return _moveEpoch.load(std::memory_order_acquire);
+        }
+
+        // Called with the buffer's allocation made from GetPool()
+        void Track(VulkanBuffer* buffer);
+
+        // True if the pending pass took over freeing the allocation
+        bool Untrack(VulkanBuffer* buffer);
+
+        virtual void SetBudget(const Budget& budget) override;
+        virtual void Start() override;
+        virtual void Update() override;
+        virtual bool IsRunning() const override;
+        virtual Stats GetStats() const override;
+    };
+
+}
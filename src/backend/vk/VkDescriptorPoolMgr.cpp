@@ -1,7 +1,13 @@
 #include "VkDescriptorPoolMgr.hpp"
 
+#include "alloy/common/Trace.hpp"
+
 #include <vector>
 #include <memory>
+#include <bit>
+#include <chrono>
+#include <functional>
+#include <thread>
 
 #include "VkCommon.hpp"
 #include "VulkanDevice.hpp"
@@ -15,21 +21,33 @@ namespace alloy::vk {
         , _poolType (args.type)
         , _maxSetsPerPool (args.maxSetsPerPool)
         , _maxDescriptorsPerPool (args.maxDescriptorsPerPool)
-        , _currentPool(nullptr)
+        , _allocCnt(0)
+        , _failedAllocCnt(0)
+        , _allocTimeNs(0)
+        , _maxAllocTimeNs(0)
     { }
 
     _DescriptorPoolMgr::~_DescriptorPoolMgr(){
+        //Retire current pools
+        for(auto& shard : _shards) {
+            if(shard.current)
+                _dirtyPools.push_back(std::move(shard.current));
+        }
+
         _SweepDirtyPools();
         ////All dirty pools should be recycled by now.
         assert(_dirtyPools.empty());
-        ////Retire current pool
-        //_currentPool = nullptr;
-//
+
         while (!_freePools.empty()) {
             auto pool = _freePools.front();
             _freePools.pop();
             VK_DEV_CALL(_dev, vkDestroyDescriptorPool(_dev->LogicalDev(), pool, nullptr));
         }
+
+        for(auto& [capacity, pools] : _freeDedicatedPools) {
+            for(auto pool : pools)
+                VK_DEV_CALL(_dev, vkDestroyDescriptorPool(_dev->LogicalDev(), pool, nullptr));
+        }
     }
     
     void _DescriptorPoolMgr::_SweepDirtyPools() {
@@ -48,13 +66,13 @@ namespace alloy::vk {
 
         for(i = end; i < _dirtyPools.size(); ++i) {
             Container* container = _dirtyPools[i].get();
+            // Bulk reset, individual sets are never freed
+            VK_CHECK(VK_DEV_CALL(_dev,
+                vkResetDescriptorPool(_dev->LogicalDev(), container->pool, 0)));
             if(container->isDedicatedAlloc) {
-                VK_DEV_CALL(_dev,
-                    vkDestroyDescriptorPool(_dev->LogicalDev(),  container->pool, 0));
+                _freeDedicatedPools[container->descriptorCapacity].push_back(container->pool);
             }
             else {
-                VK_CHECK(VK_DEV_CALL(_dev,
-                    vkResetDescriptorPool(_dev->LogicalDev(), container->pool, 0)));
                 _freePools.push(container->pool);
             }
         }
@@ -63,9 +81,6 @@ namespace alloy::vk {
     }
 
     VkDescriptorPool _DescriptorPoolMgr::_GetOnePool(){
-        //Should only be called from allocate
-        //std::scoped_lock l{_m_pool};
-
         if(_freePools.empty()) {
             _SweepDirtyPools();
         }
@@ -81,6 +96,55 @@ namespace alloy::vk {
         return rawPool;
     }
 
+    std::unique_ptr<_DescriptorPoolMgr::Container>
+    _DescriptorPoolMgr::_GetDedicatedPool(uint32_t descriptorCnt) {
+        // Round up to a size class so variable count sets of similar
+        // sizes can share recycled pools.
+        uint32_t capacity = std::bit_ceil(descriptorCnt);
+
+        auto findFree = [&]() -> VkDescriptorPool {
+            auto it = _freeDedicatedPools.find(capacity);
+            if(it == _freeDedicatedPools.end() || it->second.empty())
+                return VK_NULL_HANDLE;
+            auto pool = it->second.back();
+            it->second.pop_back();
+            return pool;
+        };
+
+        auto pool = findFree();
+        if(pool == VK_NULL_HANDLE) {
+            _SweepDirtyPools();
+            pool = findFree();
+        }
+        if(pool == VK_NULL_HANDLE) {
+            pool = _CreatePool(1, capacity);
+        }
+
+        return std::make_unique<Container>(
+            /*.pool */ pool,
+            /*.refCnt */ 0, // _DescriptorSet ctor will increment ref cnt
+            /*.isDedicatedAlloc */ true,
+            /*.descriptorCapacity */ capacity
+        );
+    }
+
+    _DescriptorPoolMgr::_Shard& _DescriptorPoolMgr::_GetShard() {
+        auto idx = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        return _shards[idx % kShardCount];
+    }
+
+    void _DescriptorPoolMgr::_RecordAlloc(uint64_t ns, bool succeeded) {
+        _allocCnt.fetch_add(1, std::memory_order_relaxed);
+        if(!succeeded)
+            _failedAllocCnt.fetch_add(1, std::memory_order_relaxed);
+        _allocTimeNs.fetch_add(ns, std::memory_order_relaxed);
+
+        auto prevMax = _maxAllocTimeNs.load(std::memory_order_relaxed);
+        while(prevMax < ns &&
+            !_maxAllocTimeNs.compare_exchange_weak(prevMax, ns, std::memory_order_relaxed))
+        { }
+    }
+
 
     VkDescriptorPool _DescriptorPoolMgr::_CreatePool(
         uint32_t maxSetsPerPool,
@@ -125,13 +189,14 @@ namespace alloy::vk {
         return descriptorPool;
     }
 
-    
     _DescriptorSet _DescriptorPoolMgr::Allocate(
         VkDescriptorSetLayout layout,
         uint32_t descriptorCnt, // Total descriptor counts. We can't get this info from
                             //   VkDescriptorSetLayout.
         bool isVariableCnt // Enables variable count
     ) {
+        VLD_TRACE_ZONE("_DescriptorPoolMgr::Allocate");
+        auto startTime = std::chrono::steady_clock::now();
         _DescriptorSet allocated {};
 
         VkDescriptorSetAllocateInfo allocInfo;
@@ -152,100 +217,119 @@ namespace alloy::vk {
             allocInfo.pNext = &variableCountInfo;
         }
 
-        {
-            //Critical section guard
+        // Make a dedicated allocation if descriptorCnt is larger than current
+        // block size
+        if(descriptorCnt >= _maxDescriptorsPerPool) {
             std::scoped_lock l{_m_pool};
 
-            // Make a dedicated allocation if descriptorCnt is larger than current
-            // block size
-            if(descriptorCnt >= _maxDescriptorsPerPool) {
-                auto dedicatedPool = _CreatePool(1, descriptorCnt);
-                allocInfo.descriptorPool = dedicatedPool;
-                // Should not fail the dedicated allocation
-                VkDescriptorSet set;
-                VK_CHECK(VK_DEV_CALL(_dev,
-                    vkAllocateDescriptorSets(_dev->LogicalDev(), &allocInfo, &set)));
-
-                auto pContainer = std::make_unique<Container>(
-                    /*.pool */ dedicatedPool,
-                    /*.refCnt */ 0, // _DescriptorSet ctor will increment ref cnt
-                    /*.isDedicatedAlloc */ true
+            auto pContainer = _GetDedicatedPool(descriptorCnt);
+            allocInfo.descriptorPool = pContainer->pool;
+            // Should not fail the dedicated allocation
+            VkDescriptorSet set;
+            VK_CHECK(VK_DEV_CALL(_dev,
+                vkAllocateDescriptorSets(_dev->LogicalDev(), &allocInfo, &set)));
+
+            allocated = _DescriptorSet(
+                pContainer.get(), set
+            );
+
+            _dirtyPools.push_back(std::move(pContainer));
+        } 
+        else {
+            //Only threads hashed to the same shard contend here
+            auto& shard = _GetShard();
+            std::scoped_lock l{shard.m};
+
+            auto _FetchFreshPool = [&]() {
+                std::scoped_lock lPool{_m_pool};
+                //Retire the full pool
+                if(shard.current)
+                    _dirtyPools.push_back(std::move(shard.current));
+                shard.current = std::make_unique<Container>(
+                    /*.pool */ _GetOnePool(),
+                    /*.refCnt */ 0,
+                    /*.isDedicatedAlloc */ false,
+                    /*.descriptorCapacity */ _maxDescriptorsPerPool
                 );
+            };
 
-                allocated = _DescriptorSet(
-                    pContainer.get(), set
-                );
+            bool fromFreshPool = false;
+            if(!shard.current) {
+                fromFreshPool = true;
+                _FetchFreshPool();
+            }
 
-                _dirtyPools.push_back(std::move(pContainer));
-            } 
-            else {
-                bool fromFreshPool = false;
-                if(!_currentPool) {
-                    fromFreshPool = true;
-                    auto newPool = _GetOnePool();
-                    auto pContainer = std::make_unique<Container>(
-                        newPool
-                    );
-                    _currentPool = pContainer.get();
-                    _dirtyPools.push_back(std::move(pContainer));
-                }
-
-                //Try to allocate from current pool.
-                auto vkPool = _currentPool->pool;
-                allocInfo.descriptorPool = vkPool;
-
-                VkDescriptorSet set;
-                VkResult result = VK_DEV_CALL(_dev,
-                    vkAllocateDescriptorSets(_dev->LogicalDev(), &allocInfo, &set));
+            //Try to allocate from current pool.
+            allocInfo.descriptorPool = shard.current->pool;
+
+            VkDescriptorSet set;
+            VkResult result = VK_DEV_CALL(_dev,
+                vkAllocateDescriptorSets(_dev->LogicalDev(), &allocInfo, &set));
 
-                switch (result) {
-                    case VK_SUCCESS: break;
-
-                    case VK_ERROR_FRAGMENTED_POOL:
-                    case VK_ERROR_OUT_OF_POOL_MEMORY:
-
-                    if(!fromFreshPool){
-                        //Fetch a new pool
-                        auto newPool = _GetOnePool();
-
-                        //Try to allocate from a clean pool
-                        allocInfo.descriptorPool = newPool;
-                        result = VK_DEV_CALL(_dev,
-                            vkAllocateDescriptorSets(_dev->LogicalDev(), &allocInfo, &set));
-                        if(result != VK_SUCCESS){
-                            //Still can't allocate, maybe the set is too large?
-                            //Clean up
-                            _freePools.push(newPool);
-                            return allocated;
-                        }
-
-                        //Allocate succeeded, seems like the current pool is full
-                        //Add to dirty pools
-
-                        //Wrap the raw pool
-                        auto pContainer = std::make_unique<Container>(
-                            newPool
-                        );
-
-                        //change current pool to new pool
-                        _currentPool = pContainer.get();
-                        _dirtyPools.push_back(std::move(pContainer));
-                        break;
-                    } 
-
-                    default:
-                        return allocated;
-                }
+            if((result == VK_ERROR_FRAGMENTED_POOL || result == VK_ERROR_OUT_OF_POOL_MEMORY)
+                && !fromFreshPool
+            ) {
+                //Current pool is full, try to allocate from a clean pool
+                _FetchFreshPool();
+                allocInfo.descriptorPool = shard.current->pool;
+                result = VK_DEV_CALL(_dev,
+                    vkAllocateDescriptorSets(_dev->LogicalDev(), &allocInfo, &set));
+            }
 
+            //Still can't allocate, maybe the set is too large?
+            //The fresh pool stays current for the next allocation.
+            if(result == VK_SUCCESS) {
                 allocated = _DescriptorSet(
-                    _currentPool, set
+                    shard.current.get(), set
                 );
             }
         }
-        //Release the mutex to allow old container to do its clean-ups
+
+        auto elapsed = std::chrono::steady_clock::now() - startTime;
+        _RecordAlloc(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+            allocated.GetHandle() != VK_NULL_HANDLE);
         
         return allocated;
     }
 
+    _DescriptorPoolMgr::Stats _DescriptorPoolMgr::GetStats() {
+        Stats stats {};
+
+        auto countPool = [&](const Container& container) {
+            auto refCnt = container.refCnt.load(std::memory_order_relaxed);
+            stats.poolsAlive++;
+            if(container.isDedicatedAlloc) stats.dedicatedPools++;
+            if(refCnt != 0) {
+                stats.liveSets += refCnt;
+                stats.setCapacity += container.isDedicatedAlloc ? 1 : _maxSetsPerPool;
+            }
+        };
+
+        for(auto& shard : _shards) {
+            std::scoped_lock l{shard.m};
+            if(shard.current) countPool(*shard.current);
+        }
+
+        {
+            std::scoped_lock l{_m_pool};
+            for(auto& container : _dirtyPools)
+                countPool(*container);
+
+            stats.freePools = _freePools.size();
+            for(auto& [capacity, pools] : _freeDedicatedPools) {
+                stats.freePools += pools.size();
+                stats.dedicatedPools += pools.size();
+            }
+            stats.poolsAlive += stats.freePools;
+        }
+
+        stats.allocations = _allocCnt.load(std::memory_order_relaxed);
+        stats.failedAllocations = _failedAllocCnt.load(std::memory_order_relaxed);
+        stats.allocTimeNs = _allocTimeNs.load(std::memory_order_relaxed);
+        stats.maxAllocTimeNs = _maxAllocTimeNs.load(std::memory_order_relaxed);
+        return stats;
+    }
+
 
 }
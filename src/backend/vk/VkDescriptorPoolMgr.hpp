@@ -6,9 +6,14 @@
 #include "alloy/common/Macros.h"
 
 #include <cstdint>
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
 #include <queue>
 #include <unordered_set>
 #include <mutex>
+#include <vector>
 
 // Vulkan multithreading safety:
 // From: https://docs.vulkan.org/spec/latest/chapters/descriptorsets.html
@@ -50,38 +55,75 @@ namespace alloy::vk {
             VkDescriptorPool pool;
             std::atomic<uint32_t> refCnt;
             
-            // We generally don't want to reuse a dedicated
-            // allocation pool:
-            //   1. It has only 1 set capacity
-            //   2. It has non-standard descriptor capacity
+            // Dedicated allocation pools hold a single set with a
+            // non-standard descriptor capacity. They are recycled
+            // only into the size class bucket they were created for.
             bool isDedicatedAlloc;
+            uint32_t descriptorCapacity;
          };
 
+        struct Stats {
+            uint64_t poolsAlive;      // Including free pools
+            uint64_t freePools;
+            uint64_t dedicatedPools;  // Alive dedicated pools, in use or free
+            // Fragmentation is 1 - liveSets / setCapacity, counted
+            // over pools with outstanding sets.
+            uint64_t liveSets;
+            uint64_t setCapacity;
+            uint64_t allocations;
+            uint64_t failedAllocations;
+            uint64_t allocTimeNs;     // Sum over all allocations
+            uint64_t maxAllocTimeNs;
+        };
+
+        // Allocations are striped by thread id so concurrent recording
+        // threads rarely contend on the same pool.
+        constexpr static unsigned kShardCount = 8;
+
     private:
+        struct alignas(64) _Shard {
+            std::mutex m;
+            //Currently active pool, that is not full.
+            std::unique_ptr<Container> current;
+        };
+
         VulkanDevice* _dev;
 
         VkDescriptorType _poolType;
         unsigned _maxSetsPerPool;
         unsigned _maxDescriptorsPerPool;
 
+        std::array<_Shard, kShardCount> _shards;
+
         //'Clean' pools.
         std::queue<VkDescriptorPool> _freePools;
+        //Clean dedicated pools, keyed by power of 2 descriptor capacity.
+        std::map<uint32_t, std::vector<VkDescriptorPool>> _freeDedicatedPools;
         //previously full pools, some sets might be freed, but at least one set is in use.
         std::vector<std::unique_ptr<Container>> _dirtyPools;
-        //Currently active pool, that is not full.
-        Container* _currentPool;
 
+        // Guards free and dirty pool lists. Taken after a shard lock.
         std::mutex _m_pool;
 
+        std::atomic<uint64_t> _allocCnt;
+        std::atomic<uint64_t> _failedAllocCnt;
+        std::atomic<uint64_t> _allocTimeNs;
+        std::atomic<uint64_t> _maxAllocTimeNs;
+
         // Walk each "dirty pools" and gather no outstanding ref ones
         // into _freePools. Not thread safe.
         void _SweepDirtyPools();
 
+        // Not thread safe, caller holds _m_pool.
         VkDescriptorPool _GetOnePool();
+        std::unique_ptr<Container> _GetDedicatedPool(uint32_t descriptorCnt);
         VkDescriptorPool _CreatePool(
             uint32_t maxSetsPerPool,
             uint32_t maxDescriptorsPerPool);
 
+        _Shard& _GetShard();
+        void _RecordAlloc(uint64_t ns, bool succeeded);
+
     public:
         struct CreateArgs {
             VulkanDevice* dev;
@@ -102,6 +144,8 @@ namespace alloy::vk {
                                 //   VkDescriptorSetLayout.
             bool isVariableCnt // Enables variable count
         );
+
+        Stats GetStats();
     };
 
 
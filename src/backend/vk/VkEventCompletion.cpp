@@ -0,0 +1,188 @@
+#include "VkEventCompletion.hpp"
+
+#include "alloy/common/Trace.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+#include "VkCommon.hpp"
+#include "VulkanDevice.hpp"
+
+namespace alloy::vk {
+
+    _VkEventCompletionThread::_VkEventCompletionThread()
+        : _dev(nullptr)
+        , _wake(VK_NULL_HANDLE)
+        , _wakeValue(0)
+        , _stopWorker(false)
+    { }
+
+    _VkEventCompletionThread::~_VkEventCompletionThread() {
+        assert(!_worker.joinable());
+        assert(_wake == VK_NULL_HANDLE);
+    }
+
+    void _VkEventCompletionThread::Init(VulkanDevice* dev) {
+        _dev = dev;
+
+        VkSemaphoreTypeCreateInfo timelineCreateInfo {};
+        timelineCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timelineCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timelineCreateInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo createInfo {};
+        createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        createInfo.pNext = &timelineCreateInfo;
+
+        VK_CHECK(VK_DEV_CALL(_dev,
+            vkCreateSemaphore(_dev->LogicalDev(), &createInfo, nullptr, &_wake)));
+
+        _stopWorker = false;
+        _worker = std::thread([this]() { _WorkerMain(); });
+    }
+
+    void _VkEventCompletionThread::Shutdown() {
+        if(_wake == VK_NULL_HANDLE) return;
+
+        {
+            std::scoped_lock lk{_m};
+            _stopWorker = true;
+            _Wake();
+        }
+        _cv.notify_all();
+        if(_worker.joinable())
+            _worker.join();
+
+        assert(_pending.empty());
+        VK_DEV_CALL(_dev, vkDestroySemaphore(_dev->LogicalDev(), _wake, nullptr));
+        _wake = VK_NULL_HANDLE;
+    }
+
+    void _VkEventCompletionThread::_Wake() {
+        VkSemaphoreSignalInfo signalInfo {};
+        signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+        signalInfo.semaphore = _wake;
+        signalInfo.value = ++_wakeValue;
+        VK_DEV_CALL(_dev, vkSignalSemaphoreKHR(_dev->LogicalDev(), &signalInfo));
+    }
+
+    void _VkEventCompletionThread::Add(
+        VkSemaphore semaphore,
+        uint64_t value,
+        IEvent::ReachedCallback callback
+    ) {
+        {
+            std::scoped_lock lk{_m};
+            // A lower value than the worker waits for needs a new wait
+            if(!_waiting.empty())
+                _Wake();
+            _pending.push_back({ semaphore, value, std::move(callback) });
+        }
+        _cv.notify_all();
+    }
+
+    void _VkEventCompletionThread::Cancel(VkSemaphore semaphore) {
+        std::vector<_Callback> dropped;
+        {
+            std::unique_lock lk{_m};
+            for(auto it = _pending.begin(); it != _pending.end(); ) {
+                if(it->semaphore == semaphore) {
+                    dropped.push_back(std::move(*it));
+                    it = _pending.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+
+            auto isWaitedOn = [&]() {
+                return std::find(_waiting.begin(), _waiting.end(), semaphore) != _waiting.end();
+            };
+            if(isWaitedOn()) {
+                _Wake();
+                _cv.wait(lk, [&]() { return !isWaitedOn(); });
+            }
+        }
+
+        // Never reached through this semaphore, outside the lock as they
+        // may add callbacks
+        for(auto& cb : dropped)
+            cb.fn(false);
+    }
+
+    void _VkEventCompletionThread::_WorkerMain() {
+        std::vector<VkSemaphore> sems;
+        std::vector<uint64_t> values;
+        std::unordered_map<VkSemaphore, uint64_t> reached;
+        std::vector<IEvent::ReachedCallback> ready;
+
+        std::unique_lock lk{_m};
+        for(;;) {
+            _cv.wait(lk, [&]() { return _stopWorker || !_pending.empty(); });
+            if(_stopWorker) return;
+
+            // Lowest pending value per semaphore
+            sems.clear();
+            values.clear();
+            for(auto& cb : _pending) {
+                auto it = std::find(sems.begin(), sems.end(), cb.semaphore);
+                if(it == sems.end()) {
+                    sems.push_back(cb.semaphore);
+                    values.push_back(cb.value);
+                }
+                else {
+                    auto& v = values[it - sems.begin()];
+                    v = (std::min)(v, cb.value);
+                }
+            }
+            _waiting = sems;
+
+            sems.push_back(_wake);
+            values.push_back(_wakeValue + 1);
+            lk.unlock();
+
+            {
+                VLD_TRACE_ZONE("_VkEventCompletionThread::Wait");
+                VkSemaphoreWaitInfo waitInfo {};
+                waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+                waitInfo.flags = VK_SEMAPHORE_WAIT_ANY_BIT;
+                waitInfo.semaphoreCount = (uint32_t)sems.size();
+                waitInfo.pSemaphores = sems.data();
+                waitInfo.pValues = values.data();
+                VK_DEV_CALL(_dev, vkWaitSemaphoresKHR(_dev->LogicalDev(), &waitInfo, UINT64_MAX));
+            }
+
+            // Still listed as waited on, Cancel() can't destroy them yet
+            reached.clear();
+            for(size_t i = 0; i + 1 < sems.size(); i++) {
+                uint64_t value = 0;
+                VK_DEV_CALL(_dev, vkGetSemaphoreCounterValueKHR(_dev->LogicalDev(), sems[i], &value));
+                reached[sems[i]] = value;
+            }
+
+            lk.lock();
+            _waiting.clear();
+            _cv.notify_all();
+
+            for(auto it = _pending.begin(); it != _pending.end(); ) {
+                auto r = reached.find(it->semaphore);
+                if(r != reached.end() && r->second >= it->value) {
+                    ready.push_back(std::move(it->fn));
+                    it = _pending.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+            if(ready.empty()) continue;
+
+            lk.unlock();
+            for(auto& fn : ready)
+                fn(true);
+            ready.clear();
+            lk.lock();
+        }
+    }
+
+}
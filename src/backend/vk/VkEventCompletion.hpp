@@ -0,0 +1,72 @@
+#pragma once
+
+#include <volk.h>
+
+#include "alloy/common/Macros.h"
+#include "alloy/SyncObjects.hpp"
+
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// IEvent::OnReached callbacks.
+//
+// A worker thread waits on the lowest pending value of every registered
+// timeline semaphore at once (vkWaitSemaphores, wait any) and runs the
+// callbacks that got reached. An internal timeline semaphore signaled
+// from the CPU interrupts the wait when callbacks are added or canceled.
+
+namespace alloy::vk {
+
+    class VulkanDevice;
+
+    class _VkEventCompletionThread {
+        DISABLE_COPY_AND_ASSIGN(_VkEventCompletionThread);
+
+        struct _Callback {
+            VkSemaphore semaphore;
+            uint64_t value;
+            IEvent::ReachedCallback fn;
+        };
+
+        VulkanDevice* _dev;
+
+        // Signaled with increasing values to interrupt the worker's wait
+        VkSemaphore _wake;
+        uint64_t _wakeValue;
+
+        std::vector<_Callback> _pending;
+        // Semaphores the worker is waiting on outside the lock
+        std::vector<VkSemaphore> _waiting;
+        std::mutex _m;
+        std::condition_variable _cv;
+
+        std::thread _worker;
+        bool _stopWorker;
+
+        // Under _m
+        void _Wake();
+
+        void _WorkerMain();
+
+    public:
+        _VkEventCompletionThread();
+        ~_VkEventCompletionThread();
+
+        void Init(VulkanDevice* dev);
+
+        // Every event is gone and the deferred destroy queue is shut
+        // down by now
+        void Shutdown();
+
+        void Add(VkSemaphore semaphore, uint64_t value, IEvent::ReachedCallback callback);
+
+        // Runs the semaphore's pending callbacks with false on this
+        // thread. Returns once the worker no longer waits on it, so it can
+        // be destroyed.
+        void Cancel(VkSemaphore semaphore);
+    };
+
+}
@@ -0,0 +1,273 @@
+#include "VkGpuProfiler.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "VkCommon.hpp"
+#include "VulkanDevice.hpp"
+
+namespace alloy::vk {
+
+    _VkGpuProfiler::_VkGpuProfiler()
+        : _dev(nullptr)
+        , _enabled(false)
+        , _timestampPeriod(1.0)
+        , _queues{}
+        , _frameIdx(0)
+    { }
+
+    _VkGpuProfiler::~_VkGpuProfiler() {
+        assert(_allBlocks.empty());
+    }
+
+    void _VkGpuProfiler::Init(
+        VulkanDevice* dev,
+        std::span<VulkanCommandQueue* const> queues
+    ) {
+        _dev = dev;
+        _timestampPeriod = _dev->GetDevCaps().limits.timestampPeriod;
+
+        assert(queues.size() <= kMaxQueues);
+        for(std::uint32_t i = 0; i < queues.size(); ++i)
+            _queues[i] = queues[i];
+
+        uint32_t familyCnt = 0;
+        VK_INST_CALL(_dev, vkGetPhysicalDeviceQueueFamilyProperties(
+            _dev->PhysicalDev(), &familyCnt, nullptr));
+        std::vector<VkQueueFamilyProperties> families(familyCnt);
+        VK_INST_CALL(_dev, vkGetPhysicalDeviceQueueFamilyProperties(
+            _dev->PhysicalDev(), &familyCnt, families.data()));
+
+        // Blocks are reset from host
+        bool hostQueryReset = _dev->GetDevCaps().features12.hostQueryReset;
+        for(auto& family : families) {
+            _timestampValidBits.push_back(hostQueryReset ? family.timestampValidBits : 0);
+        }
+
+        _frames.push_back({false, 0, Frame{_frameIdx, {}}});
+    }
+
+    void _VkGpuProfiler::Shutdown() {
+        _pending.clear();
+        _frames.clear();
+
+        for(auto pool : _allBlocks) {
+            VK_DEV_CALL(_dev, vkDestroyQueryPool(_dev->LogicalDev(), pool, nullptr));
+        }
+        _allBlocks.clear();
+        _freeBlocks.clear();
+    }
+
+    VkQueryPool _VkGpuProfiler::_AcquireBlock() {
+        VkQueryPool pool = VK_NULL_HANDLE;
+        {
+            std::scoped_lock l{_m_blocks};
+            if(!_freeBlocks.empty()) {
+                pool = _freeBlocks.back();
+                _freeBlocks.pop_back();
+            }
+        }
+
+        if(pool == VK_NULL_HANDLE) {
+            VkQueryPoolCreateInfo poolCI {};
+            poolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            poolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            poolCI.queryCount = kQueriesPerBlock;
+            VK_CHECK(VK_DEV_CALL(_dev,
+                vkCreateQueryPool(_dev->LogicalDev(), &poolCI, nullptr, &pool)));
+
+            std::scoped_lock l{_m_blocks};
+            _allBlocks.push_back(pool);
+        }
+
+        VK_DEV_CALL(_dev, vkResetQueryPool(_dev->LogicalDev(), pool, 0, kQueriesPerBlock));
+        return pool;
+    }
+
+    std::unique_ptr<_GpuProfileRecording> _VkGpuProfiler::BeginRecording(
+        std::uint32_t queueFamily
+    ) {
+        if(!IsEnabled()) return nullptr;
+        if(_timestampValidBits[queueFamily] == 0) return nullptr;
+        return std::make_unique<_GpuProfileRecording>();
+    }
+
+    void _VkGpuProfiler::ReleaseRecording(std::unique_ptr<_GpuProfileRecording>&& rec) {
+        if(!rec) return;
+        std::scoped_lock l{_m_blocks};
+        _freeBlocks.insert(_freeBlocks.end(), rec->blocks.begin(), rec->blocks.end());
+        rec.reset();
+    }
+
+    std::uint32_t _VkGpuProfiler::_WriteTimestamp(
+        VkCommandBuffer cmdBuf,
+        _GpuProfileRecording& rec,
+        VkPipelineStageFlags2 stage
+    ) {
+        auto query = rec.queryCnt++;
+        auto blockIdx = query / kQueriesPerBlock;
+        if(blockIdx == rec.blocks.size()) {
+            rec.blocks.push_back(_AcquireBlock());
+        }
+
+        VK_DEV_CALL(_dev, vkCmdWriteTimestamp2KHR(
+            cmdBuf, stage, rec.blocks[blockIdx], query % kQueriesPerBlock));
+        return query;
+    }
+
+    void _VkGpuProfiler::BeginScope(
+        VkCommandBuffer cmdBuf,
+        _GpuProfileRecording& rec,
+        const std::string& name,
+        bool isPass
+    ) {
+        std::uint32_t parent = rec.stack.empty() ? kNoParent : rec.stack.back();
+        std::uint32_t scopeIdx = rec.scopes.size();
+
+        rec.scopes.push_back({
+            name,
+            parent,
+            (std::uint32_t)rec.stack.size(),
+            _WriteTimestamp(cmdBuf, rec, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT),
+            0
+        });
+
+        if(isPass) rec.passDepth = rec.stack.size();
+        rec.stack.push_back(scopeIdx);
+    }
+
+    void _VkGpuProfiler::EndGroupScope(VkCommandBuffer cmdBuf, _GpuProfileRecording& rec) {
+        // Unbalanced pop, or pop of the pass scope itself
+        if(rec.stack.empty()) return;
+        if(rec.passDepth != kNoParent && rec.stack.size() - 1 == rec.passDepth) return;
+
+        auto& scope = rec.scopes[rec.stack.back()];
+        scope.endQuery = _WriteTimestamp(cmdBuf, rec, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT);
+        rec.stack.pop_back();
+    }
+
+    void _VkGpuProfiler::EndPassScope(VkCommandBuffer cmdBuf, _GpuProfileRecording& rec) {
+        if(rec.passDepth == kNoParent) return;
+
+        // Groups left open inside the pass end with it
+        auto endQuery = _WriteTimestamp(cmdBuf, rec, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT);
+        while(rec.stack.size() > rec.passDepth) {
+            rec.scopes[rec.stack.back()].endQuery = endQuery;
+            rec.stack.pop_back();
+        }
+        rec.passDepth = kNoParent;
+    }
+
+    void _VkGpuProfiler::EndAllScopes(VkCommandBuffer cmdBuf, _GpuProfileRecording& rec) {
+        if(rec.stack.empty()) return;
+
+        auto endQuery = _WriteTimestamp(cmdBuf, rec, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT);
+        for(auto scopeIdx : rec.stack) {
+            rec.scopes[scopeIdx].endQuery = endQuery;
+        }
+        rec.stack.clear();
+        rec.passDepth = kNoParent;
+    }
+
+    void _VkGpuProfiler::OnSubmit(
+        std::unique_ptr<_GpuProfileRecording>&& rec,
+        const VulkanCommandQueue* queue,
+        std::uint64_t signalValue
+    ) {
+        if(!rec) return;
+        if(rec->scopes.empty()) {
+            ReleaseRecording(std::move(rec));
+            return;
+        }
+
+        std::uint32_t queueIdx = 0;
+        while(queueIdx < kMaxQueues && _queues[queueIdx] != queue) ++queueIdx;
+        assert(queueIdx < kMaxQueues);
+
+        std::scoped_lock l{_m_frames};
+        _frames.back().outstanding++;
+        _pending.push_back({_frameIdx, queueIdx, signalValue, std::move(rec)});
+    }
+
+    void _VkGpuProfiler::_Resolve(_Pending& pending, Frame& frame) {
+        auto& rec = *pending.recording;
+
+        std::vector<std::uint64_t> ticks(rec.queryCnt);
+        for(std::uint32_t blockIdx = 0; blockIdx < rec.blocks.size(); ++blockIdx) {
+            auto first = blockIdx * kQueriesPerBlock;
+            auto cnt = std::min(kQueriesPerBlock, rec.queryCnt - first);
+            // Submission is known complete, results are available
+            VK_CHECK(VK_DEV_CALL(_dev, vkGetQueryPoolResults(
+                _dev->LogicalDev(), rec.blocks[blockIdx], 0, cnt,
+                cnt * sizeof(std::uint64_t), ticks.data() + first,
+                sizeof(std::uint64_t), VK_QUERY_RESULT_64_BIT)));
+        }
+
+        auto queueFamily = _queues[pending.queueIdx]->GetQueueFamily();
+        auto validBits = _timestampValidBits[queueFamily];
+        std::uint64_t mask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+        auto toNs = [&](std::uint32_t query) {
+            return (std::uint64_t)((double)(ticks[query] & mask) * _timestampPeriod);
+        };
+
+        std::uint32_t base = frame.scopes.size();
+        for(auto& scope : rec.scopes) {
+            frame.scopes.push_back({
+                scope.name,
+                scope.parent == kNoParent ? kNoParent : base + scope.parent,
+                scope.depth,
+                pending.queueIdx,
+                toNs(scope.beginQuery),
+                toNs(scope.endQuery)
+            });
+        }
+    }
+
+    void _VkGpuProfiler::EndFrame() {
+        std::scoped_lock l{_m_frames};
+        _frames.back().ended = true;
+        _frameIdx++;
+        _frames.push_back({false, 0, Frame{_frameIdx, {}}});
+    }
+
+    std::vector<IGpuProfiler::Frame> _VkGpuProfiler::CollectFrames() {
+        std::vector<std::unique_ptr<_GpuProfileRecording>> resolved;
+        std::vector<Frame> collected;
+
+        {
+            std::scoped_lock l{_m_frames};
+
+            std::uint64_t completed[kMaxQueues] {};
+            for(std::uint32_t i = 0; i < kMaxQueues; ++i) {
+                if(_queues[i]) completed[i] = _queues[i]->GetCompletedValue();
+            }
+
+            auto firstFrameIdx = _frames.front().frame.frameIdx;
+            // Queues finish independently, so check every pending entry
+            for(auto it = _pending.begin(); it != _pending.end();) {
+                if(it->signalValue > completed[it->queueIdx]) {
+                    ++it;
+                    continue;
+                }
+
+                auto& state = _frames[it->frameIdx - firstFrameIdx];
+                _Resolve(*it, state.frame);
+                state.outstanding--;
+                resolved.push_back(std::move(it->recording));
+                it = _pending.erase(it);
+            }
+
+            while(_frames.front().ended && _frames.front().outstanding == 0) {
+                collected.push_back(std::move(_frames.front().frame));
+                _frames.pop_front();
+            }
+        }
+
+        for(auto& rec : resolved) {
+            ReleaseRecording(std::move(rec));
+        }
+
+        return collected;
+    }
+
+}
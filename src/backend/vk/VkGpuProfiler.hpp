@@ -0,0 +1,134 @@
+#pragma once
+
+#include <volk.h>
+
+#include "alloy/common/Macros.h"
+#include "alloy/GpuProfiler.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+// Timestamp queries for IGpuProfiler.
+//
+// Each command list records into its own _GpuProfileRecording, taking
+// fixed size query pool blocks from a shared free list as it goes. Blocks
+// are host reset (hostQueryReset) when handed out, so recording never has
+// to reset queries outside a render pass. At submission the recording is
+// tagged with the queue timeline value; it's read back and its blocks
+// recycled once the timeline passes that value.
+
+namespace alloy::vk {
+
+    class VulkanDevice;
+    class VulkanCommandQueue;
+
+    struct _GpuProfileRecording {
+        struct Scope {
+            std::string name;
+            std::uint32_t parent;
+            std::uint32_t depth;
+            std::uint32_t beginQuery;
+            std::uint32_t endQuery;
+        };
+
+        std::vector<VkQueryPool> blocks;
+        std::uint32_t queryCnt = 0;
+
+        std::vector<Scope> scopes;
+        // Open scopes, innermost last
+        std::vector<std::uint32_t> stack;
+        // Stack depth of the open pass scope, if any
+        std::uint32_t passDepth = IGpuProfiler::kNoParent;
+    };
+
+    class _VkGpuProfiler : public IGpuProfiler {
+        DISABLE_COPY_AND_ASSIGN(_VkGpuProfiler);
+
+    public:
+        constexpr static std::uint32_t kQueriesPerBlock = 256;
+        constexpr static std::uint32_t kMaxQueues = 3;
+
+    private:
+        struct _Pending {
+            std::uint64_t frameIdx;
+            std::uint32_t queueIdx;
+            std::uint64_t signalValue;
+            std::unique_ptr<_GpuProfileRecording> recording;
+        };
+
+        struct _FrameState {
+            bool ended;
+            std::uint32_t outstanding;
+            Frame frame;
+        };
+
+        VulkanDevice* _dev;
+        std::atomic<bool> _enabled;
+        double _timestampPeriod;
+
+        VulkanCommandQueue* _queues[kMaxQueues];
+        // Per queue family, 0 if it can't write timestamps
+        std::vector<std::uint32_t> _timestampValidBits;
+
+        std::mutex _m_blocks;
+        std::vector<VkQueryPool> _freeBlocks;
+        std::vector<VkQueryPool> _allBlocks;
+
+        std::mutex _m_frames;
+        std::uint64_t _frameIdx;
+        std::deque<_Pending> _pending;
+        std::deque<_FrameState> _frames;
+
+        VkQueryPool _AcquireBlock();
+        std::uint32_t _WriteTimestamp(
+            VkCommandBuffer cmdBuf,
+            _GpuProfileRecording& rec,
+            VkPipelineStageFlags2 stage);
+        void _Resolve(_Pending& pending, Frame& frame);
+
+    public:
+        _VkGpuProfiler();
+        ~_VkGpuProfiler() override;
+
+        void Init(VulkanDevice* dev, std::span<VulkanCommandQueue* const> queues);
+        // Destroys query pools, device must be idle
+        void Shutdown();
+
+        // Null when disabled or the queue family lacks timestamps
+        std::unique_ptr<_GpuProfileRecording> BeginRecording(std::uint32_t queueFamily);
+        void ReleaseRecording(std::unique_ptr<_GpuProfileRecording>&& rec);
+
+        void BeginScope(
+            VkCommandBuffer cmdBuf,
+            _GpuProfileRecording& rec,
+            const std::string& name,
+            bool isPass);
+        // Closes the innermost debug group, never the pass scope
+        void EndGroupScope(VkCommandBuffer cmdBuf, _GpuProfileRecording& rec);
+        // Closes the pass scope and debug groups left open in it
+        void EndPassScope(VkCommandBuffer cmdBuf, _GpuProfileRecording& rec);
+        void EndAllScopes(VkCommandBuffer cmdBuf, _GpuProfileRecording& rec);
+
+        void OnSubmit(
+            std::unique_ptr<_GpuProfileRecording>&& rec,
+            const VulkanCommandQueue* queue,
+            std::uint64_t signalValue);
+
+        /*IGpuProfiler implementations*/
+        virtual void SetEnabled(bool enabled) override {
+            _enabled.store(enabled, std::memory_order_relaxed);
+        }
+        virtual bool IsEnabled() const override {
+            return _enabled.load(std::memory_order_relaxed);
+        }
+        virtual void EndFrame() override;
+        virtual std::vector<Frame> CollectFrames() override;
+    };
+
+}
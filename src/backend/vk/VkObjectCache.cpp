@@ -0,0 +1,212 @@
+#include "VkObjectCache.hpp"
+
+#include <cassert>
+
+#include "VkCommon.hpp"
+#include "VulkanDevice.hpp"
+
+namespace alloy::vk {
+
+    _VkObjectCache::~_VkObjectCache() {
+        // Every owner releases before device goes away
+        assert(_samplers.entries.empty());
+        assert(_imageViews.entries.empty());
+        assert(_dsls.entries.empty());
+        assert(_pipelineLayouts.entries.empty());
+    }
+
+    template<typename Handle, typename CreateFn>
+    Handle _VkObjectCache::_Acquire(
+        _Cache<Handle>& cache,
+        std::string&& key,
+        bool cacheable,
+        CreateFn&& create
+    ) {
+        std::scoped_lock lk{cache.m};
+        if(cacheable) {
+            auto it = cache.entries.find(key);
+            if(it != cache.entries.end()) {
+                cache.hits++;
+                it->second.refCnt++;
+                return it->second.handle;
+            }
+        }
+
+        cache.misses++;
+        Handle handle = create();
+
+        if(!cacheable) {
+            // Private key nobody else can match
+            _KeyWriter privateKey {'!'};
+            privateKey << _HandleBits(handle);
+            key = privateKey.Take();
+        }
+
+        cache.entries.emplace(key, typename _Cache<Handle>::Entry{handle, 1});
+        cache.keys.emplace(handle, std::move(key));
+        return handle;
+    }
+
+    template<typename Handle>
+    bool _VkObjectCache::_Release(_Cache<Handle>& cache, Handle handle) {
+        std::scoped_lock lk{cache.m};
+        auto keyIt = cache.keys.find(handle);
+        assert(keyIt != cache.keys.end());
+
+        auto it = cache.entries.find(keyIt->second);
+        assert(it != cache.entries.end());
+        assert(it->second.refCnt > 0);
+
+        if(--it->second.refCnt > 0) return false;
+
+        cache.entries.erase(it);
+        cache.keys.erase(keyIt);
+        return true;
+    }
+
+    template<typename Handle>
+    bool _VkObjectCache::_IsShareable(_Cache<Handle>& cache, Handle handle) {
+        std::scoped_lock lk{cache.m};
+        auto keyIt = cache.keys.find(handle);
+        assert(keyIt != cache.keys.end());
+        return keyIt->second.front() != '!';
+    }
+
+    template<typename Handle>
+    _VkObjectCache::Stats _VkObjectCache::_GetStats(_Cache<Handle>& cache) {
+        std::scoped_lock lk{cache.m};
+        Stats stats {};
+        stats.hits = cache.hits;
+        stats.misses = cache.misses;
+        stats.alive = cache.entries.size();
+        return stats;
+    }
+
+    VkSampler _VkObjectCache::AcquireSampler(const VkSamplerCreateInfo& ci) {
+        _KeyWriter key {'s'};
+        key << ci.flags
+            << ci.magFilter << ci.minFilter << ci.mipmapMode
+            << ci.addressModeU << ci.addressModeV << ci.addressModeW
+            << ci.mipLodBias
+            << ci.anisotropyEnable << ci.maxAnisotropy
+            << ci.compareEnable << ci.compareOp
+            << ci.minLod << ci.maxLod
+            << ci.borderColor
+            << ci.unnormalizedCoordinates;
+
+        return _Acquire(_samplers, key.Take(), ci.pNext == nullptr, [&]() {
+            VkSampler sampler;
+            VK_CHECK(VK_DEV_CALL(_dev,
+                vkCreateSampler(_dev->LogicalDev(), &ci, nullptr, &sampler)));
+            return sampler;
+        });
+    }
+
+    void _VkObjectCache::ReleaseSampler(VkSampler sampler) {
+        if(_Release(_samplers, sampler))
+            _dev->DeferDestroy(VK_OBJECT_TYPE_SAMPLER, (uint64_t)sampler);
+    }
+
+    VkImageView _VkObjectCache::AcquireImageView(const VkImageViewCreateInfo& ci) {
+        _KeyWriter key {'v'};
+        key << ci.flags
+            << _HandleBits(ci.image)
+            << ci.viewType << ci.format
+            << ci.components.r << ci.components.g << ci.components.b << ci.components.a
+            << ci.subresourceRange.aspectMask
+            << ci.subresourceRange.baseMipLevel << ci.subresourceRange.levelCount
+            << ci.subresourceRange.baseArrayLayer << ci.subresourceRange.layerCount;
+
+        return _Acquire(_imageViews, key.Take(), ci.pNext == nullptr, [&]() {
+            VkImageView view;
+            VK_CHECK(VK_DEV_CALL(_dev,
+                vkCreateImageView(_dev->LogicalDev(), &ci, nullptr, &view)));
+            return view;
+        });
+    }
+
+    void _VkObjectCache::ReleaseImageView(VkImageView view) {
+        if(_Release(_imageViews, view))
+            _dev->DeferDestroy(VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t)view);
+    }
+
+    VkDescriptorSetLayout _VkObjectCache::AcquireDSL(const VkDescriptorSetLayoutCreateInfo& ci) {
+        _KeyWriter key {'d'};
+        key << ci.flags << ci.bindingCount;
+        for(uint32_t i = 0; i < ci.bindingCount; i++) {
+            const auto& b = ci.pBindings[i];
+            key << b.binding << b.descriptorType << b.descriptorCount << b.stageFlags;
+            bool hasImmutableSamplers = b.pImmutableSamplers != nullptr;
+            key << hasImmutableSamplers;
+            if(hasImmutableSamplers) {
+                for(uint32_t j = 0; j < b.descriptorCount; j++)
+                    key << _HandleBits(b.pImmutableSamplers[j]);
+            }
+        }
+
+        bool cacheable = true;
+        for(auto* p = (const VkBaseInStructure*)ci.pNext; p != nullptr; p = p->pNext) {
+            switch(p->sType) {
+            case VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO: {
+                auto* flagsCI = (const VkDescriptorSetLayoutBindingFlagsCreateInfo*)p;
+                key << p->sType << flagsCI->bindingCount;
+                for(uint32_t i = 0; i < flagsCI->bindingCount; i++)
+                    key << flagsCI->pBindingFlags[i];
+                break;
+            }
+            case VK_STRUCTURE_TYPE_MUTABLE_DESCRIPTOR_TYPE_CREATE_INFO_EXT: {
+                auto* mutCI = (const VkMutableDescriptorTypeCreateInfoEXT*)p;
+                key << p->sType << mutCI->mutableDescriptorTypeListCount;
+                for(uint32_t i = 0; i < mutCI->mutableDescriptorTypeListCount; i++) {
+                    const auto& list = mutCI->pMutableDescriptorTypeLists[i];
+                    key << list.descriptorTypeCount;
+                    for(uint32_t j = 0; j < list.descriptorTypeCount; j++)
+                        key << list.pDescriptorTypes[j];
+                }
+                break;
+            }
+            default:
+                cacheable = false;
+                break;
+            }
+        }
+
+        return _Acquire(_dsls, key.Take(), cacheable, [&]() {
+            VkDescriptorSetLayout dsl;
+            VK_CHECK(VK_DEV_CALL(_dev,
+                vkCreateDescriptorSetLayout(_dev->LogicalDev(), &ci, nullptr, &dsl)));
+            return dsl;
+        });
+    }
+
+    void _VkObjectCache::ReleaseDSL(VkDescriptorSetLayout dsl) {
+        if(_Release(_dsls, dsl))
+            _dev->DeferDestroy(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, (uint64_t)dsl);
+    }
+
+    VkPipelineLayout _VkObjectCache::AcquirePipelineLayout(const VkPipelineLayoutCreateInfo& ci) {
+        // DSLs are deduplicated too, so handle identity is enough here
+        _KeyWriter key {'p'};
+        key << ci.flags << ci.setLayoutCount;
+        for(uint32_t i = 0; i < ci.setLayoutCount; i++)
+            key << _HandleBits(ci.pSetLayouts[i]);
+        key << ci.pushConstantRangeCount;
+        for(uint32_t i = 0; i < ci.pushConstantRangeCount; i++) {
+            const auto& r = ci.pPushConstantRanges[i];
+            key << r.stageFlags << r.offset << r.size;
+        }
+
+        return _Acquire(_pipelineLayouts, key.Take(), ci.pNext == nullptr, [&]() {
+            VkPipelineLayout layout;
+            VK_CHECK(VK_DEV_CALL(_dev,
+                vkCreatePipelineLayout(_dev->LogicalDev(), &ci, nullptr, &layout)));
+            return layout;
+        });
+    }
+
+    void _VkObjectCache::ReleasePipelineLayout(VkPipelineLayout layout) {
+        if(_Release(_pipelineLayouts, layout))
+            _dev->DeferDestroy(VK_OBJECT_TYPE_PIPELINE_LAYOUT, (uint64_t)layout);
+    }
+
+}
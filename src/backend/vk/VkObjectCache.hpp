@@ -0,0 +1,134 @@
+#pragma once
+
+#include <volk.h>
+
+#include "alloy/common/Macros.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <mutex>
+
+// Hash-consing caches for immutable Vulkan objects.
+//
+// Samplers, image views, descriptor set layouts and pipeline layouts are
+// fully described by their create info. Identical create infos share one
+// native handle, refcounted by Acquire/Release pairs. The handle is handed
+// to the device deferred destroy queue once the last user releases it.
+//
+// Keys are the create infos flattened into byte strings, pointers followed
+// (bindings, set layouts, push constant ranges, known pNext structs).
+// Create infos with unknown pNext structs are never shared.
+//
+// Debug names go on the native handle, so shareable handles must not be
+// named: the name would show on every user of the handle, and stick to
+// it for users that come later.
+
+namespace alloy::vk {
+
+    class VulkanDevice;
+
+    // Appends field by field, so struct padding never leaks into keys
+    class _KeyWriter {
+        std::string _key;
+    public:
+        explicit _KeyWriter(char tag) { _key.push_back(tag); }
+
+        template<typename T>
+        _KeyWriter& operator<<(const T& v) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            _key.append(reinterpret_cast<const char*>(&v), sizeof(T));
+            return *this;
+        }
+
+        // Length prefixed
+        _KeyWriter& operator<<(std::string_view str) {
+            *this << str.size();
+            _key.append(str);
+            return *this;
+        }
+        _KeyWriter& operator<<(const std::string& str) {
+            return *this << std::string_view(str);
+        }
+
+        std::string Take() { return std::move(_key); }
+    };
+
+    template<typename T>
+    uint64_t _HandleBits(T handle) { return (uint64_t)handle; }
+
+    class _VkObjectCache {
+        DISABLE_COPY_AND_ASSIGN(_VkObjectCache);
+
+    public:
+        struct Stats {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t alive;
+        };
+
+    private:
+        template<typename Handle>
+        struct _Cache {
+            struct Entry {
+                Handle handle;
+                uint32_t refCnt;
+            };
+
+            std::unordered_map<std::string, Entry> entries;
+            // Reverse lookup for Release
+            std::unordered_map<Handle, std::string> keys;
+            std::mutex m;
+
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+        };
+
+        VulkanDevice* _dev;
+
+        _Cache<VkSampler> _samplers;
+        _Cache<VkImageView> _imageViews;
+        _Cache<VkDescriptorSetLayout> _dsls;
+        _Cache<VkPipelineLayout> _pipelineLayouts;
+
+        template<typename Handle, typename CreateFn>
+        Handle _Acquire(_Cache<Handle>& cache, std::string&& key, bool cacheable, CreateFn&& create);
+
+        template<typename Handle>
+        bool _Release(_Cache<Handle>& cache, Handle handle);
+
+        template<typename Handle>
+        static bool _IsShareable(_Cache<Handle>& cache, Handle handle);
+
+        template<typename Handle>
+        static Stats _GetStats(_Cache<Handle>& cache);
+
+    public:
+        _VkObjectCache() : _dev(nullptr) {}
+        ~_VkObjectCache();
+
+        void Init(VulkanDevice* dev) { _dev = dev; }
+
+        VkSampler AcquireSampler(const VkSamplerCreateInfo& ci);
+        void ReleaseSampler(VkSampler sampler);
+        // False for samplers nobody else can be handed
+        bool IsSamplerShareable(VkSampler sampler) { return _IsShareable(_samplers, sampler); }
+
+        VkImageView AcquireImageView(const VkImageViewCreateInfo& ci);
+        void ReleaseImageView(VkImageView view);
+
+        VkDescriptorSetLayout AcquireDSL(const VkDescriptorSetLayoutCreateInfo& ci);
+        void ReleaseDSL(VkDescriptorSetLayout dsl);
+
+        VkPipelineLayout AcquirePipelineLayout(const VkPipelineLayoutCreateInfo& ci);
+        void ReleasePipelineLayout(VkPipelineLayout layout);
+
+        Stats GetSamplerStats()        { return _GetStats(_samplers); }
+        Stats GetImageViewStats()      { return _GetStats(_imageViews); }
+        Stats GetDSLStats()            { return _GetStats(_dsls); }
+        Stats GetPipelineLayoutStats() { return _GetStats(_pipelineLayouts); }
+    };
+
+}
@@ -0,0 +1,162 @@
+#include "VkPipelineLibrary.hpp"
+
+#include "alloy/common/Trace.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "VkCommon.hpp"
+#include "VulkanDevice.hpp"
+#include "VulkanPipeline.hpp"
+
+namespace alloy::vk {
+
+    _VkPipelineLibraryCache::_VkPipelineLibraryCache()
+        : _dev(nullptr)
+        , _hits(0)
+        , _misses(0)
+        , _relinking(nullptr)
+        , _relinked(0)
+        , _stopWorker(false)
+    { }
+
+    _VkPipelineLibraryCache::~_VkPipelineLibraryCache() {
+        // Every pipeline releases its parts before device goes away
+        assert(!_worker.joinable());
+        assert(_entries.empty());
+        assert(_relinkQueue.empty());
+    }
+
+    void _VkPipelineLibraryCache::Init(VulkanDevice* dev) {
+        _dev = dev;
+        _stopWorker = false;
+        _worker = std::thread([this]() { _WorkerMain(); });
+    }
+
+    void _VkPipelineLibraryCache::Shutdown() {
+        {
+            std::scoped_lock lk{_m_relink};
+            _stopWorker = true;
+        }
+        _cvRelink.notify_all();
+        if(_worker.joinable())
+            _worker.join();
+    }
+
+    _VkPipelineLibraryCache::Library _VkPipelineLibraryCache::Acquire(
+        std::string&& key,
+        const CreateFn& create
+    ) {
+        std::unique_lock lk{_m_entries};
+        auto [it, inserted] = _entries.try_emplace(std::move(key));
+        // Map nodes don't move, the entry stays put while unlocked. The
+        // reference taken here keeps it from being released.
+        auto& entry = it->second;
+        if(!inserted) {
+            _hits++;
+            entry.refCnt++;
+            _cvEntries.wait(lk, [&]() { return entry.ready; });
+            return { entry.handle, &entry.stageOutputs };
+        }
+
+        _misses++;
+        entry.handle = VK_NULL_HANDLE;
+        entry.refCnt = 1;
+        entry.ready = false;
+        lk.unlock();
+
+        CreateResult res;
+        {
+            VLD_TRACE_ZONE("_VkPipelineLibraryCache::Compile");
+            res = create();
+        }
+
+        lk.lock();
+        entry.handle = res.handle;
+        entry.refs = std::move(res.refs);
+        entry.stageOutputs = std::move(res.stageOutputs);
+        entry.ready = true;
+        _keys.emplace(res.handle, it->first);
+        lk.unlock();
+        _cvEntries.notify_all();
+
+        return { entry.handle, &entry.stageOutputs };
+    }
+
+    void _VkPipelineLibraryCache::Release(VkPipeline library) {
+        {
+            std::scoped_lock lk{_m_entries};
+            // Only handed out once ready, so the key is registered
+            auto keyIt = _keys.find(library);
+            assert(keyIt != _keys.end());
+
+            auto it = _entries.find(keyIt->second);
+            assert(it != _entries.end());
+            assert(it->second.refCnt > 0);
+
+            if(--it->second.refCnt > 0) return;
+
+            _entries.erase(it);
+            _keys.erase(keyIt);
+        }
+        _dev->DeferDestroy(VK_OBJECT_TYPE_PIPELINE, (uint64_t)library);
+    }
+
+    void _VkPipelineLibraryCache::RequestRelink(VulkanGraphicsPipeline* pipeline) {
+        {
+            std::scoped_lock lk{_m_relink};
+            _relinkQueue.push_back(pipeline);
+        }
+        _cvRelink.notify_all();
+    }
+
+    void _VkPipelineLibraryCache::CancelRelink(VulkanGraphicsPipeline* pipeline) {
+        std::unique_lock lk{_m_relink};
+        std::erase(_relinkQueue, pipeline);
+        _cvRelink.wait(lk, [&]() { return _relinking != pipeline; });
+    }
+
+    void _VkPipelineLibraryCache::_WorkerMain() {
+        for(;;) {
+            VulkanGraphicsPipeline* pipeline;
+            {
+                std::unique_lock lk{_m_relink};
+                _cvRelink.wait(lk, [&]() { return _stopWorker || !_relinkQueue.empty(); });
+                if(_stopWorker) return;
+
+                pipeline = _relinkQueue.front();
+                _relinkQueue.pop_front();
+                _relinking = pipeline;
+            }
+
+            {
+                VLD_TRACE_ZONE("_VkPipelineLibraryCache::Relink");
+                pipeline->RelinkOptimized();
+            }
+
+            {
+                std::scoped_lock lk{_m_relink};
+                _relinking = nullptr;
+                _relinked++;
+            }
+            _cvRelink.notify_all();
+        }
+    }
+
+    _VkPipelineLibraryCache::Stats _VkPipelineLibraryCache::GetStats() {
+        Stats stats {};
+        {
+            std::scoped_lock lk{_m_entries};
+            stats.hits = _hits;
+            stats.misses = _misses;
+            stats.alive = _entries.size();
+        }
+        {
+            std::scoped_lock lk{_m_relink};
+            stats.pendingRelinks = _relinkQueue.size() + (_relinking ? 1 : 0);
+            stats.relinked = _relinked;
+        }
+        return stats;
+    }
+
+}
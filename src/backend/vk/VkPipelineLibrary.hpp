@@ -0,0 +1,125 @@
+#pragma once
+
+#include <volk.h>
+
+#include "alloy/common/Macros.h"
+#include "alloy/common/RefCnt.hpp"
+
+#include "VulkanShader.hpp"
+
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Graphics pipeline library parts (VK_EXT_graphics_pipeline_library).
+//
+// A graphics pipeline is split into vertex input, pre-rasterization,
+// fragment shader and fragment output parts. Each part is compiled once
+// per distinct key and shared by every pipeline using it, refcounted by
+// Acquire/Release pairs like _VkObjectCache. Changing blend state only
+// compiles a new fragment output part, the shaders are reused.
+//
+// Pipelines fast-link their parts so creation doesn't wait on a full
+// compile. A worker thread relinks them with link time optimization
+// afterwards and the pipeline switches over to the result.
+//
+// Keys may hold shader and resource layout pointers. Entries keep those
+// objects referenced, so a pointer can't be reused while it's cached.
+
+namespace alloy::vk {
+
+    class VulkanDevice;
+    class VulkanGraphicsPipeline;
+
+    class _VkPipelineLibraryCache {
+        DISABLE_COPY_AND_ASSIGN(_VkPipelineLibraryCache);
+
+    public:
+        struct Library {
+            VkPipeline handle;
+            // Vertex stage outputs the fragment stage links against.
+            // Only filled for pre-rasterization parts.
+            const SPVRemapper::StageIOMap* stageOutputs;
+        };
+
+        struct CreateResult {
+            VkPipeline handle;
+            std::vector<common::sp<common::RefCntBase>> refs;
+            SPVRemapper::StageIOMap stageOutputs;
+        };
+
+        using CreateFn = std::function<CreateResult()>;
+
+        struct Stats {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t alive;
+            uint64_t pendingRelinks;
+            uint64_t relinked;
+        };
+
+    private:
+        struct _Entry {
+            VkPipeline handle;
+            uint32_t refCnt;
+            // Set once the first acquirer finished compiling. Later
+            // acquirers of the key wait on _cvEntries until then.
+            bool ready;
+            std::vector<common::sp<common::RefCntBase>> refs;
+            SPVRemapper::StageIOMap stageOutputs;
+        };
+
+        VulkanDevice* _dev;
+
+        std::unordered_map<std::string, _Entry> _entries;
+        // Reverse lookup for Release
+        std::unordered_map<VkPipeline, std::string> _keys;
+        std::mutex _m_entries;
+        std::condition_variable _cvEntries;
+        uint64_t _hits;
+        uint64_t _misses;
+
+        std::deque<VulkanGraphicsPipeline*> _relinkQueue;
+        // Taken off the queue, relinking outside the lock
+        VulkanGraphicsPipeline* _relinking;
+        uint64_t _relinked;
+        std::mutex _m_relink;
+        std::condition_variable _cvRelink;
+
+        std::thread _worker;
+        bool _stopWorker;
+
+        void _WorkerMain();
+
+    public:
+        _VkPipelineLibraryCache();
+        ~_VkPipelineLibraryCache();
+
+        // Starts the relink worker
+        void Init(VulkanDevice* dev);
+
+        // Stops the worker. Every pipeline is gone by now.
+        void Shutdown();
+
+        // Keys of different parts must not collide, tag them per part.
+        // create runs outside the cache lock on a miss, acquiring the
+        // same key meanwhile waits for it instead of compiling again.
+        Library Acquire(std::string&& key, const CreateFn& create);
+        void Release(VkPipeline library);
+
+        // Queues the pipeline for an optimized relink of its parts
+        void RequestRelink(VulkanGraphicsPipeline* pipeline);
+
+        // Drops a queued relink and waits for one in progress
+        void CancelRelink(VulkanGraphicsPipeline* pipeline);
+
+        Stats GetStats();
+    };
+
+}
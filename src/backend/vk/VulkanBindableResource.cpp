@@ -1,7 +1,10 @@
 #include "VulkanBindableResource.hpp"
 
 #include "alloy/common/Common.hpp"
+#include "alloy/common/Trace.hpp"
 
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <stdexcept>
 
@@ -37,9 +40,8 @@ namespace alloy::vk
     VulkanResourceLayout::~VulkanResourceLayout(){
         // T2 set 0/1 reference device-owned shared DSLs; do not destroy those.
         if(!_desc.useGlobalHeaps) {
-            for(auto& s : _sets) {
-                VK_DEV_CALL(_dev,
-                    vkDestroyDescriptorSetLayout(_dev->LogicalDev(), s.layout, nullptr));
+            for(auto dsl : _setLayouts) {
+                _dev->GetObjectCache().ReleaseDSL(dsl);
             }
         }
     }
@@ -81,8 +83,8 @@ namespace alloy::vk
         std::vector<VulkanResourceLayout::SlotLocation> slotLocations(elements.size());
         // Also builds the 
         // desc.shaderResources -> ResSet::Desc.boundResources index mapping 
+        uint32_t linearBase = 0;
         {
-            uint32_t linearBase = 0;
             for(uint32_t i = 0; i < elements.size(); i++) {
                 const auto& e = elements[i];
                 auto vkType = VdToVkDescriptorType(e.kind, e.options);
@@ -120,66 +122,110 @@ namespace alloy::vk
             }
         }
 
-        // Create the layouts
-        for(uint32_t i = 0; i < sets.size(); i++) {
-            auto& s = sets[i];
-
+        const auto& devCaps = dev->GetDevCaps();
+        const bool usePushDescriptor = desc.inlineResources
+            && dev->GetVkFeatures().flags.supportsPushDescriptor
+            && linearBase > 0
+            && linearBase <= std::min(MaxPushDescriptors,
+                                      devCaps.pushDescriptorProperties.maxPushDescriptors);
+
+        std::vector<VkDescriptorSetLayout> setLayouts;
+        if(usePushDescriptor) {
+            // Only one set can be pushed, renumber the bindings of all
+            // kinds into set 0
             std::vector<VkDescriptorSetLayoutBinding> bindings;
-                    bindings.reserve(s.bindings.size());
+            for(auto& s : sets) {
+                for(auto& b : s.bindings) {
+                    const auto& bindingDesc = desc.shaderResources[
+                        b.indexInShaderResources
+                    ];
+
+                    b.bindSetAllocated = 0;
+                    b.bindSlotAllocated = bindings.size();
+                    auto& location = slotLocations[b.indexInShaderResources];
+                    location.setIndexAllocated = 0;
+                    location.bindingAllocated = b.bindSlotAllocated;
+
+                    auto& binding = bindings.emplace_back();
+                    binding.binding = b.bindSlotAllocated;
+                    binding.descriptorCount = bindingDesc.bindingCount;
+                    binding.descriptorType = s.type;
+                    binding.stageFlags = VdToVkShaderStages(bindingDesc.stages);
+                }
+                s.layout = VK_NULL_HANDLE;
+            }
+
+            VkDescriptorSetLayoutCreateInfo dslCI{};
+            dslCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            dslCI.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+            dslCI.bindingCount = bindings.size();
+            dslCI.pBindings = bindings.data();
+
+            setLayouts.push_back(dev->GetObjectCache().AcquireDSL(dslCI));
+        } else {
+            // Create the layouts
+            for(uint32_t i = 0; i < sets.size(); i++) {
+                auto& s = sets[i];
+
+                std::vector<VkDescriptorSetLayoutBinding> bindings;
+                        bindings.reserve(s.bindings.size());
             
-            std::vector<VkDescriptorBindingFlags> bindingFlags;
-                    bindingFlags.reserve(s.bindings.size());
+                std::vector<VkDescriptorBindingFlags> bindingFlags;
+                        bindingFlags.reserve(s.bindings.size());
 
-            for(const auto& b : s.bindings) {
+                for(const auto& b : s.bindings) {
 
-                const auto& bindingDesc = desc.shaderResources[
-                    b.indexInShaderResources
-                ];
+                    const auto& bindingDesc = desc.shaderResources[
+                        b.indexInShaderResources
+                    ];
 
-                assert(s.type ==
-                    VdToVkDescriptorType(bindingDesc.kind, bindingDesc.options));
+                    assert(s.type ==
+                        VdToVkDescriptorType(bindingDesc.kind, bindingDesc.options));
 
-                auto& binding = bindings.emplace_back();
+                    auto& binding = bindings.emplace_back();
             
-                binding.binding = b.bindSlotAllocated;
-                binding.descriptorCount = bindingDesc.bindingCount;
-                binding.descriptorType = s.type;
-                binding.stageFlags = VdToVkShaderStages(bindingDesc.stages);
+                    binding.binding = b.bindSlotAllocated;
+                    binding.descriptorCount = bindingDesc.bindingCount;
+                    binding.descriptorType = s.type;
+                    binding.stageFlags = VdToVkShaderStages(bindingDesc.stages);
 
 
-                VkDescriptorBindingFlags flags = 0;
-                if(useDescriptorIndexing) {
-                    flags |= VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
-                                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
-                                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+                    VkDescriptorBindingFlags flags = 0;
+                    if(useDescriptorIndexing) {
+                        flags |= VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                    VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+                                    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+                    }
+                    bindingFlags.push_back(flags);
                 }
-                bindingFlags.push_back(flags);
-            }
 
             
-            VkDescriptorSetLayoutCreateInfo dslCI{};
-            dslCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-            dslCI.bindingCount = bindings.size();
-            dslCI.pBindings = bindings.data();
-            if(useDescriptorIndexing) {
-                dslCI.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
-            }
+                VkDescriptorSetLayoutCreateInfo dslCI{};
+                dslCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+                dslCI.bindingCount = bindings.size();
+                dslCI.pBindings = bindings.data();
+                if(useDescriptorIndexing) {
+                    dslCI.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+                }
 
-            VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCI {};
-            if(useDescriptorIndexing) {
-                bindingFlagsCI.sType =
-                    VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
-                bindingFlagsCI.bindingCount = bindingFlags.size();
-                bindingFlagsCI.pBindingFlags = bindingFlags.data();
-                dslCI.pNext = &bindingFlagsCI;
-            }
+                VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCI {};
+                if(useDescriptorIndexing) {
+                    bindingFlagsCI.sType =
+                        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+                    bindingFlagsCI.bindingCount = bindingFlags.size();
+                    bindingFlagsCI.pBindingFlags = bindingFlags.data();
+                    dslCI.pNext = &bindingFlagsCI;
+                }
 
-            VK_CHECK(VK_DEV_CALL(dev, 
-                vkCreateDescriptorSetLayout(dev->LogicalDev(), &dslCI, nullptr, &s.layout)));
+                s.layout = dev->GetObjectCache().AcquireDSL(dslCI);
+                setLayouts.push_back(s.layout);
+            }
         }
 
         auto dsl = new VulkanResourceLayout(dev, desc);
         dsl->_sets = std::move(sets);
+        dsl->_setLayouts = std::move(setLayouts);
+        dsl->_isPushDescriptor = usePushDescriptor;
         dsl->_slotLocations = std::move(slotLocations);
         dsl->_pushConstants = std::move(pushConstants);
         dsl->_pushConstantSize = pushConstantSize;
@@ -236,6 +282,9 @@ namespace alloy::vk
         };
     
         auto dsl = new VulkanResourceLayout(dev, desc);
+        for(auto& s : t2SetInfos) {
+            dsl->_setLayouts.push_back(s.layout);
+        }
         dsl->_sets = std::move(t2SetInfos);
         // _slotLocations is unused on the T2 path. only full bindless is supported
         dsl->_pushConstants = std::move(pushConstants);
@@ -323,8 +372,16 @@ namespace alloy::vk
         , _isMutable(isMutable)
     { }
 
+    VulkanResourceSetBase::~VulkanResourceSetBase() {
+        // Sets might still be referenced by command buffers in flight
+        _dev->DeferDestroy(std::move(_descSet));
+    }
+
 
     void VulkanResourceSetBase::AllocateDescriptorSets() {
+        // Pushed when bound
+        if(_layout->IsPushDescriptor()) return;
+
         auto& sets = _layout->GetResSetInfo();
         for(auto& s : sets) {
             auto descriptorAllocationToken = _dev->AllocateDescriptorSet(
@@ -376,6 +433,8 @@ namespace alloy::vk
         assert(dev->GetAdapter().GetAdapterInfo().resourceBindingModel
                != ResourceBindingModel::FixedBindings &&
             "Vulkan mutable ResourceSet requires DescriptorIndexing support.");
+        assert(!PtrCast<VulkanResourceLayout>(desc.layout.get())->IsPushDescriptor() &&
+            "Vulkan mutable ResourceSet can't use an inlineResources layout.");
 
         auto descSet = new VulkanMutableResourceSet(dev, desc);
         descSet->AllocateDescriptorSets();
@@ -403,6 +462,8 @@ namespace alloy::vk
         const std::span<const IMutableResourceSet::WriteBinding>& writes
     ) {
         auto& slotDescs = _layout->GetDesc().shaderResources;
+        // Only keep the resources, they are pushed on bind
+        const bool pushed = _layout->IsPushDescriptor();
 
         assert(_boundResources.size() == GetRequiredBoundResourceCount(_layout->GetDesc()));
 
@@ -413,10 +474,13 @@ namespace alloy::vk
                 continue;
             }
 
-            auto location = FindSlotLocation(
-                _layout.get(),
-                _descSet,
-                write.layoutSlot);
+            VulkanSetSlotLocation location {};
+            if(!pushed) {
+                location = FindSlotLocation(
+                    _layout.get(),
+                    _descSet,
+                    write.layoutSlot);
+            }
 
             std::vector<VkDescriptorBufferInfo> bufferInfos;
             std::vector<VkDescriptorImageInfo> imageInfos;
@@ -489,6 +553,8 @@ namespace alloy::vk
                     linearBase + write.firstArrayElement + i] = write.resources[i];
             }
 
+            if(pushed) continue;
+
             VK_DEV_CALL(_dev,
                 vkUpdateDescriptorSets(
                     _dev->LogicalDev(),
@@ -496,7 +562,95 @@ namespace alloy::vk
                     &descriptorWrite,
                     0,
                     nullptr));
+            VLD_TRACE_COUNT(DescriptorWrites, 1);
+        }
+    }
+
+    void VulkanResourceLayout::PushDescriptors(
+        VkCommandBuffer cmdBuf,
+        VkPipelineBindPoint bindPoint,
+        VkPipelineLayout pipelineLayout,
+        std::span<const common::sp<IBindableResource>> resources
+    ) const {
+        assert(_isPushDescriptor);
+
+        auto& slotDescs = _desc.shaderResources;
+        assert(resources.size() == GetRequiredBoundResourceCount(_desc));
+
+        std::array<VkWriteDescriptorSet, MaxPushDescriptors> writes;
+        std::array<VkDescriptorBufferInfo, MaxPushDescriptors> bufferInfos;
+        std::array<VkDescriptorImageInfo, MaxPushDescriptors> imageInfos;
+
+        uint32_t writeCnt = 0;
+        for(uint32_t layoutSlot = 0; layoutSlot < slotDescs.size(); ++layoutSlot) {
+            auto& slotDesc = slotDescs[layoutSlot];
+            auto& location = _slotLocations[layoutSlot];
+            auto linearBase = location.linearResourceOffset;
+
+            auto& descriptorWrite = writes[writeCnt++];
+            descriptorWrite = { .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+            descriptorWrite.dstBinding = location.bindingAllocated;
+            descriptorWrite.descriptorCount = slotDesc.bindingCount;
+            descriptorWrite.descriptorType =
+                VdToVkDescriptorType(slotDesc.kind, slotDesc.options);
+
+            using _ResKind = IBindableResource::ResourceKind;
+            switch(slotDesc.kind) {
+                case _ResKind::UniformBuffer:
+                case _ResKind::StorageBuffer:
+                    descriptorWrite.pBufferInfo = &bufferInfos[linearBase];
+                    break;
+                case _ResKind::Texture:
+                case _ResKind::Sampler:
+                    descriptorWrite.pImageInfo = &imageInfos[linearBase];
+                    break;
+            }
+
+            for(uint32_t i = 0; i < slotDesc.bindingCount; ++i) {
+                auto* res = resources[linearBase + i].get();
+                assert(res != nullptr && "Pushed resources contain a null resource.");
+
+                switch(slotDesc.kind) {
+                    case _ResKind::UniformBuffer:
+                    case _ResKind::StorageBuffer: {
+                        const auto* range = PtrCast<BufferRange>(res);
+                        const auto* rangedVkBuffer =
+                            PtrCast<VulkanBuffer>(range->GetBufferObject().get());
+                        auto& info = bufferInfos[linearBase + i];
+                        info.buffer = rangedVkBuffer->GetHandle();
+                        info.offset = range->GetShape().GetOffsetInBytes();
+                        info.range = range->GetShape().GetSizeInBytes();
+                    } break;
+
+                    case _ResKind::Texture: {
+                        const auto* vkTexView = PtrCast<VulkanTextureView>(res);
+                        auto& info = imageInfos[linearBase + i];
+                        info.sampler = VK_NULL_HANDLE;
+                        info.imageView = vkTexView->GetHandle();
+                        info.imageLayout = slotDesc.options.writable
+                            ? VK_IMAGE_LAYOUT_GENERAL
+                            : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                    } break;
+
+                    case _ResKind::Sampler: {
+                        auto& info = imageInfos[linearBase + i];
+                        info.sampler = PtrCast<VulkanSampler>(res)->GetHandle();
+                        info.imageView = VK_NULL_HANDLE;
+                        info.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                    } break;
+                }
+            }
         }
+
+        VK_DEV_CALL(_dev,
+            vkCmdPushDescriptorSetKHR(
+                cmdBuf,
+                bindPoint,
+                pipelineLayout,
+                0,
+                writeCnt,
+                writes.data()));
+        VLD_TRACE_COUNT(DescriptorWrites, writeCnt);
     }
 
     IBindableResource* VulkanResourceSetBase::GetBoundResource(
@@ -69,10 +69,18 @@ namespace alloy::vk{
             T2Set_Count
         };
 
+        // Upper bound for push descriptor layouts, keeps the writes on
+        // the stack
+        static constexpr uint32_t MaxPushDescriptors = 32;
+
     private:
         common::sp<VulkanDevice> _dev;
 
         std::vector<ResourceSetInfo> _sets;
+        // Pipeline layout sets, one per ResourceSetInfo or the single
+        // push descriptor set
+        std::vector<VkDescriptorSetLayout> _setLayouts;
+        bool _isPushDescriptor;
         std::vector<SlotLocation> _slotLocations;
         //std::uint32_t _dynamicBufferCount;
 
@@ -87,6 +95,7 @@ namespace alloy::vk{
         ) 
             : IResourceLayout({})
             , _dev(dev)
+            , _isPushDescriptor(false)
             , _desc(desc)
         { }
 
@@ -120,6 +129,21 @@ namespace alloy::vk{
         const SlotLocation& GetSlotLocation(uint32_t layoutSlot) const {return _slotLocations.at(layoutSlot);}
         const std::vector<PushConstantInfo>& GetPushConstants() const {return _pushConstants;}
         std::uint32_t GetPushConstantSize() const {return _pushConstantSize;}
+
+        const std::vector<VkDescriptorSetLayout>& GetSetLayouts() const {return _setLayouts;}
+
+        // inlineResources layouts small enough for one push descriptor
+        // set. Every binding lives in set 0 and no sets are allocated.
+        bool IsPushDescriptor() const {return _isPushDescriptor;}
+
+        // Writes resources, ordered like IResourceSet::Description::boundResources,
+        // into set 0 of pipelineLayout
+        void PushDescriptors(
+            VkCommandBuffer cmdBuf,
+            VkPipelineBindPoint bindPoint,
+            VkPipelineLayout pipelineLayout,
+            std::span<const common::sp<IBindableResource>> resources
+        ) const;
     };
 
     class VulkanResourceSetBase {
@@ -147,8 +171,11 @@ namespace alloy::vk{
             bool isMutable
         );
 
+        ~VulkanResourceSetBase();
+
     public:
         const VulkanResourceLayout& GetLayout() const { return *_layout; }
+        const VulkanResourceLayout& GetVkLayout() const { return *_layout; }
         IBindableResource* GetBoundResource(
             uint32_t layoutSlot,
             uint32_t firstArrayElement
@@ -2,6 +2,7 @@
 
 #include "alloy/common/Common.hpp"
 #include "alloy/Helpers.hpp"
+#include "alloy/common/Trace.hpp"
 
 #include "VkCommon.hpp"
 #include "VkTypeCvt.hpp"
@@ -193,16 +194,23 @@ namespace alloy::vk{
         : _dev(dev)
         , _cmdBuf(cmdBuf)
         , _cmdPool(std::move(alloc))
+        , _moveEpoch(0)
     { }
 
     VulkanCommandList::~VulkanCommandList(){
         for(auto* p : _passes) {
             delete p;
         }
+        _dev->GetVkGpuProfiler().ReleaseRecording(std::move(_profile));
         _cmdPool->FreeBuffer(_cmdBuf);
     }
 
+    std::uint32_t VulkanCommandList::GetQueueFamily() const {
+        return _cmdPool->mgr->GetQueueFamily();
+    }
+
     void VulkanCommandList::Begin(){
+        VLD_TRACE_ZONE("VulkanCommandList::Begin");
 
         for(auto* p : _passes) {
             delete p;
@@ -210,19 +218,34 @@ namespace alloy::vk{
 
         _passes.clear();
         _currentPass = nullptr;
+        // Everything the last recording used, its submits are covered by
+        // the deferred destroy queue from here on.
+        _devRes.clear();
+        _moveEpoch = _dev->GetVkDefragmenter().GetMoveEpoch();
+
+        auto& profiler = _dev->GetVkGpuProfiler();
+        profiler.ReleaseRecording(std::move(_profile));
+        _profile = profiler.BeginRecording(_cmdPool->mgr->GetQueueFamily());
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VkCommandBufferUsageFlagBits::VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        // No ONE_TIME_SUBMIT, a recording may be submitted again once the
+        // previous submit completed
+        beginInfo.flags = 0;
         VK_DEV_CALL(_dev, vkBeginCommandBuffer(_cmdBuf, &beginInfo));
 
     }
     void VulkanCommandList::End(){
+        VLD_TRACE_ZONE("VulkanCommandList::End");
         //if(_currentPass != nullptr) {
         //    assert(false);
         //}
         _EndCurrentActivePass();
 
+        if(_profile) {
+            _dev->GetVkGpuProfiler().EndAllScopes(_cmdBuf, *_profile);
+        }
+
         VK_DEV_CALL(_dev, vkEndCommandBuffer(_cmdBuf));
     }
 
@@ -338,25 +361,41 @@ namespace alloy::vk{
         std::uint32_t index, const common::sp<BufferRange>& buffer
     ){
         resources.insert(buffer);
+        SetVertexBuffer(
+            index,
+            buffer->GetBufferObject().get(),
+            buffer->GetShape().GetOffsetInBytes());
+    }
+
+    void VkRenderCmdEnc::SetIndexBuffer(
+        const common::sp<BufferRange>& buffer, IndexFormat format
+    ){
+        resources.insert(buffer);
+        SetIndexBuffer(
+            buffer->GetBufferObject().get(),
+            format,
+            buffer->GetShape().GetOffsetInBytes());
+    }
+
+    void VkRenderCmdEnc::SetVertexBuffer(
+        std::uint32_t index, IBuffer* buffer, std::uint64_t offsetInBytes
+    ){
         //_resReg.InsertPipelineBarrierIfNecessary(_cmdBuf);
-        VulkanBuffer* vkBuffer = PtrCast<VulkanBuffer>(buffer->GetBufferObject().get());
-        std::uint64_t offset64 = buffer->GetShape().GetOffsetInBytes();
+        VulkanBuffer* vkBuffer = PtrCast<VulkanBuffer>(buffer);
 
         VK_DEV_CALL(dev,
-            vkCmdBindVertexBuffers(cmdList, index, 1, &(vkBuffer->GetHandle()), &offset64));
+            vkCmdBindVertexBuffers(cmdList, index, 1, &(vkBuffer->GetHandle()), &offsetInBytes));
     }
 
     void VkRenderCmdEnc::SetIndexBuffer(
-        const common::sp<BufferRange>& buffer, IndexFormat format
+        IBuffer* buffer, IndexFormat format, std::uint64_t offsetInBytes
     ){
-        resources.insert(buffer);
         //_resReg.InsertPipelineBarrierIfNecessary(_cmdBuf);
-        VulkanBuffer* vkBuffer = PtrCast<VulkanBuffer>(buffer->GetBufferObject().get());
-        auto offset = buffer->GetShape().GetOffsetInBytes();
+        VulkanBuffer* vkBuffer = PtrCast<VulkanBuffer>(buffer);
         VK_DEV_CALL(dev,
             vkCmdBindIndexBuffer(cmdList,
                                  vkBuffer->GetHandle(),
-                                 offset,
+                                 offsetInBytes,
                                  alloy::vk::VdToVkIndexFormat(format)));
     }
 
@@ -364,6 +403,11 @@ namespace alloy::vk{
     void VkRenderCmdEnc::SetGraphicsResourceSet(
         const common::sp<IResourceSet>& rs
     ){
+        resources.insert(rs);
+        SetGraphicsResourceSet(rs.get());
+    }
+
+    void VkRenderCmdEnc::SetGraphicsResourceSet(IResourceSet* rs){
         assert(currentPipeline != nullptr);
 
         VkPipelineLayout pipelineLayout = currentPipeline->GetLayout();
@@ -379,8 +423,13 @@ namespace alloy::vk{
         //    assert(false);
         //}
 
-        resources.insert(rs);
-        auto vkrs = PtrCast<VulkanResourceSet>(rs.get());
+        auto vkrs = PtrCast<VulkanResourceSet>(rs);
+
+        if(auto& vkLayout = vkrs->GetVkLayout(); vkLayout.IsPushDescriptor()) {
+            vkLayout.PushDescriptors(cmdList, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                     pipelineLayout, vkrs->GetBoundResources());
+            return;
+        }
 
         auto& dss = vkrs->GetHandle();
 
@@ -445,6 +494,26 @@ namespace alloy::vk{
         }
     }
 
+    void VkRenderCmdEnc::SetGraphicsResources(
+        IResourceLayout* layout,
+        std::span<const common::sp<IBindableResource>> resources
+    ){
+        assert(currentPipeline != nullptr);
+
+        auto vkLayout = PtrCast<VulkanResourceLayout>(layout);
+        if(!vkLayout->IsPushDescriptor()) {
+            // No push descriptors for this layout, bind a one-off set
+            IResourceSet::Description desc{};
+            desc.layout = common::ref_sp(layout);
+            desc.boundResources.assign(resources.begin(), resources.end());
+            SetGraphicsResourceSet(VulkanResourceSet::Make(common::ref_sp(dev), desc));
+            return;
+        }
+
+        vkLayout->PushDescriptors(cmdList, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                  currentPipeline->GetLayout(), resources);
+    }
+
     void VkRenderCmdEnc::SetDescriptorHeaps(
         const common::sp<IResourceDescriptorHeap>& resourceHeap,
         const common::sp<ISamplerDescriptorHeap>& samplerHeap
@@ -519,13 +588,23 @@ namespace alloy::vk{
     void VkComputeCmdEnc::SetComputeResourceSet(
         const common::sp<IResourceSet>& rs
     ){
+        resources.insert(rs);
+        SetComputeResourceSet(rs.get());
+    }
+
+    void VkComputeCmdEnc::SetComputeResourceSet(IResourceSet* rs){
         assert(currentPipeline != nullptr);
         //assert(std::holds_alternative<VulkanComputePipeline*>(currentPipeline));
 
         //VulkanPipelineBase* pipeline = std::get<VulkanComputePipeline*>(currentPipeline);
 
-        resources.insert(rs);
-        auto vkrs = PtrCast<VulkanResourceSet>(rs.get());
+        auto vkrs = PtrCast<VulkanResourceSet>(rs);
+
+        if(auto& vkLayout = vkrs->GetVkLayout(); vkLayout.IsPushDescriptor()) {
+            vkLayout.PushDescriptors(cmdList, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                     currentPipeline->GetLayout(), vkrs->GetBoundResources());
+            return;
+        }
 
         auto& dss = vkrs->GetHandle();
 
@@ -592,6 +671,26 @@ namespace alloy::vk{
     }
 
 
+    void VkComputeCmdEnc::SetComputeResources(
+        IResourceLayout* layout,
+        std::span<const common::sp<IBindableResource>> resources
+    ){
+        assert(currentPipeline != nullptr);
+
+        auto vkLayout = PtrCast<VulkanResourceLayout>(layout);
+        if(!vkLayout->IsPushDescriptor()) {
+            // No push descriptors for this layout, bind a one-off set
+            IResourceSet::Description desc{};
+            desc.layout = common::ref_sp(layout);
+            desc.boundResources.assign(resources.begin(), resources.end());
+            SetComputeResourceSet(VulkanResourceSet::Make(common::ref_sp(dev), desc));
+            return;
+        }
+
+        vkLayout->PushDescriptors(cmdList, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                  currentPipeline->GetLayout(), resources);
+    }
+
     void VkComputeCmdEnc::SetDescriptorHeaps(
         const common::sp<IResourceDescriptorHeap>& resourceHeap,
         const common::sp<ISamplerDescriptorHeap>& samplerHeap
@@ -891,10 +990,58 @@ namespace alloy::vk{
         SetScissorRects(sr);
     }
 
+    void VkRenderCmdEnc::SetCullMode(RasterizerStateDescription::FaceCullMode cullMode) {
+        // Ignored without the extension, as documented. The entry points
+        // aren't loaded then.
+        if(!dev->GetVkFeatures().flags.supportsExtendedDynamicState) return;
+        VK_DEV_CALL(dev, vkCmdSetCullModeEXT(cmdList, VdToVkCullMode(cullMode)));
+    }
+
+    void VkRenderCmdEnc::SetDepthTest(
+        bool testEnabled, bool writeEnabled, ComparisonKind comparison
+    ) {
+        if(!dev->GetVkFeatures().flags.supportsExtendedDynamicState) return;
+        VK_DEV_CALL(dev, vkCmdSetDepthTestEnableEXT(cmdList, testEnabled));
+        VK_DEV_CALL(dev, vkCmdSetDepthWriteEnableEXT(cmdList, writeEnabled));
+        VK_DEV_CALL(dev, vkCmdSetDepthCompareOpEXT(cmdList, VdToVkCompareOp(comparison)));
+    }
+
+    void VkRenderCmdEnc::SetPrimitiveTopology(PrimitiveTopology topology) {
+        if(!dev->GetVkFeatures().flags.supportsExtendedDynamicState) return;
+        VK_DEV_CALL(dev, vkCmdSetPrimitiveTopologyEXT(cmdList, VdToVkPrimitiveTopology(topology)));
+    }
+
+    void VkRenderCmdEnc::SetStencilOp(
+        bool testEnabled,
+        const DepthStencilStateDescription::StencilBehavior& front,
+        const DepthStencilStateDescription::StencilBehavior& back
+    ) {
+        if(!dev->GetVkFeatures().flags.supportsExtendedDynamicState) return;
+        VK_DEV_CALL(dev, vkCmdSetStencilTestEnableEXT(cmdList, testEnabled));
+
+        auto _SetOp = [&](VkStencilFaceFlags face,
+                          const DepthStencilStateDescription::StencilBehavior& op) {
+            VK_DEV_CALL(dev, vkCmdSetStencilOpEXT(cmdList, face,
+                VdToVkStencilOp(op.fail),
+                VdToVkStencilOp(op.pass),
+                VdToVkStencilOp(op.depthFail),
+                VdToVkCompareOp(op.comparison)));
+        };
+        _SetOp(VK_STENCIL_FACE_FRONT_BIT, front);
+        _SetOp(VK_STENCIL_FACE_BACK_BIT, back);
+    }
+
+    void VkRenderCmdEnc::SetBlendEnabled(std::uint32_t attachment, bool enabled) {
+        if(!dev->GetVkFeatures().flags.supportsDynamicBlendEnable) return;
+        VkBool32 vkEnabled = enabled;
+        VK_DEV_CALL(dev, vkCmdSetColorBlendEnableEXT(cmdList, attachment, 1, &vkEnabled));
+    }
+
     void VkRenderCmdEnc::Draw(
         std::uint32_t vertexCount, std::uint32_t instanceCount,
         std::uint32_t vertexStart, std::uint32_t instanceStart
     ){
+        VLD_TRACE_ZONE("VkRenderCmdEnc::Draw");
         //PreDrawCommand();
         VK_DEV_CALL(dev,
             vkCmdDraw(cmdList, vertexCount, instanceCount, vertexStart, instanceStart));
@@ -905,6 +1052,7 @@ namespace alloy::vk{
         std::uint32_t indexStart, std::uint32_t vertexOffset,
         std::uint32_t instanceStart
     ){
+        VLD_TRACE_ZONE("VkRenderCmdEnc::DrawIndexed");
         //PreDrawCommand();
         VK_DEV_CALL(dev,
             vkCmdDrawIndexed(
@@ -949,7 +1097,7 @@ namespace alloy::vk{
     void VkComputeCmdEnc::Dispatch(
         std::uint32_t groupCountX, std::uint32_t groupCountY, std::uint32_t groupCountZ
     ){
-
+        VLD_TRACE_ZONE("VkComputeCmdEnc::Dispatch");
         VK_DEV_CALL(dev, vkCmdDispatch(cmdList, groupCountX, groupCountY, groupCountZ));
     };
 
@@ -1295,112 +1443,237 @@ namespace alloy::vk{
         //}
     }
 
-    void VkTransferCmdEnc::GenerateMipmaps(const common::sp<ITexture>& texture){
-#if 0
-        auto vkTex = PtrCast<VulkanTexture>(texture.get());
-        resources.insert(texture);
-
-
-        //_resReg.InsertPipelineBarrierIfNecessary(_cmdBuf);
-
-        auto layerCount = vkTex->GetDesc().arrayLayers;
-        if (vkTex->GetDesc().usage.cubemap) {
-            layerCount *= 6;
-        }
-
-        VkImageBlit region;
-
-        auto width = vkTex->GetDesc().width;
-        auto height = vkTex->GetDesc().height;
-        auto depth = vkTex->GetDesc().depth;
-
-        VkFormatProperties vkFormatProps;
-        vkGetPhysicalDeviceFormatProperties(
-            vkDev->PhysicalDev(), alloy::VK::priv::VdToVkPixelFormat(vkTex->GetDesc().format), &vkFormatProps);
-
+    void VkTransferCmdEnc::_BlitMipChain(
+        VkImage image,
+        std::uint32_t baseLevel,
+        std::uint32_t levelCount,
+        std::uint32_t baseLayer,
+        std::uint32_t layerCount,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t depth,
         VkFilter filter
-            = (vkFormatProps.optimalTilingFeatures
-                & VkFormatFeatureFlagBits::VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0
-                ? VkFilter::VK_FILTER_LINEAR
-                : VkFilter::VK_FILTER_NEAREST;
-
+    ) {
+        // Moves the level just written into CopySource so the next blit
+        // can read it. Every blit reads the level the previous one wrote,
+        // so the chain needs one per level. Covers all layers at once.
+        VkImageMemoryBarrier memBarrier{};
+        memBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        memBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        memBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        memBarrier.image = image;
+        memBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        memBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        memBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        memBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        memBarrier.subresourceRange.levelCount = 1;
+        memBarrier.subresourceRange.baseArrayLayer = baseLayer;
+        memBarrier.subresourceRange.layerCount = layerCount;
+
+        auto transitionLevel = [&](std::uint32_t level) {
+            memBarrier.subresourceRange.baseMipLevel = level;
+            VK_DEV_CALL(dev, vkCmdPipelineBarrier(
+                cmdList,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &memBarrier));
+        };
 
-        for (unsigned level = 1; level < vkTex->GetDesc().mipLevels; level++) {
-            //vkTex.TransitionImageLayoutNonmatching(_cb, level - 1, 1, 0, layerCount, VkImageLayout.TransferSrcOptimal);
-            //vkTex.TransitionImageLayoutNonmatching(_cb, level, 1, 0, layerCount, VkImageLayout.TransferDstOptimal);
+        auto lastLevel = baseLevel + levelCount - 1;
+        for (auto level = baseLevel + 1; level <= lastLevel; level++) {
+            transitionLevel(level - 1);
 
-            VkImage deviceImage = vkTex->GetHandle();
             auto mipWidth = std::max(width >> 1, 1U);
             auto mipHeight = std::max(height >> 1, 1U);
             auto mipDepth = std::max(depth >> 1, 1U);
 
-
+            VkImageBlit region{};
             region.srcSubresource.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
-            region.srcSubresource.baseArrayLayer = 0;
+            region.srcSubresource.baseArrayLayer = baseLayer;
             region.srcSubresource.layerCount = layerCount;
             region.srcSubresource.mipLevel = level - 1;
-            region.srcOffsets[0] = {};
             region.srcOffsets[1] = { (int)width, (int)height, (int)depth };
-            region.dstOffsets[0] = {};
-            region.dstOffsets[1] = { (int)mipWidth, (int)mipHeight, (int)mipDepth };
 
-            region.dstSubresource.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
-            region.dstSubresource.baseArrayLayer = 0;
-            region.dstSubresource.layerCount = layerCount;
+            region.dstSubresource = region.srcSubresource;
             region.dstSubresource.mipLevel = level;
+            region.dstOffsets[1] = { (int)mipWidth, (int)mipHeight, (int)mipDepth };
 
-            //if (!_filters.TryGetValue(format, out VkFilter filter))
-            if (level > 1) {
-                //Beyond first transition, barrier needed
-                VkImageMemoryBarrier memBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
-                memBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                memBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                memBarrier.image = deviceImage;
-                memBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-                memBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-                memBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                memBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-                vkCmdPipelineBarrier(_cmdBuf,
-                    VK_PIPELINE_STAGE_TRANSFER_BIT,
-                    VK_PIPELINE_STAGE_TRANSFER_BIT,
-                    0,
-                    0, nullptr,
-                    0, nullptr,
-                    1, &memBarrier
-                );
-            }
-            vkCmdBlitImage(
-                _cmdBuf,
-                deviceImage, VkImageLayout::VK_IMAGE_LAYOUT_GENERAL,
-                deviceImage, VkImageLayout::VK_IMAGE_LAYOUT_GENERAL,
+            VK_DEV_CALL(dev, vkCmdBlitImage(
+                cmdList,
+                image, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                image, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                 1, &region,
-                filter);
+                filter));
 
             width = mipWidth;
             height = mipHeight;
             depth = mipDepth;
         }
 
-        //if ((vkTex.Usage & TextureUsage.Sampled) != 0)
-        //{
-        //    vkTex.TransitionImageLayoutNonmatching(_cb, 0, vkTex.MipLevels, 0, layerCount, VkImageLayout.ShaderReadOnlyOptimal);
-        //}
-        _resReg.ModifyTexUsage(
-            texture,
-            VK_IMAGE_LAYOUT_GENERAL,
+        // Leave every level in CopySource
+        transitionLevel(lastLevel);
+    }
+
+    bool VkTransferCmdEnc::GenerateMipmaps(const common::sp<ITextureView>& texture){
+        VLD_TRACE_ZONE("VkTransferCmdEnc::GenerateMipmaps");
+
+        auto vkView = PtrCast<VulkanTextureView>(texture.get());
+        auto vkTex = PtrCast<VulkanTexture>(texture->GetTextureObject().get());
+        const auto& viewDesc = vkView->GetDesc();
+        const auto& texDesc = vkTex->GetDesc();
+
+        assert(!texDesc.usage.depthStencil);
+        if(viewDesc.mipLevels < 2) return true;
+
+        PixelFormat blitFormat;
+        VkFilter filter;
+        if(!dev->GetMipmapBlitFormat(texDesc.format, blitFormat, filter)) return false;
+
+        auto layerCount = viewDesc.arrayLayers;
+        if (texDesc.usage.cubemap) {
+            layerCount *= 6;
+        }
+
+        std::uint32_t width, height, depth;
+        GetMipDimensions(texDesc, viewDesc.baseMipLevel, width, height, depth);
+
+        if(blitFormat == texDesc.format) {
+            resources.insert(texture);
+            _BlitMipChain(vkTex->GetHandle(),
+                viewDesc.baseMipLevel, viewDesc.mipLevels,
+                viewDesc.baseArrayLayer, layerCount,
+                width, height, depth, filter);
+            return true;
+        }
+
+        // The blit engine rejects the format. Copy the base level into a
+        // same sized integer image, point sample the chain there and copy
+        // the lower levels back.
+        ITexture::Description scratchDesc = texDesc;
+        scratchDesc.width = width;
+        scratchDesc.height = height;
+        scratchDesc.depth = depth;
+        scratchDesc.mipLevels = viewDesc.mipLevels;
+        scratchDesc.arrayLayers = viewDesc.arrayLayers;
+        scratchDesc.format = blitFormat;
+        scratchDesc.usage = {};
+        scratchDesc.usage.cubemap = texDesc.usage.cubemap;
+        scratchDesc.hostAccess = HostAccess::None;
+        auto scratch = dev->CreateTexture(scratchDesc);
+        if(!scratch) return false;
+
+        resources.insert(texture);
+        // Freed with the other resources once the list is re-recorded
+        resources.insert(scratch);
+        auto srcImage = vkTex->GetHandle();
+        auto scratchImage = PtrCast<VulkanTexture>(scratch.get())->GetHandle();
+
+        VkImageMemoryBarrier barriers[2] {};
+        for(auto& b : barriers) {
+            b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            b.subresourceRange.layerCount = layerCount;
+        }
+        // Base level becomes the copy source
+        barriers[0].image = srcImage;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barriers[0].subresourceRange.baseMipLevel = viewDesc.baseMipLevel;
+        barriers[0].subresourceRange.levelCount = 1;
+        barriers[0].subresourceRange.baseArrayLayer = viewDesc.baseArrayLayer;
+        // Every scratch level gets written
+        barriers[1].image = scratchImage;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[1].srcAccessMask = 0;
+        barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barriers[1].subresourceRange.levelCount = viewDesc.mipLevels;
+        VK_DEV_CALL(dev, vkCmdPipelineBarrier(
+            cmdList,
             VK_PIPELINE_STAGE_TRANSFER_BIT,
-            VK_ACCESS_TRANSFER_WRITE_BIT
-        );
-#endif
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            2, barriers));
+
+        VkImageCopy baseCopy{};
+        baseCopy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        baseCopy.srcSubresource.mipLevel = viewDesc.baseMipLevel;
+        baseCopy.srcSubresource.baseArrayLayer = viewDesc.baseArrayLayer;
+        baseCopy.srcSubresource.layerCount = layerCount;
+        baseCopy.dstSubresource = baseCopy.srcSubresource;
+        baseCopy.dstSubresource.mipLevel = 0;
+        baseCopy.dstSubresource.baseArrayLayer = 0;
+        baseCopy.extent = { width, height, depth };
+        VK_DEV_CALL(dev, vkCmdCopyImage(
+            cmdList,
+            srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            scratchImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &baseCopy));
+
+        _BlitMipChain(scratchImage, 0, viewDesc.mipLevels, 0, layerCount,
+            width, height, depth, VK_FILTER_NEAREST);
+
+        // Lower levels back in a single copy, they're still in CopyDest
+        std::vector<VkImageCopy> copies(viewDesc.mipLevels - 1);
+        for(std::uint32_t i = 0; i < copies.size(); i++) {
+            auto level = i + 1;
+            auto& copy = copies[i];
+            copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copy.srcSubresource.mipLevel = level;
+            copy.srcSubresource.baseArrayLayer = 0;
+            copy.srcSubresource.layerCount = layerCount;
+            copy.dstSubresource = copy.srcSubresource;
+            copy.dstSubresource.mipLevel = viewDesc.baseMipLevel + level;
+            copy.dstSubresource.baseArrayLayer = viewDesc.baseArrayLayer;
+            copy.extent = {
+                std::max(width >> level, 1U),
+                std::max(height >> level, 1U),
+                std::max(depth >> level, 1U)
+            };
+        }
+        VK_DEV_CALL(dev, vkCmdCopyImage(
+            cmdList,
+            scratchImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            srcImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            (std::uint32_t)copies.size(), copies.data()));
+
+        // Leave every level in CopySource, the base one already is
+        barriers[0].subresourceRange.baseMipLevel = viewDesc.baseMipLevel + 1;
+        barriers[0].subresourceRange.levelCount = viewDesc.mipLevels - 1;
+        VK_DEV_CALL(dev, vkCmdPipelineBarrier(
+            cmdList,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barriers[0]));
+        return true;
     }
 
     void VulkanCommandList::PushDebugGroup(const std::string& name, const Color4f& color) {
         _BeginDummyPassIfNoActivePass();
         _currentPass->PushDebugGroup(name, color);
+        if(_profile) {
+            _dev->GetVkGpuProfiler().BeginScope(_cmdBuf, *_profile, name, false);
+        }
     };
 
     void VulkanCommandList::PopDebugGroup() {
         _BeginDummyPassIfNoActivePass();
+        if(_profile) {
+            _dev->GetVkGpuProfiler().EndGroupScope(_cmdBuf, *_profile);
+        }
         _currentPass->PopDebugGroup();
     };
 
@@ -1411,6 +1684,8 @@ namespace alloy::vk{
 
 
     void VulkanCommandList::Barrier(std::span<const alloy::BarrierOp> barriers) {
+        VLD_TRACE_ZONE("VulkanCommandList::Barrier");
+        VLD_TRACE_COUNT(Barriers, barriers.size());
         BindBarrier(this, barriers);
     }
 
@@ -1602,6 +1877,11 @@ namespace alloy::vk{
 
         //auto vkfb = common::SPCast<VulkanFrameBufferBase>(fb);
 
+        // Outside of the pass, so its begin/end commands are timed too
+        if(_profile) {
+            _dev->GetVkGpuProfiler().BeginScope(_cmdBuf, *_profile, "Render pass", true);
+        }
+
         auto* pNewEnc = new VkRenderCmdEnc(_dev.get(), _cmdBuf, actions);
         //Record render pass
         _passes.push_back(pNewEnc);
@@ -1620,6 +1900,11 @@ namespace alloy::vk{
         //CHK_RENDERPASS_ENDED();
         _EndCurrentActivePass();
 
+        // Outside of the pass, so its begin/end commands are timed too
+        if(_profile) {
+            _dev->GetVkGpuProfiler().BeginScope(_cmdBuf, *_profile, "Compute pass", true);
+        }
+
         auto* pNewEnc = new VkComputeCmdEnc(_dev.get(), _cmdBuf);
         //Record render pass
         _passes.push_back(pNewEnc);
@@ -1633,6 +1918,11 @@ namespace alloy::vk{
         //CHK_RENDERPASS_ENDED();
         _EndCurrentActivePass();
 
+        // Outside of the pass, so its begin/end commands are timed too
+        if(_profile) {
+            _dev->GetVkGpuProfiler().BeginScope(_cmdBuf, *_profile, "Transfer pass", true);
+        }
+
         auto* pNewEnc = new VkTransferCmdEnc(_dev.get(), _cmdBuf);
         //Record render pass
         _passes.push_back(pNewEnc);
@@ -1648,6 +1938,10 @@ namespace alloy::vk{
 
         _currentPass->EndPass();
         _currentPass = nullptr;
+
+        if(_profile) {
+            _dev->GetVkGpuProfiler().EndPassScope(_cmdBuf, *_profile);
+        }
     }
 
     
@@ -9,9 +9,11 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <variant>
+#include <memory>
 
 #include "VulkanPipeline.hpp"
 #include "VulkanBindableResource.hpp"
+#include "VkGpuProfiler.hpp"
 
 //TODO: a system to track image layouts inside a command buffer and
 //insert image layout transition commands when necessary. also each
@@ -78,11 +80,19 @@ namespace alloy::vk
         std::vector<VkCmdEncBase*> _passes;
         VkCmdEncBase *_currentPass;
 
-        //Resources used
+        // Resources used, kept until the list is re-recorded or destroyed
+        // so it can be submitted again. Releasing them enqueues their
+        // native objects behind every submit made so far.
         std::unordered_set<common::sp<RefCntBase>> _devRes;
 
         std::string _debugName;
 
+        // Defragmenter move epoch at Begin()
+        std::uint64_t _moveEpoch;
+
+        // Timestamps of this recording, null unless the profiler is enabled
+        std::unique_ptr<_GpuProfileRecording> _profile;
+
         void _EndCurrentActivePass();
         void _BeginDummyPassIfNoActivePass();
 
@@ -98,6 +108,15 @@ namespace alloy::vk
         //static sp<CommandList> Make(const sp<VulkanDevice>& dev);
         const VkCommandBuffer& GetHandle() const { return _cmdBuf; }
         VulkanDevice* GetDevice() const { return _dev.get(); }
+        // Family of the queue this list was allocated for
+        std::uint32_t GetQueueFamily() const;
+
+        std::uint64_t GetMoveEpoch() const { return _moveEpoch; }
+
+        // Called by queue on submission, handing timestamps to the profiler
+        std::unique_ptr<_GpuProfileRecording> TakeProfileRecording() {
+            return std::move(_profile);
+        }
 
         virtual void Begin() override;
         virtual void End() override;
@@ -172,10 +191,20 @@ namespace alloy::vk
         virtual void SetIndexBuffer(
             const common::sp<BufferRange>& buffer, IndexFormat format) override;
 
+        virtual void SetVertexBuffer(
+            std::uint32_t index, IBuffer* buffer, std::uint64_t offsetInBytes) override;
+
+        virtual void SetIndexBuffer(
+            IBuffer* buffer, IndexFormat format, std::uint64_t offsetInBytes) override;
+
 
         virtual void SetGraphicsResourceSet(const common::sp<IResourceSet>& rs) override;
+        virtual void SetGraphicsResourceSet(IResourceSet* rs) override;
         virtual void SetGraphicsMutableResourceSet(
             const common::sp<IMutableResourceSet>& rs) override;
+        virtual void SetGraphicsResources(
+            IResourceLayout* layout,
+            std::span<const common::sp<IBindableResource>> resources) override;
 
         virtual void SetDescriptorHeaps(
             const common::sp<IResourceDescriptorHeap>& resourceHeap,
@@ -192,6 +221,15 @@ namespace alloy::vk
         virtual void SetScissorRects(std::span<const Rect> ) override;
         virtual void SetFullScissorRect() override;
 
+        virtual void SetCullMode(RasterizerStateDescription::FaceCullMode) override;
+        virtual void SetDepthTest(
+            bool testEnabled, bool writeEnabled, ComparisonKind comparison) override;
+        virtual void SetPrimitiveTopology(PrimitiveTopology) override;
+        virtual void SetStencilOp(
+            bool testEnabled,
+            const DepthStencilStateDescription::StencilBehavior& front,
+            const DepthStencilStateDescription::StencilBehavior& back) override;
+        virtual void SetBlendEnabled(std::uint32_t attachment, bool enabled) override;
 
         virtual void Draw(
             std::uint32_t vertexCount, std::uint32_t instanceCount,
@@ -230,8 +268,12 @@ namespace alloy::vk
         virtual void SetComputeResourceSet(
             const common::sp<IResourceSet>& rs
             /*const std::vector<std::uint32_t>& dynamicOffsets*/) override;
+        virtual void SetComputeResourceSet(IResourceSet* rs) override;
         virtual void SetComputeMutableResourceSet(
             const common::sp<IMutableResourceSet>& rs) override;
+        virtual void SetComputeResources(
+            IResourceLayout* layout,
+            std::span<const common::sp<IBindableResource>> resources) override;
 
         virtual void SetDescriptorHeaps(
             const common::sp<IResourceDescriptorHeap>& resourceHeap,
@@ -314,7 +356,21 @@ namespace alloy::vk
             std::uint32_t dstBaseArrayLayer,
             const Size3D& copySize) override;
 
-        virtual void GenerateMipmaps(const common::sp<ITexture>& texture) override;
+        virtual bool GenerateMipmaps(const common::sp<ITextureView>& texture) override;
+
+    private:
+        // Blits each level from the one above, levels must be in CopyDest
+        // and are left in CopySource
+        void _BlitMipChain(
+            VkImage image,
+            std::uint32_t baseLevel,
+            std::uint32_t levelCount,
+            std::uint32_t baseLayer,
+            std::uint32_t layerCount,
+            std::uint32_t width,
+            std::uint32_t height,
+            std::uint32_t depth,
+            VkFilter filter);
     };
 
     template<typename T>
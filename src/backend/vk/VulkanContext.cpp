@@ -56,6 +56,11 @@ namespace alloy::vk
 
         fnTable.vkGetPhysicalDeviceFeatures(adp, &features);
 
+        graphicsPipelineLibraryFeatures = {};
+        extendedDynamicStateFeatures = {};
+        extendedDynamicState3Features = {};
+        pushDescriptorProperties = {};
+
         if(devProps.apiVersion >= VK_VERSION_1_1) {
 
             VkPhysicalDeviceProperties2 devProps2 {
@@ -114,6 +119,36 @@ namespace alloy::vk
                 features2.pNext = &meshShaderFeatures;
             }
 
+            if(IsExtSupported(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+               IsExtSupported(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)
+            ) {
+                graphicsPipelineLibraryFeatures.sType =
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+                graphicsPipelineLibraryFeatures.pNext = features2.pNext;
+                features2.pNext = &graphicsPipelineLibraryFeatures;
+            }
+
+            if(IsExtSupported(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+                extendedDynamicStateFeatures.sType =
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+                extendedDynamicStateFeatures.pNext = features2.pNext;
+                features2.pNext = &extendedDynamicStateFeatures;
+            }
+
+            if(IsExtSupported(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+                extendedDynamicState3Features.sType =
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+                extendedDynamicState3Features.pNext = features2.pNext;
+                features2.pNext = &extendedDynamicState3Features;
+            }
+
+            if(IsExtSupported(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)) {
+                pushDescriptorProperties.sType =
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+                pushDescriptorProperties.pNext = devProps2.pNext;
+                devProps2.pNext = &pushDescriptorProperties;
+            }
+
             if(hasDescriptorBufferExt) {
                 descriptorBufferFeatures.sType =
                     VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
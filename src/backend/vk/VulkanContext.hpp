@@ -38,6 +38,10 @@ namespace alloy::vk
         VkPhysicalDeviceMaintenance3Properties maintenance3Props;
 
         VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures;
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures;
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures;
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features;
+        VkPhysicalDevicePushDescriptorPropertiesKHR pushDescriptorProperties;
         //bool hasDescriptorBufferExt;
         bool hasMutableDescriptorTypeExt;
         VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures;
@@ -55,6 +59,21 @@ namespace alloy::vk
         bool SupportMeshShader() const { return meshShaderFeatures.meshShader != 0
                                              && meshShaderFeatures.taskShader != 0; }
         bool SupportBindless() const {return resourceBindingModel != ResourceBindingModel::T0; }
+        bool SupportGraphicsPipelineLibrary() const {
+            return graphicsPipelineLibraryFeatures.graphicsPipelineLibrary != 0;
+        }
+        bool SupportExtendedDynamicState() const {
+            return extendedDynamicStateFeatures.extendedDynamicState != 0;
+        }
+        bool SupportDynamicBlendEnable() const {
+            return extendedDynamicState3Features.extendedDynamicState3ColorBlendEnable != 0;
+        }
+        bool SupportPushDescriptor() const {
+            return pushDescriptorProperties.maxPushDescriptors != 0;
+        }
+        bool SupportBufferDeviceAddress() const {
+            return features12.bufferDeviceAddress != 0;
+        }
         
         
         bool HasMutableDescriptorTypeExtension() const { return hasMutableDescriptorTypeExt; }
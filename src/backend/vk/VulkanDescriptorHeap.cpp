@@ -1,6 +1,7 @@
 #include "VulkanDescriptorHeap.hpp"
 
 #include "alloy/common/Common.hpp"
+#include "alloy/common/Trace.hpp"
 
 #include "VkCommon.hpp"
 #include "VulkanDevice.hpp"
@@ -57,7 +58,11 @@ namespace alloy::vk
         , _entries(desc.capacity)
     { }
 
-    VulkanResourceDescriptorHeap::~VulkanResourceDescriptorHeap() = default;
+    VulkanResourceDescriptorHeap::~VulkanResourceDescriptorHeap() {
+        std::vector<_DescriptorSet> sets;
+        sets.push_back(std::move(_heapSet));
+        _dev->DeferDestroy(std::move(sets));
+    }
 
     common::sp<IResourceDescriptorHeap> VulkanResourceDescriptorHeap::Make(
         const common::sp<VulkanDevice>& dev,
@@ -113,6 +118,7 @@ namespace alloy::vk
 
         VK_DEV_CALL(_dev,
             vkUpdateDescriptorSets(_dev->LogicalDev(), 1, &vkWrite, 0, nullptr));
+        VLD_TRACE_COUNT(DescriptorWrites, 1);
 
         _entries[absoluteIndex] = lifetimeRef;
     }
@@ -163,7 +169,11 @@ namespace alloy::vk
         , _entries(desc.capacity)
     { }
 
-    VulkanSamplerDescriptorHeap::~VulkanSamplerDescriptorHeap() = default;
+    VulkanSamplerDescriptorHeap::~VulkanSamplerDescriptorHeap() {
+        std::vector<_DescriptorSet> sets;
+        sets.push_back(std::move(_heapSet));
+        _dev->DeferDestroy(std::move(sets));
+    }
 
     common::sp<ISamplerDescriptorHeap> VulkanSamplerDescriptorHeap::Make(
         const common::sp<VulkanDevice>& dev,
@@ -203,6 +213,7 @@ namespace alloy::vk
 
         VK_DEV_CALL(_dev,
             vkUpdateDescriptorSets(_dev->LogicalDev(), 1, &vkWrite, 0, nullptr));
+        VLD_TRACE_COUNT(DescriptorWrites, 1);
 
         _entries[absoluteIndex] = sampler;
     }
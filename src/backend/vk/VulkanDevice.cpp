@@ -4,8 +4,11 @@
 
 #include "alloy/common/Common.hpp"
 #include "alloy/common/RefCnt.hpp"
+#include "alloy/common/Trace.hpp"
 #include "alloy/backend/Backends.hpp"
+#include "alloy/Helpers.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 #include <cassert>
@@ -18,10 +21,12 @@
 #include "VkSurfaceUtil.hpp"
 #include "VkCommon.hpp"
 #include "VkStructStream.hpp"
+#include "VkTypeCvt.hpp"
 #include "VulkanContext.hpp"
 #include "VulkanCommandList.hpp"
 //#include "VulkanDescriptorHeap.hpp"
 #include "VulkanSwapChain.hpp"
+#include "VulkanTexture.hpp"
 //#include "VulkanResourceBarrier.hpp"
 
 namespace alloy::vk {
@@ -32,6 +37,17 @@ namespace alloy::vk {
     {
         _fnTable.vkDeviceWaitIdle(_dev);
 
+        // Joins the relink worker
+        _pipelineLibs.Shutdown();
+        // Needs queues & allocator alive, and returns descriptor sets to
+        // their pools before pool managers go away. Its last callback runs
+        // on the completion thread.
+        _deferredDestroy.Shutdown();
+        _eventCompletion.Shutdown();
+        _gpuProfiler.Shutdown();
+        // Pool allocations were freed by the deferred destroy queue
+        _defragmenter.Shutdown();
+
         delete _gfxQ;
         delete _copyQ;
         delete _computeQ;
@@ -437,6 +453,8 @@ namespace alloy::vk {
 
         features12.timelineSemaphore = true;
         features12.separateDepthStencilLayouts = true;
+        // GPU profiler resets its query pools from host
+        features12.hostQueryReset = devCaps.features12.hostQueryReset;
 
         //Bindless shader ABI and binding models
         {
@@ -471,10 +489,14 @@ namespace alloy::vk {
                 }
             }
 
+            //Buffer device address, descriptor buffers need it too
+            if(devCaps.SupportBufferDeviceAddress()) {
+                features12.bufferDeviceAddress = true;
+            }
+
             //Enable the descriptor buffer
             if(devCaps.supportDescriptorBuffer) {
                 devExtensions.push_back(VkDevExtNames::VK_EXT_DESCRIPTOR_BUFFER);
-                features12.bufferDeviceAddress = true;
 
                 auto& descriptorBufferFeatures
                     = featureStructs.Append<VkPhysicalDeviceDescriptorBufferFeaturesEXT,
@@ -538,6 +560,43 @@ namespace alloy::vk {
             meshShaderFeature.meshShader = VK_TRUE;
         }
 
+        if(devCaps.SupportGraphicsPipelineLibrary()) {
+            devExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+            devExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+            auto& gplFeature
+                = featureStructs.Append<VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT,
+                                        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT>();
+            gplFeature.graphicsPipelineLibrary = VK_TRUE;
+        }
+        dev->_features.flags.supportsGraphicsPipelineLibrary = devCaps.SupportGraphicsPipelineLibrary();
+
+        if(devCaps.SupportExtendedDynamicState()) {
+            devExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+            auto& edsFeature
+                = featureStructs.Append<VkPhysicalDeviceExtendedDynamicStateFeaturesEXT,
+                                        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT>();
+            edsFeature.extendedDynamicState = VK_TRUE;
+        }
+        dev->_features.flags.supportsExtendedDynamicState = devCaps.SupportExtendedDynamicState();
+
+        // Only blend enable is used out of extended dynamic state 3
+        if(devCaps.SupportExtendedDynamicState() && devCaps.SupportDynamicBlendEnable()) {
+            devExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+            auto& eds3Feature
+                = featureStructs.Append<VkPhysicalDeviceExtendedDynamicState3FeaturesEXT,
+                                        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT>();
+            eds3Feature.extendedDynamicState3ColorBlendEnable = VK_TRUE;
+            dev->_features.flags.supportsDynamicBlendEnable = true;
+        } else {
+            dev->_features.flags.supportsDynamicBlendEnable = false;
+        }
+
+        if(devCaps.SupportPushDescriptor()) {
+            devExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+        }
+        dev->_features.flags.supportsPushDescriptor = devCaps.SupportPushDescriptor();
+        dev->_features.flags.supportsBufferDeviceAddress = devCaps.SupportBufferDeviceAddress();
+
         createInfo.pNext = featureStructs.Front<void*>();
 
         auto _AddExtIfPresent = [&](const char* extName) {
@@ -581,6 +640,7 @@ namespace alloy::vk {
         }
 
         dev->_features.flags.supportsDepthClip = _AddExtIfPresent(VkDevExtNames::VK_EXT_DEPTH_CLIP_ENABLE);
+        dev->_features.flags.supportsMemoryBudget = _AddExtIfPresent(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
         dev->_features.flags.supportReadOnlyAttachment = _AddExtIfPresent(VK_KHR_LOAD_STORE_OP_NONE_EXTENSION_NAME);
 
         createInfo.enabledExtensionCount = static_cast<uint32_t>(devExtensions.size());
@@ -650,13 +710,20 @@ namespace alloy::vk {
                                                     qInfo.computeQueueFamily.value(),
                                                     rawComputeQ);
         }
+        // Families are picked distinct per queue
+        for(auto q : { dev->_gfxQ, dev->_copyQ, dev->_computeQ }) {
+            if(q) dev->_queueFamilies.push_back(q->GetQueueFamily());
+        }
         auto apiVer = adp->GetAdapterInfo().apiVersion;
 
         //Init allocator
         VmaAllocatorCreateInfo allocatorInfo = {};
-        if(devCaps.supportDescriptorBuffer) {
+        if(dev->_features.flags.supportsBufferDeviceAddress) {
             allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
         }
+        if(dev->_features.flags.supportsMemoryBudget) {
+            allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+        }
         allocatorInfo.vulkanApiVersion = VK_MAKE_API_VERSION(0, apiVer.major, apiVer.minor, apiVer.patch);
         allocatorInfo.physicalDevice = adp->GetHandle();
         allocatorInfo.device = dev->_dev;
@@ -679,6 +746,7 @@ namespace alloy::vk {
         fn.vkGetImageMemoryRequirements = dev->_fnTable.vkGetImageMemoryRequirements;
         fn.vkGetPhysicalDeviceMemoryProperties = vkGetPhysicalDeviceMemoryProperties;
         fn.vkGetPhysicalDeviceProperties = vkGetPhysicalDeviceProperties;
+        fn.vkGetPhysicalDeviceMemoryProperties2KHR = vkGetPhysicalDeviceMemoryProperties2;
         fn.vkInvalidateMappedMemoryRanges = dev->_fnTable.vkInvalidateMappedMemoryRanges;
         fn.vkMapMemory = dev->_fnTable.vkMapMemory;
         fn.vkUnmapMemory = dev->_fnTable.vkUnmapMemory;
@@ -692,6 +760,15 @@ namespace alloy::vk {
 
         vmaCreateAllocator(&allocatorInfo, &dev->_allocator);
 
+        VulkanCommandQueue* queues[] = { dev->_gfxQ, dev->_copyQ, dev->_computeQ };
+        // Retires deferred destructions
+        dev->_eventCompletion.Init(dev.get());
+        dev->_deferredDestroy.Init(dev.get(), queues);
+        dev->_objectCache.Init(dev.get());
+        dev->_pipelineLibs.Init(dev.get());
+        dev->_gpuProfiler.Init(dev.get(), queues);
+        dev->_defragmenter.Init(dev.get(), dev->_copyQ ? dev->_copyQ : dev->_gfxQ, queues);
+
         //dev->_isValid = true;
 
         //Fill driver and api info
@@ -739,6 +816,13 @@ namespace alloy::vk {
         dev->_commonFeat.commandListDebugMarkers = dev->_features.flags.supportsDebug;
         dev->_commonFeat.bufferRangeBinding = true;
         dev->_commonFeat.shaderFloat64 = deviceFeatures.shaderFloat64;
+        dev->_commonFeat.dynamicRasterState = dev->_features.flags.supportsExtendedDynamicState;
+        dev->_commonFeat.dynamicBlendEnable = dev->_features.flags.supportsDynamicBlendEnable;
+        // Falls back to a transient set without push descriptors
+        dev->_commonFeat.inlineResources = true;
+        dev->_commonFeat.bufferDeviceAddress = dev->_features.flags.supportsBufferDeviceAddress;
+        dev->_commonFeat.placedResources = true;
+        dev->_commonFeat.generateMipmaps = true;
 
         return dev;
 	}
@@ -748,6 +832,9 @@ namespace alloy::vk {
     ICommandQueue* VulkanDevice::GetCopyCommandQueue() {
         return _copyQ;
     }
+    ICommandQueue* VulkanDevice::GetComputeCommandQueue() {
+        return _computeQ;
+    }
 
 
     IPhysicalAdapter& VulkanDevice::GetAdapter() const {
@@ -762,6 +849,10 @@ namespace alloy::vk {
         VulkanSwapChain* vkSC = PtrCast<VulkanSwapChain>(sc);
         //auto tex = vkSC->GetCurrentColorTarget()->GetTextureObject().get();
 
+        // Other processes move the budget too, recheck once per frame
+        vmaSetCurrentFrameIndex(_allocator, ++_allocFrameIdx);
+        CheckMemoryBudget();
+
         auto sem = _gfxQ->PrepareForPresent();
 
         VkSwapchainKHR deviceSwapchain = vkSC->GetHandle();
@@ -819,11 +910,254 @@ namespace alloy::vk {
         );
     }
 
-    common::sp<IBuffer> VulkanBuffer::Make(
+    _DescriptorPoolMgr::Stats VulkanDevice::GetDescriptorPoolStats() {
+        _DescriptorPoolMgr::Stats total {};
+        for(auto& [type, mgr] : _descPoolMgrs) {
+            auto stats = mgr.GetStats();
+            total.poolsAlive += stats.poolsAlive;
+            total.freePools += stats.freePools;
+            total.dedicatedPools += stats.dedicatedPools;
+            total.liveSets += stats.liveSets;
+            total.setCapacity += stats.setCapacity;
+            total.allocations += stats.allocations;
+            total.failedAllocations += stats.failedAllocations;
+            total.allocTimeNs += stats.allocTimeNs;
+            total.maxAllocTimeNs = std::max(total.maxAllocTimeNs, stats.maxAllocTimeNs);
+        }
+        return total;
+    }
+
+    static void _FillHeapStats(
+        const VmaBudget& budget,
+        const VkMemoryHeap& heap,
+        IGraphicsDevice::MemoryHeapStats& stats
+    ) {
+        stats.deviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        stats.budgetBytes = budget.budget;
+        stats.usageBytes = budget.usage;
+        stats.blockCount = budget.statistics.blockCount;
+        stats.allocationCount = budget.statistics.allocationCount;
+        stats.blockBytes = budget.statistics.blockBytes;
+        stats.allocationBytes = budget.statistics.allocationBytes;
+    }
+
+    void VulkanDevice::CheckMemoryBudget() {
+        const VkPhysicalDeviceMemoryProperties* memProps;
+        vmaGetMemoryProperties(_allocator, &memProps);
+        VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+        vmaGetHeapBudgets(_allocator, budgets);
+
+        std::uint32_t overBudget = 0;
+        for(std::uint32_t i = 0; i < memProps->memoryHeapCount; i++) {
+            if(budgets[i].usage > budgets[i].budget)
+                overBudget |= 1u << i;
+        }
+
+        MemoryBudgetCallback callback;
+        std::uint32_t crossed;
+        {
+            std::scoped_lock lk{_m_budget};
+            crossed = overBudget & ~_overBudgetHeaps;
+            _overBudgetHeaps = overBudget;
+            if(!crossed || !_budgetCallback) return;
+            callback = _budgetCallback;
+        }
+
+        for(std::uint32_t i = 0; i < memProps->memoryHeapCount; i++) {
+            if(!(crossed & (1u << i))) continue;
+            MemoryHeapStats stats {};
+            _FillHeapStats(budgets[i], memProps->memoryHeaps[i], stats);
+            callback(i, stats);
+        }
+    }
+
+    bool VulkanDevice::GetMipmapBlitFormat(
+        PixelFormat format,
+        PixelFormat& blitFormat,
+        VkFilter& filter
+    ) const {
+        // Block compressed levels can't be produced by the GPU
+        if(FormatHelpers::IsCompressedFormat(format)) return false;
+
+        constexpr VkFormatFeatureFlags blitBits
+            = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+        auto getFeatures = [this](PixelFormat f) {
+            VkFormatProperties props{};
+            VK_INST_CALL(this, vkGetPhysicalDeviceFormatProperties(
+                PhysicalDev(), VdToVkPixelFormat(f), &props));
+            return props.optimalTilingFeatures;
+        };
+
+        auto features = getFeatures(format);
+        if((features & blitBits) == blitBits) {
+            // Blits can't filter every format linearly, fall back to point sampling
+            blitFormat = format;
+            filter = (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+                ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+            return true;
+        }
+
+        // Point sampling picks whole texels, an integer format of the same
+        // size moves them bit exact. These are mandatory blit formats.
+        switch(FormatHelpers::GetSizeInBytes(format)) {
+            case 1: blitFormat = PixelFormat::R8_UInt; break;
+            case 2: blitFormat = PixelFormat::R16_UInt; break;
+            case 4: blitFormat = PixelFormat::R32_UInt; break;
+            case 8: blitFormat = PixelFormat::R32_G32_UInt; break;
+            case 16: blitFormat = PixelFormat::R32_G32_B32_A32_UInt; break;
+            default: return false;
+        }
+        filter = VK_FILTER_NEAREST;
+        return (getFeatures(blitFormat) & blitBits) == blitBits;
+    }
+
+    bool VulkanDevice::CanGenerateMipmaps(PixelFormat format) const {
+        PixelFormat blitFormat;
+        VkFilter filter;
+        return GetMipmapBlitFormat(format, blitFormat, filter);
+    }
+
+    bool VulkanDevice::GetMemoryStats(MemoryStats& stats, bool detailed) {
+        const VkPhysicalDeviceMemoryProperties* memProps;
+        vmaGetMemoryProperties(_allocator, &memProps);
+        VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+        vmaGetHeapBudgets(_allocator, budgets);
+
+        stats.heaps.resize(memProps->memoryHeapCount);
+        for(std::uint32_t i = 0; i < memProps->memoryHeapCount; i++) {
+            stats.heaps[i] = {};
+            _FillHeapStats(budgets[i], memProps->memoryHeaps[i], stats.heaps[i]);
+        }
+
+        if(detailed) {
+            VmaTotalStatistics total;
+            vmaCalculateStatistics(_allocator, &total);
+            for(std::uint32_t i = 0; i < memProps->memoryHeapCount; i++) {
+                stats.heaps[i].unusedRangeCount = total.memoryHeap[i].unusedRangeCount;
+                stats.heaps[i].largestUnusedRangeBytes = total.memoryHeap[i].unusedRangeSizeMax;
+            }
+        }
+        return true;
+    }
+
+    std::string VulkanDevice::DumpMemoryStats(bool detailed) {
+        char* json = nullptr;
+        vmaBuildStatsString(_allocator, &json, detailed);
+        std::string res = json;
+        vmaFreeStatsString(_allocator, json);
+        return res;
+    }
+
+    void VulkanDevice::SetMemoryBudgetCallback(MemoryBudgetCallback callback) {
+        std::scoped_lock lk{_m_budget};
+        _budgetCallback = std::move(callback);
+    }
+
+    // Memory types every resource of the class may use. Those only depend
+    // on usage, flags and tiling, so small resources with every usage of
+    // the class stand in for all of them.
+    static uint32_t _GetHeapMemoryTypeBits(
+        VulkanDevice& dev,
+        IMemoryHeap::ResourceClass resourceClass
+    ) {
+        using ResourceClass = IMemoryHeap::ResourceClass;
+        uint32_t bits = UINT32_MAX;
+        VkMemoryRequirements req;
+
+        if(resourceClass == ResourceClass::All || resourceClass == ResourceClass::Buffers) {
+            IBuffer::Description bufDesc{};
+            bufDesc.sizeInBytes = 256;
+            bufDesc.usage.vertexBuffer = 1;
+            bufDesc.usage.indexBuffer = 1;
+            bufDesc.usage.uniformBuffer = 1;
+            bufDesc.usage.structuredBufferReadOnly = 1;
+            bufDesc.usage.structuredBufferReadWrite = 1;
+            bufDesc.usage.indirectBuffer = 1;
+            bufDesc.usage.deviceAddress = dev.GetVkFeatures().flags.supportsBufferDeviceAddress;
+            if(!VulkanBuffer::GetMemoryRequirements(dev, bufDesc, req)) return 0;
+            bits &= req.memoryTypeBits;
+        }
+
+        ITexture::Description texDesc{};
+        texDesc.width = 16;
+        texDesc.height = 16;
+        texDesc.depth = 1;
+        texDesc.mipLevels = 1;
+        texDesc.arrayLayers = 1;
+        texDesc.type = ITexture::Description::Type::Texture2D;
+        texDesc.sampleCount = SampleCount::x1;
+        texDesc.format = PixelFormat::R8_G8_B8_A8_UNorm;
+
+        if(resourceClass == ResourceClass::All || resourceClass == ResourceClass::Textures) {
+            auto desc = texDesc;
+            desc.usage.sampled = 1;
+            desc.usage.storage = 1;
+            if(!VulkanTexture::GetMemoryRequirements(dev, desc, req)) return 0;
+            bits &= req.memoryTypeBits;
+        }
+
+        if(resourceClass == ResourceClass::All || resourceClass == ResourceClass::RenderTargets) {
+            auto desc = texDesc;
+            desc.usage.sampled = 1;
+            desc.usage.renderTarget = 1;
+            if(!VulkanTexture::GetMemoryRequirements(dev, desc, req)) return 0;
+            bits &= req.memoryTypeBits;
+
+            desc = texDesc;
+            desc.format = PixelFormat::D32_Float_S8_UInt;
+            desc.usage.sampled = 1;
+            desc.usage.depthStencil = 1;
+            if(!VulkanTexture::GetMemoryRequirements(dev, desc, req)) return 0;
+            bits &= req.memoryTypeBits;
+        }
+
+        return bits;
+    }
+
+    common::sp<IMemoryHeap> VulkanMemoryHeap::Make(
         const common::sp<VulkanDevice>& dev,
-        const IBuffer::Description& desc
+        const IMemoryHeap::Description& desc
     ) {
+        VLD_TRACE_ZONE("VulkanMemoryHeap::Make");
+
+        VmaAllocationCreateInfo allocInfo{};
+        allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        // Own memory object so placed resources start at its offset 0
+        allocInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT
+                        | VMA_ALLOCATION_CREATE_CAN_ALIAS_BIT;
+
+        auto memoryTypeBits = _GetHeapMemoryTypeBits(*dev, desc.resourceClass);
+        uint32_t memoryTypeIdx;
+        if(memoryTypeBits == 0
+            || vmaFindMemoryTypeIndex(dev->Allocator(), memoryTypeBits, &allocInfo, &memoryTypeIdx) != VK_SUCCESS)
+            return nullptr;
+
+        VkMemoryRequirements req{};
+        req.size = desc.sizeInBytes;
+        req.alignment = 1;
+        req.memoryTypeBits = 1u << memoryTypeIdx;
 
+        VmaAllocation allocation;
+        if(vmaAllocateMemory(dev->Allocator(), &req, &allocInfo, &allocation, nullptr) != VK_SUCCESS)
+            return nullptr;
+        VLD_TRACE_COUNT(Allocations, 1);
+        dev->CheckMemoryBudget();
+
+        auto heap = new VulkanMemoryHeap{ dev, desc };
+        heap->_allocation = allocation;
+        heap->_memoryTypeIdx = memoryTypeIdx;
+        return common::sp<IMemoryHeap>(heap);
+    }
+
+    VulkanMemoryHeap::~VulkanMemoryHeap() {
+        // Queued after the resources placed in it
+        _dev->DeferDestroy(VK_OBJECT_TYPE_DEVICE_MEMORY, 0, _allocation);
+    }
+
+    static VkBufferCreateInfo _GetBufferCreateInfo(
+        VulkanDevice& dev,
+        const IBuffer::Description& desc
+    ) {
         auto& usage = desc.usage;
 
         VkBufferUsageFlags usages = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
@@ -849,6 +1183,11 @@ namespace alloy::vk {
         {
             usages |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
         }
+        if ((desc.usage.deviceAddress))
+        {
+            assert(dev.GetVkFeatures().flags.supportsBufferDeviceAddress);
+            usages |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+        }
 
         //bool isStaging = desc.usage.staging;
         //bool hostVisible = isStaging || desc.usage.dynamic;
@@ -858,6 +1197,24 @@ namespace alloy::vk {
         VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
         bufferInfo.size = desc.sizeInBytes;
         bufferInfo.usage = usages;
+        // Buffers aren't ownership tracked, let every queue access them
+        auto queueFamilies = dev.GetQueueFamilies();
+        if(queueFamilies.size() > 1) {
+            bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferInfo.queueFamilyIndexCount = queueFamilies.size();
+            bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+        }
+
+        return bufferInfo;
+    }
+
+    common::sp<IBuffer> VulkanBuffer::Make(
+        const common::sp<VulkanDevice>& dev,
+        const IBuffer::Description& desc
+    ) {
+        VLD_TRACE_ZONE("VulkanBuffer::Make");
+
+        auto bufferInfo = _GetBufferCreateInfo(*dev, desc);
 
         VmaAllocationCreateInfo allocInfo{};
         allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
@@ -905,24 +1262,128 @@ namespace alloy::vk {
                 VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
         }*/
 
+        auto& defragmenter = dev->GetVkDefragmenter();
+        bool movable = defragmenter.CanMove(desc);
+        if(movable) allocInfo.pool = defragmenter.GetPool();
+
         VkBuffer buffer;
         VmaAllocation allocation;
         auto res = vmaCreateBuffer(dev->Allocator(), &bufferInfo, &allocInfo, &buffer, &allocation, nullptr);
+        if(res != VK_SUCCESS && movable) {
+            // Too large for a pool block, or the pool's type doesn't fit
+            movable = false;
+            allocInfo.pool = VK_NULL_HANDLE;
+            res = vmaCreateBuffer(dev->Allocator(), &bufferInfo, &allocInfo, &buffer, &allocation, nullptr);
+        }
 
         if(res != VK_SUCCESS) return nullptr;
+        VLD_TRACE_COUNT(Allocations, 1);
+        dev->CheckMemoryBudget();
 
         auto buf = new VulkanBuffer{ dev, desc };
         buf->_buffer = buffer;
         //buf->_size = size;
         buf->_allocation = allocation;
+        buf->_QueryDeviceAddress();
+        if(movable) {
+            buf->_movable = true;
+            defragmenter.Track(buf);
+        }
 
         //buf->_usages = usages;
         //buf->_allocationType = allocationType;
         return common::sp(buf);
     }
 
+    common::sp<IBuffer> VulkanBuffer::MakePlaced(
+        const common::sp<VulkanDevice>& dev,
+        const common::sp<VulkanMemoryHeap>& heap,
+        std::uint64_t offset,
+        const IBuffer::Description& desc
+    ) {
+        VLD_TRACE_ZONE("VulkanBuffer::MakePlaced");
+
+        if(desc.hostAccess != HostAccess::None || !heap->CanHold(desc)) return nullptr;
+
+        auto bufferInfo = _GetBufferCreateInfo(*dev, desc);
+        VkBuffer buffer;
+        if(VK_DEV_CALL(dev, vkCreateBuffer(dev->LogicalDev(), &bufferInfo, nullptr, &buffer)) != VK_SUCCESS)
+            return nullptr;
+
+        VkMemoryRequirements req;
+        VK_DEV_CALL(dev, vkGetBufferMemoryRequirements(dev->LogicalDev(), buffer, &req));
+        if(!heap->CanPlace(req, offset)
+            || vmaBindBufferMemory2(dev->Allocator(), heap->GetAllocation(), offset, buffer, nullptr) != VK_SUCCESS
+        ) {
+            VK_DEV_CALL(dev, vkDestroyBuffer(dev->LogicalDev(), buffer, nullptr));
+            return nullptr;
+        }
+
+        auto buf = new VulkanBuffer{ dev, desc };
+        buf->_buffer = buffer;
+        buf->_heap = heap;
+        buf->_QueryDeviceAddress();
+        return common::sp(buf);
+    }
+
+    bool VulkanBuffer::GetMemoryRequirements(
+        VulkanDevice& dev,
+        const IBuffer::Description& desc,
+        VkMemoryRequirements& req
+    ) {
+        // No vkGetDeviceBufferMemoryRequirements before 1.3, ask a throwaway buffer
+        auto bufferInfo = _GetBufferCreateInfo(dev, desc);
+        VkBuffer buffer;
+        if(VK_DEV_CALL(&dev, vkCreateBuffer(dev.LogicalDev(), &bufferInfo, nullptr, &buffer)) != VK_SUCCESS)
+            return false;
+
+        VK_DEV_CALL(&dev, vkGetBufferMemoryRequirements(dev.LogicalDev(), buffer, &req));
+        VK_DEV_CALL(&dev, vkDestroyBuffer(dev.LogicalDev(), buffer, nullptr));
+        return true;
+    }
+
+    IMemoryHeap::Placement VulkanBuffer::GetPlacement(
+        VulkanDevice& dev,
+        const IBuffer::Description& desc
+    ) {
+        VkMemoryRequirements req;
+        if(!GetMemoryRequirements(dev, desc, req))
+            return {};
+        return { req.size, req.alignment };
+    }
+
+    void VulkanBuffer::_QueryDeviceAddress() {
+        if(!_desc.usage.deviceAddress) return;
+
+        VkBufferDeviceAddressInfo addrInfo{ VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO };
+        addrInfo.buffer = _buffer;
+        _deviceAddress = VK_DEV_CALL(_dev, vkGetBufferDeviceAddress(_dev->LogicalDev(), &addrInfo));
+    }
+
+    bool VulkanBuffer::_MoveTo(VmaAllocation dst, VkBuffer& oldHandle) {
+        auto bufferInfo = _GetBufferCreateInfo(*_dev, _desc);
+        VkBuffer buffer;
+        if(VK_DEV_CALL(_dev, vkCreateBuffer(_dev->LogicalDev(), &bufferInfo, nullptr, &buffer)) != VK_SUCCESS)
+            return false;
+
+        if(vmaBindBufferMemory(_dev->Allocator(), dst, buffer) != VK_SUCCESS) {
+            VK_DEV_CALL(_dev, vkDestroyBuffer(_dev->LogicalDev(), buffer, nullptr));
+            return false;
+        }
+
+        oldHandle = _buffer;
+        _buffer = buffer;
+        if(!_debugName.empty())
+            SetDebugName(_debugName);
+        return true;
+    }
+
     VulkanBuffer::~VulkanBuffer(){
-        vmaDestroyBuffer(_dev->Allocator(), _buffer, _allocation);
+        auto allocation = _allocation;
+        // A pending defragmentation pass frees it instead
+        if(_movable && _dev->GetVkDefragmenter().Untrack(this))
+            allocation = VK_NULL_HANDLE;
+        _dev->DeferDestroy(VK_OBJECT_TYPE_BUFFER, (uint64_t)_buffer, allocation);
 
         DEBUGCODE(_dev = nullptr);
         DEBUGCODE(_buffer = VK_NULL_HANDLE);
@@ -944,7 +1405,8 @@ namespace alloy::vk {
 
     VulkanFence::~VulkanFence()
     {
-        _dev->GetFnTable().vkDestroySemaphore(_dev->LogicalDev(), _timelineSem, nullptr);
+        _dev->GetEventCompletionThread().Cancel(_timelineSem);
+        _dev->DeferDestroy(VK_OBJECT_TYPE_SEMAPHORE, (uint64_t)_timelineSem);
     }
 
     uint64_t VulkanFence::GetSignaledValue() {
@@ -971,7 +1433,9 @@ namespace alloy::vk {
         waitInfo.pSemaphores = &_timelineSem;
         waitInfo.pValues = &expectedValue;
 
-        auto res = VK_DEV_CALL(_dev, vkWaitSemaphoresKHR(_dev->LogicalDev(), &waitInfo, timeoutMs * 1000000));
+        const uint64_t timeoutNs = timeoutMs == (std::numeric_limits<std::uint32_t>::max)()
+            ? UINT64_MAX : timeoutMs * 1000000ull;
+        auto res = VK_DEV_CALL(_dev, vkWaitSemaphoresKHR(_dev->LogicalDev(), &waitInfo, timeoutNs));
 
         switch (res) {
         //On success, this command returns
@@ -992,6 +1456,42 @@ namespace alloy::vk {
         return false;
     }
 
+    void VulkanFence::OnReached(uint64_t value, ReachedCallback callback) {
+        if(GetSignaledValue() >= value) {
+            callback(true);
+            return;
+        }
+        _dev->GetEventCompletionThread().Add(_timelineSem, value, std::move(callback));
+    }
+
+    bool VulkanDevice::WaitForEvents(
+        std::span<const EventWait> waits,
+        bool waitAll,
+        uint32_t timeoutMs
+    ) {
+        if(waits.empty()) return true;
+
+        std::vector<VkSemaphore> sems;
+        std::vector<uint64_t> values;
+        sems.reserve(waits.size());
+        values.reserve(waits.size());
+        for(auto& w : waits) {
+            sems.push_back(PtrCast<VulkanFence>(w.event)->GetHandle());
+            values.push_back(w.value);
+        }
+
+        VkSemaphoreWaitInfo waitInfo {};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.flags = waitAll ? 0 : VK_SEMAPHORE_WAIT_ANY_BIT;
+        waitInfo.semaphoreCount = (uint32_t)sems.size();
+        waitInfo.pSemaphores = sems.data();
+        waitInfo.pValues = values.data();
+
+        const uint64_t timeoutNs = timeoutMs == (std::numeric_limits<std::uint32_t>::max)()
+            ? UINT64_MAX : timeoutMs * 1000000ull;
+        return VK_DEV_CALL(this, vkWaitSemaphoresKHR(_dev, &waitInfo, timeoutNs)) == VK_SUCCESS;
+    }
+
     common::sp<IEvent> VulkanFence::Make(const common::sp<VulkanDevice>& dev)
     {
         VkSemaphoreTypeCreateInfo timelineCreateInfo {};
@@ -1097,6 +1597,7 @@ namespace alloy::vk {
         : _dev(dev)
         , _cmdPoolMgr(dev, queueFamily)
         , _q(q)
+        , _lastSubmittedValue(0)
     {
 
         VkSemaphoreTypeCreateInfo timelineCreateInfo {};
@@ -1110,6 +1611,8 @@ namespace alloy::vk {
         createInfo.pNext = &timelineCreateInfo;
         createInfo.flags = 0;
 
+        VK_CHECK(VK_DEV_CALL(dev,
+            vkCreateSemaphore(dev->LogicalDev(), &createInfo, nullptr, &_timeline)));
 
         createInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
 
@@ -1119,6 +1622,13 @@ namespace alloy::vk {
 
     VulkanCommandQueue::~VulkanCommandQueue() {
         VK_DEV_CALL(_dev,vkDestroySemaphore(_dev->LogicalDev(), _presentFence, nullptr));
+        VK_DEV_CALL(_dev,vkDestroySemaphore(_dev->LogicalDev(), _timeline, nullptr));
+    }
+
+    uint64_t VulkanCommandQueue::GetCompletedValue() const {
+        uint64_t value = 0;
+        VK_DEV_CALL(_dev, vkGetSemaphoreCounterValueKHR(_dev->LogicalDev(), _timeline, &value));
+        return value;
     }
 
     void VulkanCommandQueue::EncodeSignalEvent(IEvent* evt, uint64_t value) {
@@ -1139,6 +1649,7 @@ namespace alloy::vk {
         submitInfo.signalSemaphoreCount  = 1;
         submitInfo.pSignalSemaphores = &rawFence;
 
+        std::scoped_lock lk{_m_queue};
         VK_DEV_CALL(_dev, vkQueueSubmit(_q, 1, &submitInfo, VK_NULL_HANDLE));
 
     }
@@ -1162,6 +1673,28 @@ namespace alloy::vk {
         submitInfo.waitSemaphoreCount = 1;
         submitInfo.pWaitSemaphores = &rawFence;
 
+        std::scoped_lock lk{_m_queue};
+        VK_DEV_CALL(_dev, vkQueueSubmit(_q, 1, &submitInfo, VK_NULL_HANDLE));
+    }
+
+    void VulkanCommandQueue::EncodeWaitForQueue(const VulkanCommandQueue& other, uint64_t value) {
+        VkSemaphore timeline = other.GetTimelineHandle();
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = 1;
+        timelineInfo.pWaitSemaphoreValues = &value;
+
+        const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        VkSubmitInfo submitInfo {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &timeline;
+        submitInfo.pWaitDstStageMask = &waitStage;
+
+        std::scoped_lock lk{_m_queue};
         VK_DEV_CALL(_dev, vkQueueSubmit(_q, 1, &submitInfo, VK_NULL_HANDLE));
     }
 
@@ -1176,30 +1709,58 @@ namespace alloy::vk {
             submitInfo.signalSemaphoreCount = 1;
             submitInfo.pSignalSemaphores = &_presentFence;
 
+            std::scoped_lock lk{_m_queue};
             VK_DEV_CALL(_dev, vkQueueSubmit(_q, 1, &submitInfo, VK_NULL_HANDLE));
         }
 
         return _presentFence;
     }
 
-    void VulkanCommandQueue::SubmitCommand(ICommandList* cmd) {
-
-        assert(cmd != nullptr);
-        auto* vkCmd = PtrCast<VulkanCommandList>(cmd);
+    uint64_t VulkanCommandQueue::SubmitCommandBuffer(VkCommandBuffer cmdBuf) {
+        std::scoped_lock lk{_m_queue};
+        const uint64_t signalValue = _lastSubmittedValue.load(std::memory_order_relaxed) + 1;
 
-        auto rawCmdBuf = vkCmd->GetHandle();
+        VkTimelineSemaphoreSubmitInfo timelineInfo {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.pNext = NULL;
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &signalValue;
 
         VkSubmitInfo submitInfo {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.pNext = nullptr;
+        submitInfo.pNext = &timelineInfo;
         submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &rawCmdBuf;
-        submitInfo.signalSemaphoreCount  = 0;
-        submitInfo.pSignalSemaphores = nullptr;
+        submitInfo.pCommandBuffers = &cmdBuf;
+        submitInfo.signalSemaphoreCount  = 1;
+        submitInfo.pSignalSemaphores = &_timeline;
 
         VK_CHECK(VK_DEV_CALL(_dev, vkQueueSubmit(
             _q, 1, &submitInfo, nullptr
         )));
+
+        _lastSubmittedValue.store(signalValue, std::memory_order_release);
+        return signalValue;
+    }
+
+    void VulkanCommandQueue::SubmitCommand(ICommandList* cmd) {
+        VLD_TRACE_ZONE("VulkanCommandQueue::SubmitCommand");
+        VLD_TRACE_COUNT(Submits, 1);
+
+        assert(cmd != nullptr);
+        auto* vkCmd = PtrCast<VulkanCommandList>(cmd);
+
+        // Recorded before a defragmentation pass swapped buffer handles,
+        // the list may still reference the freed ranges.
+        if(vkCmd->GetMoveEpoch() != _dev->GetVkDefragmenter().GetMoveEpoch()) {
+            assert(false && "Command list recorded before IBufferDefragmenter::Update()");
+            return;
+        }
+
+        const uint64_t signaledValue = SubmitCommandBuffer(vkCmd->GetHandle());
+
+        if(auto profile = vkCmd->TakeProfileRecording()) {
+            _dev->GetVkGpuProfiler().OnSubmit(std::move(profile), this, signaledValue);
+        }
     }
 
     common::sp<ICommandList> VulkanCommandQueue::CreateCommandList(){
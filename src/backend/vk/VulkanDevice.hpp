@@ -8,6 +8,8 @@
 #include "alloy/GraphicsDevice.hpp"
 #include "alloy/SyncObjects.hpp"
 #include "alloy/Buffer.hpp"
+#include "alloy/MemoryHeap.hpp"
+#include "alloy/Texture.hpp"
 #include "alloy/SwapChain.hpp"
 #include "alloy/CommandQueue.hpp"
 
@@ -16,8 +18,17 @@
 #include <unordered_map>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <span>
+#include <vector>
 
 #include "VkDescriptorPoolMgr.hpp"
+#include "VkDeferredDestroyQueue.hpp"
+#include "VkObjectCache.hpp"
+#include "VkPipelineLibrary.hpp"
+#include "VkGpuProfiler.hpp"
+#include "VkDefragmenter.hpp"
+#include "VkEventCompletion.hpp"
 #include "VulkanContext.hpp"
 #include "VulkanResourceFactory.hpp"
 
@@ -59,6 +70,7 @@ namespace alloy::vk
         ~_CmdPoolMgr();
 
         common::sp<_CmdPoolContainer> GetOnePool() { return _AcquireCmdPoolHolder(); }
+        std::uint32_t GetQueueFamily() const { return _queueFamily; }
     };
 
     struct _CmdPoolContainer : public common::RefCntBase {
@@ -83,6 +95,14 @@ namespace alloy::vk
 
         VkSemaphore _presentFence;
 
+        // Signaled with an increasing value on each SubmitCommand(), tells
+        // how far the GPU progressed on this queue.
+        VkSemaphore _timeline;
+        std::atomic<uint64_t> _lastSubmittedValue;
+
+        // VkQueue is externally synchronized
+        std::mutex _m_queue;
+
     public:
 
         VulkanCommandQueue(VulkanDevice* dev, std::uint32_t queueFamily, VkQueue q);
@@ -100,14 +120,27 @@ namespace alloy::vk
         //virtual void Reset() = 0;
 
         VkQueue GetHandle() const {return _q;}
+        std::uint32_t GetQueueFamily() const { return _cmdPoolMgr.GetQueueFamily(); }
+
+        VkSemaphore GetTimelineHandle() const { return _timeline; }
+        uint64_t GetLastSubmittedValue() const {
+            return _lastSubmittedValue.load(std::memory_order_acquire);
+        }
+        uint64_t GetCompletedValue() const;
 
         /*ICommandQueue implementations*/
         virtual void EncodeSignalEvent(IEvent* evt, uint64_t value) override;
 
         virtual void EncodeWaitForEvent(IEvent* evt, uint64_t value) override;
 
+        // Orders work submitted from now on after other's timeline value
+        void EncodeWaitForQueue(const VulkanCommandQueue& other, uint64_t value);
+
         virtual void SubmitCommand(ICommandList* cmd) override;
 
+        // Submits a raw command buffer, returns the timeline value it signals
+        uint64_t SubmitCommandBuffer(VkCommandBuffer cmdBuf);
+
         virtual common::sp<ICommandList> CreateCommandList() override;
 
         virtual void* GetNativeHandle() const override {return _q;}
@@ -140,6 +173,12 @@ namespace alloy::vk
                     std::uint32_t supportsDrvPropQuery : 1;
 
                     std::uint32_t supportsDepthClip : 1;
+                    std::uint32_t supportsGraphicsPipelineLibrary : 1;
+                    std::uint32_t supportsExtendedDynamicState : 1;
+                    std::uint32_t supportsDynamicBlendEnable : 1;
+                    std::uint32_t supportsPushDescriptor : 1;
+                    std::uint32_t supportsBufferDeviceAddress : 1;
+                    std::uint32_t supportsMemoryBudget : 1;
 
                     // VK_KHR_load_store_op_none is promoted into vk1.4
                     // validate extension support on actual hardware
@@ -172,9 +211,37 @@ namespace alloy::vk
         VkDescriptorSetLayout _t2SamplerHeapDsl = VK_NULL_HANDLE;
         VkDescriptorSetLayout _t2OffsetUBODSL = VK_NULL_HANDLE;
 
-        VulkanCommandQueue* _gfxQ;
-        VulkanCommandQueue* _copyQ;
-        VulkanCommandQueue* _computeQ;
+        VulkanCommandQueue* _gfxQ = nullptr;
+        VulkanCommandQueue* _copyQ = nullptr;
+        VulkanCommandQueue* _computeQ = nullptr;
+        // Families of the created queues, buffers are shared across them
+        std::vector<std::uint32_t> _queueFamilies;
+
+        // Native handles released by resources wait here until every
+        // queue has passed the submissions that could reference them.
+        mutable _DeferredDestroyQueue _deferredDestroy;
+
+        // Shared samplers, image views, DSLs and pipeline layouts
+        mutable _VkObjectCache _objectCache;
+
+        // Graphics pipeline parts, when pipeline libraries are supported
+        mutable _VkPipelineLibraryCache _pipelineLibs;
+
+        // Timestamps of passes and debug groups, off unless enabled
+        _VkGpuProfiler _gpuProfiler;
+
+        // Moves device local buffers out of sparse blocks on request
+        _VkDefragmenter _defragmenter;
+
+        // Runs IEvent::OnReached callbacks
+        mutable _VkEventCompletionThread _eventCompletion;
+
+        MemoryBudgetCallback _budgetCallback;
+        // Bit per heap that was over budget at the last check
+        std::uint32_t _overBudgetHeaps = 0;
+        std::mutex _m_budget;
+        // Budgets are refetched when the allocator's frame index moves
+        std::atomic<std::uint32_t> _allocFrameIdx = 0;
 
         //VkSurfaceKHR _surface;
         //bool _isOwnSurface;
@@ -261,6 +328,44 @@ namespace alloy::vk
             bool isVariableCnt, // Enables variable count
             bool isMutableSet   // Implies partially bound and update after use.
         );
+
+        // Destroy the handle once all work submitted so far has finished
+        // on GPU. allocation is the VMA allocation bound to buffers/images.
+        void DeferDestroy(
+            VkObjectType type,
+            uint64_t handle,
+            VmaAllocation allocation = VK_NULL_HANDLE
+        ) const {
+            _deferredDestroy.Enqueue(type, handle, allocation);
+        }
+
+        void DeferDestroy(std::vector<_DescriptorSet>&& sets) const {
+            _deferredDestroy.Enqueue(std::move(sets));
+        }
+
+        _DeferredDestroyQueue::Stats GetDeferredDestroyStats() const {
+            return _deferredDestroy.GetStats();
+        }
+
+        const _DeferredDestroyQueue& GetDeferredDestroyQueue() const { return _deferredDestroy; }
+
+        _VkObjectCache& GetObjectCache() const { return _objectCache; }
+
+        _VkPipelineLibraryCache& GetPipelineLibraryCache() const { return _pipelineLibs; }
+
+        // Summed over the per-type pool managers
+        _DescriptorPoolMgr::Stats GetDescriptorPoolStats();
+
+        _VkGpuProfiler& GetVkGpuProfiler() { return _gpuProfiler; }
+
+        _VkDefragmenter& GetVkDefragmenter() { return _defragmenter; }
+
+        _VkEventCompletionThread& GetEventCompletionThread() const { return _eventCompletion; }
+
+        // Reports heaps that went over budget, after each allocation
+        void CheckMemoryBudget();
+
+        std::span<const std::uint32_t> GetQueueFamilies() const { return _queueFamilies; }
     //Interface
     public:
 
@@ -270,19 +375,98 @@ namespace alloy::vk
 
         virtual ICommandQueue* GetGfxCommandQueue() override;
         virtual ICommandQueue* GetCopyCommandQueue() override;
+        virtual ICommandQueue* GetComputeCommandQueue() override;
+
+        virtual IGpuProfiler* GetGpuProfiler() override { return &_gpuProfiler; }
+
+        virtual IBufferDefragmenter* GetBufferDefragmenter() override {
+            return _defragmenter.GetPool() != VK_NULL_HANDLE ? &_defragmenter : nullptr;
+        }
+
+        virtual bool CanGenerateMipmaps(PixelFormat format) const override;
+
+        // Format GenerateMipmaps() blits with: the texture's own, or a same
+        // sized integer one it copies through. False if neither blits.
+        bool GetMipmapBlitFormat(PixelFormat format, PixelFormat& blitFormat, VkFilter& filter) const;
+
+        virtual bool GetMemoryStats(MemoryStats& stats, bool detailed) override;
+        virtual std::string DumpMemoryStats(bool detailed) override;
+        virtual void SetMemoryBudgetCallback(MemoryBudgetCallback callback) override;
+
+        // A single vkWaitSemaphores over every event
+        virtual bool WaitForEvents(std::span<const EventWait> waits, bool waitAll, uint32_t timeoutMs) override;
+        using IGraphicsDevice::WaitForEvents;
 
         //virtual bool WaitForFence(const sp<Fence>& fence, std::uint32_t timeOutNs) override;
         void WaitForIdle() override { _fnTable.vkDeviceWaitIdle(_dev);}
     };
 
+    // One dedicated VMA allocation of the first device local memory type.
+    // Resources are bound into it without allocations of their own.
+    class VulkanMemoryHeap : public IMemoryHeap {
+
+        common::sp<VulkanDevice> _dev;
+        VmaAllocation _allocation;
+        std::uint32_t _memoryTypeIdx;
+
+        Description _desc;
+
+        VulkanMemoryHeap(
+            const common::sp<VulkanDevice>& dev,
+            const IMemoryHeap::Description& desc
+        )
+            : _dev(dev)
+            , _allocation(VK_NULL_HANDLE)
+            , _memoryTypeIdx(0)
+            , _desc(desc)
+        { }
+
+    public:
+        ~VulkanMemoryHeap();
+
+        static common::sp<IMemoryHeap> Make(
+            const common::sp<VulkanDevice>& dev,
+            const IMemoryHeap::Description& desc
+        );
+
+        VmaAllocation GetAllocation() const { return _allocation; }
+
+        bool CanPlace(const VkMemoryRequirements& req, std::uint64_t offset) const {
+            return (req.memoryTypeBits & (1u << _memoryTypeIdx))
+                && offset % req.alignment == 0
+                && offset + req.size <= _desc.sizeInBytes;
+        }
+
+        bool CanHold(const IBuffer::Description&) const {
+            return _desc.resourceClass == ResourceClass::All
+                || _desc.resourceClass == ResourceClass::Buffers;
+        }
+
+        bool CanHold(const ITexture::Description& desc) const {
+            auto cls = desc.usage.renderTarget || desc.usage.depthStencil
+                ? ResourceClass::RenderTargets : ResourceClass::Textures;
+            return _desc.resourceClass == ResourceClass::All
+                || _desc.resourceClass == cls;
+        }
+
+        virtual const Description& GetDesc() const override { return _desc; }
+    };
+
     class VulkanBuffer : public IBuffer{
 
+        friend class _VkDefragmenter;
+
     private:
         std::string _debugName;
         common::sp<VulkanDevice> _dev;
 
         VkBuffer _buffer;
+        // Null for placed buffers
         VmaAllocation _allocation;
+        common::sp<VulkanMemoryHeap> _heap;
+        VkDeviceAddress _deviceAddress;
+        // Allocated from the defragmenter's pool
+        bool _movable;
 
         //VkBufferUsageFlags _usages;
         //VmaMemoryUsage _allocationType;
@@ -295,8 +479,16 @@ namespace alloy::vk
         )
             : _desc(desc)
             , _dev(dev)
+            , _allocation(VK_NULL_HANDLE)
+            , _deviceAddress(0)
+            , _movable(false)
         { }
 
+        void _QueryDeviceAddress();
+
+        // Binds a new handle to dst, returns the old one to copy from
+        bool _MoveTo(VmaAllocation dst, VkBuffer& oldHandle);
+
     public:
 
         virtual ~VulkanBuffer();
@@ -310,9 +502,31 @@ namespace alloy::vk
             const IBuffer::Description& desc
         );
 
+        static common::sp<IBuffer> MakePlaced(
+            const common::sp<VulkanDevice>& dev,
+            const common::sp<VulkanMemoryHeap>& heap,
+            std::uint64_t offset,
+            const IBuffer::Description& desc
+        );
+
+        static IMemoryHeap::Placement GetPlacement(
+            VulkanDevice& dev,
+            const IBuffer::Description& desc
+        );
+
+        // Asks a throwaway buffer, false if it can't be created
+        static bool GetMemoryRequirements(
+            VulkanDevice& dev,
+            const IBuffer::Description& desc,
+            VkMemoryRequirements& req
+        );
+
         virtual const Description& GetDesc() const override { return _desc; }
 
         const VkBuffer& GetHandle() const {return _buffer;}
+        VmaAllocation GetAllocation() const { return _allocation; }
+
+        virtual std::uint64_t GetDeviceAddress() const override { return _deviceAddress; }
 
         virtual void* MapToCPU();
 
@@ -364,6 +578,7 @@ namespace alloy::vk
         bool WaitFromCPU(uint64_t expectedValue) {
             return WaitFromCPU(expectedValue, (std::numeric_limits<std::uint32_t>::max)());
         }
+        virtual void OnReached(uint64_t value, ReachedCallback callback) override;
     };
 
 } // namespace alloy
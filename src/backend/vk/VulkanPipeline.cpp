@@ -2,7 +2,9 @@
 
 #include "alloy/common/Common.hpp"
 #include "alloy/Helpers.hpp"
+#include "alloy/common/Trace.hpp"
 
+#include <algorithm>
 #include <vector>
 #include <cassert>
 #include <cstring>
@@ -12,25 +14,10 @@
 #include "VulkanDevice.hpp"
 #include "VulkanShader.hpp"
 #include "VulkanBindableResource.hpp"
+#include "VkPipelineLibrary.hpp"
 
 
 namespace alloy::vk{
-class VkShaderRAII {
-    VulkanDevice* _dev;
-    VkShaderModule _mod;
-public:
-    VkShaderRAII(VulkanDevice* dev) : _dev(dev), _mod(VK_NULL_HANDLE) {}
-    ~VkShaderRAII() {
-        if(_mod != VK_NULL_HANDLE)
-            VK_DEV_CALL(_dev, vkDestroyShaderModule(_dev->LogicalDev(), _mod, nullptr));
-    }
-    VkShaderModule* operator&() {return &_mod;}
-    VkShaderModule operator*() {return _mod;}
-    VkShaderModule Reset() {
-        auto res = _mod;  _mod = VK_NULL_HANDLE; return res;
-    }
-};
-
 class VkPipelineLayoutRAII {
     VulkanDevice* _dev;
     VkPipelineLayout _obj;
@@ -38,9 +25,11 @@ public:
     VkPipelineLayoutRAII(VulkanDevice* dev) : _dev(dev), _obj(VK_NULL_HANDLE) {}
     ~VkPipelineLayoutRAII() {
         if(_obj != VK_NULL_HANDLE)
-            VK_DEV_CALL(_dev, vkDestroyPipelineLayout(_dev->LogicalDev(), _obj, nullptr));
+            _dev->GetObjectCache().ReleasePipelineLayout(_obj);
+    }
+    void Acquire(const VkPipelineLayoutCreateInfo& ci) {
+        _obj = _dev->GetObjectCache().AcquirePipelineLayout(ci);
     }
-    VkPipelineLayout* operator&() {return &_obj;}
     VkPipelineLayout operator*() {return _obj;}
     VkPipelineLayout Reset() {
         auto res = _obj;  _obj = VK_NULL_HANDLE; return res;
@@ -268,8 +257,8 @@ public:
 
 
     VulkanPipelineBase::~VulkanPipelineBase() {
-        VK_DEV_CALL(dev, vkDestroyPipelineLayout(dev->LogicalDev(), _pipelineLayout, nullptr));
-        VK_DEV_CALL(dev, vkDestroyPipeline(dev->LogicalDev(), _devicePipeline, nullptr));
+        dev->DeferDestroy(VK_OBJECT_TYPE_PIPELINE, (uint64_t)_devicePipeline.load());
+        dev->GetObjectCache().ReleasePipelineLayout(_pipelineLayout);
     }
 
     VulkanComputePipeline::~VulkanComputePipeline(){
@@ -277,435 +266,655 @@ public:
     }
 
     VulkanGraphicsPipeline::~VulkanGraphicsPipeline(){
-
+        if(_libraries[0] == VK_NULL_HANDLE) return;
+
+        auto& libs = dev->GetPipelineLibraryCache();
+        libs.CancelRelink(this);
+        if(_fastLinked != VK_NULL_HANDLE)
+            dev->DeferDestroy(VK_OBJECT_TYPE_PIPELINE, (uint64_t)_fastLinked);
+        for(auto lib : _libraries)
+            libs.Release(lib);
     }
 
-    common::sp<IGfxPipeline> VulkanGraphicsPipeline::Make(
-        const common::sp<VulkanDevice>& dev,
-        const GraphicsPipelineDescription& desc
-    )
-    {
-        std::vector<common::sp<common::RefCntBase>> refCnts;
-
-        VkGraphicsPipelineCreateInfo pipelineCI{};
-        pipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-
-        //*************************************************
-        //*************************************************
-        //*************************************************
-        // From Standard creation info ***Makes it work!***
-        //*************************************************
-        //*************************************************
-        //*************************************************
-        // Blend State
-        VkPipelineColorBlendStateCreateInfo blendStateCI{};
-        blendStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        auto attachmentsCount = desc.attachmentState.colorAttachments.size();
-        std::vector<VkPipelineColorBlendAttachmentState> attachments(attachmentsCount);
-        for (int i = 0; i < attachmentsCount; i++)
-        {
-            auto vdDesc = desc.attachmentState.colorAttachments[i];
-            auto& attachmentState = attachments[i];
-            attachmentState.srcColorBlendFactor = VdToVkBlendFactor(vdDesc.sourceColorFactor);
-            attachmentState.dstColorBlendFactor = VdToVkBlendFactor(vdDesc.destinationColorFactor);
-            attachmentState.colorBlendOp = VdToVkBlendOp(vdDesc.colorFunction);
-            attachmentState.srcAlphaBlendFactor = VdToVkBlendFactor(vdDesc.sourceAlphaFactor);
-            attachmentState.dstAlphaBlendFactor = VdToVkBlendFactor(vdDesc.destinationAlphaFactor);
-            attachmentState.alphaBlendOp = VdToVkBlendOp(vdDesc.alphaFunction);
-            attachmentState.colorWriteMask = VdToVkColorWriteMask(vdDesc.colorWriteMask);
-            attachmentState.blendEnable = vdDesc.blendEnabled;
-        }
-
-        blendStateCI.attachmentCount = attachmentsCount;
-        blendStateCI.pAttachments = attachments.data();
-        auto& blendFactor = desc.attachmentState.blendConstant;
-        blendStateCI.blendConstants[0] = blendFactor.r;
-        blendStateCI.blendConstants[1] = blendFactor.g;
-        blendStateCI.blendConstants[2] = blendFactor.b;
-        blendStateCI.blendConstants[3] = blendFactor.a;
-
-        pipelineCI.pColorBlendState = &blendStateCI;
-
-
-        // Rasterizer State
-        auto& rsDesc = desc.rasterizerState;
-        VkPipelineRasterizationStateCreateInfo rsCI{};
-        rsCI.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rsCI.cullMode = VdToVkCullMode(rsDesc.cullMode);
-        rsCI.polygonMode = VdToVkPolygonMode(rsDesc.fillMode);
-
-        //depthClampEnable controls whether to clamp the fragment’s depth values
-        // as described in Depth Test. If the pipeline is not created with
-        //VkPipelineRasterizationDepthClipStateCreateInfoEXT present then enabling
-        //depth clamp will also disable clipping primitives to the z planes of
-        //the frustrum as described in Primitive Clipping. Otherwise depth clipping
-        //is controlled by the state set in VkPipelineRasterizationDepthClipStateCreateInfoEXT.
-
-        rsCI.depthClampEnable = false;
-        VkPipelineRasterizationDepthClipStateCreateInfoEXT rsDepthClipCI{};
-        if(dev->GetVkFeatures().flags.supportsDepthClip) {
-
-            //If the pNext chain of VkPipelineRasterizationStateCreateInfo includes
-            // a VkPipelineRasterizationDepthClipStateCreateInfoEXT structure, then
-            //that structure controls whether depth clipping is enabled or disabled.
-
-            // Provided by VK_EXT_depth_clip_enable
-            //typedef struct VkPipelineRasterizationDepthClipStateCreateInfoEXT {
-            //    VkStructureType                                        sType;
-            //    const void*                                            pNext;
-            //    VkPipelineRasterizationDepthClipStateCreateFlagsEXT    flags;
-            //    VkBool32                                               depthClipEnable;
-            //} VkPipelineRasterizationDepthClipStateCreateInfoEXT;
-            rsDepthClipCI.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_DEPTH_CLIP_STATE_CREATE_INFO_EXT;
-            rsDepthClipCI.pNext = rsCI.pNext;
-            rsCI.pNext = &rsDepthClipCI;
-            rsDepthClipCI.depthClipEnable = rsDesc.depthClipEnabled;
-        }
-
-        rsCI.frontFace = rsDesc.frontFace == RasterizerStateDescription::FrontFace::Clockwise
-            ? VkFrontFace::VK_FRONT_FACE_CLOCKWISE
-            : VkFrontFace::VK_FRONT_FACE_COUNTER_CLOCKWISE;
-        rsCI.lineWidth = 1.f;
-        pipelineCI.pRasterizationState = &rsCI;
-
-        // Dynamic State
-        VkPipelineDynamicStateCreateInfo dynamicStateCI{};
-        dynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-        VkDynamicState dynamicStates[2];
-        dynamicStates[0] = VkDynamicState::VK_DYNAMIC_STATE_VIEWPORT;
-        dynamicStates[1] = VkDynamicState::VK_DYNAMIC_STATE_SCISSOR;
-        dynamicStateCI.dynamicStateCount = 2;
-        dynamicStateCI.pDynamicStates = dynamicStates;
-
-        pipelineCI.pDynamicState = &dynamicStateCI;
-
-        // Depth Stencil State
-        auto& vdDssDesc = desc.depthStencilState;
-        VkPipelineDepthStencilStateCreateInfo dssCI{};
-        dssCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-        dssCI.depthWriteEnable = vdDssDesc.depthWriteEnabled;
-        dssCI.depthTestEnable = vdDssDesc.depthTestEnabled;
-        dssCI.depthCompareOp = VdToVkCompareOp(vdDssDesc.depthComparison);
-        dssCI.stencilTestEnable = vdDssDesc.stencilTestEnabled;
-
-        dssCI.front.failOp = VdToVkStencilOp(vdDssDesc.stencilFront.fail);
-        dssCI.front.passOp = VdToVkStencilOp(vdDssDesc.stencilFront.pass);
-        dssCI.front.depthFailOp = VdToVkStencilOp(vdDssDesc.stencilFront.depthFail);
-        dssCI.front.compareOp = VdToVkCompareOp(vdDssDesc.stencilFront.comparison);
-        dssCI.front.compareMask = vdDssDesc.stencilReadMask;
-        dssCI.front.writeMask = vdDssDesc.stencilWriteMask;
-        dssCI.front.reference = vdDssDesc.stencilReference;
-
-        dssCI.back.failOp = VdToVkStencilOp(vdDssDesc.stencilBack.fail);
-        dssCI.back.passOp = VdToVkStencilOp(vdDssDesc.stencilBack.pass);
-        dssCI.back.depthFailOp = VdToVkStencilOp(vdDssDesc.stencilBack.depthFail);
-        dssCI.back.compareOp = VdToVkCompareOp(vdDssDesc.stencilBack.comparison);
-        dssCI.back.compareMask = vdDssDesc.stencilReadMask;
-        dssCI.back.writeMask = vdDssDesc.stencilWriteMask;
-        dssCI.back.reference = vdDssDesc.stencilReference;
-
-        pipelineCI.pDepthStencilState = &dssCI;
-
-        // Multisample
-        VkPipelineMultisampleStateCreateInfo multisampleCI{};
-        multisampleCI.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        VkSampleCountFlagBits vkSampleCount = VdToVkSampleCount(desc.attachmentState.sampleCount);
-        multisampleCI.rasterizationSamples = vkSampleCount;
-        multisampleCI.alphaToCoverageEnable = desc.attachmentState.alphaToCoverageEnabled;
-        pipelineCI.pMultisampleState = &multisampleCI;
-
-        // Input Assembly
-        VkPipelineInputAssemblyStateCreateInfo inputAssemblyCI{};
-        inputAssemblyCI.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        inputAssemblyCI.topology = VdToVkPrimitiveTopology(desc.primitiveTopology);
-        inputAssemblyCI.primitiveRestartEnable = VK_FALSE;
-        pipelineCI.pInputAssemblyState = &inputAssemblyCI;
-
-        // Pipeline Layout
-        std::vector<VkDescriptorSetLayout> dsls{};
-        std::vector<VkPushConstantRange> pushConstantRanges;
-        
-        if(desc.resourceLayout) {
-            auto resourceLayout = PtrCast<VulkanResourceLayout>(desc.resourceLayout.get());
-            //refCnts.push_back(desc.resourceLayout);
-            const auto& setInfo = resourceLayout->GetResSetInfo();
-            const auto& pcInfo = resourceLayout->GetPushConstants();
-
-            if(!pcInfo.empty()) {
-                pushConstantRanges.emplace_back(
-                    /*stageFlags*/ VK_SHADER_STAGE_ALL_GRAPHICS,
-                    /*offset    */ 0,
-                    /*size      */ resourceLayout->GetPushConstantSize() * 4
-                );
-            }
-            for(auto& s : setInfo) {
-                dsls.push_back(s.layout);
+    namespace {
+
+        // Constants packed for VkSpecializationInfo, shared by every
+        // stage of a pipeline. The translated SPIR-V declares each one as
+        // a 32 bit word, see SpecializationConstantSpace, so smaller types
+        // are passed as their low bytes widened to a word.
+        struct _SpecializationInfo {
+            DISABLE_COPY_AND_ASSIGN(_SpecializationInfo);
+            _SpecializationInfo() = default;
+
+            std::vector<VkSpecializationMapEntry> mapEntries;
+            std::vector<std::uint8_t> data;
+            VkSpecializationInfo info{};
+            // Words the shaders may read, highest id + 1
+            uint32_t wordCnt = 0;
+
+            void Build(std::span<const SpecializationConstant> constants) {
+                for(auto& spec : constants) {
+                    if(GetSpecializationConstantSize(spec.type) > sizeof(uint32_t)) {
+                        assert(false && "64 bit specialization constants aren't supported");
+                        continue;
+                    }
+                    auto& entry = mapEntries.emplace_back();
+                    entry.constantID = spec.id;
+                    entry.offset = (uint32_t)data.size();
+                    entry.size = sizeof(uint32_t);
+                    auto srcData = (const std::uint8_t*)&spec.data;
+                    data.insert(data.end(), srcData, srcData + sizeof(uint32_t));
+                    wordCnt = std::max(wordCnt, spec.id + 1);
+                }
+                info.mapEntryCount = (uint32_t)mapEntries.size();
+                info.pMapEntries = mapEntries.data();
+                info.dataSize = data.size();
+                info.pData = data.data();
             }
-        }
 
-        VkPipelineLayoutCreateInfo pipelineLayoutCI {};
-        pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutCI.setLayoutCount = dsls.size();
-        pipelineLayoutCI.pSetLayouts = dsls.data();
-        pipelineLayoutCI.pushConstantRangeCount = pushConstantRanges.size();
-        pipelineLayoutCI.pPushConstantRanges = pushConstantRanges.data();
+            const VkSpecializationInfo* Get() const {
+                return mapEntries.empty() ? nullptr : &info;
+            }
 
-        VkPipelineLayoutRAII pipelineLayout{dev.get()};
-        VK_CHECK(VK_DEV_CALL(dev,
-            vkCreatePipelineLayout(
-                dev->LogicalDev(), &pipelineLayoutCI, nullptr, &pipelineLayout)));
-        pipelineCI.layout = *pipelineLayout;
+            void WriteKey(_KeyWriter& key) const {
+                key << mapEntries.size();
+                for(auto& e : mapEntries)
+                    key << e.constantID << e.offset << e.size;
+                key << std::string_view((const char*)data.data(), data.size());
+            }
+        };
 
-        // Vertex Input State
-        VkPipelineVertexInputStateCreateInfo vertexInputCI{};
-        vertexInputCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        // Fixed function state of a graphics pipeline, shared by the
+        // whole pipeline and the library path. Create infos point into
+        // the object itself, so it stays where it's built.
+        struct _GfxPipelineState {
+            DISABLE_COPY_AND_ASSIGN(_GfxPipelineState);
+            _GfxPipelineState() = default;
+
+            std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+            VkPipelineColorBlendStateCreateInfo blendStateCI{};
+            VkPipelineRasterizationStateCreateInfo rsCI{};
+            VkPipelineRasterizationDepthClipStateCreateInfoEXT rsDepthClipCI{};
+            DynamicStateDescription dynamic;
+            std::vector<VkDynamicState> dynamicStates;
+            VkPipelineDynamicStateCreateInfo dynamicStateCI{};
+            VkPipelineDepthStencilStateCreateInfo dssCI{};
+            VkPipelineMultisampleStateCreateInfo multisampleCI{};
+            VkPipelineInputAssemblyStateCreateInfo inputAssemblyCI{};
+            std::vector<VkVertexInputBindingDescription> bindingDescs;
+            std::vector<VkVertexInputAttributeDescription> attributeDescs;
+            VkPipelineVertexInputStateCreateInfo vertexInputCI{};
+            SPVRemapper::IAMappingInfo iaMappings;
+            VkPipelineViewportStateCreateInfo viewportStateCI{};
+            std::vector<VkFormat> colorAttachmentFormats;
+            VkPipelineRenderingCreateInfoKHR dynRenderingCI{};
+            _SpecializationInfo specialization;
+
+            void Build(VulkanDevice* dev, const GraphicsPipelineDescription& desc);
+        };
 
-        auto& inputDescriptions = desc.shaderSet.vertexLayouts;
-        auto bindingCount = inputDescriptions.size();
-        unsigned attributeCount = 0;
-        for (int i = 0; i < inputDescriptions.size(); i++)
-        {
-            attributeCount += inputDescriptions[i].elements.size();
-        }
-        std::vector<VkVertexInputBindingDescription> bindingDescs(bindingCount);
-        std::vector<VkVertexInputAttributeDescription> attributeDescs(attributeCount);
+        void _GfxPipelineState::Build(VulkanDevice* dev, const GraphicsPipelineDescription& desc) {
+            // Blend State
+            blendStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+            auto attachmentsCount = desc.attachmentState.colorAttachments.size();
+            blendAttachments.resize(attachmentsCount);
+            for (int i = 0; i < attachmentsCount; i++)
+            {
+                auto vdDesc = desc.attachmentState.colorAttachments[i];
+                auto& attachmentState = blendAttachments[i];
+                attachmentState.srcColorBlendFactor = VdToVkBlendFactor(vdDesc.sourceColorFactor);
+                attachmentState.dstColorBlendFactor = VdToVkBlendFactor(vdDesc.destinationColorFactor);
+                attachmentState.colorBlendOp = VdToVkBlendOp(vdDesc.colorFunction);
+                attachmentState.srcAlphaBlendFactor = VdToVkBlendFactor(vdDesc.sourceAlphaFactor);
+                attachmentState.dstAlphaBlendFactor = VdToVkBlendFactor(vdDesc.destinationAlphaFactor);
+                attachmentState.alphaBlendOp = VdToVkBlendOp(vdDesc.alphaFunction);
+                attachmentState.colorWriteMask = VdToVkColorWriteMask(vdDesc.colorWriteMask);
+                attachmentState.blendEnable = vdDesc.blendEnabled;
+            }
 
-        std::unordered_map<VertexInputSemantic, uint32_t> iaMappings;
+            blendStateCI.attachmentCount = attachmentsCount;
+            blendStateCI.pAttachments = blendAttachments.data();
+            auto& blendFactor = desc.attachmentState.blendConstant;
+            blendStateCI.blendConstants[0] = blendFactor.r;
+            blendStateCI.blendConstants[1] = blendFactor.g;
+            blendStateCI.blendConstants[2] = blendFactor.b;
+            blendStateCI.blendConstants[3] = blendFactor.a;
+
+            // Rasterizer State
+            auto& rsDesc = desc.rasterizerState;
+            rsCI.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+            rsCI.cullMode = VdToVkCullMode(rsDesc.cullMode);
+            rsCI.polygonMode = VdToVkPolygonMode(rsDesc.fillMode);
+
+            //depthClampEnable controls whether to clamp the fragment’s depth values
+            // as described in Depth Test. If the pipeline is not created with
+            //VkPipelineRasterizationDepthClipStateCreateInfoEXT present then enabling
+            //depth clamp will also disable clipping primitives to the z planes of
+            //the frustrum as described in Primitive Clipping. Otherwise depth clipping
+            //is controlled by the state set in VkPipelineRasterizationDepthClipStateCreateInfoEXT.
+
+            rsCI.depthClampEnable = false;
+            if(dev->GetVkFeatures().flags.supportsDepthClip) {
+
+                //If the pNext chain of VkPipelineRasterizationStateCreateInfo includes
+                // a VkPipelineRasterizationDepthClipStateCreateInfoEXT structure, then
+                //that structure controls whether depth clipping is enabled or disabled.
+                rsDepthClipCI.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_DEPTH_CLIP_STATE_CREATE_INFO_EXT;
+                rsDepthClipCI.pNext = rsCI.pNext;
+                rsCI.pNext = &rsDepthClipCI;
+                rsDepthClipCI.depthClipEnable = rsDesc.depthClipEnabled;
+            }
 
-        int targetIndex = 0;
-        int targetLocation = 0;
-        for (int binding = 0; binding < inputDescriptions.size(); binding++)
-        {
-            auto& inputDesc = inputDescriptions[binding];
-            bindingDescs[binding].binding = binding;
-            bindingDescs[binding].inputRate = (inputDesc.instanceStepRate != 0)
-                ? VkVertexInputRate::VK_VERTEX_INPUT_RATE_INSTANCE
-                : VkVertexInputRate::VK_VERTEX_INPUT_RATE_VERTEX;
-            bindingDescs[binding].stride = inputDesc.stride;
-
-            unsigned currentOffset = 0;
-            for (int location = 0; location < inputDesc.elements.size(); location++)
+            rsCI.frontFace = rsDesc.frontFace == RasterizerStateDescription::FrontFace::Clockwise
+                ? VkFrontFace::VK_FRONT_FACE_CLOCKWISE
+                : VkFrontFace::VK_FRONT_FACE_COUNTER_CLOCKWISE;
+            rsCI.lineWidth = 1.f;
+
+            // Depth Stencil State
+            auto& vdDssDesc = desc.depthStencilState;
+            dssCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+            dssCI.depthWriteEnable = vdDssDesc.depthWriteEnabled;
+            dssCI.depthTestEnable = vdDssDesc.depthTestEnabled;
+            dssCI.depthCompareOp = VdToVkCompareOp(vdDssDesc.depthComparison);
+            dssCI.stencilTestEnable = vdDssDesc.stencilTestEnabled;
+
+            dssCI.front.failOp = VdToVkStencilOp(vdDssDesc.stencilFront.fail);
+            dssCI.front.passOp = VdToVkStencilOp(vdDssDesc.stencilFront.pass);
+            dssCI.front.depthFailOp = VdToVkStencilOp(vdDssDesc.stencilFront.depthFail);
+            dssCI.front.compareOp = VdToVkCompareOp(vdDssDesc.stencilFront.comparison);
+            dssCI.front.compareMask = vdDssDesc.stencilReadMask;
+            dssCI.front.writeMask = vdDssDesc.stencilWriteMask;
+            dssCI.front.reference = vdDssDesc.stencilReference;
+
+            dssCI.back.failOp = VdToVkStencilOp(vdDssDesc.stencilBack.fail);
+            dssCI.back.passOp = VdToVkStencilOp(vdDssDesc.stencilBack.pass);
+            dssCI.back.depthFailOp = VdToVkStencilOp(vdDssDesc.stencilBack.depthFail);
+            dssCI.back.compareOp = VdToVkCompareOp(vdDssDesc.stencilBack.comparison);
+            dssCI.back.compareMask = vdDssDesc.stencilReadMask;
+            dssCI.back.writeMask = vdDssDesc.stencilWriteMask;
+            dssCI.back.reference = vdDssDesc.stencilReference;
+
+            // Multisample
+            multisampleCI.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+            multisampleCI.rasterizationSamples = VdToVkSampleCount(desc.attachmentState.sampleCount);
+            multisampleCI.alphaToCoverageEnable = desc.attachmentState.alphaToCoverageEnabled;
+
+            // Input Assembly
+            inputAssemblyCI.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+            inputAssemblyCI.topology = VdToVkPrimitiveTopology(desc.primitiveTopology);
+            inputAssemblyCI.primitiveRestartEnable = VK_FALSE;
+
+            // Vertex Input State
+            vertexInputCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+            auto& inputDescriptions = desc.shaderSet.vertexLayouts;
+            auto bindingCount = inputDescriptions.size();
+            unsigned attributeCount = 0;
+            for (int i = 0; i < inputDescriptions.size(); i++)
             {
-                auto& inputElement = inputDesc.elements[location];
-                auto thisLocation = targetLocation + location;
-
-                iaMappings.insert({inputElement.semantic, thisLocation});
+                attributeCount += inputDescriptions[i].elements.size();
+            }
+            bindingDescs.resize(bindingCount);
+            attributeDescs.resize(attributeCount);
 
-                attributeDescs[targetIndex].format = VdToVkShaderDataType(inputElement.format);
-                attributeDescs[targetIndex].binding = binding;
-                attributeDescs[targetIndex].location = thisLocation;
-                attributeDescs[targetIndex].offset = inputElement.offset != 0
-                    ? inputElement.offset
-                    : currentOffset;
+            int targetIndex = 0;
+            int targetLocation = 0;
+            for (int binding = 0; binding < inputDescriptions.size(); binding++)
+            {
+                auto& inputDesc = inputDescriptions[binding];
+                bindingDescs[binding].binding = binding;
+                bindingDescs[binding].inputRate = (inputDesc.instanceStepRate != 0)
+                    ? VkVertexInputRate::VK_VERTEX_INPUT_RATE_INSTANCE
+                    : VkVertexInputRate::VK_VERTEX_INPUT_RATE_VERTEX;
+                bindingDescs[binding].stride = inputDesc.stride;
+
+                unsigned currentOffset = 0;
+                for (int location = 0; location < inputDesc.elements.size(); location++)
+                {
+                    auto& inputElement = inputDesc.elements[location];
+                    auto thisLocation = targetLocation + location;
+
+                    iaMappings.insert({inputElement.semantic, thisLocation});
+
+                    attributeDescs[targetIndex].format = VdToVkShaderDataType(inputElement.format);
+                    attributeDescs[targetIndex].binding = binding;
+                    attributeDescs[targetIndex].location = thisLocation;
+                    attributeDescs[targetIndex].offset = inputElement.offset != 0
+                        ? inputElement.offset
+                        : currentOffset;
+
+                    targetIndex += 1;
+                    currentOffset += FormatHelpers::GetSizeInBytes(inputElement.format);
+                }
 
-                targetIndex += 1;
-                currentOffset += FormatHelpers::GetSizeInBytes(inputElement.format);
+                targetLocation += inputDesc.elements.size();
             }
 
-            targetLocation += inputDesc.elements.size();
-        }
-
-        vertexInputCI.vertexBindingDescriptionCount = bindingCount;
-        vertexInputCI.pVertexBindingDescriptions = bindingDescs.data();
-        vertexInputCI.vertexAttributeDescriptionCount = attributeCount;
-        vertexInputCI.pVertexAttributeDescriptions = attributeDescs.data();
+            vertexInputCI.vertexBindingDescriptionCount = bindingCount;
+            vertexInputCI.pVertexBindingDescriptions = bindingDescs.data();
+            vertexInputCI.vertexAttributeDescriptionCount = attributeCount;
+            vertexInputCI.pVertexAttributeDescriptions = attributeDescs.data();
+
+            // ViewportState
+            // Vulkan spec specifies that there must be 1 viewport no matter
+            // dynamic viewport state enabled or not...
+            viewportStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+            viewportStateCI.viewportCount = 1;
+            viewportStateCI.scissorCount = 1;
+
+            // Provide information for dynamic rendering
+            colorAttachmentFormats.reserve(desc.attachmentState.colorAttachments.size());
+            for(auto& a : desc.attachmentState.colorAttachments) {
+                colorAttachmentFormats.push_back(VdToVkPixelFormat(a.format, false));
+            }
 
-        pipelineCI.pVertexInputState = &vertexInputCI;
+            dynRenderingCI.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+            dynRenderingCI.colorAttachmentCount = (uint32_t)colorAttachmentFormats.size();
+            dynRenderingCI.pColorAttachmentFormats = colorAttachmentFormats.data();
 
-        // Shader Stage
+            if(desc.attachmentState.depthStencilAttachment.has_value()) {
 
-        //VkSpecializationInfo specializationInfo{};
-        //auto& specDescs = desc.shaderSet.specializations;
-        //if (!specDescs.empty())
-        //{
-        //    unsigned specDataSize = 0;
-        //    for (auto& spec : specDescs) {
-        //        specDataSize += GetSpecializationConstantSize(spec.type);
-        //    }
-        //    std::vector<std::uint8_t> fullSpecData(specDataSize);
-        //    int specializationCount = specDescs.size();
-        //    std::vector<VkSpecializationMapEntry> mapEntries(specializationCount);
-        //    unsigned specOffset = 0;
-        //    for (int i = 0; i < specializationCount; i++)
-        //    {
-        //        auto data = specDescs[i].data;
-        //        auto srcData = (byte*)&data;
-        //        auto dataSize = GetSpecializationConstantSize(specDescs[i].type);
-        //        //Unsafe.CopyBlock(fullSpecData + specOffset, srcData, dataSize);
-        //        memcpy(fullSpecData.data() + specOffset, srcData, dataSize);
-        //        mapEntries[i].constantID = specDescs[i].id;
-        //        mapEntries[i].offset = specOffset;
-        //        mapEntries[i].size = dataSize;
-        //        specOffset += dataSize;
-        //    }
-        //    specializationInfo.dataSize = specDataSize;
-        //    specializationInfo.pData = fullSpecData.data();
-        //    specializationInfo.mapEntryCount = specializationCount;
-        //    specializationInfo.pMapEntries = mapEntries.data();
-        //}
+                PixelFormat depthFormat = desc.attachmentState.depthStencilAttachment->depthStencilFormat;
+                auto vkFormat = VdToVkPixelFormat(depthFormat, true);
+                dynRenderingCI.depthAttachmentFormat  = vkFormat;
+                if(FormatHelpers::IsStencilFormat(depthFormat))
+                    dynRenderingCI.stencilAttachmentFormat = vkFormat;
+            }
 
-        SPVRemapper remapper {
-            PtrCast<VulkanResourceLayout>(desc.resourceLayout.get()),
-            &iaMappings
-        };
-        //alloy::vk::SPVRemapper remapper{
-        //    [&iaMappings](auto& d3dIn, auto& vkOut) -> bool {
-        //        VertexInputSemantic d3dSemantic {};
-        //        VertexInputSemantic::Name d3dSemanticName;
-        //        if(!Str2Semantic(d3dIn.semantic, d3dSemanticName))
-        //            return false;
-        //
-        //        d3dSemantic.name = d3dSemanticName;
-        //        d3dSemantic.slot = d3dIn.semantic_index;
-        //
-        //        auto findRes = iaMappings.find(d3dSemantic);
-        //        if(findRes == iaMappings.end())
-        //            return false;
-        //        vkOut.location = findRes->second;
-        //
-        //        return true;
-        //    }
-        //};
+            // Dynamic State
+            dynamicStates = {
+                VkDynamicState::VK_DYNAMIC_STATE_VIEWPORT,
+                VkDynamicState::VK_DYNAMIC_STATE_SCISSOR,
+            };
 
-        VkShaderRAII vs{dev.get()}, fs{dev.get()};
+            // Values of dynamic states are reset, so pipelines differing
+            // only in those end up with the same library parts.
+            dynamic = desc.dynamicStates;
+            assert(!dynamic.Any() || dev->GetVkFeatures().flags.supportsExtendedDynamicState);
 
-        VkPipelineShaderStageCreateInfo stageCIs[2] = {};
+            if(dynamic.cullMode) {
+                dynamicStates.push_back(VK_DYNAMIC_STATE_CULL_MODE_EXT);
+                rsCI.cullMode = VK_CULL_MODE_NONE;
+            }
 
-        {
-            auto& shader = desc.shaderSet.vertexShader;
-            auto vkShader = PtrCast<VulkanShader>(shader.get());
-            auto dxil = vkShader->GetByteCode();
+            if(dynamic.depthTest) {
+                dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT);
+                dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT);
+                dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT);
+                dssCI.depthTestEnable = VK_FALSE;
+                dssCI.depthWriteEnable = VK_FALSE;
+                dssCI.depthCompareOp = VK_COMPARE_OP_NEVER;
+            }
 
-            alloy::vk::ConverterCompilerArgs compiler_args{};
-            compiler_args.shaderStage = VK_SHADER_STAGE_VERTEX_BIT;
-            compiler_args.entryPoint = shader->GetDesc().entryPoint;
-            if(desc.resourceLayout) {
-                auto resourceLayout = PtrCast<VulkanResourceLayout>(desc.resourceLayout.get());
-                compiler_args.root_constant_words =  resourceLayout->GetPushConstantSize();
+            if(dynamic.primitiveTopology) {
+                // Only the topology class is baked
+                dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT);
+                switch(inputAssemblyCI.topology) {
+                    case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+                        break;
+                    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+                    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+                        inputAssemblyCI.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+                        break;
+                    default:
+                        inputAssemblyCI.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+                        break;
+                }
             }
 
-            remapper.SetStage(alloy::IShader::Stage::Vertex);
+            if(dynamic.stencilOp) {
+                dynamicStates.push_back(VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT);
+                dynamicStates.push_back(VK_DYNAMIC_STATE_STENCIL_OP_EXT);
+                dssCI.stencilTestEnable = VK_FALSE;
+                for(auto* op : { &dssCI.front, &dssCI.back }) {
+                    op->failOp = VK_STENCIL_OP_KEEP;
+                    op->passOp = VK_STENCIL_OP_KEEP;
+                    op->depthFailOp = VK_STENCIL_OP_KEEP;
+                    op->compareOp = VK_COMPARE_OP_NEVER;
+                }
+            }
 
-            alloy::vk::SPIRVBlob spvBlob;
-            auto cvtRes = alloy::vk::DXIL2SPV(*dev, dxil, compiler_args, remapper, spvBlob);
-            VK_ASSERT(cvtRes == alloy::vk::ShaderConverterResult::Success);
+            if(dynamic.blendEnable) {
+                assert(dev->GetVkFeatures().flags.supportsDynamicBlendEnable);
+                dynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+                for(auto& a : blendAttachments)
+                    a.blendEnable = VK_FALSE;
+            }
 
-            VkShaderModuleCreateInfo shaderModuleCI {};
-            shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            shaderModuleCI.codeSize = spvBlob.code.size();
-            shaderModuleCI.pCode = (const uint32_t*)spvBlob.code.data();
-            VK_CHECK(VK_DEV_CALL(dev,
-                vkCreateShaderModule(dev->LogicalDev(), &shaderModuleCI, nullptr, &vs)));
+            dynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+            dynamicStateCI.dynamicStateCount = (uint32_t)dynamicStates.size();
+            dynamicStateCI.pDynamicStates = dynamicStates.data();
 
-            stageCIs[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-            stageCIs[0].module = *vs;
-            stageCIs[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-            // stageCI.pName = CommonStrings.main; // Meh
-            stageCIs[0].pName = "main";//Don't have a way to convince dxil-spv to change this name
+            specialization.Build(desc.shaderSet.specializations);
         }
 
-        {
-            auto& shader = desc.shaderSet.fragmentShader;
+        // Stage from the shader's translated module. Vertex stage outputs
+        // are left in the remapper for the fragment stage.
+        void _CreateGfxStage(
+            const GraphicsPipelineDescription& desc,
+            const common::sp<IShader>& shader,
+            IShader::Stage stage,
+            VkShaderStageFlagBits vkStage,
+            SPVRemapper& remapper,
+            const _SpecializationInfo& specialization,
+            VkPipelineShaderStageCreateInfo& stageCI
+        ) {
             auto vkShader = PtrCast<VulkanShader>(shader.get());
-            auto dxil = vkShader->GetByteCode();
 
             alloy::vk::ConverterCompilerArgs compiler_args{};
-            compiler_args.shaderStage = VK_SHADER_STAGE_FRAGMENT_BIT;
+            compiler_args.shaderStage = vkStage;
             compiler_args.entryPoint = shader->GetDesc().entryPoint;
             if(desc.resourceLayout) {
                 auto resourceLayout = PtrCast<VulkanResourceLayout>(desc.resourceLayout.get());
                 compiler_args.root_constant_words =  resourceLayout->GetPushConstantSize();
             }
+            compiler_args.spec_constant_words = specialization.wordCnt;
 
-            remapper.SetStage(alloy::IShader::Stage::Fragment);
+            remapper.SetStage(stage);
 
-            alloy::vk::SPIRVBlob spvBlob;
-            auto cvtRes = alloy::vk::DXIL2SPV(*dev, dxil, compiler_args, remapper, spvBlob);
-            VK_ASSERT(cvtRes == alloy::vk::ShaderConverterResult::Success);
+            stageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stageCI.module = vkShader->GetModule(compiler_args, remapper, desc.resourceLayout);
+            stageCI.stage = vkStage;
+            stageCI.pName = "main";//Don't have a way to convince dxil-spv to change this name
+            stageCI.pSpecializationInfo = specialization.Get();
+        }
 
-            VkShaderModuleCreateInfo shaderModuleCI {};
-            shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            shaderModuleCI.codeSize = spvBlob.code.size();//Although pCode is uint32_t*, this is byte size
-            shaderModuleCI.pCode = (const uint32_t*)spvBlob.code.data();
+        VkPipeline _CreateGfxLibrary(
+            VulkanDevice* dev,
+            VkGraphicsPipelineLibraryFlagsEXT part,
+            VkGraphicsPipelineCreateInfo& pipelineCI
+        ) {
+            VkGraphicsPipelineLibraryCreateInfoEXT libraryCI{};
+            libraryCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+            libraryCI.pNext = pipelineCI.pNext;
+            libraryCI.flags = part;
+            pipelineCI.pNext = &libraryCI;
+            pipelineCI.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR
+                              | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+            VkPipeline library;
             VK_CHECK(VK_DEV_CALL(dev,
-                vkCreateShaderModule(dev->LogicalDev(), &shaderModuleCI, nullptr, &fs)));
-
-            stageCIs[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-            stageCIs[1].module = *fs;
-            stageCIs[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-            // stageCI.pName = CommonStrings.main; // Meh
-            stageCIs[1].pName = "main";//Don't have a way to convince dxil-spv to change this name
+                vkCreateGraphicsPipelines(
+                    dev->LogicalDev(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &library)));
+            return library;
+        }
 
+        VkPipeline _LinkGfxLibraries(
+            VulkanDevice* dev,
+            const std::array<VkPipeline, 4>& libraries,
+            VkPipelineLayout layout,
+            bool optimize
+        ) {
+            VkPipelineLibraryCreateInfoKHR linkCI{};
+            linkCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+            linkCI.libraryCount = libraries.size();
+            linkCI.pLibraries = libraries.data();
+
+            VkGraphicsPipelineCreateInfo pipelineCI{};
+            pipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            pipelineCI.pNext = &linkCI;
+            pipelineCI.layout = layout;
+            if(optimize)
+                pipelineCI.flags = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+
+            VkPipeline pipeline;
+            VK_CHECK(VK_DEV_CALL(dev,
+                vkCreateGraphicsPipelines(
+                    dev->LogicalDev(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pipeline)));
+            return pipeline;
         }
 
-        pipelineCI.stageCount = 2;
-        pipelineCI.pStages = stageCIs;
+        // Acquires the four parts from the library cache. Keys only hold
+        // the state each part consumes, dynamic states by flag only. Every
+        // part gets the whole dynamic state list, states outside a part
+        // are ignored.
+        void _AcquireGfxLibraries(
+            VulkanDevice* dev,
+            const GraphicsPipelineDescription& desc,
+            _GfxPipelineState& state,
+            VkPipelineLayout layout,
+            std::array<VkPipeline, 4>& libraries
+        ) {
+            auto& cache = dev->GetPipelineLibraryCache();
+            auto* resourceLayout = PtrCast<VulkanResourceLayout>(desc.resourceLayout.get());
+            auto& vs = desc.shaderSet.vertexShader;
+            auto& fs = desc.shaderSet.fragmentShader;
 
-        // ViewportState
-        // Vulkan spec specifies that there must be 1 viewport no matter
-        // dynamic viewport state enabled or not...
-        VkPipelineViewportStateCreateInfo viewportStateCI{};
-        viewportStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        viewportStateCI.viewportCount = 1;
-        viewportStateCI.scissorCount = 1;
+            {
+                _KeyWriter key {'i'};
+                key << state.vertexInputCI.vertexBindingDescriptionCount;
+                for(auto& b : state.bindingDescs)
+                    key << b.binding << b.stride << b.inputRate;
+                key << state.vertexInputCI.vertexAttributeDescriptionCount;
+                for(auto& a : state.attributeDescs)
+                    key << a.location << a.binding << a.format << a.offset;
+                key << state.inputAssemblyCI.topology << state.inputAssemblyCI.primitiveRestartEnable
+                    << state.dynamic.primitiveTopology;
+
+                libraries[0] = cache.Acquire(key.Take(), [&]() {
+                    VkGraphicsPipelineCreateInfo pipelineCI{};
+                    pipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+                    pipelineCI.pVertexInputState = &state.vertexInputCI;
+                    pipelineCI.pInputAssemblyState = &state.inputAssemblyCI;
+                    pipelineCI.pDynamicState = &state.dynamicStateCI;
+
+                    _VkPipelineLibraryCache::CreateResult res{};
+                    res.handle = _CreateGfxLibrary(
+                        dev, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, pipelineCI);
+                    return res;
+                }).handle;
+            }
 
-        pipelineCI.pViewportState = &viewportStateCI;
+            _VkPipelineLibraryCache::Library preRaster;
+            {
+                // Vertex inputs are remapped by semantic
+                _KeyWriter key {'r'};
+                key << _HandleBits(layout) << _HandleBits(resourceLayout) << _HandleBits(vs.get());
+                for(auto& l : desc.shaderSet.vertexLayouts) {
+                    key << l.elements.size();
+                    for(auto& e : l.elements)
+                        key << e.semantic.name << e.semantic.slot;
+                }
+                key << state.rsCI.polygonMode << state.rsCI.cullMode << state.rsCI.frontFace
+                    << state.rsCI.depthClampEnable << state.rsCI.lineWidth
+                    << (state.rsCI.pNext != nullptr) << state.rsDepthClipCI.depthClipEnable
+                    << state.dynamic.cullMode;
+                state.specialization.WriteKey(key);
+
+                preRaster = cache.Acquire(key.Take(), [&]() {
+                    SPVRemapper remapper { resourceLayout, &state.iaMappings };
+                    VkPipelineShaderStageCreateInfo stageCI{};
+                    _CreateGfxStage(desc, vs, IShader::Stage::Vertex, VK_SHADER_STAGE_VERTEX_BIT,
+                                    remapper, state.specialization, stageCI);
+
+                    VkGraphicsPipelineCreateInfo pipelineCI{};
+                    pipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+                    pipelineCI.layout = layout;
+                    pipelineCI.stageCount = 1;
+                    pipelineCI.pStages = &stageCI;
+                    pipelineCI.pViewportState = &state.viewportStateCI;
+                    pipelineCI.pRasterizationState = &state.rsCI;
+                    pipelineCI.pDynamicState = &state.dynamicStateCI;
+
+                    _VkPipelineLibraryCache::CreateResult res{};
+                    res.handle = _CreateGfxLibrary(
+                        dev, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, pipelineCI);
+                    res.refs = { vs, desc.resourceLayout };
+                    res.stageOutputs = remapper.GetStageIO();
+                    return res;
+                });
+                libraries[1] = preRaster.handle;
+            }
 
+            {
+                // Fragment inputs link against the vertex shader outputs
+                _KeyWriter key {'f'};
+                key << _HandleBits(layout) << _HandleBits(resourceLayout)
+                    << _HandleBits(vs.get()) << _HandleBits(fs.get());
+                const auto& d = state.dssCI;
+                key << d.depthTestEnable << d.depthWriteEnable << d.depthCompareOp
+                    << d.stencilTestEnable;
+                for(auto* op : { &d.front, &d.back })
+                    key << op->failOp << op->passOp << op->depthFailOp << op->compareOp
+                        << op->compareMask << op->writeMask << op->reference;
+                key << state.multisampleCI.rasterizationSamples
+                    << state.multisampleCI.alphaToCoverageEnable
+                    << state.dynamic.depthTest << state.dynamic.stencilOp;
+                state.specialization.WriteKey(key);
+
+                libraries[2] = cache.Acquire(key.Take(), [&]() {
+                    SPVRemapper remapper { resourceLayout, &state.iaMappings };
+                    remapper.SetStageIO(*preRaster.stageOutputs);
+                    VkPipelineShaderStageCreateInfo stageCI{};
+                    _CreateGfxStage(desc, fs, IShader::Stage::Fragment, VK_SHADER_STAGE_FRAGMENT_BIT,
+                                    remapper, state.specialization, stageCI);
+
+                    VkGraphicsPipelineCreateInfo pipelineCI{};
+                    pipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+                    pipelineCI.layout = layout;
+                    pipelineCI.stageCount = 1;
+                    pipelineCI.pStages = &stageCI;
+                    pipelineCI.pDepthStencilState = &state.dssCI;
+                    pipelineCI.pMultisampleState = &state.multisampleCI;
+                    pipelineCI.pDynamicState = &state.dynamicStateCI;
+
+                    _VkPipelineLibraryCache::CreateResult res{};
+                    res.handle = _CreateGfxLibrary(
+                        dev, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, pipelineCI);
+                    res.refs = { vs, fs, desc.resourceLayout };
+                    return res;
+                }).handle;
+            }
 
+            {
+                _KeyWriter key {'o'};
+                key << state.blendStateCI.attachmentCount;
+                for(auto& a : state.blendAttachments)
+                    key << a.blendEnable
+                        << a.srcColorBlendFactor << a.dstColorBlendFactor << a.colorBlendOp
+                        << a.srcAlphaBlendFactor << a.dstAlphaBlendFactor << a.alphaBlendOp
+                        << a.colorWriteMask;
+                for(auto c : state.blendStateCI.blendConstants)
+                    key << c;
+                key << state.multisampleCI.rasterizationSamples
+                    << state.multisampleCI.alphaToCoverageEnable;
+                for(auto f : state.colorAttachmentFormats)
+                    key << f;
+                key << state.dynRenderingCI.depthAttachmentFormat
+                    << state.dynRenderingCI.stencilAttachmentFormat
+                    << state.dynamic.blendEnable;
+
+                libraries[3] = cache.Acquire(key.Take(), [&]() {
+                    VkGraphicsPipelineCreateInfo pipelineCI{};
+                    pipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+                    pipelineCI.pNext = &state.dynRenderingCI;
+                    pipelineCI.pColorBlendState = &state.blendStateCI;
+                    pipelineCI.pMultisampleState = &state.multisampleCI;
+                    pipelineCI.pDynamicState = &state.dynamicStateCI;
+
+                    _VkPipelineLibraryCache::CreateResult res{};
+                    res.handle = _CreateGfxLibrary(
+                        dev, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, pipelineCI);
+                    return res;
+                }).handle;
+            }
+        }
+    }
 
-        // Create fake RenderPass for compatibility.
+    common::sp<IGfxPipeline> VulkanGraphicsPipeline::Make(
+        const common::sp<VulkanDevice>& dev,
+        const GraphicsPipelineDescription& desc
+    )
+    {
+        VLD_TRACE_ZONE("VulkanGraphicsPipeline::Make");
 
-        //We have dynamic rendering now
-        //auto compatRenderPass = CreateFakeRenderPassForCompat(dev.get(), outputDesc, VK_SAMPLE_COUNT_1_BIT);
-        //auto compatRenderPass = CreateFakeRenderPassForCompat(dev.get(), outputDesc, vkSampleCount);
-        //pipelineCI.renderPass = compatRenderPass;
+        std::vector<common::sp<common::RefCntBase>> refCnts;
 
-        // Provide information for dynamic rendering
-        std::vector<VkFormat> colorAttachmentFormats{};
-        colorAttachmentFormats.reserve(desc.attachmentState.colorAttachments.size());
+        _GfxPipelineState state;
+        state.Build(dev.get(), desc);
 
-        for(auto& a : desc.attachmentState.colorAttachments) {
-            auto f = a.format;
-            colorAttachmentFormats.push_back(VdToVkPixelFormat(f, false));
-        }
+        // Pipeline Layout
+        std::vector<VkDescriptorSetLayout> dsls{};
+        std::vector<VkPushConstantRange> pushConstantRanges;
+        
+        if(desc.resourceLayout) {
+            auto resourceLayout = PtrCast<VulkanResourceLayout>(desc.resourceLayout.get());
+            //refCnts.push_back(desc.resourceLayout);
+            const auto& pcInfo = resourceLayout->GetPushConstants();
 
-        VkPipelineRenderingCreateInfoKHR dynRenderingCI{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
-            .pNext                   = nullptr,
-            .colorAttachmentCount    = (uint32_t)colorAttachmentFormats.size(),
-            .pColorAttachmentFormats = colorAttachmentFormats.data(),
-        };
+            if(!pcInfo.empty()) {
+                // Matches the shaders' block, DXIL2SPV strips the
+                // specialization constant words from it
+                pushConstantRanges.emplace_back(
+                    /*stageFlags*/ VK_SHADER_STAGE_ALL_GRAPHICS,
+                    /*offset    */ 0,
+                    /*size      */ resourceLayout->GetPushConstantSize() * 4
+                );
+            }
+            dsls = resourceLayout->GetSetLayouts();
+        }
 
-        if(desc.attachmentState.depthStencilAttachment.has_value()) {
+        VkPipelineLayoutCreateInfo pipelineLayoutCI {};
+        pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCI.setLayoutCount = dsls.size();
+        pipelineLayoutCI.pSetLayouts = dsls.data();
+        pipelineLayoutCI.pushConstantRangeCount = pushConstantRanges.size();
+        pipelineLayoutCI.pPushConstantRanges = pushConstantRanges.data();
 
-            PixelFormat depthFormat = desc.attachmentState.depthStencilAttachment->depthStencilFormat;
-            auto vkFormat = VdToVkPixelFormat(depthFormat, true);
-            dynRenderingCI.depthAttachmentFormat  = vkFormat;
-            if(FormatHelpers::IsStencilFormat(depthFormat))
-                dynRenderingCI.stencilAttachmentFormat = vkFormat;
-        }
-        // Use the pNext to point to the rendering create struct
-        pipelineCI.pNext               = &dynRenderingCI; // reference the new dynamic structure
-        pipelineCI.renderPass          = nullptr; // previously required non-null
+        VkPipelineLayoutRAII pipelineLayout{dev.get()};
+        pipelineLayout.Acquire(pipelineLayoutCI);
 
         VkPipeline devicePipeline;
-        VK_CHECK(VK_DEV_CALL(dev,
-            vkCreateGraphicsPipelines(
-                dev->LogicalDev(),
-                VK_NULL_HANDLE,
-                1,
-                &pipelineCI,
-                nullptr,
-                &devicePipeline)));
-
-        //auto vkVertShader = reinterpret_cast<VulkanShader*>(shaders[0].get());
-        //auto vkFragShader = reinterpret_cast<VulkanShader*>(shaders[1].get());
+        std::array<VkPipeline, 4> libraries {};
+
+        if(dev->GetVkFeatures().flags.supportsGraphicsPipelineLibrary) {
+            // Shared parts, fast-linked now and relinked optimized later
+            _AcquireGfxLibraries(dev.get(), desc, state, *pipelineLayout, libraries);
+            devicePipeline = _LinkGfxLibraries(dev.get(), libraries, *pipelineLayout, false);
+        } else {
+            VkGraphicsPipelineCreateInfo pipelineCI{};
+            pipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            pipelineCI.pColorBlendState = &state.blendStateCI;
+            pipelineCI.pRasterizationState = &state.rsCI;
+            pipelineCI.pDynamicState = &state.dynamicStateCI;
+            pipelineCI.pDepthStencilState = &state.dssCI;
+            pipelineCI.pMultisampleState = &state.multisampleCI;
+            pipelineCI.pInputAssemblyState = &state.inputAssemblyCI;
+            pipelineCI.pVertexInputState = &state.vertexInputCI;
+            pipelineCI.pViewportState = &state.viewportStateCI;
+            pipelineCI.layout = *pipelineLayout;
+
+            // Shader Stage
+            SPVRemapper remapper {
+                PtrCast<VulkanResourceLayout>(desc.resourceLayout.get()),
+                &state.iaMappings
+            };
+
+            VkPipelineShaderStageCreateInfo stageCIs[2] = {};
+
+            _CreateGfxStage(desc, desc.shaderSet.vertexShader,
+                            IShader::Stage::Vertex, VK_SHADER_STAGE_VERTEX_BIT,
+                            remapper, state.specialization, stageCIs[0]);
+            _CreateGfxStage(desc, desc.shaderSet.fragmentShader,
+                            IShader::Stage::Fragment, VK_SHADER_STAGE_FRAGMENT_BIT,
+                            remapper, state.specialization, stageCIs[1]);
+
+            pipelineCI.stageCount = 2;
+            pipelineCI.pStages = stageCIs;
+
+            // Use the pNext to point to the rendering create struct
+            pipelineCI.pNext               = &state.dynRenderingCI; // reference the new dynamic structure
+            pipelineCI.renderPass          = nullptr; // previously required non-null
 
-        //_CreateStandardPipeline(dev->LogicalDev(),
-        //    vkVertShader->GetHandle(), vkFragShader->GetHandle(),
-        //    640,480, compatRenderPass,
-        //    pipelineLayout, devicePipeline
-        //    );
+            VK_CHECK(VK_DEV_CALL(dev,
+                vkCreateGraphicsPipelines(
+                    dev->LogicalDev(),
+                    VK_NULL_HANDLE,
+                    1,
+                    &pipelineCI,
+                    nullptr,
+                    &devicePipeline)));
+        }
 
         std::uint32_t resourceSetCount = dsls.size();
         std::uint32_t dynamicOffsetsCount = 0;
@@ -719,7 +928,7 @@ public:
         rawPipe->_devicePipeline = devicePipeline;
         rawPipe->_pipelineLayout = pipelineLayout.Reset();
         //rawPipe->_renderPass = compatRenderPass;
-        rawPipe->scissorTestEnabled = rsDesc.scissorTestEnabled;
+        rawPipe->scissorTestEnabled = desc.rasterizerState.scissorTestEnabled;
         rawPipe->resourceSetCount = resourceSetCount;
         rawPipe->dynamicOffsetsCount = dynamicOffsetsCount;
         if(desc.resourceLayout) {
@@ -727,10 +936,19 @@ public:
             rawPipe->pushConstants = resourceLayout->GetPushConstants();
         }
         rawPipe->_refCnts = std::move(refCnts);
+        rawPipe->_libraries = libraries;
+
+        if(libraries[0] != VK_NULL_HANDLE)
+            dev->GetPipelineLibraryCache().RequestRelink(rawPipe);
 
         return common::sp(rawPipe);
     }
 
+    void VulkanGraphicsPipeline::RelinkOptimized() {
+        auto optimized = _LinkGfxLibraries(dev.get(), _libraries, _pipelineLayout, true);
+        _fastLinked = _devicePipeline.exchange(optimized, std::memory_order_acq_rel);
+    }
+
 
 
     common::sp<IComputePipeline> VulkanComputePipeline::Make(
@@ -748,19 +966,18 @@ public:
         if(desc.resourceLayout) {
             auto resourceLayout = PtrCast<VulkanResourceLayout>(desc.resourceLayout.get());
             //refCnts.push_back(desc.resourceLayout);
-            const auto& setInfo = resourceLayout->GetResSetInfo();
             const auto& pcInfo = resourceLayout->GetPushConstants();
 
             if(!pcInfo.empty()) {
+                // Matches the shaders' block, DXIL2SPV strips the
+                // specialization constant words from it
                 pushConstantRanges.emplace_back(
                     /*stageFlags*/ VK_SHADER_STAGE_COMPUTE_BIT,
                     /*offset    */ 0,
                     /*size      */ resourceLayout->GetPushConstantSize() * 4
                 );
             }
-            for(auto& s : setInfo) {
-                dsls.push_back(s.layout);
-            }
+            dsls = resourceLayout->GetSetLayouts();
         }
 
         VkPipelineLayoutCreateInfo pipelineLayoutCI {};
@@ -771,79 +988,42 @@ public:
         pipelineLayoutCI.pPushConstantRanges = pushConstantRanges.data();
 
         VkPipelineLayoutRAII pipelineLayout{dev.get()};
-        VK_CHECK(VK_DEV_CALL(dev,
-            vkCreatePipelineLayout(
-                dev->LogicalDev(), &pipelineLayoutCI, nullptr, &pipelineLayout)));
+        pipelineLayout.Acquire(pipelineLayoutCI);
         pipelineCI.layout = *pipelineLayout;
 
         // Shader Stage
 
-        //VkSpecializationInfo specializationInfo;
-        //auto& specDescs = desc.specializations;
-        //if (!specDescs.empty())
-        //{
-        //    unsigned specDataSize = 0;
-        //    for(auto& spec : specDescs)
-        //    {
-        //        specDataSize += GetSpecializationConstantSize(spec->type);
-        //    }
-        //    std::vector<std::uint8_t> fullSpecData(specDataSize);
-        //    unsigned specializationCount = specDescs.size();
-        //    std::vector<VkSpecializationMapEntry> mapEntries(specializationCount);
-        //    unsigned specOffset = 0;
-        //    for (int i = 0; i < specializationCount; i++)
-        //    {
-        //        auto data = specDescs[i]->data;
-        //        byte* srcData = (byte*)&data;
-        //        unsigned dataSize = GetSpecializationConstantSize(specDescs[i]->type);
-        //        memcpy(fullSpecData.data() + specOffset, srcData, dataSize);
-        //        mapEntries[i].constantID = specDescs[i]->id;
-        //        mapEntries[i].offset = specOffset;
-        //        mapEntries[i].size = dataSize;
-        //        specOffset += dataSize;
-        //    }
-        //    specializationInfo.dataSize = specDataSize;
-        //    specializationInfo.pData = fullSpecData.data();
-        //    specializationInfo.mapEntryCount = specializationCount;
-        //    specializationInfo.pMapEntries = mapEntries.data();
-        //}
+        _SpecializationInfo specialization;
+        specialization.Build(desc.specializations);
 
         SPVRemapper remapper {
             PtrCast<VulkanResourceLayout>(desc.resourceLayout.get()),
             nullptr
         };
 
-        VkShaderRAII cs{dev.get()};
-
         VkPipelineShaderStageCreateInfo& stageCI = pipelineCI.stage;
 
         {
             auto& shader = desc.computeShader;
             auto vkShader = PtrCast<VulkanShader>(shader.get());
-            auto dxil = vkShader->GetByteCode();
 
             alloy::vk::ConverterCompilerArgs compiler_args{};
             compiler_args.shaderStage = VK_SHADER_STAGE_COMPUTE_BIT;
             compiler_args.entryPoint = shader->GetDesc().entryPoint;
+            if(desc.resourceLayout) {
+                auto resourceLayout = PtrCast<VulkanResourceLayout>(desc.resourceLayout.get());
+                compiler_args.root_constant_words =  resourceLayout->GetPushConstantSize();
+            }
+            compiler_args.spec_constant_words = specialization.wordCnt;
 
             remapper.SetStage(alloy::IShader::Stage::Compute);
 
-            alloy::vk::SPIRVBlob spvBlob;
-            auto cvtRes = alloy::vk::DXIL2SPV(*dev, dxil, compiler_args, remapper, spvBlob);
-            VK_ASSERT(cvtRes == alloy::vk::ShaderConverterResult::Success);
-
-            VkShaderModuleCreateInfo shaderModuleCI {};
-            shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            shaderModuleCI.codeSize = spvBlob.code.size();
-            shaderModuleCI.pCode = (const uint32_t*)spvBlob.code.data();
-            VK_CHECK(VK_DEV_CALL(dev,
-                vkCreateShaderModule(dev->LogicalDev(), &shaderModuleCI, nullptr, &cs)));
-
             stageCI.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-            stageCI.module = *cs;
+            stageCI.module = vkShader->GetModule(compiler_args, remapper, desc.resourceLayout);
             stageCI.stage = VK_SHADER_STAGE_COMPUTE_BIT;
             // stageCI.pName = CommonStrings.main; // Meh
             stageCI.pName = "main";//Don't have a way to convince dxil-spv to change this name
+            stageCI.pSpecializationInfo = specialization.Get();
         }
 
 
@@ -1015,19 +1195,18 @@ public:
         if(desc.resourceLayout) {
             auto resourceLayout = PtrCast<VulkanResourceLayout>(desc.resourceLayout.get());
             //refCnts.push_back(desc.resourceLayout);
-            const auto& setInfo = resourceLayout->GetResSetInfo();
             const auto& pcInfo = resourceLayout->GetPushConstants();
 
             if(!pcInfo.empty()) {
+                // Matches the shaders' block, DXIL2SPV strips the
+                // specialization constant words from it
                 pushConstantRanges.emplace_back(
                     /*stageFlags*/ VK_SHADER_STAGE_ALL_GRAPHICS,
                     /*offset    */ 0,
                     /*size      */ resourceLayout->GetPushConstantSize() * 4
                 );
             }
-            for(auto& s : setInfo) {
-                dsls.push_back(s.layout);
-            }
+            dsls = resourceLayout->GetSetLayouts();
         }
 
         VkPipelineLayoutCreateInfo pipelineLayoutCI {};
@@ -1038,9 +1217,7 @@ public:
         pipelineLayoutCI.pPushConstantRanges = pushConstantRanges.data();
 
         VkPipelineLayoutRAII pipelineLayout{dev.get()};
-        VK_CHECK(VK_DEV_CALL(dev,
-            vkCreatePipelineLayout(
-                dev->LogicalDev(), &pipelineLayoutCI, nullptr, &pipelineLayout)));
+        pipelineLayout.Acquire(pipelineLayoutCI);
         pipelineCI.layout = *pipelineLayout;
 
         // Vertex Input State
@@ -1101,36 +1278,8 @@ public:
 
         // Shader Stage
 
-        //VkSpecializationInfo specializationInfo{};
-        //auto& specDescs = desc.shaderSet.specializations;
-        //if (!specDescs.empty())
-        //{
-        //    unsigned specDataSize = 0;
-        //    for (auto& spec : specDescs) {
-        //        specDataSize += GetSpecializationConstantSize(spec.type);
-        //    }
-        //    std::vector<std::uint8_t> fullSpecData(specDataSize);
-        //    int specializationCount = specDescs.size();
-        //    std::vector<VkSpecializationMapEntry> mapEntries(specializationCount);
-        //    unsigned specOffset = 0;
-        //    for (int i = 0; i < specializationCount; i++)
-        //    {
-        //        auto data = specDescs[i].data;
-        //        auto srcData = (byte*)&data;
-        //        auto dataSize = GetSpecializationConstantSize(specDescs[i].type);
-        //        //Unsafe.CopyBlock(fullSpecData + specOffset, srcData, dataSize);
-        //        memcpy(fullSpecData.data() + specOffset, srcData, dataSize);
-        //        mapEntries[i].constantID = specDescs[i].id;
-        //        mapEntries[i].offset = specOffset;
-        //        mapEntries[i].size = dataSize;
-        //        specOffset += dataSize;
-        //    }
-        //    specializationInfo.dataSize = specDataSize;
-        //    specializationInfo.pData = fullSpecData.data();
-        //    specializationInfo.mapEntryCount = specializationCount;
-        //    specializationInfo.pMapEntries = mapEntries.data();
-        //}
-        //
+        _SpecializationInfo specialization;
+        specialization.Build(desc.specializations);
 
         //#TODO: revisit dxil-spv remapper for mesh shaders
         SPVRemapper remapper {
@@ -1138,17 +1287,14 @@ public:
             nullptr
         };
 
-        VkShaderRAII shaderMods[3] { {dev.get()}, {dev.get()}, {dev.get()}};
         pipelineCI.stageCount = 0;
         VkPipelineShaderStageCreateInfo stageCIs[3] = {};
 
 
         auto _CreateShaderStageCI = [&](const common::sp<IShader>& shader, IShader::Stage stage) {
             auto slot = pipelineCI.stageCount++;
-            auto& mod = shaderMods[slot];
             auto& ci = stageCIs[slot];
             auto vkShader = PtrCast<VulkanShader>(shader.get());
-            auto dxil = vkShader->GetByteCode();
 
             alloy::vk::ConverterCompilerArgs compiler_args{};
             compiler_args.shaderStage = VdToVkShaderStageSingle(stage);
@@ -1157,26 +1303,17 @@ public:
                 auto resourceLayout = PtrCast<VulkanResourceLayout>(desc.resourceLayout.get());
                 compiler_args.root_constant_words =  resourceLayout->GetPushConstantSize();
             }
+            compiler_args.spec_constant_words = specialization.wordCnt;
 
             //#TODO: revisit dxil-spv remapper for mesh shaders
             remapper.SetStage(stage);
 
-            alloy::vk::SPIRVBlob spvBlob;
-            auto cvtRes = alloy::vk::DXIL2SPV(*dev, dxil, compiler_args, remapper, spvBlob);
-            VK_ASSERT(cvtRes == alloy::vk::ShaderConverterResult::Success);
-
-            VkShaderModuleCreateInfo shaderModuleCI {};
-            shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            shaderModuleCI.codeSize = spvBlob.code.size();
-            shaderModuleCI.pCode = (const uint32_t*)spvBlob.code.data();
-            VK_CHECK(VK_DEV_CALL(dev,
-                vkCreateShaderModule(dev->LogicalDev(), &shaderModuleCI, nullptr, &mod)));
-
             ci.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-            ci.module = *mod;
+            ci.module = vkShader->GetModule(compiler_args, remapper, desc.resourceLayout);
             ci.stage = VdToVkShaderStageSingle(stage);
             // stageCI.pName = CommonStrings.main; // Meh
             ci.pName = "main";//Don't have a way to convince dxil-spv to change this name
+            ci.pSpecializationInfo = specialization.Get();
         };
 
         if(desc.taskShader) {
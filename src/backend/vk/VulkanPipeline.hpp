@@ -8,6 +8,8 @@
 
 #include "VulkanBindableResource.hpp"
 
+#include <array>
+#include <atomic>
 #include <vector>
 
 
@@ -23,7 +25,8 @@ namespace alloy::vk
         std::vector<VulkanResourceLayout::PushConstantInfo> pushConstants;
 
         VkPipelineLayout _pipelineLayout;
-        VkPipeline _devicePipeline;
+        // Swapped by the pipeline library worker once relinked
+        std::atomic<VkPipeline> _devicePipeline;
 
         std::uint32_t resourceSetCount;
         std::uint32_t dynamicOffsetsCount;
@@ -132,7 +135,7 @@ namespace alloy::vk
     public:
         virtual ~VulkanPipelineBase();
 
-        const VkPipeline& GetHandle() const {return _devicePipeline;}
+        VkPipeline GetHandle() const {return _devicePipeline.load(std::memory_order_acquire);}
         const VkPipelineLayout& GetLayout() const { return _pipelineLayout; }
         std::uint32_t GetResourceSetCount() const { return resourceSetCount; }
         std::uint32_t GetDynamicOffsetCount() const {return dynamicOffsetsCount;}
@@ -166,6 +169,13 @@ namespace alloy::vk
 
         bool scissorTestEnabled;
 
+        // Vertex input, pre-rasterization, fragment shader and fragment
+        // output parts. Null when compiled as a whole.
+        std::array<VkPipeline, 4> _libraries {};
+        // Fast-linked handle replaced by the optimized one. Command lists
+        // recorded before the swap may still use it.
+        VkPipeline _fastLinked = VK_NULL_HANDLE;
+
         VulkanGraphicsPipeline(
             const common::sp<VulkanDevice>& dev
         ) : VulkanPipelineBase(dev){}
@@ -179,6 +189,9 @@ namespace alloy::vk
             const GraphicsPipelineDescription& desc
         );
 
+        // Called from the pipeline library worker
+        void RelinkOptimized();
+
     };
 
 
@@ -160,16 +160,43 @@ VkPipelineStageFlags vk_stage_flags_from_alloy_barrier(
                 const auto& texDesc = thisTex->GetDesc();
                 auto& barrier = texBarriers.emplace_back(VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
 
-                stagesBefore |= vk_stage_flags_from_alloy_barrier(
-                    barrierDesc.from.stages, barrierDesc.from.access);
-                stagesAfter |= vk_stage_flags_from_alloy_barrier(
-                    barrierDesc.to.stages, barrierDesc.to.access);
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                auto& transfer = barrierDesc.queueTransfer;
+                if(transfer.srcQueue && transfer.dstQueue) {
+                    auto srcFamily = common::PtrCast<VulkanCommandQueue>(transfer.srcQueue)->GetQueueFamily();
+                    auto dstFamily = common::PtrCast<VulkanCommandQueue>(transfer.dstQueue)->GetQueueFamily();
+                    if(srcFamily != dstFamily) {
+                        barrier.srcQueueFamilyIndex = srcFamily;
+                        barrier.dstQueueFamilyIndex = dstFamily;
+                    }
+                }
+
+                bool isRelease = barrier.srcQueueFamilyIndex != barrier.dstQueueFamilyIndex
+                    && barrier.srcQueueFamilyIndex == cmdBuf->GetQueueFamily();
+                bool isAcquire = barrier.srcQueueFamilyIndex != barrier.dstQueueFamilyIndex
+                    && barrier.dstQueueFamilyIndex == cmdBuf->GetQueueFamily();
+
+                // The other queue's half of an ownership transfer may use
+                // stages this queue doesn't support, leave it out.
+                if(isAcquire) {
+                    stagesBefore |= VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                } else {
+                    stagesBefore |= vk_stage_flags_from_alloy_barrier(
+                        barrierDesc.from.stages, barrierDesc.from.access);
+                }
+                if(isRelease) {
+                    stagesAfter |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+                } else {
+                    stagesAfter |= vk_stage_flags_from_alloy_barrier(
+                        barrierDesc.to.stages, barrierDesc.to.access);
+                }
 
                 _PopulateBarrierAccess(barrierDesc.from.access, barrierDesc.to.access, barrier);
+                if(isAcquire) barrier.srcAccessMask = 0;
+                if(isRelease) barrier.dstAccessMask = 0;
                 barrier.oldLayout = AlToVkTexLayout(barrierDesc.from.layout);
                 barrier.newLayout = AlToVkTexLayout(barrierDesc.to.layout);
-                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
                 barrier.image = thisTex->GetHandle();
 
                 auto& aspectMask = barrier.subresourceRange.aspectMask;
@@ -89,4 +89,40 @@ namespace alloy::vk
     common::sp<IEvent> VulkanResourceFactory::CreateSyncEvent() {
        return VulkanFence::Make(_CreateNewDevHandle());
     }
+
+    common::sp<IMemoryHeap> VulkanResourceFactory::CreateMemoryHeap(
+        const IMemoryHeap::Description& description
+    ) {
+        return VulkanMemoryHeap::Make(_CreateNewDevHandle(), description);
+    }
+
+    IMemoryHeap::Placement VulkanResourceFactory::GetPlacement(
+        const IBuffer::Description& description
+    ) {
+        return VulkanBuffer::GetPlacement(*GetBase(), description);
+    }
+
+    IMemoryHeap::Placement VulkanResourceFactory::GetPlacement(
+        const ITexture::Description& description
+    ) {
+        return VulkanTexture::GetPlacement(*GetBase(), description);
+    }
+
+    common::sp<IBuffer> VulkanResourceFactory::CreatePlacedBuffer(
+        const common::sp<IMemoryHeap>& heap,
+        std::uint64_t offset,
+        const IBuffer::Description& description
+    ) {
+        auto vkHeap = PtrCast<VulkanMemoryHeap>(heap.get());
+        return VulkanBuffer::MakePlaced(_CreateNewDevHandle(), RefRawPtr(vkHeap), offset, description);
+    }
+
+    common::sp<ITexture> VulkanResourceFactory::CreatePlacedTexture(
+        const common::sp<IMemoryHeap>& heap,
+        std::uint64_t offset,
+        const ITexture::Description& description
+    ) {
+        auto vkHeap = PtrCast<VulkanMemoryHeap>(heap.get());
+        return VulkanTexture::MakePlaced(_CreateNewDevHandle(), RefRawPtr(vkHeap), offset, description);
+    }
 } // namespace alloy
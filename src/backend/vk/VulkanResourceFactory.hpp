@@ -60,6 +60,23 @@ namespace alloy::vk{
 
         //virtual sp<Fence> CreateFence() override;
         virtual common::sp<IEvent> CreateSyncEvent() override;
+
+        virtual common::sp<IMemoryHeap> CreateMemoryHeap(
+            const IMemoryHeap::Description& description) override;
+
+        virtual IMemoryHeap::Placement GetPlacement(
+            const IBuffer::Description& description) override;
+        virtual IMemoryHeap::Placement GetPlacement(
+            const ITexture::Description& description) override;
+
+        virtual common::sp<IBuffer> CreatePlacedBuffer(
+            const common::sp<IMemoryHeap>& heap,
+            std::uint64_t offset,
+            const IBuffer::Description& description) override;
+        virtual common::sp<ITexture> CreatePlacedTexture(
+            const common::sp<IMemoryHeap>& heap,
+            std::uint64_t offset,
+            const ITexture::Description& description) override;
     };
 
 }
@@ -1,10 +1,18 @@
 #include "VulkanShader.hpp"
 
+#include "alloy/common/Trace.hpp"
+
 #include "VulkanDevice.hpp"
 #include "VkCommon.hpp"
 #include "VulkanBindableResource.hpp"
+#include "VkObjectCache.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <format>
+#include <map>
+#include <tuple>
+#include <unordered_set>
 
 namespace alloy::vk
 {
@@ -70,6 +78,7 @@ namespace alloy::vk
     )
         : layout(layout)
         , iaMappings(iaMappings)
+        , specConstantBase(0)
     { }
     
     bool SPVRemapper::FindVkBindingSet(
@@ -233,6 +242,17 @@ namespace alloy::vk
     bool SPVRemapper::RemapCBV( const dxil_spv_d3d_binding& binding,
                             dxil_spv_cbv_vulkan_binding& vk_binding
     ) {
+        // Read as root constants, promoted to specialization constants
+        // once translated
+        if(binding.register_space == SpecializationConstantSpace
+            && binding.register_index == 0
+        ) {
+            vk_binding = {};
+            vk_binding.push_constant = DXIL_SPV_TRUE;
+            vk_binding.vulkan.push_constant.offset_in_words = specConstantBase;
+            return true;
+        }
+
         // shouldn't trigger remapping when no layout provided
         if(!layout) {
             assert(false && "Can't remap a shader using pipelines that have no resource layout");
@@ -472,12 +492,260 @@ namespace alloy::vk
         return true;
     }
     
+    namespace _SpvEnc {
+        enum : uint32_t {
+            HeaderWords = 5,
+            BoundWord = 3,
+            OpName = 5,
+            OpMemberName = 6,
+            OpEntryPoint = 15,
+            OpTypeVoid = 19,
+            OpTypeInt = 21,
+            OpTypeStruct = 30,
+            OpTypePointer = 32,
+            OpTypeForwardPointer = 39,
+            OpConstant = 43,
+            OpSpecConstant = 50,
+            OpFunction = 54,
+            OpVariable = 59,
+            OpLoad = 61,
+            OpStore = 62,
+            OpAccessChain = 65,
+            OpInBoundsAccessChain = 66,
+            OpDecorate = 71,
+            OpMemberDecorate = 72,
+            OpCopyObject = 83,
+            OpBitcast = 124,
+            StorageClassPushConstant = 9,
+            DecorationSpecId = 1,
+        };
+    }
+
+    // Drops the words in [firstWord, firstWord + wordCnt) from the end of
+    // dxil-spirv's root constant block, one uint member per word, so the
+    // block matches the pipeline layout's push constant range of firstWord
+    // words. Without any word left the block variable goes. False if
+    // something still reads the dropped words or the block has another
+    // shape.
+    static bool StripRootConstantWords(
+        std::vector<uint32_t>& words,
+        uint32_t firstWord,
+        uint32_t wordCnt
+    ) {
+        using namespace _SpvEnc;
+
+        std::unordered_set<uint32_t> int32Types;
+        std::unordered_map<uint32_t, uint32_t> intConstants;
+        std::unordered_map<uint32_t, uint32_t> pointeeOfPtr;
+        std::unordered_map<uint32_t, uint32_t> structMemberCnt;
+        uint32_t var = 0;
+        uint32_t block = 0;
+
+        for(size_t i = HeaderWords; i < words.size();) {
+            uint32_t op = words[i] & 0xFFFF;
+            uint32_t len = words[i] >> 16;
+            if(len == 0 || i + len > words.size()) return false;
+
+            if(op == OpTypeInt && len == 4 && words[i + 2] == 32)
+                int32Types.insert(words[i + 1]);
+            else if(op == OpConstant && len == 4 && int32Types.contains(words[i + 1]))
+                intConstants[words[i + 2]] = words[i + 3];
+            else if(op == OpTypeStruct)
+                structMemberCnt[words[i + 1]] = len - 2;
+            else if(op == OpTypePointer && len == 4 && words[i + 2] == StorageClassPushConstant)
+                pointeeOfPtr[words[i + 1]] = words[i + 3];
+            else if(op == OpVariable && len >= 4 && words[i + 3] == StorageClassPushConstant) {
+                // dxil-spirv declares a single root constant block
+                if(var) return false;
+                var = words[i + 2];
+                auto pointee = pointeeOfPtr.find(words[i + 1]);
+                if(pointee == pointeeOfPtr.end()) return false;
+                block = pointee->second;
+            }
+            else if(var && (op == OpAccessChain || op == OpInBoundsAccessChain)
+                    && len >= 5 && words[i + 3] == var) {
+                auto idx = intConstants.find(words[i + 4]);
+                if(idx == intConstants.end() || idx->second >= firstWord) return false;
+            }
+            else if(var && (op == OpLoad || op == OpCopyObject) && len >= 4 && words[i + 3] == var)
+                return false;
+            else if(var && op == OpStore && len >= 3 && words[i + 1] == var)
+                return false;
+            i += len;
+        }
+
+        // Never read, dxil-spirv didn't declare it
+        if(!var) return true;
+        if(structMemberCnt[block] != firstWord + wordCnt) return false;
+
+        std::vector<uint32_t> out(words.begin(), words.begin() + HeaderWords);
+        out.reserve(words.size());
+        for(size_t i = HeaderWords; i < words.size();) {
+            uint32_t op = words[i] & 0xFFFF;
+            uint32_t len = words[i] >> 16;
+            auto first = words.begin() + i;
+            i += len;
+
+            if(firstWord == 0) {
+                if(op == OpVariable && first[2] == var) continue;
+                if((op == OpName || op == OpDecorate) && first[1] == var) continue;
+                if(op == OpEntryPoint) {
+                    // Interface ids follow the null terminated name
+                    uint32_t nameEnd = 3;
+                    while(nameEnd < len && (first[nameEnd] >> 24) != 0) nameEnd++;
+                    std::vector<uint32_t> entry(first, first + nameEnd + 1);
+                    for(uint32_t k = nameEnd + 1; k < len; k++)
+                        if(first[k] != var) entry.push_back(first[k]);
+                    entry[0] = uint32_t(entry.size()) << 16 | op;
+                    out.insert(out.end(), entry.begin(), entry.end());
+                    continue;
+                }
+                // The unused struct and pointer types are left in place,
+                // decorations included
+            }
+            else if(op == OpTypeStruct && first[1] == block) {
+                out.push_back((2 + firstWord) << 16 | op);
+                out.insert(out.end(), first + 1, first + 2 + firstWord);
+                continue;
+            }
+            else if((op == OpMemberDecorate || op == OpMemberName)
+                && first[1] == block && first[2] >= firstWord) {
+                continue;
+            }
+
+            out.insert(out.end(), first, first + len);
+        }
+
+        words = std::move(out);
+        return true;
+    }
+
+    // dxil-spirv reads root constant N as
+    //   %ptr = OpAccessChain %_ptr_PushConstant_uint %registers %uint_N
+    //   %val = OpLoad %uint %ptr
+    // Loads of the words in [firstWord, firstWord + wordCnt) become copies
+    // of a specialization constant with SpecId N - firstWord, their access
+    // chains are dropped. The words are then stripped from the block. False
+    // if the module reads them in another shape, it would read past the
+    // pipeline layout's push constant range.
+    static bool PromoteRootConstantsToSpecConstants(
+        std::vector<uint8_t>& code,
+        uint32_t firstWord,
+        uint32_t wordCnt
+    ) {
+        using namespace _SpvEnc;
+
+        std::vector<uint32_t> in(code.size() / sizeof(uint32_t));
+        memcpy(in.data(), code.data(), in.size() * sizeof(uint32_t));
+        if(in.size() < HeaderWords) return false;
+
+        std::unordered_set<uint32_t> int32Types;
+        std::unordered_map<uint32_t, uint32_t> intConstants;
+        std::unordered_set<uint32_t> pushConstantVars;
+        // Access chain -> SpecId
+        std::unordered_map<uint32_t, uint32_t> chains;
+        struct SpecConstant {
+            uint32_t type;
+            uint32_t id;
+        };
+        // Ordered so the output doesn't depend on hashing
+        std::map<uint32_t, SpecConstant> specConstants;
+
+        for(size_t i = HeaderWords; i < in.size();) {
+            uint32_t op = in[i] & 0xFFFF;
+            uint32_t len = in[i] >> 16;
+            if(len == 0 || i + len > in.size()) return false;
+
+            if(op == OpTypeInt && len == 4 && in[i + 2] == 32)
+                int32Types.insert(in[i + 1]);
+            else if(op == OpConstant && len == 4 && int32Types.contains(in[i + 1]))
+                intConstants[in[i + 2]] = in[i + 3];
+            else if(op == OpVariable && len >= 4 && in[i + 3] == StorageClassPushConstant)
+                pushConstantVars.insert(in[i + 2]);
+            else if((op == OpAccessChain || op == OpInBoundsAccessChain) && len == 5
+                    && pushConstantVars.contains(in[i + 3])) {
+                auto idx = intConstants.find(in[i + 4]);
+                if(idx != intConstants.end()
+                    && idx->second >= firstWord && idx->second - firstWord < wordCnt)
+                    chains[in[i + 2]] = idx->second - firstWord;
+            }
+            else if(op == OpLoad && len >= 4) {
+                auto chain = chains.find(in[i + 3]);
+                if(chain != chains.end())
+                    specConstants.try_emplace(chain->second, SpecConstant{ in[i + 1], 0 });
+            }
+            i += len;
+        }
+
+        std::vector<uint32_t> out;
+        if(specConstants.empty()) {
+            out = std::move(in);
+        }
+        else {
+            auto bound = in[BoundWord];
+            for(auto& [_, spec] : specConstants)
+                spec.id = bound++;
+
+            out.assign(in.begin(), in.begin() + HeaderWords);
+            out.reserve(in.size() + specConstants.size() * 8);
+            out[BoundWord] = bound;
+
+            bool decorated = false;
+            bool declared = false;
+            for(size_t i = HeaderWords; i < in.size();) {
+                uint32_t op = in[i] & 0xFFFF;
+                uint32_t len = in[i] >> 16;
+
+                // Annotations end where the first type is declared
+                if(!decorated && op >= OpTypeVoid && op <= OpTypeForwardPointer) {
+                    for(auto& [specId, spec] : specConstants)
+                        out.insert(out.end(), { 4u << 16 | OpDecorate, spec.id, DecorationSpecId, specId });
+                    decorated = true;
+                }
+                // After every type, before any function
+                if(!declared && op == OpFunction) {
+                    for(auto& [_, spec] : specConstants)
+                        out.insert(out.end(), { 4u << 16 | OpSpecConstant, spec.type, spec.id, 0u });
+                    declared = true;
+                }
+
+                if((op == OpAccessChain || op == OpInBoundsAccessChain) && chains.contains(in[i + 2])) {
+                    i += len;
+                    continue;
+                }
+                if(op == OpLoad) {
+                    auto chain = chains.find(in[i + 3]);
+                    if(chain != chains.end()) {
+                        // Words are uint, a load of another 32 bit type
+                        // reinterprets them
+                        auto& spec = specConstants.at(chain->second);
+                        auto copyOp = spec.type == in[i + 1] ? OpCopyObject : OpBitcast;
+                        out.insert(out.end(), { 4u << 16 | copyOp, in[i + 1], in[i + 2], spec.id });
+                        i += len;
+                        continue;
+                    }
+                }
+
+                out.insert(out.end(), in.begin() + i, in.begin() + i + len);
+                i += len;
+            }
+            if(!decorated || !declared) return false;
+        }
+
+        if(!StripRootConstantWords(out, firstWord, wordCnt)) return false;
+
+        code.resize(out.size() * sizeof(uint32_t));
+        memcpy(code.data(), out.data(), code.size());
+        return true;
+    }
+
     ShaderConverterResult DXIL2SPV(VulkanDevice& device,
                                    const std::span<uint8_t>& dxil,
                                    const ConverterCompilerArgs& compiler_args,
                                    SPVRemapper& remapper,
                                    SPIRVBlob& spirv) {
-        
+        VLD_TRACE_ZONE("DXIL2SPV");
+
         const auto& devLimit = device.GetAdapter().GetAdapterInfo().limits;
         
         //dxil_spv_converter converter = nullptr;
@@ -554,10 +822,12 @@ namespace alloy::vk
             
             dxil_spv_converter_set_entry_point(converter.converter, compiler_args.entryPoint.c_str());
 
-            uint32_t root_constant_words = compiler_args.root_constant_words;
+            uint32_t root_constant_words = compiler_args.root_constant_words
+                                         + compiler_args.spec_constant_words;
             uint32_t num_root_descriptors = 0; /*One for srv_uav_cbv_combined, one for samplers*/
 
             dxil_spv_converter_set_root_constant_word_count(converter.converter, root_constant_words);
+            remapper.SetSpecConstantBase(compiler_args.root_constant_words);
             //dxil_spv_converter_set_root_descriptor_count(converter.converter, num_root_descriptors);
             dxil_spv_converter_set_srv_remapper(converter.converter, SPVRemapper_RemapSRV, &remapper);
             dxil_spv_converter_set_sampler_remapper(converter.converter, SPVRemapper_RemapSampler, &remapper);
@@ -604,6 +874,16 @@ namespace alloy::vk
                 memcpy(spirv.code.data(), compiled.data, compiled.size);
             }
 
+            // The pipeline layout's push constant range doesn't cover them
+            if(compiler_args.spec_constant_words
+                && !PromoteRootConstantsToSpecConstants(spirv.code,
+                    compiler_args.root_constant_words, compiler_args.spec_constant_words))
+            {
+                ret = VKD3D_ERROR_NOT_IMPLEMENTED;
+                assert(false);
+                break;
+            }
+
             dxil_spv_converter_get_compute_workgroup_dimensions(converter.converter,
                     &spirv.meta.cs_workgroup_size[0],
                     &spirv.meta.cs_workgroup_size[1],
@@ -655,6 +935,69 @@ namespace alloy::vk
 
     VulkanShader::~VulkanShader(){
         //vkDestroyShaderModule(_Dev()->LogicalDev(), _shaderModule, nullptr);
+        for(auto& [_, m] : _modules)
+            VK_DEV_CALL(_dev, vkDestroyShaderModule(_dev->LogicalDev(), m.handle, nullptr));
+    }
+
+    VkShaderModule VulkanShader::GetModule(
+        const ConverterCompilerArgs& args,
+        SPVRemapper& remapper,
+        const common::sp<IResourceLayout>& layout
+    ) {
+        assert(layout.get() == nullptr
+            || PtrCast<VulkanResourceLayout>(layout.get()) == remapper.GetLayout());
+
+        _KeyWriter key {'m'};
+        key << args.shaderStage << args.root_constant_words << args.spec_constant_words
+            << _HandleBits(layout.get());
+
+        // Unordered maps, sorted so equal interfaces give equal keys
+        if(auto* ia = remapper.GetIAMappings()) {
+            std::vector<std::tuple<uint32_t, VertexInputSemantic::Name, uint32_t>> inputs;
+            for(auto& [semantic, location] : *ia)
+                inputs.emplace_back(location, semantic.name, semantic.slot);
+            std::sort(inputs.begin(), inputs.end());
+            key << inputs.size();
+            for(auto& [location, name, slot] : inputs)
+                key << location << name << slot;
+        }
+
+        std::vector<const SPVRemapper::StageIOMap::value_type*> stageIO;
+        for(auto& io : remapper.GetStageIO())
+            stageIO.push_back(&io);
+        std::sort(stageIO.begin(), stageIO.end(),
+            [](auto* a, auto* b) { return a->first < b->first; });
+        key << stageIO.size();
+        for(auto* io : stageIO) {
+            auto& info = io->second;
+            key << io->first << info.semanticName << info.semanticIndex
+                << info.vk_location << info.vk_component << info.vk_flags;
+        }
+
+        auto moduleKey = key.Take();
+
+        std::scoped_lock lk{_m_modules};
+        auto it = _modules.find(moduleKey);
+        if(it != _modules.end()) {
+            remapper.SetStageIO(it->second.stageIO);
+            return it->second.handle;
+        }
+
+        SPIRVBlob spvBlob;
+        auto cvtRes = DXIL2SPV(*_dev, _il, args, remapper, spvBlob);
+        VK_ASSERT(cvtRes == ShaderConverterResult::Success);
+
+        VkShaderModuleCreateInfo shaderModuleCI {};
+        shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        shaderModuleCI.codeSize = spvBlob.code.size();//Although pCode is uint32_t*, this is byte size
+        shaderModuleCI.pCode = (const uint32_t*)spvBlob.code.data();
+
+        VkShaderModule module;
+        VK_CHECK(VK_DEV_CALL(_dev,
+            vkCreateShaderModule(_dev->LogicalDev(), &shaderModuleCI, nullptr, &module)));
+
+        _modules.emplace(std::move(moduleKey), _CachedModule{ module, remapper.GetStageIO(), layout });
+        return module;
     }
 
     common::sp<IShader> VulkanShader::Make(
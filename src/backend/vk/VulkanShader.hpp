@@ -10,6 +10,7 @@
 #include <unordered_map>
 #include <span>
 #include <functional>
+#include <mutex>
 
 #include "alloy/Pipeline.hpp"
 
@@ -69,6 +70,9 @@ namespace alloy::vk {
 
         //std::vector<vkd3d_shader_parameter> parameters;
         uint32_t root_constant_words;
+        // Words of the SpecializationConstantSpace buffer, read as root
+        // constants past root_constant_words and promoted to SpecIds
+        uint32_t spec_constant_words;
         bool dual_source_blending;
         const unsigned int *output_swizzles;
         unsigned int output_swizzle_count;
@@ -87,8 +91,6 @@ namespace alloy::vk {
     public:         
         using IAMappingInfo = std::unordered_map<VertexInputSemantic, uint32_t>;
 
-    protected:
-
         struct ShaderStageIOInfo {
             std::string semanticName;
             unsigned int semanticIndex;
@@ -97,13 +99,19 @@ namespace alloy::vk {
             unsigned int vk_flags;
         };
 
+        using StageIOMap = std::unordered_map<std::string, ShaderStageIOInfo>;
+
+    protected:
+
         IShader::Stage currentStage;
 
-        std::unordered_map<std::string, ShaderStageIOInfo> shaderStageIoMap;
+        StageIOMap shaderStageIoMap;
 
 
         const VulkanResourceLayout* layout;
         const IAMappingInfo* iaMappings;
+        // Root constant word the specialization constants start at
+        uint32_t specConstantBase;
         //RemapFn _remapFn;
 
 
@@ -124,6 +132,15 @@ namespace alloy::vk {
         virtual ~SPVRemapper() { }
 
         void SetStage(IShader::Stage stage) {currentStage = stage;}
+        void SetSpecConstantBase(uint32_t word) { specConstantBase = word; }
+
+        const VulkanResourceLayout* GetLayout() const { return layout; }
+        const IAMappingInfo* GetIAMappings() const { return iaMappings; }
+
+        // Outputs captured from the previous stage, matched against the
+        // inputs of the next one
+        const StageIOMap& GetStageIO() const { return shaderStageIoMap; }
+        void SetStageIO(const StageIOMap& io) { shaderStageIoMap = io; }
 
         virtual bool RemapSRV( const dxil_spv_d3d_binding& binding,
                               dxil_spv_srv_vulkan_binding& vk_binding
@@ -177,6 +194,18 @@ namespace alloy::vk {
         std::vector<std::uint8_t> _il;
         //VkShaderModule ShaderModule => _shaderModule;
 
+        struct _CachedModule {
+            VkShaderModule handle;
+            // Remapper stage IO after translating
+            SPVRemapper::StageIOMap stageIO;
+            // Keyed by pointer, keep it alive
+            common::sp<IResourceLayout> layout;
+        };
+
+        // Translations per pipeline interface
+        std::unordered_map<std::string, _CachedModule> _modules;
+        std::mutex _m_modules;
+
         VulkanShader(
             const common::sp<VulkanDevice>& dev,
             const Description& desc,
@@ -193,6 +222,16 @@ namespace alloy::vk {
 
         virtual const std::span<uint8_t> GetByteCode() override { return _il; }
 
+        // Translates the DXIL for the interface given by args, layout and
+        // remapper, or reuses an earlier translation for the same one, so
+        // pipelines differing only in specialization constants skip it.
+        // Leaves the remapper stage IO as translating would. The module
+        // lives as long as the shader.
+        VkShaderModule GetModule(
+            const ConverterCompilerArgs& args,
+            SPVRemapper& remapper,
+            const common::sp<IResourceLayout>& layout);
+
         ~VulkanShader();
 
         static common::sp<IShader> Make(
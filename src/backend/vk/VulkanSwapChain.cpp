@@ -40,8 +40,7 @@ namespace alloy::vk
         //}
 #endif
         for(auto& fb : _fbs){
-            _dev->GetFnTable().vkDestroyImageView(
-                _dev->LogicalDev(), fb.colorTgtView, nullptr);
+            _dev->GetObjectCache().ReleaseImageView(fb.colorTgtView);
         }
 
         _fbs.clear();
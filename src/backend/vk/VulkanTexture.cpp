@@ -2,6 +2,7 @@
 
 #include "alloy/common/Macros.h"
 #include "alloy/common/Common.hpp"
+#include "alloy/common/Trace.hpp"
 #include "alloy/Helpers.hpp"
 
 #include "VkCommon.hpp"
@@ -12,23 +13,15 @@ namespace alloy::vk {
     
     VulkanTexture::~VulkanTexture() {
         if(IsOwnTexture()){
-            vmaDestroyImage(_dev->Allocator(), _img, _allocation);
+            _dev->DeferDestroy(VK_OBJECT_TYPE_IMAGE, (uint64_t)_img, _allocation);
         }
     }
 
-	common::sp<ITexture> VulkanTexture::Make(const common::sp<VulkanDevice>& dev, 
-                                             const ITexture::Description& desc)
-	{
-        //_gd = gd;
-        //_width = description.Width;
-        //_height = description.Height;
-        //_depth = description.Depth;
-        //MipLevels = description.MipLevels;
-        //ArrayLayers = description.ArrayLayers;
+    static VkImageCreateInfo _GetImageCreateInfo(const ITexture::Description& desc) {
         bool isCubemap = desc.usage.cubemap;
         auto actualImageArrayLayers = isCubemap
-            ? 6 * desc.arrayLayers
-            : desc.arrayLayers;
+        ? 6 * desc.arrayLayers
+        : desc.arrayLayers;
         //_format = description.Format;
         //Usage = description.Usage;
         //Type = description.Type;
@@ -37,29 +30,44 @@ namespace alloy::vk {
 
         bool isHostVisible = desc.hostAccess != HostAccess::None;
 
-            VkImageCreateInfo imageCI{};
-            imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-            imageCI.mipLevels = desc.mipLevels;
-            imageCI.arrayLayers = actualImageArrayLayers;
-            imageCI.imageType = VdToVkTextureType(desc.type);
-            imageCI.extent.width = desc.width;
-            imageCI.extent.height = desc.height;
-            imageCI.extent.depth = desc.depth;
-            imageCI.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
-            imageCI.usage = VdToVkTextureUsage(desc.usage);
-
-            // #TODO: Ditch mapped texture altogether. Move towards dedicated transfer queue
-            // Make all textures host invisible?
-            imageCI.tiling = isHostVisible ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
-
-            imageCI.format = VdToVkPixelFormat(desc.format, desc.usage.depthStencil);
-            imageCI.flags = VkImageCreateFlagBits::VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
-
-            imageCI.samples = VdToVkSampleCount(desc.sampleCount);
-            if (isCubemap)
-            {
-                imageCI.flags |= VkImageCreateFlagBits::VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-            }
+        VkImageCreateInfo imageCI{};
+        imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCI.mipLevels = desc.mipLevels;
+        imageCI.arrayLayers = actualImageArrayLayers;
+        imageCI.imageType = VdToVkTextureType(desc.type);
+        imageCI.extent.width = desc.width;
+        imageCI.extent.height = desc.height;
+        imageCI.extent.depth = desc.depth;
+        imageCI.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
+        imageCI.usage = VdToVkTextureUsage(desc.usage);
+
+        // #TODO: Ditch mapped texture altogether. Move towards dedicated transfer queue
+        // Make all textures host invisible?
+        imageCI.tiling = isHostVisible ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
+
+        imageCI.format = VdToVkPixelFormat(desc.format, desc.usage.depthStencil);
+        imageCI.flags = VkImageCreateFlagBits::VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+
+        imageCI.samples = VdToVkSampleCount(desc.sampleCount);
+        if (isCubemap)
+        {
+            imageCI.flags |= VkImageCreateFlagBits::VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+        }
+
+        return imageCI;
+    }
+
+	common::sp<ITexture> VulkanTexture::Make(const common::sp<VulkanDevice>& dev, 
+                                             const ITexture::Description& desc)
+	{
+        VLD_TRACE_ZONE("VulkanTexture::Make");
+        //_gd = gd;
+        //_width = description.Width;
+        //_height = description.Height;
+        //_depth = description.Depth;
+        //MipLevels = description.MipLevels;
+        //ArrayLayers = description.ArrayLayers;
+        auto imageCI = _GetImageCreateInfo(desc);
 
             auto& allocator = dev->Allocator();
             //allocator
@@ -98,6 +106,8 @@ namespace alloy::vk {
             auto res = vmaCreateImage(allocator, &imageCI, &allocInfo, &img, &allocation, nullptr);
 
             if (res != VK_SUCCESS) return nullptr;
+            VLD_TRACE_COUNT(Allocations, 1);
+            dev->CheckMemoryBudget();
 
         auto tex = new VulkanTexture{dev, desc};
         tex->_img = img;
@@ -106,6 +116,62 @@ namespace alloy::vk {
 		return common::sp<ITexture>(tex);
 	}
 
+    common::sp<ITexture> VulkanTexture::MakePlaced(
+        const common::sp<VulkanDevice>& dev,
+        const common::sp<VulkanMemoryHeap>& heap,
+        std::uint64_t offset,
+        const ITexture::Description& desc
+    ) {
+        VLD_TRACE_ZONE("VulkanTexture::MakePlaced");
+
+        if(desc.hostAccess != HostAccess::None || !heap->CanHold(desc)) return nullptr;
+
+        auto imageCI = _GetImageCreateInfo(desc);
+        VkImage img;
+        if(VK_DEV_CALL(dev, vkCreateImage(dev->LogicalDev(), &imageCI, nullptr, &img)) != VK_SUCCESS)
+            return nullptr;
+
+        VkMemoryRequirements req;
+        VK_DEV_CALL(dev, vkGetImageMemoryRequirements(dev->LogicalDev(), img, &req));
+        if(!heap->CanPlace(req, offset)
+            || vmaBindImageMemory2(dev->Allocator(), heap->GetAllocation(), offset, img, nullptr) != VK_SUCCESS
+        ) {
+            VK_DEV_CALL(dev, vkDestroyImage(dev->LogicalDev(), img, nullptr));
+            return nullptr;
+        }
+
+        auto tex = new VulkanTexture{dev, desc};
+        tex->_img = img;
+        tex->_allocation = VK_NULL_HANDLE;
+        tex->_heap = heap;
+        return common::sp<ITexture>(tex);
+    }
+
+    bool VulkanTexture::GetMemoryRequirements(
+        VulkanDevice& dev,
+        const ITexture::Description& desc,
+        VkMemoryRequirements& req
+    ) {
+        auto imageCI = _GetImageCreateInfo(desc);
+        VkImage img;
+        if(VK_DEV_CALL(&dev, vkCreateImage(dev.LogicalDev(), &imageCI, nullptr, &img)) != VK_SUCCESS)
+            return false;
+
+        VK_DEV_CALL(&dev, vkGetImageMemoryRequirements(dev.LogicalDev(), img, &req));
+        VK_DEV_CALL(&dev, vkDestroyImage(dev.LogicalDev(), img, nullptr));
+        return true;
+    }
+
+    IMemoryHeap::Placement VulkanTexture::GetPlacement(
+        VulkanDevice& dev,
+        const ITexture::Description& desc
+    ) {
+        VkMemoryRequirements req;
+        if(!GetMemoryRequirements(dev, desc, req))
+            return {};
+        return { req.size, req.alignment };
+    }
+
 
     common::sp<ITexture> VulkanTexture::WrapNative(
         const common::sp<VulkanDevice>& dev, 
@@ -277,7 +343,7 @@ namespace alloy::vk {
     
     VulkanTextureView::~VulkanTextureView() {
         auto& _dev = target->GetDevice();
-        _dev.GetFnTable().vkDestroyImageView(_dev.LogicalDev(), view, nullptr);
+        _dev.GetObjectCache().ReleaseImageView(view);
     }
 
     
@@ -364,11 +430,7 @@ namespace alloy::vk {
             }
         }
 
-        VkImageView vkImgView;
-        VK_CHECK(
-            dev.GetFnTable().vkCreateImageView(dev.LogicalDev(), &imageViewCI, nullptr, &vkImgView));
-
-        return vkImgView;
+        return dev.GetObjectCache().AcquireImageView(imageViewCI);
     }
 
 	common::sp<VulkanTextureView> VulkanTextureView::Make(
@@ -427,7 +489,7 @@ namespace alloy::vk {
 
 
     VulkanSampler::~VulkanSampler(){
-        VK_DEV_CALL(_dev, vkDestroySampler(_dev->LogicalDev(), _sampler, nullptr));
+        _dev->GetObjectCache().ReleaseSampler(_sampler);
     }
 
 
@@ -461,11 +523,8 @@ namespace alloy::vk {
         samplerCI.mipLodBias = desc.lodBias;
         samplerCI.borderColor = VdToVkSamplerBorderColor(desc.borderColor);
 
-        VkSampler rawSampler;
-        VK_DEV_CALL(dev, vkCreateSampler(dev->LogicalDev(), &samplerCI, nullptr, &rawSampler));
-
         auto* sampler = new VulkanSampler(dev, desc);
-        sampler->_sampler = rawSampler;
+        sampler->_sampler = dev->GetObjectCache().AcquireSampler(samplerCI);
         return common::sp<VulkanSampler>(sampler);
     }
 
@@ -489,8 +548,10 @@ namespace alloy::vk {
     
     void VulkanSampler::SetDebugName(const std::string& name) {
         // Check for a valid function pointer
-
-        if (_dev->GetContext().GetCaps().hasDebugUtilExt)
+        // Samplers with the same description share the handle, only
+        // private ones get a native name
+        if (_dev->GetContext().GetCaps().hasDebugUtilExt
+            && !_dev->GetObjectCache().IsSamplerShareable(_sampler))
         {
             VkDebugUtilsObjectNameInfoEXT nameInfo = {};
             nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
@@ -3,6 +3,7 @@
 #include <volk.h>
 #include <vk_mem_alloc.h>
 
+#include "alloy/MemoryHeap.hpp"
 #include "alloy/Texture.hpp"
 #include "alloy/Sampler.hpp"
 
@@ -12,12 +13,15 @@
 namespace alloy::vk
 {
     class VulkanDevice;
+    class VulkanMemoryHeap;
     
     class VulkanTexture : public ITexture{
 
         common::sp<VulkanDevice> _dev;
         VkImage _img;
+        // Null for placed and wrapped textures
         VmaAllocation _allocation;
+        common::sp<VulkanMemoryHeap> _heap;
 
         std::string _debugName;
 
@@ -38,13 +42,32 @@ namespace alloy::vk
         virtual void* GetNativeHandle() const override {return GetHandle();}
 
         const VulkanDevice& GetDevice() const { return *_dev; }
-        bool IsOwnTexture() const {return _allocation != VK_NULL_HANDLE; }
+        bool IsOwnTexture() const {return _allocation != VK_NULL_HANDLE || _heap; }
 
         static common::sp<ITexture> Make(
             const common::sp<VulkanDevice>& dev,
             const ITexture::Description& desc
         );
 
+        static common::sp<ITexture> MakePlaced(
+            const common::sp<VulkanDevice>& dev,
+            const common::sp<VulkanMemoryHeap>& heap,
+            std::uint64_t offset,
+            const ITexture::Description& desc
+        );
+
+        static IMemoryHeap::Placement GetPlacement(
+            VulkanDevice& dev,
+            const ITexture::Description& desc
+        );
+
+        // Asks a throwaway image, false if it can't be created
+        static bool GetMemoryRequirements(
+            VulkanDevice& dev,
+            const ITexture::Description& desc,
+            VkMemoryRequirements& req
+        );
+
         static common::sp<ITexture> WrapNative(
             const common::sp<VulkanDevice>& dev,
             const ITexture::Description& desc,
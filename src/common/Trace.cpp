@@ -0,0 +1,207 @@
+#include "alloy/common/Trace.hpp"
+
+#include "utils/ChromeTraceWriter.hpp"
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace alloy::common::trace
+{
+    namespace _detail {
+        std::atomic<bool> enabled { false };
+    }
+
+    namespace {
+
+        constexpr std::uint32_t kRingSize = 4096;
+        // Frames kept when nobody drains them
+        constexpr std::size_t kMaxPendingFrames = 1024;
+
+        // Written by the owning thread only, drained under the registry lock
+        struct _ThreadBuffer {
+            std::uint32_t threadId = 0;
+            std::atomic<bool> inUse { false };
+
+            alignas(64) std::atomic<std::uint64_t> head { 0 };
+            alignas(64) std::atomic<std::uint64_t> tail { 0 };
+
+            std::atomic<std::uint64_t> counts[kCounterCount] {};
+
+            Zone ring[kRingSize];
+        };
+
+        struct _Registry {
+            std::mutex m;
+            std::vector<std::unique_ptr<_ThreadBuffer>> buffers;
+            std::uint32_t nextThreadId = 0;
+
+            std::uint64_t frameIdx = 0;
+            std::uint64_t lastTotals[kCounterCount] {};
+            std::deque<FrameCounters> frames;
+
+            std::atomic<std::uint64_t> droppedZones { 0 };
+        };
+
+        _Registry& GetRegistry() {
+            // Leaked so threads outliving static destruction stay safe
+            static _Registry* registry = new _Registry();
+            return *registry;
+        }
+
+        // Hands the buffer back for reuse when its thread exits
+        struct _ThreadSlot {
+            _ThreadBuffer* buffer = nullptr;
+
+            ~_ThreadSlot() {
+                if(buffer) buffer->inUse.store(false, std::memory_order_release);
+            }
+        };
+
+        thread_local _ThreadSlot t_slot;
+
+        _ThreadBuffer* GetThreadBuffer() {
+            if(t_slot.buffer) return t_slot.buffer;
+
+            auto& registry = GetRegistry();
+            std::scoped_lock l{registry.m};
+
+            _ThreadBuffer* buffer = nullptr;
+            for(auto& b : registry.buffers) {
+                if(!b->inUse.load(std::memory_order_acquire)) {
+                    buffer = b.get();
+                    break;
+                }
+            }
+            if(!buffer) {
+                registry.buffers.push_back(std::make_unique<_ThreadBuffer>());
+                buffer = registry.buffers.back().get();
+            }
+
+            buffer->threadId = registry.nextThreadId++;
+            buffer->inUse.store(true, std::memory_order_relaxed);
+            t_slot.buffer = buffer;
+            return buffer;
+        }
+
+        const char* GetCounterName(std::uint32_t counter) {
+            switch((Counter)counter) {
+            case Counter::Allocations: return "Allocations";
+            case Counter::Barriers: return "Barriers";
+            case Counter::Submits: return "Submits";
+            case Counter::DescriptorWrites: return "Descriptor writes";
+            default: return "Counter";
+            }
+        }
+    }
+
+    void SetEnabled(bool enabled) {
+        _detail::enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    std::uint64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void RecordZone(const char* name, std::uint64_t beginNs, std::uint64_t endNs) {
+        auto* buffer = GetThreadBuffer();
+
+        auto head = buffer->head.load(std::memory_order_relaxed);
+        auto tail = buffer->tail.load(std::memory_order_acquire);
+        if(head - tail >= kRingSize) {
+            GetRegistry().droppedZones.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer->ring[head % kRingSize] = { name, buffer->threadId, beginNs, endNs };
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    void AddCount(Counter counter, std::uint64_t n) {
+        auto* buffer = GetThreadBuffer();
+        // Single writer, no need for an atomic RMW
+        auto& count = buffer->counts[(std::uint32_t)counter];
+        count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void EndFrame() {
+        auto& registry = GetRegistry();
+        std::scoped_lock l{registry.m};
+
+        FrameCounters frame {};
+        frame.frameIdx = registry.frameIdx++;
+        frame.endNs = Now();
+
+        for(std::uint32_t i = 0; i < kCounterCount; ++i) {
+            std::uint64_t total = 0;
+            for(auto& b : registry.buffers) {
+                total += b->counts[i].load(std::memory_order_relaxed);
+            }
+            frame.values[i] = total - registry.lastTotals[i];
+            registry.lastTotals[i] = total;
+        }
+
+        registry.frames.push_back(frame);
+        if(registry.frames.size() > kMaxPendingFrames) {
+            registry.frames.pop_front();
+        }
+    }
+
+    std::vector<Zone> DrainZones() {
+        auto& registry = GetRegistry();
+        std::scoped_lock l{registry.m};
+
+        std::vector<Zone> zones;
+        for(auto& b : registry.buffers) {
+            auto tail = b->tail.load(std::memory_order_relaxed);
+            auto head = b->head.load(std::memory_order_acquire);
+            for(auto i = tail; i < head; ++i) {
+                zones.push_back(b->ring[i % kRingSize]);
+            }
+            b->tail.store(head, std::memory_order_release);
+        }
+        return zones;
+    }
+
+    std::vector<FrameCounters> DrainFrameCounters() {
+        auto& registry = GetRegistry();
+        std::scoped_lock l{registry.m};
+
+        std::vector<FrameCounters> frames(registry.frames.begin(), registry.frames.end());
+        registry.frames.clear();
+        return frames;
+    }
+
+    std::uint64_t GetDroppedZoneCount() {
+        return GetRegistry().droppedZones.load(std::memory_order_relaxed);
+    }
+
+    std::string ExportChromeTrace(
+        std::span<const Zone> zones,
+        std::span<const FrameCounters> frames
+    ) {
+        utils::ChromeTraceWriter writer;
+
+        std::set<std::uint32_t> threads;
+        for(auto& zone : zones) threads.insert(zone.threadId);
+        for(auto threadId : threads) {
+            writer.TrackName(threadId, "Thread " + std::to_string(threadId));
+        }
+
+        for(auto& zone : zones) {
+            writer.Complete(zone.name, zone.threadId, zone.beginNs, zone.endNs);
+        }
+
+        for(auto& frame : frames) {
+            for(std::uint32_t i = 0; i < kCounterCount; ++i) {
+                writer.Counter(GetCounterName(i), frame.endNs, frame.values[i]);
+            }
+        }
+
+        return writer.Finish();
+    }
+
+} // namespace alloy::common::trace
@@ -1,253 +1,463 @@
 
 #include "alloy/common/Waitable.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#endif
 
 namespace alloy::common {
 
+    namespace {
+
+        using Clock = std::chrono::steady_clock;
+
+        // Set in a latch's state by waiters about to park, cleared by the
+        // signaler that wakes them
+        constexpr uint32_t kParked = 1u << 31;
+
+        // Roughly a few microseconds, about what a fork/join job takes to
+        // finish once the waiter got there
+        constexpr int kSpinCount = 64;
+
+        inline void CpuRelax() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#elif defined(_M_ARM64)
+            __yield();
+#elif defined(__aarch64__) || defined(__arm__)
+            __asm__ __volatile__("yield");
+#endif
+        }
+
+        // Returns whether |condition()| held before giving up spinning.
+        template <typename ConditionFn>
+        bool SpinUntil(ConditionFn condition) {
+            // Nobody can make progress while we spin on a single core
+            static const int spinCount =
+                std::thread::hardware_concurrency() > 1 ? kSpinCount : 0;
+            for (int i = 0; i < spinCount; i++) {
+                if (condition()) {
+                    return true;
+                }
+                CpuRelax();
+            }
+            return condition();
+        }
+
+        Clock::time_point DeadlineAfter(Clock::duration timeout) {
+            auto now = Clock::now();
+            if (timeout > Clock::time_point::max() - now) {
+                return Clock::time_point::max();
+            }
+            return now + timeout;
+        }
+
+        // Blocks while |word| holds |old|, may return spuriously. Returns
+        // false without blocking once |deadline| passed.
+        //
+        // std::atomic::wait would do for untimed waits, but libstdc++ spins
+        // and yields on its own before parking, which costs more than the
+        // lock it replaces once the waiters outnumber the cores.
+        bool ParkOnAddress(
+            std::atomic<uint32_t>& word, uint32_t old, const Clock::time_point* deadline) {
+            Clock::duration left {};
+            if (deadline) {
+                auto now = Clock::now();
+                if (now >= *deadline) {
+                    return false;
+                }
+                left = *deadline - now;
+            }
+#if defined(__linux__)
+            timespec ts {};
+            if (deadline) {
+                auto secs = std::chrono::duration_cast<std::chrono::seconds>(left);
+                ts.tv_sec = static_cast<time_t>(secs.count());
+                ts.tv_nsec = static_cast<long>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(left - secs).count());
+            }
+            syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE,
+                static_cast<int>(old), deadline ? &ts : nullptr, nullptr, 0);
+#elif defined(_WIN32)
+            DWORD ms = INFINITE;
+            if (deadline) {
+                auto leftMs = std::chrono::ceil<std::chrono::milliseconds>(left).count();
+                ms = static_cast<DWORD>(std::min<long long>(leftMs, INFINITE - 1));
+            }
+            WaitOnAddress(&word, &old, sizeof(old), ms);
+#else
+            if (!deadline) {
+                word.wait(old);
+                return true;
+            }
+            // No timed wait on an address here, poll instead
+            if (word.load() == old) {
+                std::this_thread::sleep_for(
+                    std::min<Clock::duration>(left, std::chrono::milliseconds(1)));
+            }
+#endif
+            return true;
+        }
+
+        // Wakes up to |count| threads parked on |word|, UINT32_MAX for all.
+        // Only uses the address, the latch may be gone by now.
+        void WakeOnAddress(std::atomic<uint32_t>* word, uint32_t count) {
+#if defined(__linux__)
+            syscall(SYS_futex, reinterpret_cast<int*>(word), FUTEX_WAKE_PRIVATE,
+                static_cast<int>(std::min<uint32_t>(count, INT_MAX)), nullptr, nullptr, 0);
+#elif defined(_WIN32)
+            if (count == UINT32_MAX) {
+                WakeByAddressAll(word);
+                return;
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                WakeByAddressSingle(word);
+            }
+#else
+            // libc++ notifies through a table keyed by the address, without
+            // reading the atomic
+            if (count == 1) {
+                word->notify_one();
+            }
+            else {
+                word->notify_all();
+            }
+#endif
+        }
+
+        // Waits until |tryDone(state)| succeeds, returns false if |deadline|
+        // passed first. |tryDone| gets the latest state and may change it
+        // (e.g. to consume a signal), it only fails with a state to park on.
+        template <typename TryDoneFn>
+        bool WaitForState(
+            std::atomic<uint32_t>& word, TryDoneFn tryDone, const Clock::time_point* deadline) {
+            uint32_t state;
+            if (SpinUntil([&]() { state = word.load(); return tryDone(state); })) {
+                return true;
+            }
+            for (;;) {
+                if (tryDone(state)) {
+                    return true;
+                }
+                // Tell the signaler someone needs waking
+                if (!(state & kParked)) {
+                    if (!word.compare_exchange_weak(state, state | kParked)) {
+                        continue;
+                    }
+                    state |= kParked;
+                }
+                if (!ParkOnAddress(word, state, deadline)) {
+                    return false;
+                }
+                state = word.load();
+            }
+        }
+
+    }
+
 
     void AutoResetLatch::Signal()
     {
-        std::scoped_lock locker(mutex_);
-        signaled_ = true;
-        cv_.notify_one();
+        // Everyone parked wakes up, all but the one taking the signal park
+        // again
+        if (state_.exchange(kSignaled) & kParked) {
+            WakeOnAddress(&state_, UINT32_MAX);
+        }
     }
 
     void AutoResetLatch::Reset()
     {
-        std::scoped_lock locker(mutex_);
-        signaled_ = false;
+        state_.fetch_and(~kSignaled);
+    }
+
+    bool AutoResetLatch::WaitImpl(const Clock::time_point* deadline)
+    {
+        return WaitForState(state_, [this](uint32_t& state) {
+            while (state & kSignaled) {
+                if (state_.compare_exchange_weak(state, state & ~kSignaled)) {
+                    return true;
+                }
+            }
+            return false;
+        }, deadline);
     }
 
     void AutoResetLatch::Wait()
     {
-        std::unique_lock<std::mutex> locker(mutex_);
-        while (!signaled_) {
-            cv_.wait(locker);
-        }
-        signaled_ = false;
+        WaitImpl(nullptr);
     }
 
 
     bool AutoResetLatch::WaitWithTimeout(
         std::chrono::steady_clock::duration timeout)
     {
-        std::unique_lock<std::mutex> locker(mutex_);
-
-        if (signaled_) {
-            signaled_ = false;
-            return false;
-        }
-        // We may get spurious wakeups.
-        auto wait_remaining = timeout;
-        auto start = std::chrono::steady_clock::now();
-        while (true) {
-            if (std::cv_status::timeout ==
-                cv_.wait_for(
-                    locker, wait_remaining)) {
-                return true;  // Definitely timed out.
-            }
-
-            // We may have been awoken.
-            if (signaled_) {
-                break;
-            }
-
-            // Or the wakeup may have been spurious.
-            auto now = std::chrono::steady_clock::now();
-            //FML_DCHECK(now >= start);
-            auto elapsed = now - start;
-            // It's possible that we may have timed out anyway.
-            if (elapsed >= timeout) {
-                return true;
-            }
-
-            // Otherwise, recalculate the amount that we have left to wait.
-            wait_remaining = timeout - elapsed;
-        }
-
-        signaled_ = false;
-        return false;
+        auto deadline = DeadlineAfter(timeout);
+        return !WaitImpl(&deadline);
     }
 
     bool AutoResetLatch::IsSignaledForTest()
     {
-        std::scoped_lock locker(mutex_);
-        return signaled_;
+        return (state_.load() & kSignaled) != 0;
     }
 
 
     void ManualResetLatch::Signal() {
-        std::scoped_lock locker(mutex_);
-        signaled_ = true;
-        signal_id_++;
-        cv_.notify_all();
+        auto state = state_.load(std::memory_order_relaxed);
+        uint32_t next;
+        do {
+            // The id wraps below the parked bit
+            next = ((state + kSignalIdStep) & ~kParked) | kSignaled;
+        } while (!state_.compare_exchange_weak(state, next));
+
+        if (state & kParked) {
+            WakeOnAddress(&state_, UINT32_MAX);
+        }
     }
 
     void ManualResetLatch::Reset() {
-        std::scoped_lock locker(mutex_);
-        signaled_ = false;
+        state_.fetch_and(~kSignaled);
     }
 
-    void ManualResetLatch::Wait() {
-        std::unique_lock<std::mutex> locker(mutex_);
-
-        if (signaled_) {
-            return;
+    bool ManualResetLatch::WaitImpl(const Clock::time_point* deadline) {
+        auto last_state = state_.load() & ~kParked;
+        if (last_state & kSignaled) {
+            return true;
         }
-
-        auto last_signal_id = signal_id_;
-        do {
-            cv_.wait(locker);
-        } while (signal_id_ == last_signal_id);
+        return WaitForState(state_, [last_state](uint32_t& state) {
+            return (state & ~kParked) != last_state;
+        }, deadline);
     }
 
-    template <typename ConditionFn>
-    bool WaitWithTimeoutImpl(std::unique_lock<std::mutex>* locker,
-        std::condition_variable* cv,
-        ConditionFn condition,
-        std::chrono::steady_clock::duration timeout) {
-        //FML_DCHECK(locker->owns_lock());
-
-        if (condition()) {
-            return false;
-        }
-
-        // We may get spurious wakeups.
-        auto wait_remaining = timeout;
-        auto start = std::chrono::steady_clock::now();
-        while (true) {
-            if (std::cv_status::timeout ==
-                cv->wait_for(*locker, 
-                    wait_remaining)) {
-                return true;  // Definitely timed out.
-            }
-
-            // We may have been awoken.
-            if (condition()) {
-                return false;
-            }
-
-            // Or the wakeup may have been spurious.
-            auto now = std::chrono::steady_clock::now();
-            //FML_DCHECK(now >= start);
-            auto elapsed = now - start;
-            // It's possible that we may have timed out anyway.
-            if (elapsed >= timeout) {
-                return true;
-            }
-
-            // Otherwise, recalculate the amount that we have left to wait.
-            wait_remaining = timeout - elapsed;
-        }
+    void ManualResetLatch::Wait() {
+        WaitImpl(nullptr);
     }
 
     bool ManualResetLatch::WaitWithTimeout(std::chrono::steady_clock::duration timeout) {
-        std::unique_lock<std::mutex> locker(mutex_);
-
-        auto last_signal_id = signal_id_;
-        // Disable thread-safety analysis for the lambda: We could annotate it with
-        // |FML_EXCLUSIVE_LOCKS_REQUIRED(mutex_)|, but then the analyzer currently
-        // isn't able to figure out that |WaitWithTimeoutImpl()| calls it while
-        // holding |mutex_|.
-        bool rv = WaitWithTimeoutImpl(
-            &locker, &cv_,
-            [this, last_signal_id]() {
-                // Also check |signaled_| in case we're already signaled.
-                return signaled_ || signal_id_ != last_signal_id;
-            },
-            timeout);
-        //FML_DCHECK(rv || signaled_ || signal_id_ != last_signal_id);
-        return rv;
+        auto deadline = DeadlineAfter(timeout);
+        return !WaitImpl(&deadline);
     }
 
     bool ManualResetLatch::IsSignaledForTest() {
-        std::scoped_lock locker(mutex_);
-        return signaled_;
+        return (state_.load() & kSignaled) != 0;
     }
 
-    void MultiObjectLatch::Wait()
+    bool MultiObjectLatch::_WaitImpl(const Clock::time_point* deadline)
     {
-        std::unique_lock<std::mutex> lock(_m);
+        return WaitForState(_launchCnt, [](uint32_t& launchCnt) {
+            return (launchCnt & ~kParked) == 0;
+        }, deadline);
+    }
 
-        while (_launchCnt > 0)
-        {
-            _cv.wait(lock);
-        }
+    void MultiObjectLatch::Wait()
+    {
+        _WaitImpl(nullptr);
     }
 
     void MultiObjectLatch::AddLaunch(int count)
     {
         assert(count > 0);
 
-        std::unique_lock<std::mutex> lock(_m);
-        _launchCnt += count;
+        _launchCnt.fetch_add(static_cast<uint32_t>(count));
     }
 
     void MultiObjectLatch::LaunchComplete(int count)
     {
         assert(count > 0);
 
-        std::unique_lock<std::mutex> lock(_m);
-        if (_launchCnt > count)
+        auto launchCnt = _launchCnt.load(std::memory_order_relaxed);
+        uint32_t remaining;
+        do {
+            // Keeps the parked bit until the count gets to 0
+            remaining = (launchCnt & ~kParked) > static_cast<uint32_t>(count)
+                ? launchCnt - count : 0;
+        } while (!_launchCnt.compare_exchange_weak(launchCnt, remaining));
+
+        if (remaining == 0 && (launchCnt & kParked))
         {
-            _launchCnt -= count;
-            return;
+            WakeOnAddress(&_launchCnt, UINT32_MAX);
         }
-
-        _launchCnt = 0;
-        _cv.notify_one();
     }
 
     bool MultiObjectLatch::WaitUntilTimeout(std::chrono::steady_clock::duration timeout)
     {
-        using clock = std::chrono::steady_clock;
-        std::unique_lock<std::mutex> locker(_m);
+        auto deadline = DeadlineAfter(timeout);
+        return !_WaitImpl(&deadline);
+    }
+
+    int MultiObjectLatch::QueryLaunchCnt()
+    {
+        return static_cast<int>(_launchCnt.load() & ~kParked);
+    }
+
+
+    CountingSemaphore::CountingSemaphore(int initialCount)
+        : _state(static_cast<uint32_t>(initialCount))
+    {
+        assert(initialCount >= 0 && static_cast<uint32_t>(initialCount) <= kPermitMask);
+    }
+
+    void CountingSemaphore::Release(int count)
+    {
+        assert(count > 0);
+
+        // No more waiters than can run at once, a thread that stays awake
+        // may take all of the permits. Woken waiters pass the wakeup on
+        // while permits are left.
+        static const uint32_t maxWake =
+            std::max(std::thread::hardware_concurrency(), 1u);
 
-        if (_launchCnt < 1)
+        auto prev = _state.fetch_add(static_cast<uint32_t>(count));
+        assert((prev & kPermitMask) + count <= kPermitMask);
+
+        auto waiters = prev >> kPermitBits;
+        if (waiters != 0)
         {
-            return false;
+            WakeOnAddress(&_state,
+                std::min({ static_cast<uint32_t>(count), waiters, maxWake }));
         }
+    }
+
+    bool CountingSemaphore::TryAcquire()
+    {
+        auto state = _state.load(std::memory_order_relaxed);
+        while (state & kPermitMask)
+        {
+            if (_state.compare_exchange_weak(state, state - 1))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
 
-        // We may get spurious wakeups.
-        auto wait_remaining = timeout;
-        auto start = clock::now();
+    bool CountingSemaphore::_Acquire(const Clock::time_point* deadline)
+    {
+        if (SpinUntil([this]() { return TryAcquire(); }))
+        {
+            return true;
+        }
 
-        while (true)
+        auto state = _state.load();
+        bool parked = false;
+        for (;;)
         {
-            if (std::cv_status::timeout ==
-                _cv.wait_for(
-                    locker, wait_remaining))
+            if (state & kPermitMask)
             {
-                return true; // Definitely timed out.
+                auto next = state - 1 - (parked ? kWaiterOne : 0);
+                if (!_state.compare_exchange_weak(state, next))
+                {
+                    continue;
+                }
+                if (parked && (next & kPermitMask) && (next >> kPermitBits))
+                {
+                    WakeOnAddress(&_state, 1);
+                }
+                return true;
             }
 
-            // We may have been awoken.
-            if (_launchCnt < 1)
+            if (!parked)
             {
-                break;
+                assert((state >> kPermitBits) < (UINT32_MAX >> kPermitBits));
+                if (!_state.compare_exchange_weak(state, state + kWaiterOne))
+                {
+                    continue;
+                }
+                state += kWaiterOne;
+                parked = true;
             }
 
-            // Or the wakeup may have been spurious.
-            auto now = clock::now();
-            auto elapsed = now - start;
-            // It's possible that we may have timed out anyway.
-            if (elapsed >= timeout)
+            if (!ParkOnAddress(_state, state, deadline))
             {
-                return true;
+                // Timed out, leave unless a permit showed up meanwhile
+                state = _state.load();
+                while (!(state & kPermitMask))
+                {
+                    if (_state.compare_exchange_weak(state, state - kWaiterOne))
+                    {
+                        return false;
+                    }
+                }
+                continue;
             }
+            state = _state.load();
+        }
+    }
+
+    void CountingSemaphore::Acquire()
+    {
+        _Acquire(nullptr);
+    }
+
+    bool CountingSemaphore::AcquireWithTimeout(std::chrono::steady_clock::duration timeout)
+    {
+        auto deadline = DeadlineAfter(timeout);
+        return !_Acquire(&deadline);
+    }
+
+
+    CountdownLatch::CountdownLatch(int count)
+        : _count(static_cast<uint32_t>(count))
+    {
+        assert(count >= 0);
+    }
 
-            // Otherwise, recalculate the amount that we have left to wait.
-            wait_remaining = timeout - elapsed;
+    void CountdownLatch::CountDown(int count)
+    {
+        assert(count > 0);
+
+        // Single use, the parked bit can stay
+        auto prev = _count.fetch_sub(static_cast<uint32_t>(count));
+        assert((prev & ~kParked) >= static_cast<uint32_t>(count));
+        if ((prev & ~kParked) == static_cast<uint32_t>(count) && (prev & kParked))
+        {
+            WakeOnAddress(&_count, UINT32_MAX);
         }
+    }
 
-        return false;
+    bool CountdownLatch::TryWait()
+    {
+        return (_count.load() & ~kParked) == 0;
     }
 
-    int MultiObjectLatch::QueryLaunchCnt()
+    bool CountdownLatch::_WaitImpl(const Clock::time_point* deadline)
+    {
+        return WaitForState(_count, [](uint32_t& count) {
+            return (count & ~kParked) == 0;
+        }, deadline);
+    }
+
+    void CountdownLatch::Wait()
+    {
+        _WaitImpl(nullptr);
+    }
+
+    bool CountdownLatch::WaitWithTimeout(std::chrono::steady_clock::duration timeout)
+    {
+        auto deadline = DeadlineAfter(timeout);
+        return !_WaitImpl(&deadline);
+    }
+
+    void CountdownLatch::CountDownAndWait(int count)
     {
-        std::unique_lock<std::mutex> lock(_m);
-        return _launchCnt;
+        CountDown(count);
+        Wait();
     }
 
-}
\ No newline at end of file
+}
@@ -115,6 +115,10 @@ namespace alloy::layers::AutoResourceUsageTracking
         return _inner->GetNativeHandle();
     }
 
+    std::uint64_t TrackedBuffer::GetDeviceAddress() const {
+        return _inner->GetDeviceAddress();
+    }
+
     void TrackedBuffer::SetDebugName(const std::string& name) {
         _inner->SetDebugName(name);
     }
@@ -291,6 +291,7 @@ namespace alloy::layers::AutoResourceUsageTracking
         void* MapToCPU() override;
         void UnMap() override;
         std::uint64_t GetNativeHandle() const override;
+        std::uint64_t GetDeviceAddress() const override;
         void SetDebugName(const std::string& name) override;
         std::string GetDebugName() override;
     };
@@ -37,6 +37,34 @@ namespace alloy::layers::AutoResourceUsageTracking {
         //find anyone with a write access
     }
 
+    bool TrackingCommandList::IsWriteAccess(const ResourceAccessMask& access) {
+        return !_IsReadAccess(access);
+    }
+
+    // The inner command list only knows its own views
+    static common::sp<ITextureView> _UnwrapView(const common::sp<ITextureView>& view) {
+        if(!view) return nullptr;
+        return PtrCast<TrackedTexView>(view.get())->GetInner();
+    }
+
+    static RenderPassAction _UnwrapTargets(RenderPassAction actions) {
+        for(auto& color : actions.colorTargetActions) {
+            color.target = _UnwrapView(color.target);
+            color.msaaResolveTarget = _UnwrapView(color.msaaResolveTarget);
+        }
+        if(actions.depthTargetAction) {
+            actions.depthTargetAction->target = _UnwrapView(actions.depthTargetAction->target);
+            actions.depthTargetAction->msaaResolveTarget =
+                _UnwrapView(actions.depthTargetAction->msaaResolveTarget);
+        }
+        if(actions.stencilTargetAction) {
+            actions.stencilTargetAction->target = _UnwrapView(actions.stencilTargetAction->target);
+        }
+        return actions;
+    }
+
+    TrackingCmdEncBase::~TrackingCmdEncBase() { }
+
     void TrackingCmdEncBase::RegisterBufferUsage(
         IBuffer* buffer,
         const TrackingCommandList::BufferState& state
@@ -50,6 +78,7 @@ namespace alloy::layers::AutoResourceUsageTracking {
         }
 
         lastState.buffers[buffer] = state;
+        cmdList->RegisterBufferAccess(buffer, state.access);
     }
 
     void TrackingCmdEncBase::RegisterTexUsage(
@@ -68,7 +97,54 @@ namespace alloy::layers::AutoResourceUsageTracking {
     }
 
 
-    void TrackingCmdEncBase::RegisterResourceSet(IResourceSet* rs) {
+    void TrackingCmdEncBase::RegisterBoundResource(
+        const IResourceLayout::ShaderResourceDescription& slot,
+        IBindableResource* pBoundRes
+    ) {
+        using _ResKind = IBindableResource::ResourceKind;
+
+        switch (slot.kind) {
+            case _ResKind::Texture: {
+                auto* vkTexView = PtrCast<TrackedTexView>(pBoundRes);
+                TrackingCommandList::TextureState state{};
+                state.access = ResourceAccess::ShaderResourceRead;
+                if(slot.options.writable)
+                    state.access |= ResourceAccess::UnorderedAccess;
+                state.stage = PipelineStage::AllGraphics; // Adjust as needed
+                state.layout = slot.options.writable ?
+                    TextureLayout::General :
+                    TextureLayout::ShaderReadOnly;
+                RegisterTexUsage(vkTexView, state);
+                break;
+            }
+            case _ResKind::UniformBuffer: {
+                auto* range = PtrCast<BufferRange>(pBoundRes);
+                auto buffer = range->GetBufferObject().get();
+                TrackingCommandList::BufferState state{};
+                state.access = ResourceAccess::ConstantBufferRead;
+                state.stage = PipelineStage::AllGraphics;
+                RegisterBufferUsage(buffer, state);
+                break;
+            }
+            case _ResKind::StorageBuffer: {
+                auto* range = PtrCast<BufferRange>(pBoundRes);
+                auto buffer = range->GetBufferObject().get();
+                TrackingCommandList::BufferState state{};
+                state.access = ResourceAccess::ShaderResourceRead;
+                if(slot.options.writable)
+                    state.access |= ResourceAccess::UnorderedAccess;
+                state.stage = PipelineStage::AllGraphics;
+                RegisterBufferUsage(buffer, state);
+                break;
+            }
+            default:
+                // Samplers don't need to be registered for usage
+                break;
+        }
+    }
+
+    template<typename TResSet>
+    static void _RegisterSetResources(TrackingCmdEncBase& enc, TResSet* rs) {
         const auto& layoutDesc = rs->GetLayout().GetDesc();
 
         const auto& layoutSlots = layoutDesc.shaderResources;
@@ -80,48 +156,32 @@ namespace alloy::layers::AutoResourceUsageTracking {
                 auto pBoundRes = rs->GetBoundResource(i, arrIdx);
                 if(!pBoundRes) continue;
 
+                enc.RegisterBoundResource(slot, pBoundRes);
+            }
+        }
+    }
 
-                using _ResKind = IBindableResource::ResourceKind;
-
-                switch (slot.kind) {
-                    case _ResKind::Texture: {
-                        auto* vkTexView = PtrCast<TrackedTexView>(pBoundRes);
-                        TrackingCommandList::TextureState state{};
-                        state.access = ResourceAccess::ShaderResourceRead;
-                        if(slot.options.writable)
-                            state.access |= ResourceAccess::UnorderedAccess;
-                        state.stage = PipelineStage::AllGraphics; // Adjust as needed
-                        state.layout = slot.options.writable ?
-                            TextureLayout::General :
-                            TextureLayout::ShaderReadOnly;
-                        RegisterTexUsage(vkTexView, state);
-                        break;
-                    }
-                    case _ResKind::UniformBuffer: {
-                        auto* range = PtrCast<BufferRange>(pBoundRes);
-                        auto buffer = PtrCast<TrackedBuffer>(range->GetBufferObject().get());
-                        TrackingCommandList::BufferState state{};
-                        state.access = ResourceAccess::ConstantBufferRead;
-                        state.stage = PipelineStage::AllGraphics;
-                        RegisterBufferUsage(buffer, state);
-                        break;
-                    }
-                    case _ResKind::StorageBuffer: {
-                        auto* range = PtrCast<BufferRange>(pBoundRes);
-                        auto buffer = PtrCast<TrackedBuffer>(range->GetBufferObject().get());
-                        TrackingCommandList::BufferState state{};
-                        state.access = ResourceAccess::ShaderResourceRead;
-                        if(slot.options.writable)
-                            state.access |= ResourceAccess::UnorderedAccess;
-                        state.stage = PipelineStage::AllGraphics;
-                        RegisterBufferUsage(buffer, state);
-                        break;
-                    }
-                    default:
-                        // Samplers don't need to be registered for usage
-                        break;
-                }
+    void TrackingCmdEncBase::RegisterResourceSet(IResourceSet* rs) {
+        _RegisterSetResources(*this, rs);
+    }
+
+    void TrackingCmdEncBase::RegisterResourceSet(IMutableResourceSet* rs) {
+        _RegisterSetResources(*this, rs);
+    }
+
+    void TrackingCmdEncBase::RegisterResources(
+        const IResourceLayout& layout,
+        std::span<const common::sp<IBindableResource>> resources
+    ) {
+        const auto& layoutSlots = layout.GetDesc().shaderResources;
+
+        uint32_t resIdx = 0;
+        for(const auto& slot : layoutSlots) {
+            for(uint32_t arrIdx = 0; arrIdx < slot.bindingCount; ++arrIdx) {
+                auto& res = resources[resIdx++];
+                if(!res) continue;
 
+                RegisterBoundResource(slot, res.get());
             }
         }
     }
@@ -182,6 +242,10 @@ namespace alloy::layers::AutoResourceUsageTracking {
         _passes.clear();
         _currentPass = nullptr;
 
+        _requestedStates.Clear();
+        _finalStates.Clear();
+        _bufferAccesses.clear();
+
         _inner->Begin();
     }
     void TrackingCommandList::End(){
@@ -250,7 +314,7 @@ namespace alloy::layers::AutoResourceUsageTracking {
         state.access = ResourceAccess::VertexBufferRead;
         state.stage = PipelineStage::VertexInput;
         RegisterBufferUsage(
-            PtrCast<TrackedBuffer>(buffer->GetBufferObject().get()),
+            buffer->GetBufferObject().get(),
             state
         );
 
@@ -266,7 +330,7 @@ namespace alloy::layers::AutoResourceUsageTracking {
         state.access = ResourceAccess::IndexBufferRead;
         state.stage = PipelineStage::VertexInput;
         RegisterBufferUsage(
-            PtrCast<TrackedBuffer>(buffer->GetBufferObject().get()),
+            buffer->GetBufferObject().get(),
             state
         );
 
@@ -277,6 +341,33 @@ namespace alloy::layers::AutoResourceUsageTracking {
     }
 
 
+    void TrackingRndCmdEnc::SetVertexBuffer(
+        std::uint32_t index, IBuffer* buffer, std::uint64_t offsetInBytes
+    ){
+        TrackingCommandList::BufferState state {};
+        state.access = ResourceAccess::VertexBufferRead;
+        state.stage = PipelineStage::VertexInput;
+        RegisterBufferUsage(buffer, state);
+
+        recordedCmds.emplace_back([this, index, buffer, offsetInBytes](ICommandList* cmdList){
+            inner->SetVertexBuffer(index, buffer, offsetInBytes);
+        });
+    }
+
+    void TrackingRndCmdEnc::SetIndexBuffer(
+        IBuffer* buffer, IndexFormat format, std::uint64_t offsetInBytes
+    ){
+        TrackingCommandList::BufferState state {};
+        state.access = ResourceAccess::IndexBufferRead;
+        state.stage = PipelineStage::VertexInput;
+        RegisterBufferUsage(buffer, state);
+
+        recordedCmds.emplace_back([this, buffer, format, offsetInBytes](ICommandList* cmdList){
+            inner->SetIndexBuffer(buffer, format, offsetInBytes);
+        });
+    }
+
+
     void TrackingRndCmdEnc::SetGraphicsResourceSet(
         const common::sp<IResourceSet>& rs
     ){
@@ -291,6 +382,47 @@ namespace alloy::layers::AutoResourceUsageTracking {
     }
 
 
+    void TrackingRndCmdEnc::SetGraphicsResourceSet(IResourceSet* rs){
+
+        RegisterResourceSet(rs);
+
+        recordedCmds.emplace_back([this, rs](
+            ICommandList* cmdList
+        ){
+            inner->SetGraphicsResourceSet(rs);
+        });
+    }
+
+
+    void TrackingRndCmdEnc::SetGraphicsMutableResourceSet(
+        const common::sp<IMutableResourceSet>& rs
+    ){
+        // Bindings as of recording, later Update()s aren't seen
+        RegisterResourceSet(rs.get());
+
+        recordedCmds.emplace_back([this, rs](
+            ICommandList* cmdList
+        ){
+            inner->SetGraphicsMutableResourceSet(rs);
+        });
+    }
+
+
+    void TrackingRndCmdEnc::SetGraphicsResources(
+        IResourceLayout* layout,
+        std::span<const common::sp<IBindableResource>> resources
+    ){
+        RegisterResources(*layout, resources);
+
+        std::vector<common::sp<IBindableResource>> savedResources {
+            resources.begin(), resources.end()};
+        recordedCmds.emplace_back(
+        [this, layout, savedResources = std::move(savedResources)](ICommandList* cmdList){
+            inner->SetGraphicsResources(layout, savedResources);
+        });
+    }
+
+
     void TrackingRndCmdEnc::SetPushConstants( std::uint32_t pushConstantIndex,
                                               std::span<const uint32_t> data,
                                               std::uint32_t destOffsetIn32BitValues
@@ -316,6 +448,43 @@ namespace alloy::layers::AutoResourceUsageTracking {
 
 
 
+    void TrackingCompCmdEnc::SetComputeResourceSet(IResourceSet* rs){
+        RegisterResourceSet(rs);
+
+        recordedCmds.emplace_back([this, rs](
+            ICommandList* cmdList
+        ){
+            inner->SetComputeResourceSet(rs);
+        });
+    }
+
+    void TrackingCompCmdEnc::SetComputeMutableResourceSet(
+        const common::sp<IMutableResourceSet>& rs
+    ){
+        // Bindings as of recording, later Update()s aren't seen
+        RegisterResourceSet(rs.get());
+
+        recordedCmds.emplace_back([this, rs](
+            ICommandList* cmdList
+        ){
+            inner->SetComputeMutableResourceSet(rs);
+        });
+    }
+
+    void TrackingCompCmdEnc::SetComputeResources(
+        IResourceLayout* layout,
+        std::span<const common::sp<IBindableResource>> resources
+    ){
+        RegisterResources(*layout, resources);
+
+        std::vector<common::sp<IBindableResource>> savedResources {
+            resources.begin(), resources.end()};
+        recordedCmds.emplace_back(
+        [this, layout, savedResources = std::move(savedResources)](ICommandList* cmdList){
+            inner->SetComputeResources(layout, savedResources);
+        });
+    }
+
     void TrackingCompCmdEnc::SetPushConstants( std::uint32_t pushConstantIndex,
                                            std::span<const uint32_t> data,
                                            std::uint32_t destOffsetIn32BitValues
@@ -359,6 +528,42 @@ namespace alloy::layers::AutoResourceUsageTracking {
         });
     }
 
+    void TrackingRndCmdEnc::SetCullMode(RasterizerStateDescription::FaceCullMode cullMode) {
+        recordedCmds.emplace_back([this, cullMode](auto _){
+            inner->SetCullMode(cullMode);
+        });
+    }
+
+    void TrackingRndCmdEnc::SetDepthTest(
+        bool testEnabled, bool writeEnabled, ComparisonKind comparison
+    ) {
+        recordedCmds.emplace_back([this, testEnabled, writeEnabled, comparison](auto _){
+            inner->SetDepthTest(testEnabled, writeEnabled, comparison);
+        });
+    }
+
+    void TrackingRndCmdEnc::SetPrimitiveTopology(PrimitiveTopology topology) {
+        recordedCmds.emplace_back([this, topology](auto _){
+            inner->SetPrimitiveTopology(topology);
+        });
+    }
+
+    void TrackingRndCmdEnc::SetStencilOp(
+        bool testEnabled,
+        const DepthStencilStateDescription::StencilBehavior& front,
+        const DepthStencilStateDescription::StencilBehavior& back
+    ) {
+        recordedCmds.emplace_back([this, testEnabled, front, back](auto _){
+            inner->SetStencilOp(testEnabled, front, back);
+        });
+    }
+
+    void TrackingRndCmdEnc::SetBlendEnabled(std::uint32_t attachment, bool enabled) {
+        recordedCmds.emplace_back([this, attachment, enabled](auto _){
+            inner->SetBlendEnabled(attachment, enabled);
+        });
+    }
+
     void TrackingRndCmdEnc::Draw(
         std::uint32_t vertexCount, std::uint32_t instanceCount,
         std::uint32_t vertexStart, std::uint32_t instanceStart
@@ -406,7 +611,7 @@ namespace alloy::layers::AutoResourceUsageTracking {
         const Size3D& copySize
     ){
 
-        auto* srcBuffer = PtrCast<TrackedBuffer>(src->GetBufferObject().get());
+        auto* srcBuffer = src->GetBufferObject().get();
         auto* dstImg = PtrCast<TrackedTexView>(dst.get());
 
         TrackingCommandList::BufferState srcState{};
@@ -424,7 +629,7 @@ namespace alloy::layers::AutoResourceUsageTracking {
 
             inner->CopyBufferToTexture(
                 src, srcBytesPerRow, srcBytesPerImage,
-                dst, dstOrigin, dstMipLevel, dstBaseArrayLayer,
+                _UnwrapView(dst), dstOrigin, dstMipLevel, dstBaseArrayLayer,
                 copySize
             );
         });
@@ -443,7 +648,7 @@ namespace alloy::layers::AutoResourceUsageTracking {
     ) {
 
         auto srcVkTexture = PtrCast<TrackedTexView>(src.get());
-        auto* dstBuffer = PtrCast<TrackedBuffer>(dst->GetBufferObject().get());
+        auto* dstBuffer = dst->GetBufferObject().get();
 
         TrackingCommandList::TextureState srcState{};
         srcState.access = ResourceAccess::CopySource;
@@ -459,7 +664,7 @@ namespace alloy::layers::AutoResourceUsageTracking {
         recordedCmds.emplace_back([=, this](ICommandList* cmdList){
 
             inner->CopyTextureToBuffer(
-                src, srcOrigin, srcMipLevel, srcBaseArrayLayer,
+                _UnwrapView(src), srcOrigin, srcMipLevel, srcBaseArrayLayer,
                 dst, dstBytesPerRow, dstBytesPerImage,
                 copySize
             );
@@ -483,8 +688,8 @@ namespace alloy::layers::AutoResourceUsageTracking {
         const common::sp<BufferRange>& destination,
         std::uint32_t sizeInBytes
     ){
-        auto* srcVkBuffer = PtrCast<TrackedBuffer>(source->GetBufferObject().get());
-        auto* dstVkBuffer = PtrCast<TrackedBuffer>(destination->GetBufferObject().get());
+        auto* srcVkBuffer = source->GetBufferObject().get();
+        auto* dstVkBuffer = destination->GetBufferObject().get();
 
 
         TrackingCommandList::BufferState srcState{};
@@ -546,11 +751,11 @@ namespace alloy::layers::AutoResourceUsageTracking {
         //_resReg.InsertPipelineBarrierIfNecessary(_cmdBuf);
 
 
-        recordedCmds.emplace_back([=](ICommandList* cmdList){
+        recordedCmds.emplace_back([=, this](ICommandList* cmdList){
 
             inner->CopyTexture(
-                src, srcOrigin, srcMipLevel, srcBaseArrayLayer,
-                dst, dstOrigin, dstMipLevel, dstBaseArrayLayer,
+                _UnwrapView(src), srcOrigin, srcMipLevel, srcBaseArrayLayer,
+                _UnwrapView(dst), dstOrigin, dstMipLevel, dstBaseArrayLayer,
                 copySize
             );
 
@@ -580,103 +785,32 @@ namespace alloy::layers::AutoResourceUsageTracking {
         //}
     }
 
-    void TrackingXferCmdEnc::GenerateMipmaps(const common::sp<ITexture>& texture){
-#if 0
-        auto vkTex = PtrCast<VulkanTexture>(texture.get());
-        resources.insert(texture);
-
-
-        //_resReg.InsertPipelineBarrierIfNecessary(_cmdBuf);
-
-        auto layerCount = vkTex->GetDesc().arrayLayers;
-        if (vkTex->GetDesc().usage.cubemap) {
-            layerCount *= 6;
-        }
-
-        VkImageBlit region;
-
-        auto width = vkTex->GetDesc().width;
-        auto height = vkTex->GetDesc().height;
-        auto depth = vkTex->GetDesc().depth;
-
-        VkFormatProperties vkFormatProps;
-        vkGetPhysicalDeviceFormatProperties(
-            vkDev->PhysicalDev(), alloy::VK::priv::VdToVkPixelFormat(vkTex->GetDesc().format), &vkFormatProps);
-
-        VkFilter filter
-            = (vkFormatProps.optimalTilingFeatures
-                & VkFormatFeatureFlagBits::VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0
-                ? VkFilter::VK_FILTER_LINEAR
-                : VkFilter::VK_FILTER_NEAREST;
-
-
-        for (unsigned level = 1; level < vkTex->GetDesc().mipLevels; level++) {
-            //vkTex.TransitionImageLayoutNonmatching(_cb, level - 1, 1, 0, layerCount, VkImageLayout.TransferSrcOptimal);
-            //vkTex.TransitionImageLayoutNonmatching(_cb, level, 1, 0, layerCount, VkImageLayout.TransferDstOptimal);
-
-            VkImage deviceImage = vkTex->GetHandle();
-            auto mipWidth = std::max(width >> 1, 1U);
-            auto mipHeight = std::max(height >> 1, 1U);
-            auto mipDepth = std::max(depth >> 1, 1U);
-
-
-            region.srcSubresource.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
-            region.srcSubresource.baseArrayLayer = 0;
-            region.srcSubresource.layerCount = layerCount;
-            region.srcSubresource.mipLevel = level - 1;
-            region.srcOffsets[0] = {};
-            region.srcOffsets[1] = { (int)width, (int)height, (int)depth };
-            region.dstOffsets[0] = {};
-            region.dstOffsets[1] = { (int)mipWidth, (int)mipHeight, (int)mipDepth };
-
-            region.dstSubresource.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
-            region.dstSubresource.baseArrayLayer = 0;
-            region.dstSubresource.layerCount = layerCount;
-            region.dstSubresource.mipLevel = level;
-
-            //if (!_filters.TryGetValue(format, out VkFilter filter))
-            if (level > 1) {
-                //Beyond first transition, barrier needed
-                VkImageMemoryBarrier memBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
-                memBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                memBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                memBarrier.image = deviceImage;
-                memBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-                memBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-                memBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                memBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-                vkCmdPipelineBarrier(_cmdBuf,
-                    VK_PIPELINE_STAGE_TRANSFER_BIT,
-                    VK_PIPELINE_STAGE_TRANSFER_BIT,
-                    0,
-                    0, nullptr,
-                    0, nullptr,
-                    1, &memBarrier
-                );
-            }
-            vkCmdBlitImage(
-                _cmdBuf,
-                deviceImage, VkImageLayout::VK_IMAGE_LAYOUT_GENERAL,
-                deviceImage, VkImageLayout::VK_IMAGE_LAYOUT_GENERAL,
-                1, &region,
-                filter);
-
-            width = mipWidth;
-            height = mipHeight;
-            depth = mipDepth;
-        }
-
-        //if ((vkTex.Usage & TextureUsage.Sampled) != 0)
-        //{
-        //    vkTex.TransitionImageLayoutNonmatching(_cb, 0, vkTex.MipLevels, 0, layerCount, VkImageLayout.ShaderReadOnlyOptimal);
-        //}
-        _resReg.ModifyTexUsage(
-            texture,
-            VK_IMAGE_LAYOUT_GENERAL,
-            VK_PIPELINE_STAGE_TRANSFER_BIT,
-            VK_ACCESS_TRANSFER_WRITE_BIT
-        );
-#endif
+    bool TrackingXferCmdEnc::GenerateMipmaps(const common::sp<ITextureView>& texture){
+        auto vkTexture = PtrCast<TrackedTexView>(texture.get());
+
+        // Replayed later, so ask up front whether the backend records
+        // anything. If not, the view's state must stay as it is.
+        auto format = vkTexture->GetTextureObject()->GetDesc().format;
+        if(!cmdList->GetDevice()->GetInner()->CanGenerateMipmaps(format)) return false;
+
+        // Level barriers are recorded by the backend, the view only has
+        // to enter in CopyDest and leaves in CopySource
+        TrackingCommandList::TextureState inState{};
+        inState.access = ResourceAccess::CopyDest;
+        inState.stage = PipelineStage::Copy;
+        inState.layout = TextureLayout::CopyDest;
+        RegisterTexUsage(vkTexture, inState);
+
+        TrackingCommandList::TextureState outState{};
+        outState.access = ResourceAccess::CopySource;
+        outState.stage = PipelineStage::Copy;
+        outState.layout = TextureLayout::CopySource;
+        RegisterTexUsage(vkTexture, outState);
+
+        recordedCmds.emplace_back([this, innerTex = vkTexture->GetInner()](ICommandList* cmdList){
+            inner->GenerateMipmaps(innerTex);
+        });
+        return true;
     }
 
     void TrackingCommandList::PushDebugGroup(const std::string& name, const Color4f& color) {
@@ -815,7 +949,7 @@ namespace alloy::layers::AutoResourceUsageTracking {
         std::vector<PassResourceAccess> usageCopy { usage.begin(), usage.end() };
         recordedCmds.emplace_back(
             [this,
-             actions = fb,
+             actions = _UnwrapTargets(fb),
              passResources = std::move(usageCopy)
             ](ICommandList* cmdList) {
                 inner = &cmdList->BeginRenderPass(actions, passResources);
@@ -841,6 +975,18 @@ namespace alloy::layers::AutoResourceUsageTracking {
         );
     }
 
+    TrackingXferCmdEnc::TrackingXferCmdEnc(
+        TrackingCommandList* cmdList
+    )
+        : TrackingCmdEncBase{ cmdList }
+        , cmdList(cmdList)
+        , inner(nullptr)
+    {
+        recordedCmds.emplace_back([this](ICommandList* cmdList) {
+            inner = &cmdList->BeginTransferPass();
+        });
+    }
+
     IRenderCommandEncoder& TrackingCommandList::BeginRenderPass(
         const RenderPassAction& actions,
         const PassResourceUsage& usage) {
@@ -55,6 +55,9 @@ namespace alloy::layers::AutoResourceUsageTracking {
 
         ResourceStates _requestedStates, _finalStates;
 
+        // Every access to each buffer, ordered against other queues on submit
+        std::unordered_map<IBuffer*, ResourceAccesses> _bufferAccesses;
+
         common::sp<TrackingDevice> _dev;
         TrackingCommandQueue* _cmdQ;
         common::sp<ICommandList> _inner;
@@ -87,6 +90,14 @@ namespace alloy::layers::AutoResourceUsageTracking {
         }
 
         ICommandList* GetInner() const {return _inner.get();}
+        TrackingDevice* GetDevice() const {return _dev.get();}
+
+        void RegisterBufferAccess(IBuffer* buffer, ResourceAccesses access) {
+            _bufferAccesses[buffer] |= access;
+        }
+        auto& GetBufferAccesses() const { return _bufferAccesses; }
+
+        static bool IsWriteAccess(const ResourceAccessMask& access);
 
         //Delegates
         virtual void Begin() override;
@@ -137,12 +148,12 @@ namespace alloy::layers::AutoResourceUsageTracking {
 
         virtual ~TrackingCmdEncBase();
 
+        // Replays the recorded commands onto the inner command list.
+        // Encoders owning an inner pass also end it.
         virtual void EndPass() {
             for(auto& cmd: recordedCmds) {
                 cmd(cmdList->GetInner());
             }
-
-            cmdList->EndPass();
         }
 
         void RegisterBufferUsage(
@@ -155,7 +166,19 @@ namespace alloy::layers::AutoResourceUsageTracking {
             const TrackingCommandList::TextureState& state
         );
 
+        void RegisterBoundResource(
+            const IResourceLayout::ShaderResourceDescription& slot,
+            IBindableResource* res
+        );
+
         void RegisterResourceSet(IResourceSet* rs);
+        void RegisterResourceSet(IMutableResourceSet* rs);
+
+        // Resources ordered like IResourceSet::Description::boundResources
+        void RegisterResources(
+            const IResourceLayout& layout,
+            std::span<const common::sp<IBindableResource>> resources
+        );
 
         void PushDebugGroup(const std::string& name, const Color4f&);
         void PopDebugGroup();
@@ -175,6 +198,11 @@ namespace alloy::layers::AutoResourceUsageTracking {
             const PassResourceUsage& usage
         );
 
+        virtual void EndPass() override {
+            TrackingCmdEncBase::EndPass();
+            cmdList->GetInner()->EndPass();
+        }
+
         //Delegates
         virtual void SetPipeline(const common::sp<IGfxPipeline>&) override;
         virtual void SetPipeline(const common::sp<IMeshShaderPipeline>&) override;
@@ -185,6 +213,12 @@ namespace alloy::layers::AutoResourceUsageTracking {
         virtual void SetIndexBuffer(
             const common::sp<BufferRange>& buffer, IndexFormat format) override;
 
+        virtual void SetVertexBuffer(
+            std::uint32_t index, IBuffer* buffer, std::uint64_t offsetInBytes) override;
+
+        virtual void SetIndexBuffer(
+            IBuffer* buffer, IndexFormat format, std::uint64_t offsetInBytes) override;
+
          virtual void SetDescriptorHeaps(
             const common::sp<IResourceDescriptorHeap>& resourceHeap,
             const common::sp<ISamplerDescriptorHeap>& samplerHeap
@@ -200,10 +234,15 @@ namespace alloy::layers::AutoResourceUsageTracking {
         virtual void SetGraphicsResourceSet(
             const common::sp<IResourceSet>& rs
             /*const std::vector<std::uint32_t>& dynamicOffsets*/) override;
+        virtual void SetGraphicsResourceSet(IResourceSet* rs) override;
 
         virtual void SetGraphicsMutableResourceSet(
             const common::sp<IMutableResourceSet>& rs) override;
 
+        virtual void SetGraphicsResources(
+            IResourceLayout* layout,
+            std::span<const common::sp<IBindableResource>> resources) override;
+
         virtual void SetViewports(std::span<const Viewport> viewport) override;
         
         virtual void SetFullViewport() override;
@@ -212,6 +251,20 @@ namespace alloy::layers::AutoResourceUsageTracking {
         
         virtual void SetFullScissorRect() override;
 
+        virtual void SetCullMode(RasterizerStateDescription::FaceCullMode) override;
+
+        virtual void SetDepthTest(
+            bool testEnabled, bool writeEnabled, ComparisonKind comparison) override;
+
+        virtual void SetPrimitiveTopology(PrimitiveTopology) override;
+
+        virtual void SetStencilOp(
+            bool testEnabled,
+            const DepthStencilStateDescription::StencilBehavior& front,
+            const DepthStencilStateDescription::StencilBehavior& back) override;
+
+        virtual void SetBlendEnabled(std::uint32_t attachment, bool enabled) override;
+
         
         virtual void Draw(
             std::uint32_t vertexCount, std::uint32_t instanceCount,
@@ -241,15 +294,25 @@ namespace alloy::layers::AutoResourceUsageTracking {
             const PassResourceUsage& usage
         );
 
+        virtual void EndPass() override {
+            TrackingCmdEncBase::EndPass();
+            cmdList->GetInner()->EndPass();
+        }
+
         virtual void SetPipeline(const common::sp<IComputePipeline>&) override;
 
         virtual void SetComputeResourceSet(
             const common::sp<IResourceSet>& rs
             /*const std::vector<std::uint32_t>& dynamicOffsets*/) override;
+        virtual void SetComputeResourceSet(IResourceSet* rs) override;
 
         virtual void SetComputeMutableResourceSet(
             const common::sp<IMutableResourceSet>& rs) override;
 
+        virtual void SetComputeResources(
+            IResourceLayout* layout,
+            std::span<const common::sp<IBindableResource>> resources) override;
+
             
         virtual void SetDescriptorHeaps(
             const common::sp<IResourceDescriptorHeap>& resourceHeap,
@@ -279,6 +342,11 @@ namespace alloy::layers::AutoResourceUsageTracking {
             TrackingCommandList* cmdList
         );
 
+        virtual void EndPass() override {
+            TrackingCmdEncBase::EndPass();
+            cmdList->GetInner()->EndPass();
+        }
+
         virtual void CopyBuffer(
             const common::sp<BufferRange>& source,
             const common::sp<BufferRange>& destination,
@@ -318,6 +386,6 @@ namespace alloy::layers::AutoResourceUsageTracking {
             std::uint32_t dstBaseArrayLayer,
             const Size3D& copySize) override;
 
-        virtual void GenerateMipmaps(const common::sp<ITexture>& texture) override;
+        virtual bool GenerateMipmaps(const common::sp<ITextureView>& texture) override;
     };
 }
@@ -3,6 +3,9 @@
 #include "TrackedResource.hpp"
 #include "TrackingCommandList.hpp"
 
+#include "alloy/common/Trace.hpp"
+
+#include <algorithm>
 #include <format>
 
 namespace alloy::layers::AutoResourceUsageTracking
@@ -13,15 +16,19 @@ namespace alloy::layers::AutoResourceUsageTracking
     {
         auto& factory = _inner->GetResourceFactory();
 
-        if(_inner->GetGfxCommandQueue()) {
-            auto evt = factory.CreateSyncEvent();
-            _gfxQ = new TrackingCommandQueue(this, std::move(evt), _inner->GetGfxCommandQueue());
-        }
+        auto makeQueue = [&](ICommandQueue* innerQ) -> TrackingCommandQueue* {
+            if(!innerQ) return nullptr;
+            return new TrackingCommandQueue(this, factory.CreateSyncEvent(), innerQ);
+        };
+        _gfxQ = makeQueue(_inner->GetGfxCommandQueue());
+        _copyQ = makeQueue(_inner->GetCopyCommandQueue());
+        _computeQ = makeQueue(_inner->GetComputeCommandQueue());
     }
 
     TrackingDevice::~TrackingDevice() {
         delete _gfxQ;
         delete _copyQ;
+        delete _computeQ;
     }
 
     
@@ -41,6 +48,23 @@ namespace alloy::layers::AutoResourceUsageTracking
         return common::sp{trackedTex};
     }
 
+    void TrackingDevice::ClearFinishedBufferUses() {
+        auto finished = [](TrackingCommandQueue* q, uint64_t value) {
+            return !q || q->GetTrackingEvent().GetSignaledValue() >= value;
+        };
+
+        auto it = _bufferUses.begin();
+        while(it != _bufferUses.end()) {
+            auto& use = it->second;
+            bool done = finished(use.writer, use.writeValue)
+                && std::all_of(use.readers.begin(), use.readers.end(),
+                    [&](auto& r) { return finished(r.first, r.second); });
+
+            if(done)    it = _bufferUses.erase(it);
+            else        ++it;
+        }
+    }
+
     ISwapChain::State TrackingDevice::PresentToSwapChain(ISwapChain* sc) {
 
         auto scImpl = PtrCast<TrackedSwapChain>(sc);
@@ -77,17 +101,12 @@ namespace alloy::layers::AutoResourceUsageTracking
 
     
     void TrackingCommandQueue::_RecycleTransitionCmdBufs() {
-        auto completedVal = GetLastFinishedFence();
-        while(!_cmdListsInUse.empty()) {
-            auto& entry = _cmdListsInUse.front();
-            if(entry.lastSubmittedFence <= completedVal) {
-                entry.cmdList.reset();
-                _cmdListsInUse.pop();
-            }
-            else {
-                break;
-            }
+        std::vector<common::sp<ICommandList>> retired;
+        {
+            std::scoped_lock lk{_m_retiredCmdLists};
+            retired.swap(_retiredCmdLists);
         }
+        // Released here, outside the lock
     }
     
     common::sp<ICommandList> TrackingCommandQueue::_GetOneTransitionCmdList() {
@@ -95,66 +114,123 @@ namespace alloy::layers::AutoResourceUsageTracking
 
         auto cmdList = _inner->CreateCommandList();
 
-        _cmdListsInUse.push({
-            cmdList,
-            GetLastSubmittedFence()
+        // Signaled right after the transitions are submitted. Also handed
+        // back when the queue goes away with the list still pending.
+        _trackingEvt.OnReached(GetLastSubmittedFence(), [this, cmdList](bool) mutable {
+            std::scoped_lock lk{_m_retiredCmdLists};
+            _retiredCmdLists.push_back(std::move(cmdList));
         });
 
         return cmdList;
     }
 
+    void TrackingCommandQueue::_SubmitTransitions(
+        std::span<const BarrierOp> barriers,
+        const char* name
+    ) {
+        auto cmdList = _GetOneTransitionCmdList();
+        cmdList->Begin();
+        cmdList->Barrier(barriers);
+        cmdList->End();
 
-    
-    void TrackingCommandQueue::_TransitResourceStatesBeforeSubmit(
-        const TrackingCommandList& cmdList
+        std::string debugName = std::format("{}_fence#{}", name, GetLastSubmittedFence());
+        cmdList->SetDebugName( debugName );
+
+        _inner->SubmitCommand( cmdList.get() );
+    }
+
+    void TrackingCommandQueue::_RequireTextureLayout(
+        TrackedTexView* tex,
+        TextureLayout layout,
+        std::vector<BarrierOp>& barriers,
+        ReleaseBatches& releases
     ) {
-        auto& resStates = cmdList.GetResourceStateReqs();
+        auto trackedRef = tex->GetTrackedRef();
 
-        auto& cpuTimeline = _dev;
+        // Last used on another queue. Its latest layout is the truth, and
+        // the owner hands the texture over with a matching release.
+        auto owner = _dev->GetTextureOwner(trackedRef);
+        if(owner && owner != this) {
+            TextureBarrierOp op {
+                .texture = tex->GetInner(),
+                .from = {
+                    .stages = PipelineStage::AllCommands,
+                    .access = {},
+                    .layout = owner->GetLatestResourceState(trackedRef),
+                },
+                .to = {
+                    .stages = PipelineStage::AllCommands,
+                    .access = {},
+                    .layout = layout,
+                },
+                .queueTransfer = { owner->_inner, _inner },
+            };
+            releases[owner].emplace_back(op);
+            barriers.emplace_back(std::move(op));
+            return;
+        }
 
-        std::vector<alloy::BarrierOp> barriers;
+        //Search for current recorded state
+        TextureLayout currState = TextureLayout::Undefined;
+        if(ContainsResource(trackedRef)) {
+            currState = GetLatestResourceState(trackedRef);
+        } else {
+            currState = _dev->FetchCurrentState(trackedRef);
+        }
 
-        for(auto& [texture, stateReq] : resStates) {
+        if(currState != layout) {
+            barriers.emplace_back(TextureBarrierOp{
+                .texture = tex->GetInner(),
+                // BOTTOM_OF_PIPE
+                .from = {
+                    .stages = PipelineStage::AllCommands,
+                    .access = {},
+                    .layout = currState,
+                },
+                // TOP_OF_PIPE
+                .to = {
+                    .stages = PipelineStage::AllCommands,
+                    .access = {},
+                    .layout = layout,
+                }
+            });
+        }
+    }
 
-            auto trackedRef = texture->GetTrackedRef();
+    uint64_t TrackingCommandQueue::_SubmitRelease(std::span<const BarrierOp> barriers) {
+        _GetFinishedSubmissions();
 
-            //Search for current recorded state
-            TextureLayout currState = TextureLayout::Undefined;
-            if(ContainsResource(trackedRef)) {
-                currState = GetLatestResourceState(trackedRef);
-            } else {
-                currState = cpuTimeline->FetchCurrentState(trackedRef);
-            }
+        auto fenceValue = IncrementLastSubmittedFence();
+        _SubmitTransitions(barriers, "QueueReleaseCmdList");
+        _inner->EncodeSignalEvent(_trackingEvt.GetInner(), fenceValue);
 
-            if(currState != stateReq.layout) {
-                using common::operator|;
-                barriers.emplace_back(TextureBarrierOp{
-                    .texture = common::ref_sp(texture), 
-                    // BOTTOM_OF_PIPE
-                    .from = {
-                        .stages = PipelineStage::AllCommands,
-                        .access = {},
-                        .layout = currState,
-                    },
-                    // TOP_OF_PIPE
-                    .to = {
-                        .stages = PipelineStage::AllCommands,
-                        .access = {},
-                        .layout = stateReq.layout,
-                    }
-                });
-            }
+        return fenceValue;
+    }
+
+    void TrackingCommandQueue::_AcquireFromOwners(const ReleaseBatches& releases) {
+        for(auto& [owner, barriers] : releases) {
+            auto fenceValue = owner->_SubmitRelease(barriers);
+            _inner->EncodeWaitForEvent(owner->_trackingEvt.GetInner(), fenceValue);
         }
+    }
 
-        if(!barriers.empty()) {
-            auto gfxCmdList = _GetOneTransitionCmdList();
-            gfxCmdList->Barrier(barriers);
-            gfxCmdList->End();
+    void TrackingCommandQueue::_TransitResourceStatesBeforeSubmit(
+        const TrackingCommandList& cmdList
+    ) {
+        VLD_TRACE_ZONE("TrackingCommandQueue::_TransitResourceStatesBeforeSubmit");
+        auto& resStates = cmdList.GetResourceStateReqs();
 
-            std::string debugName = std::format("ResTransCmdList_fence#{}", GetLastSubmittedFence());
-            gfxCmdList->SetDebugName( debugName );
+        std::vector<alloy::BarrierOp> barriers;
+        ReleaseBatches releases;
 
-            _inner->SubmitCommand( gfxCmdList.get() );
+        for(auto& [texture, stateReq] : resStates) {
+            _RequireTextureLayout(texture, stateReq.layout, barriers, releases);
+        }
+
+        _AcquireFromOwners(releases);
+
+        if(!barriers.empty()) {
+            _SubmitTransitions(barriers, "ResTransCmdList");
         }
 
     }
@@ -162,6 +238,9 @@ namespace alloy::layers::AutoResourceUsageTracking
     void TrackingCommandQueue::_MarkResourceStatesAfterSubmit(
         const TrackingCommandList& cmdList
     ) {
+        for(auto&[tex, stateReq] : cmdList.GetResourceStateReqs()) {
+            _dev->SetTextureOwner(tex->GetTrackedRef(), this);
+        }
         auto& resStates = cmdList.GetFinalResourceStates();
         for(auto&[tex, stateReq] : resStates) {
             RegisterTextureState(tex->GetTrackedRef(), stateReq.layout);
@@ -169,17 +248,73 @@ namespace alloy::layers::AutoResourceUsageTracking
     }
 
 
+    void TrackingCommandQueue::_WaitForBufferUses(const TrackingCommandList& cmdList) {
+        std::unordered_map<TrackingCommandQueue*, uint64_t> waits;
+        auto require = [&](TrackingCommandQueue* q, uint64_t value) {
+            if(!q || q == this) return;
+            auto& w = waits[q];
+            w = std::max(w, value);
+        };
+
+        for(auto& [buffer, access] : cmdList.GetBufferAccesses()) {
+            auto use = _dev->FindBufferUse(buffer);
+            if(!use) continue;
+
+            require(use->writer, use->writeValue);
+            if(TrackingCommandList::IsWriteAccess(access)) {
+                for(auto& [q, value] : use->readers) require(q, value);
+            }
+        }
+
+        for(auto& [q, value] : waits) {
+            auto& waited = _waitedValues[q];
+            if(waited >= value || q->_trackingEvt.GetSignaledValue() >= value) continue;
+
+            _inner->EncodeWaitForEvent(q->_trackingEvt.GetInner(), value);
+            waited = value;
+        }
+    }
+
+    void TrackingCommandQueue::_MarkBufferUses(
+        const TrackingCommandList& cmdList,
+        uint64_t fenceValue
+    ) {
+        for(auto& [buffer, access] : cmdList.GetBufferAccesses()) {
+            auto& use = _dev->GetBufferUse(buffer);
+
+            if(TrackingCommandList::IsWriteAccess(access)) {
+                use.writer = this;
+                use.writeValue = fenceValue;
+                use.readers.clear();
+                continue;
+            }
+
+            auto it = std::find_if(use.readers.begin(), use.readers.end(),
+                [&](auto& r) { return r.first == this; });
+            if(it != use.readers.end()) it->second = fenceValue;
+            else                        use.readers.emplace_back(this, fenceValue);
+        }
+    }
+
     uint64_t TrackingCommandQueue::SubmitCommand(ITrackingCommandList* cmdIf) {
+        VLD_TRACE_ZONE("TrackingCommandQueue::SubmitCommand");
         auto cmd = static_cast<TrackingCommandList*>(cmdIf);
+
+        std::lock_guard lock(_dev->GetSubmitMutex());
         
         //Will also trim states list
         _GetFinishedSubmissions();
+        _dev->CheckAndClearInvalidOwners();
+        _dev->ClearFinishedBufferUses();
 
         auto fenceValue = IncrementLastSubmittedFence();
         
         _TransitResourceStatesBeforeSubmit(*cmd);
         _MarkResourceStatesAfterSubmit(*cmd);
 
+        _WaitForBufferUses(*cmd);
+        _MarkBufferUses(*cmd, fenceValue);
+
         _inner->SubmitCommand(cmd->GetInner());
 
         //Signal the fence
@@ -198,53 +333,32 @@ namespace alloy::layers::AutoResourceUsageTracking
 
     
     void TrackingCommandQueue::PrepareTextureForPresent(TrackedTexView* tex) {
-        auto& cpuTimeline = _dev;
-        
-        auto trackedRef = tex->GetTrackedRef();
+        std::lock_guard lock(_dev->GetSubmitMutex());
 
-        TextureLayout currLayout = TextureLayout::Undefined;
-        if(ContainsResource(trackedRef)) {
-            currLayout = GetLatestResourceState(trackedRef);
-        } else {
-            currLayout = cpuTimeline->FetchCurrentState(trackedRef);
-        }
+        std::vector<BarrierOp> barriers;
+        ReleaseBatches releases;
+        _RequireTextureLayout(tex, TextureLayout::Present, barriers, releases);
 
-        if(currLayout != TextureLayout::Present) {
+        if(!barriers.empty()) {
+            _AcquireFromOwners(releases);
 
             auto fenceValue = IncrementLastSubmittedFence();
-            auto cmdBuf = _GetOneTransitionCmdList();
-
-            BarrierOp op[1] ={
-                TextureBarrierOp{
-                    .texture = common::ref_sp(tex),
-                    .from = {
-                        .stages = PipelineStage::AllCommands,
-                        .access = {},
-                        .layout = currLayout,
-                    },
-                    .to = {
-                        .stages = PipelineStage::AllCommands,
-                        .access = {},
-                        .layout = TextureLayout::Present,
-                    },
-                }
-            };
-
-            cmdBuf->Begin();
-            cmdBuf->Barrier(op);
-            cmdBuf->End();
-
-            std::string debugName = std::format("PrepPresentCmdList_fence#{}", fenceValue);
-            cmdBuf->SetDebugName( debugName );
-
-            _inner->SubmitCommand( cmdBuf.get() );
+            _SubmitTransitions(barriers, "PrepPresentCmdList");
 
             //Signal the fence
             _inner->EncodeSignalEvent(_trackingEvt.GetInner(), fenceValue);
 
-
+            auto trackedRef = tex->GetTrackedRef();
             RegisterTextureState(trackedRef, TextureLayout::Present);
+            _dev->SetTextureOwner(trackedRef, this);
         }
     }
 }
 
+
+namespace alloy
+{
+    common::sp<ITrackingDevice> ITrackingDevice::Make(const common::sp<IGraphicsDevice>& dev) {
+        return common::make_sp<layers::AutoResourceUsageTracking::TrackingDevice>(dev);
+    }
+}
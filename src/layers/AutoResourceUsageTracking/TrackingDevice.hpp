@@ -9,7 +9,10 @@
 #include "TrackingTimeline.hpp"
 #include "TrackingResourceFactory.hpp"
 
-#include <queue>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
 
 namespace alloy::layers::AutoResourceUsageTracking {
 
@@ -34,6 +37,10 @@ namespace alloy::layers::AutoResourceUsageTracking {
             return _inner->WaitFromCPU(expectedValue, timeoutMs);
         }
 
+        virtual void OnReached(uint64_t value, IEvent::ReachedCallback callback) override {
+            _inner->OnReached(value, std::move(callback));
+        }
+
         IEvent* GetInner() const { return _inner.get(); }
 
         GPUTimeline* GetTimeline() const { return _timeline; }
@@ -44,26 +51,48 @@ namespace alloy::layers::AutoResourceUsageTracking {
                                , public GPUTimeline 
     {
         TrackingDevice* _dev;
+
+        // Transition command lists handed back by the event once their
+        // submission finished. Dropped on the submitting thread, command
+        // pools are bound to it. Outlives the event's callbacks.
+        std::mutex _m_retiredCmdLists;
+        std::vector<common::sp<ICommandList>> _retiredCmdLists;
+
         TrackingEvent _trackingEvt;
         ICommandQueue* _inner;
 
-        
-        //Resource transition cmd pools
-        struct CmdPoolInUse {
-            common::sp<ICommandList> cmdList;
-            uint64_t lastSubmittedFence;
-        };
-    
-        std::queue<CmdPoolInUse> _cmdListsInUse;
+        // Highest value of each other queue already waited on, later
+        // submissions are ordered after it anyway
+        std::unordered_map<TrackingCommandQueue*, uint64_t> _waitedValues;
 
         void _RecycleTransitionCmdBufs();
         common::sp<ICommandList> _GetOneTransitionCmdList();
+        void _SubmitTransitions(std::span<const BarrierOp> barriers, const char* name);
 
         void _GetFinishedSubmissions();
 
+        // Release barriers to be submitted on each queue owning a texture
+        using ReleaseBatches = std::unordered_map<TrackingCommandQueue*, std::vector<BarrierOp>>;
+
+        // Adds the barrier bringing tex to layout on this queue. If another
+        // queue used it last, also adds the release that queue must submit.
+        void _RequireTextureLayout(
+            TrackedTexView* tex,
+            TextureLayout layout,
+            std::vector<BarrierOp>& barriers,
+            ReleaseBatches& releases);
+        // Submits the releases on their queues and makes this queue wait
+        void _AcquireFromOwners(const ReleaseBatches& releases);
+        uint64_t _SubmitRelease(std::span<const BarrierOp> barriers);
+
         void _TransitResourceStatesBeforeSubmit(const TrackingCommandList& cmdList);
         void _MarkResourceStatesAfterSubmit(const TrackingCommandList& cmdList);
 
+        // Waits on other queues' unfinished submissions writing a buffer
+        // the list uses, or reading one it writes.
+        void _WaitForBufferUses(const TrackingCommandList& cmdList);
+        void _MarkBufferUses(const TrackingCommandList& cmdList, uint64_t fenceValue);
+
     public:
         TrackingCommandQueue(
             TrackingDevice* dev,
@@ -100,6 +129,18 @@ namespace alloy::layers::AutoResourceUsageTracking {
 
     };
 
+    // Last submissions touching a buffer. Buffers are shared between
+    // queues without ownership, so only execution order is enforced.
+    struct BufferUse {
+        // Keeps the address from being reused while tracked
+        common::sp<IBuffer> buffer;
+
+        TrackingCommandQueue* writer = nullptr;
+        uint64_t writeValue = 0;
+        // Reads since the last write, latest value per queue
+        std::vector<std::pair<TrackingCommandQueue*, uint64_t>> readers;
+    };
+
     class TrackingDevice : public ITrackingDevice
                          , public TrackingResourceFactory<TrackingDevice>
                          , public CPUTimeline
@@ -107,8 +148,18 @@ namespace alloy::layers::AutoResourceUsageTracking {
         common::sp<IGraphicsDevice> _inner;
 
         
-        TrackingCommandQueue* _gfxQ;
-        TrackingCommandQueue* _copyQ;
+        TrackingCommandQueue* _gfxQ = nullptr;
+        TrackingCommandQueue* _copyQ = nullptr;
+        TrackingCommandQueue* _computeQ = nullptr;
+
+        // Queue that last used each texture. Another queue using it
+        // next takes over the ownership first.
+        std::unordered_map<WeakTrackedRef<ITextureView>, TrackingCommandQueue*> _textureOwners;
+
+        std::unordered_map<IBuffer*, BufferUse> _bufferUses;
+
+        // Submissions on any queue read and hand over texture ownership
+        std::mutex _m_submit;
     public:
         TrackingDevice(common::sp<IGraphicsDevice> dev);
         ~TrackingDevice();
@@ -121,6 +172,7 @@ namespace alloy::layers::AutoResourceUsageTracking {
 
         virtual ITrackingCommandQueue* GetGfxCommandQueue() override { return _gfxQ; }
         virtual ITrackingCommandQueue* GetCopyCommandQueue() override { return _copyQ; }
+        virtual ITrackingCommandQueue* GetComputeCommandQueue() override { return _computeQ; }
                
         virtual void WaitForIdle() override {
             _inner->WaitForIdle();
@@ -128,10 +180,39 @@ namespace alloy::layers::AutoResourceUsageTracking {
 
         common::sp<ITexture> CreateTrackedTexture(const ITexture::Description& desc);
 
+        std::mutex& GetSubmitMutex() { return _m_submit; }
+
+        TrackingCommandQueue* GetTextureOwner(const WeakTrackedRef<ITextureView>& ref) const {
+            auto it = _textureOwners.find(ref);
+            return it == _textureOwners.end() ? nullptr : it->second;
+        }
+        void SetTextureOwner(const WeakTrackedRef<ITextureView>& ref, TrackingCommandQueue* q) {
+            _textureOwners[ref] = q;
+        }
+        void CheckAndClearInvalidOwners() {
+            auto it = _textureOwners.cbegin();
+            while(it != _textureOwners.cend()) {
+                if(!it->first)  it = _textureOwners.erase(it);
+                else            ++it;
+            }
+        }
+
+        const BufferUse* FindBufferUse(IBuffer* buffer) const {
+            auto it = _bufferUses.find(buffer);
+            return it == _bufferUses.end() ? nullptr : &it->second;
+        }
+        BufferUse& GetBufferUse(IBuffer* buffer) {
+            auto [it, inserted] = _bufferUses.try_emplace(buffer);
+            if(inserted) it->second.buffer = common::ref_sp(buffer);
+            return it->second;
+        }
+        // Drops buffers whose tracked submissions all finished
+        void ClearFinishedBufferUses();
+
         
         IGraphicsDevice* GetInner() const { return _inner.get(); }
         
-        // We don't need cross submission buffer state for now.
+        // Buffers aren't wrapped, their usage is tracked by address.
         // This function remains dormant
         //common::sp<IBuffer> CreateTrackedBuffer(const ITexture::Description& desc);
     };
@@ -20,12 +20,14 @@ namespace alloy::layers::AutoResourceUsageTracking {
 
 #define T_RF_FOR_EACH_RES(V) \
     /*V(Framebuffer)*/\
-    V(Texture)\
+    /*V(Texture)*/\
     V(Buffer)\
     V(Sampler)\
     /*V(Shader)*/\
     V(ResourceSet)\
     V(MutableResourceSet)\
+    V(ResourceDescriptorHeap)\
+    V(SamplerDescriptorHeap)\
     V(ResourceLayout)
 
 
@@ -33,6 +35,12 @@ namespace alloy::layers::AutoResourceUsageTracking {
 
     T_RF_FOR_EACH_RES(T_IMPL_RF_CREATE_WITH_DESC)
 
+    // Wrapped, views and layout tracking expect TrackedTexture
+    template<>
+    common::sp<ITexture> TFactory::CreateTexture(const ITexture::Description& description) {
+        return GetBase()->CreateTrackedTexture(description);
+    }
+
     //common::sp<IMutableResourceSet> TFactory::CreateMutableResourceSet(
     //    const IMutableResourceSet::Description& description
     //) {
@@ -105,4 +113,37 @@ namespace alloy::layers::AutoResourceUsageTracking {
     common::sp<IEvent> TFactory::CreateSyncEvent() {
        return GetBase()->GetInner()->GetResourceFactory().CreateSyncEvent();
     }
+
+    template<>
+    common::sp<IMemoryHeap> TFactory::CreateMemoryHeap(const IMemoryHeap::Description& description) {
+        return GetBase()->GetInner()->GetResourceFactory().CreateMemoryHeap(description);
+    }
+
+    template<>
+    IMemoryHeap::Placement TFactory::GetPlacement(const IBuffer::Description& description) {
+        return GetBase()->GetInner()->GetResourceFactory().GetPlacement(description);
+    }
+
+    template<>
+    IMemoryHeap::Placement TFactory::GetPlacement(const ITexture::Description& description) {
+        return GetBase()->GetInner()->GetResourceFactory().GetPlacement(description);
+    }
+
+    template<>
+    common::sp<IBuffer> TFactory::CreatePlacedBuffer(
+        const common::sp<IMemoryHeap>& heap,
+        std::uint64_t offset,
+        const IBuffer::Description& description
+    ) {
+        return GetBase()->GetInner()->GetResourceFactory().CreatePlacedBuffer(heap, offset, description);
+    }
+
+    template<>
+    common::sp<ITexture> TFactory::CreatePlacedTexture(
+        const common::sp<IMemoryHeap>& heap,
+        std::uint64_t offset,
+        const ITexture::Description& description
+    ) {
+        return GetBase()->GetInner()->GetResourceFactory().CreatePlacedTexture(heap, offset, description);
+    }
 }
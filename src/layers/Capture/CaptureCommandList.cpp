@@ -0,0 +1,597 @@
+#include "CaptureCommandList.hpp"
+#include "CaptureDevice.hpp"
+
+#include <variant>
+
+namespace alloy::layers::Capture
+{
+    CaptureCommandList::CaptureCommandList(
+        common::sp<CaptureDevice> dev, ObjectId id, common::sp<ICommandList> inner
+    )
+        : _handle(std::move(dev), id)
+        , _inner(std::move(inner))
+        , _w(_stream)
+        , _renderEnc(this)
+        , _computeEnc(this)
+        , _transferEnc(this)
+    { }
+
+    void CaptureCommandList::Begin() {
+        _stream.clear();
+        _retained.clear();
+        _w.Emit(Op::Begin);
+        _inner->Begin();
+    }
+
+    void CaptureCommandList::End() {
+        _w.Emit(Op::End);
+        _inner->End();
+    }
+
+    void CaptureCommandList::_WriteUsage(const PassResourceUsage& usage) {
+        _w.Pod<std::uint32_t>((std::uint32_t)usage.size());
+        for(auto& access : usage) {
+            WriteResourceRef(_w, access.resource.get());
+            _w.Flags(access.stages);
+            _w.Flags(access.access);
+            _Retain(access.resource);
+        }
+    }
+
+    std::vector<PassResourceAccess> CaptureCommandList::_UnwrapUsage(
+        const PassResourceUsage& usage
+    ) {
+        std::vector<PassResourceAccess> res;
+        res.reserve(usage.size());
+        for(auto& access : usage)
+            res.push_back({ UnwrapBindable(access.resource), access.stages, access.access });
+        return res;
+    }
+
+    std::vector<common::sp<IBindableResource>> CaptureCommandList::_WriteResources(
+        IResourceLayout* layout,
+        std::span<const common::sp<IBindableResource>> resources
+    ) {
+        _w.Emit(Op::SetResources, Capture::GetId(layout));
+        _w.Pod<std::uint32_t>((std::uint32_t)resources.size());
+        _Retain(layout);
+
+        std::vector<common::sp<IBindableResource>> inner;
+        inner.reserve(resources.size());
+        for(auto& res : resources) {
+            WriteResourceRef(_w, res.get());
+            _Retain(res);
+            // Unwrapped ranges are new objects, the inner encoder doesn't
+            // keep them alive
+            auto& innerRes = inner.emplace_back(UnwrapBindable(res));
+            _Retain(innerRes);
+        }
+        return inner;
+    }
+
+    IRenderCommandEncoder& CaptureCommandList::BeginRenderPass(
+        const RenderPassAction& action,
+        const PassResourceUsage& usage
+    ) {
+        auto innerAction = action;
+
+        _w.Emit(Op::BeginRenderPass);
+
+        _w.Bool(action.depthTargetAction.has_value());
+        if(auto& depth = action.depthTargetAction) {
+            _w.Pod(Capture::GetId(depth->target));
+            _w.Pod(depth->loadAction);
+            _w.Pod(depth->storeAction);
+            _w.Pod(depth->clearDepth);
+            _w.Pod(Capture::GetId(depth->msaaResolveTarget));
+            _w.Pod(depth->msaaResolveMode);
+            _Retain(depth->target);
+            _Retain(depth->msaaResolveTarget);
+            innerAction.depthTargetAction->target = Unwrap(depth->target);
+            innerAction.depthTargetAction->msaaResolveTarget = Unwrap(depth->msaaResolveTarget);
+        }
+
+        _w.Bool(action.stencilTargetAction.has_value());
+        if(auto& stencil = action.stencilTargetAction) {
+            _w.Pod(Capture::GetId(stencil->target));
+            _w.Pod(stencil->loadAction);
+            _w.Pod(stencil->storeAction);
+            _w.Pod(stencil->clearStencil);
+            _Retain(stencil->target);
+            innerAction.stencilTargetAction->target = Unwrap(stencil->target);
+        }
+
+        _w.Pod<std::uint32_t>((std::uint32_t)action.colorTargetActions.size());
+        for(std::size_t i = 0; i < action.colorTargetActions.size(); i++) {
+            auto& color = action.colorTargetActions[i];
+            _w.Pod(Capture::GetId(color.target));
+            _w.Pod(color.loadAction);
+            _w.Pod(color.storeAction);
+            _w.Pod(color.clearColor);
+            _w.Pod(Capture::GetId(color.msaaResolveTarget));
+            _Retain(color.target);
+            _Retain(color.msaaResolveTarget);
+            innerAction.colorTargetActions[i].target = Unwrap(color.target);
+            innerAction.colorTargetActions[i].msaaResolveTarget = Unwrap(color.msaaResolveTarget);
+        }
+
+        _WriteUsage(usage);
+
+        auto innerUsage = _UnwrapUsage(usage);
+        _innerRender = &_inner->BeginRenderPass(innerAction, innerUsage);
+        return _renderEnc;
+    }
+
+    IComputeCommandEncoder& CaptureCommandList::BeginComputePass(const PassResourceUsage& usage) {
+        _w.Emit(Op::BeginComputePass);
+        _WriteUsage(usage);
+
+        auto innerUsage = _UnwrapUsage(usage);
+        _innerCompute = &_inner->BeginComputePass(innerUsage);
+        return _computeEnc;
+    }
+
+    ITransferCommandEncoder& CaptureCommandList::BeginTransferPass() {
+        _w.Emit(Op::BeginTransferPass);
+        _innerTransfer = &_inner->BeginTransferPass();
+        return _transferEnc;
+    }
+
+    void CaptureCommandList::SetDebugName(const std::string& name) {
+        _w.Emit(Op::SetCommandListName);
+        _w.String(name);
+        _inner->SetDebugName(name);
+    }
+
+    void CaptureCommandList::EndPass() {
+        _w.Emit(Op::EndPass);
+        _inner->EndPass();
+        _innerRender = nullptr;
+        _innerCompute = nullptr;
+        _innerTransfer = nullptr;
+    }
+
+    void CaptureCommandList::Barrier(std::span<const alloy::BarrierOp> barriers) {
+        std::vector<alloy::BarrierOp> innerBarriers;
+        innerBarriers.reserve(barriers.size());
+
+        _w.Emit(Op::Barrier);
+        _w.Pod<std::uint32_t>((std::uint32_t)barriers.size());
+        for(auto& barrier : barriers) {
+            _w.Pod<std::uint8_t>((std::uint8_t)barrier.index());
+            if(auto* buf = std::get_if<BufferBarrierOp>(&barrier)) {
+                WriteBufferRange(_w, buf->buffer.get());
+                _w.Flags(buf->from.stages);
+                _w.Flags(buf->from.access);
+                _w.Flags(buf->to.stages);
+                _w.Flags(buf->to.access);
+                _Retain(buf->buffer);
+                innerBarriers.push_back(BufferBarrierOp{ UnwrapRange(buf->buffer), buf->from, buf->to });
+            } else {
+                auto& tex = std::get<TextureBarrierOp>(barrier);
+                _w.Pod(Capture::GetId(tex.texture));
+                _w.Flags(tex.from.stages);
+                _w.Flags(tex.from.access);
+                _w.Pod(tex.from.layout);
+                _w.Flags(tex.to.stages);
+                _w.Flags(tex.to.access);
+                _w.Pod(tex.to.layout);
+                _Retain(tex.texture);
+
+                QueueTransfer innerTransfer{};
+                bool hasTransfer = tex.queueTransfer.srcQueue && tex.queueTransfer.dstQueue;
+                _w.Pod<std::uint8_t>(hasTransfer);
+                if(hasTransfer) {
+                    auto src = common::PtrCast<CaptureCommandQueue>(tex.queueTransfer.srcQueue);
+                    auto dst = common::PtrCast<CaptureCommandQueue>(tex.queueTransfer.dstQueue);
+                    _w.Pod(src->GetKind());
+                    _w.Pod(dst->GetKind());
+                    innerTransfer = { src->GetInner(), dst->GetInner() };
+                }
+                innerBarriers.push_back(
+                    TextureBarrierOp{ Unwrap(tex.texture), tex.from, tex.to, innerTransfer });
+            }
+        }
+
+        _inner->Barrier(innerBarriers);
+    }
+
+    void CaptureCommandList::PushDebugGroup(const std::string& name, const Color4f& color) {
+        _w.Emit(Op::PushDebugGroup);
+        _w.String(name);
+        _w.Pod(color);
+        _inner->PushDebugGroup(name, color);
+    }
+
+    void CaptureCommandList::PopDebugGroup() {
+        _w.Emit(Op::PopDebugGroup);
+        _inner->PopDebugGroup();
+    }
+
+    void CaptureCommandList::InsertDebugMarker(const std::string& name, const Color4f& color) {
+        _w.Emit(Op::InsertDebugMarker);
+        _w.String(name);
+        _w.Pod(color);
+        _inner->InsertDebugMarker(name, color);
+    }
+
+    // Render encoder
+
+    void CaptureRenderCmdEnc::SetPipeline(const common::sp<IGfxPipeline>& pipeline) {
+        _cmdList->_w.Emit(Op::SetGfxPipeline, GetId(pipeline));
+        _cmdList->_Retain(pipeline);
+        _cmdList->_innerRender->SetPipeline(Unwrap(pipeline));
+    }
+
+    void CaptureRenderCmdEnc::SetPipeline(const common::sp<IMeshShaderPipeline>& pipeline) {
+        _cmdList->_w.Emit(Op::SetMeshShaderPipeline, GetId(pipeline));
+        _cmdList->_Retain(pipeline);
+        _cmdList->_innerRender->SetPipeline(Unwrap(pipeline));
+    }
+
+    void CaptureRenderCmdEnc::SetVertexBuffer(
+        std::uint32_t index, const common::sp<BufferRange>& buffer
+    ) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::SetVertexBuffer, index);
+        w.Bool(false);
+        WriteBufferRange(w, buffer.get());
+        _cmdList->_Retain(buffer);
+        _cmdList->_innerRender->SetVertexBuffer(index, UnwrapRange(buffer));
+    }
+
+    void CaptureRenderCmdEnc::SetIndexBuffer(
+        const common::sp<BufferRange>& buffer, IndexFormat format
+    ) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::SetIndexBuffer, format);
+        w.Bool(false);
+        WriteBufferRange(w, buffer.get());
+        _cmdList->_Retain(buffer);
+        _cmdList->_innerRender->SetIndexBuffer(UnwrapRange(buffer), format);
+    }
+
+    // The raw overloads are recorded as such, so replay takes the same
+    // non-owning path
+    void CaptureRenderCmdEnc::SetVertexBuffer(
+        std::uint32_t index, IBuffer* buffer, std::uint64_t offsetInBytes
+    ) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::SetVertexBuffer, index);
+        w.Bool(true);
+        w.Pod(GetId(buffer));
+        w.Pod(offsetInBytes);
+        _cmdList->_Retain(buffer);
+        _cmdList->_innerRender->SetVertexBuffer(index, Unwrap(buffer).get(), offsetInBytes);
+    }
+
+    void CaptureRenderCmdEnc::SetIndexBuffer(
+        IBuffer* buffer, IndexFormat format, std::uint64_t offsetInBytes
+    ) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::SetIndexBuffer, format);
+        w.Bool(true);
+        w.Pod(GetId(buffer));
+        w.Pod(offsetInBytes);
+        _cmdList->_Retain(buffer);
+        _cmdList->_innerRender->SetIndexBuffer(Unwrap(buffer).get(), format, offsetInBytes);
+    }
+
+    void CaptureRenderCmdEnc::SetPushConstants(
+        std::uint32_t pushConstantIndex,
+        std::span<const uint32_t> data,
+        std::uint32_t destOffsetIn32BitValues
+    ) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::SetPushConstants, pushConstantIndex, destOffsetIn32BitValues);
+        w.PodArray(data);
+        _cmdList->_innerRender->SetPushConstants(pushConstantIndex, data, destOffsetIn32BitValues);
+    }
+
+    void CaptureRenderCmdEnc::SetGraphicsResourceSet(const common::sp<IResourceSet>& rs) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::SetResourceSet, GetId(rs));
+        w.Bool(false);
+        _cmdList->_Retain(rs);
+        _cmdList->_innerRender->SetGraphicsResourceSet(Unwrap(rs));
+    }
+
+    void CaptureRenderCmdEnc::SetGraphicsResourceSet(IResourceSet* rs) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::SetResourceSet, GetId(rs));
+        w.Bool(true);
+        _cmdList->_Retain(rs);
+        _cmdList->_innerRender->SetGraphicsResourceSet(Unwrap(rs).get());
+    }
+
+    void CaptureRenderCmdEnc::SetGraphicsMutableResourceSet(
+        const common::sp<IMutableResourceSet>& rs
+    ) {
+        _cmdList->_w.Emit(Op::SetMutableResourceSet, GetId(rs));
+        _cmdList->_Retain(rs);
+        _cmdList->_innerRender->SetGraphicsMutableResourceSet(Unwrap(rs));
+    }
+
+    void CaptureRenderCmdEnc::SetGraphicsResources(
+        IResourceLayout* layout,
+        std::span<const common::sp<IBindableResource>> resources
+    ) {
+        auto inner = _cmdList->_WriteResources(layout, resources);
+        _cmdList->_innerRender->SetGraphicsResources(Unwrap(layout).get(), inner);
+    }
+
+    void CaptureRenderCmdEnc::SetDescriptorHeaps(
+        const common::sp<IResourceDescriptorHeap>& resourceHeap,
+        const common::sp<ISamplerDescriptorHeap>& samplerHeap
+    ) {
+        _cmdList->_w.Emit(Op::SetDescriptorHeaps, GetId(resourceHeap), GetId(samplerHeap));
+        _cmdList->_Retain(resourceHeap);
+        _cmdList->_Retain(samplerHeap);
+        _cmdList->_innerRender->SetDescriptorHeaps(Unwrap(resourceHeap), Unwrap(samplerHeap));
+    }
+
+    void CaptureRenderCmdEnc::SetViewports(std::span<const Viewport> viewports) {
+        _cmdList->_w.Emit(Op::SetViewports);
+        _cmdList->_w.PodArray(viewports);
+        _cmdList->_innerRender->SetViewports(viewports);
+    }
+
+    void CaptureRenderCmdEnc::SetFullViewport() {
+        _cmdList->_w.Emit(Op::SetFullViewport);
+        _cmdList->_innerRender->SetFullViewport();
+    }
+
+    void CaptureRenderCmdEnc::SetScissorRects(std::span<const Rect> rects) {
+        _cmdList->_w.Emit(Op::SetScissorRects);
+        _cmdList->_w.PodArray(rects);
+        _cmdList->_innerRender->SetScissorRects(rects);
+    }
+
+    void CaptureRenderCmdEnc::SetFullScissorRect() {
+        _cmdList->_w.Emit(Op::SetFullScissorRect);
+        _cmdList->_innerRender->SetFullScissorRect();
+    }
+
+    void CaptureRenderCmdEnc::SetCullMode(RasterizerStateDescription::FaceCullMode cullMode) {
+        _cmdList->_w.Emit(Op::SetCullMode, cullMode);
+        _cmdList->_innerRender->SetCullMode(cullMode);
+    }
+
+    void CaptureRenderCmdEnc::SetDepthTest(
+        bool testEnabled, bool writeEnabled, ComparisonKind comparison
+    ) {
+        _cmdList->_w.Emit(Op::SetDepthTest, comparison);
+        _cmdList->_w.Bool(testEnabled);
+        _cmdList->_w.Bool(writeEnabled);
+        _cmdList->_innerRender->SetDepthTest(testEnabled, writeEnabled, comparison);
+    }
+
+    void CaptureRenderCmdEnc::SetPrimitiveTopology(PrimitiveTopology topology) {
+        _cmdList->_w.Emit(Op::SetPrimitiveTopology, topology);
+        _cmdList->_innerRender->SetPrimitiveTopology(topology);
+    }
+
+    void CaptureRenderCmdEnc::SetStencilOp(
+        bool testEnabled,
+        const DepthStencilStateDescription::StencilBehavior& front,
+        const DepthStencilStateDescription::StencilBehavior& back
+    ) {
+        _cmdList->_w.Emit(Op::SetStencilOp, front, back);
+        _cmdList->_w.Bool(testEnabled);
+        _cmdList->_innerRender->SetStencilOp(testEnabled, front, back);
+    }
+
+    void CaptureRenderCmdEnc::SetBlendEnabled(std::uint32_t attachment, bool enabled) {
+        _cmdList->_w.Emit(Op::SetBlendEnabled, attachment);
+        _cmdList->_w.Bool(enabled);
+        _cmdList->_innerRender->SetBlendEnabled(attachment, enabled);
+    }
+
+    void CaptureRenderCmdEnc::Draw(
+        std::uint32_t vertexCount, std::uint32_t instanceCount,
+        std::uint32_t vertexStart, std::uint32_t instanceStart
+    ) {
+        _cmdList->_w.Emit(Op::Draw, vertexCount, instanceCount, vertexStart, instanceStart);
+        _cmdList->_innerRender->Draw(vertexCount, instanceCount, vertexStart, instanceStart);
+    }
+
+    void CaptureRenderCmdEnc::DrawIndexed(
+        std::uint32_t indexCount, std::uint32_t instanceCount,
+        std::uint32_t indexStart, std::uint32_t vertexOffset,
+        std::uint32_t instanceStart
+    ) {
+        _cmdList->_w.Emit(Op::DrawIndexed,
+            indexCount, instanceCount, indexStart, vertexOffset, instanceStart);
+        _cmdList->_innerRender->DrawIndexed(
+            indexCount, instanceCount, indexStart, vertexOffset, instanceStart);
+    }
+
+    void CaptureRenderCmdEnc::DispatchMesh(
+        std::uint32_t groupCountX,
+        std::uint32_t groupCountY,
+        std::uint32_t groupCountZ
+    ) {
+        _cmdList->_w.Emit(Op::DispatchMesh, groupCountX, groupCountY, groupCountZ);
+        _cmdList->_innerRender->DispatchMesh(groupCountX, groupCountY, groupCountZ);
+    }
+
+    // Compute encoder
+
+    void CaptureComputeCmdEnc::SetPipeline(const common::sp<IComputePipeline>& pipeline) {
+        _cmdList->_w.Emit(Op::SetComputePipeline, GetId(pipeline));
+        _cmdList->_Retain(pipeline);
+        _cmdList->_innerCompute->SetPipeline(Unwrap(pipeline));
+    }
+
+    void CaptureComputeCmdEnc::SetComputeResourceSet(const common::sp<IResourceSet>& rs) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::SetResourceSet, GetId(rs));
+        w.Bool(false);
+        _cmdList->_Retain(rs);
+        _cmdList->_innerCompute->SetComputeResourceSet(Unwrap(rs));
+    }
+
+    void CaptureComputeCmdEnc::SetComputeResourceSet(IResourceSet* rs) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::SetResourceSet, GetId(rs));
+        w.Bool(true);
+        _cmdList->_Retain(rs);
+        _cmdList->_innerCompute->SetComputeResourceSet(Unwrap(rs).get());
+    }
+
+    void CaptureComputeCmdEnc::SetComputeMutableResourceSet(
+        const common::sp<IMutableResourceSet>& rs
+    ) {
+        _cmdList->_w.Emit(Op::SetMutableResourceSet, GetId(rs));
+        _cmdList->_Retain(rs);
+        _cmdList->_innerCompute->SetComputeMutableResourceSet(Unwrap(rs));
+    }
+
+    void CaptureComputeCmdEnc::SetComputeResources(
+        IResourceLayout* layout,
+        std::span<const common::sp<IBindableResource>> resources
+    ) {
+        auto inner = _cmdList->_WriteResources(layout, resources);
+        _cmdList->_innerCompute->SetComputeResources(Unwrap(layout).get(), inner);
+    }
+
+    void CaptureComputeCmdEnc::SetDescriptorHeaps(
+        const common::sp<IResourceDescriptorHeap>& resourceHeap,
+        const common::sp<ISamplerDescriptorHeap>& samplerHeap
+    ) {
+        _cmdList->_w.Emit(Op::SetDescriptorHeaps, GetId(resourceHeap), GetId(samplerHeap));
+        _cmdList->_Retain(resourceHeap);
+        _cmdList->_Retain(samplerHeap);
+        _cmdList->_innerCompute->SetDescriptorHeaps(Unwrap(resourceHeap), Unwrap(samplerHeap));
+    }
+
+    void CaptureComputeCmdEnc::SetPushConstants(
+        std::uint32_t pushConstantIndex,
+        std::span<const uint32_t> data,
+        std::uint32_t destOffsetIn32BitValues
+    ) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::SetPushConstants, pushConstantIndex, destOffsetIn32BitValues);
+        w.PodArray(data);
+        _cmdList->_innerCompute->SetPushConstants(pushConstantIndex, data, destOffsetIn32BitValues);
+    }
+
+    void CaptureComputeCmdEnc::Dispatch(
+        std::uint32_t groupCountX,
+        std::uint32_t groupCountY,
+        std::uint32_t groupCountZ
+    ) {
+        _cmdList->_w.Emit(Op::Dispatch, groupCountX, groupCountY, groupCountZ);
+        _cmdList->_innerCompute->Dispatch(groupCountX, groupCountY, groupCountZ);
+    }
+
+    // Transfer encoder
+
+    void CaptureTransferCmdEnc::CopyBuffer(
+        const common::sp<BufferRange>& source,
+        const common::sp<BufferRange>& destination,
+        std::uint32_t sizeInBytes
+    ) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::CopyBuffer);
+        WriteBufferRange(w, source.get());
+        WriteBufferRange(w, destination.get());
+        w.Pod(sizeInBytes);
+        _cmdList->_Retain(source);
+        _cmdList->_Retain(destination);
+        _cmdList->_innerTransfer->CopyBuffer(
+            UnwrapRange(source), UnwrapRange(destination), sizeInBytes);
+    }
+
+    void CaptureTransferCmdEnc::CopyBufferToTexture(
+        const common::sp<BufferRange>& src,
+        std::uint32_t srcBytesPerRow,
+        std::uint32_t srcBytesPerImage,
+        const common::sp<ITextureView>& dst,
+        const Point3D& dstOrigin,
+        std::uint32_t dstMipLevel,
+        std::uint32_t dstBaseArrayLayer,
+        const Size3D& copySize
+    ) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::CopyBufferToTexture);
+        WriteBufferRange(w, src.get());
+        w.Pod(srcBytesPerRow);
+        w.Pod(srcBytesPerImage);
+        w.Pod(GetId(dst));
+        w.Pod(dstOrigin);
+        w.Pod(dstMipLevel);
+        w.Pod(dstBaseArrayLayer);
+        w.Pod(copySize);
+        _cmdList->_Retain(src);
+        _cmdList->_Retain(dst);
+        _cmdList->_innerTransfer->CopyBufferToTexture(
+            UnwrapRange(src), srcBytesPerRow, srcBytesPerImage,
+            Unwrap(dst), dstOrigin, dstMipLevel, dstBaseArrayLayer, copySize);
+    }
+
+    void CaptureTransferCmdEnc::CopyTextureToBuffer(
+        const common::sp<ITextureView>& src,
+        const Point3D& srcOrigin,
+        std::uint32_t srcMipLevel,
+        std::uint32_t srcBaseArrayLayer,
+        const common::sp<BufferRange>& dst,
+        std::uint32_t srcBytesPerRow,
+        std::uint32_t srcBytesPerImage,
+        const Size3D& copySize
+    ) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::CopyTextureToBuffer);
+        w.Pod(GetId(src));
+        w.Pod(srcOrigin);
+        w.Pod(srcMipLevel);
+        w.Pod(srcBaseArrayLayer);
+        WriteBufferRange(w, dst.get());
+        w.Pod(srcBytesPerRow);
+        w.Pod(srcBytesPerImage);
+        w.Pod(copySize);
+        _cmdList->_Retain(src);
+        _cmdList->_Retain(dst);
+        _cmdList->_innerTransfer->CopyTextureToBuffer(
+            Unwrap(src), srcOrigin, srcMipLevel, srcBaseArrayLayer,
+            UnwrapRange(dst), srcBytesPerRow, srcBytesPerImage, copySize);
+    }
+
+    void CaptureTransferCmdEnc::CopyTexture(
+        const common::sp<ITextureView>& src,
+        const Point3D& srcOrigin,
+        std::uint32_t srcMipLevel,
+        std::uint32_t srcBaseArrayLayer,
+        const common::sp<ITextureView>& dst,
+        const Point3D& dstOrigin,
+        std::uint32_t dstMipLevel,
+        std::uint32_t dstBaseArrayLayer,
+        const Size3D& copySize
+    ) {
+        auto& w = _cmdList->_w;
+        w.Emit(Op::CopyTexture);
+        w.Pod(GetId(src));
+        w.Pod(srcOrigin);
+        w.Pod(srcMipLevel);
+        w.Pod(srcBaseArrayLayer);
+        w.Pod(GetId(dst));
+        w.Pod(dstOrigin);
+        w.Pod(dstMipLevel);
+        w.Pod(dstBaseArrayLayer);
+        w.Pod(copySize);
+        _cmdList->_Retain(src);
+        _cmdList->_Retain(dst);
+        _cmdList->_innerTransfer->CopyTexture(
+            Unwrap(src), srcOrigin, srcMipLevel, srcBaseArrayLayer,
+            Unwrap(dst), dstOrigin, dstMipLevel, dstBaseArrayLayer, copySize);
+    }
+
+    bool CaptureTransferCmdEnc::GenerateMipmaps(const common::sp<ITextureView>& texture) {
+        // Nothing recorded, nothing to replay
+        if(!_cmdList->_innerTransfer->GenerateMipmaps(Unwrap(texture))) return false;
+        _cmdList->_w.Emit(Op::GenerateMipmaps, GetId(texture));
+        _cmdList->_Retain(texture);
+        return true;
+    }
+
+} // namespace alloy::layers::Capture
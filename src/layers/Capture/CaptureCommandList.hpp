@@ -0,0 +1,231 @@
+#pragma once
+
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/CommandList.hpp"
+
+#include "CaptureFormat.hpp"
+#include "CapturedResources.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace alloy::layers::Capture
+{
+    class CaptureDevice;
+    class CaptureCommandList;
+
+    class CaptureRenderCmdEnc : public IRenderCommandEncoder {
+
+        CaptureCommandList* _cmdList;
+
+    public:
+        CaptureRenderCmdEnc(CaptureCommandList* cmdList) : _cmdList(cmdList) { }
+
+        virtual void SetPipeline(const common::sp<IGfxPipeline>&) override;
+        virtual void SetPipeline(const common::sp<IMeshShaderPipeline>&) override;
+
+        virtual void SetVertexBuffer(
+            std::uint32_t index, const common::sp<BufferRange>& buffer) override;
+        virtual void SetIndexBuffer(
+            const common::sp<BufferRange>& buffer, IndexFormat format) override;
+        virtual void SetVertexBuffer(
+            std::uint32_t index, IBuffer* buffer, std::uint64_t offsetInBytes) override;
+        virtual void SetIndexBuffer(
+            IBuffer* buffer, IndexFormat format, std::uint64_t offsetInBytes) override;
+
+        virtual void SetPushConstants(
+            std::uint32_t pushConstantIndex,
+            std::span<const uint32_t> data,
+            std::uint32_t destOffsetIn32BitValues) override;
+
+        virtual void SetGraphicsResourceSet(const common::sp<IResourceSet>& rs) override;
+        virtual void SetGraphicsResourceSet(IResourceSet* rs) override;
+        virtual void SetGraphicsMutableResourceSet(
+            const common::sp<IMutableResourceSet>& rs) override;
+        virtual void SetGraphicsResources(
+            IResourceLayout* layout,
+            std::span<const common::sp<IBindableResource>> resources) override;
+
+        virtual void SetDescriptorHeaps(
+            const common::sp<IResourceDescriptorHeap>& resourceHeap,
+            const common::sp<ISamplerDescriptorHeap>& samplerHeap) override;
+
+        virtual void SetViewports(std::span<const Viewport> viewport) override;
+        virtual void SetFullViewport() override;
+        virtual void SetScissorRects(std::span<const Rect>) override;
+        virtual void SetFullScissorRect() override;
+
+        virtual void SetCullMode(RasterizerStateDescription::FaceCullMode) override;
+        virtual void SetDepthTest(
+            bool testEnabled, bool writeEnabled, ComparisonKind comparison) override;
+        virtual void SetPrimitiveTopology(PrimitiveTopology) override;
+        virtual void SetStencilOp(
+            bool testEnabled,
+            const DepthStencilStateDescription::StencilBehavior& front,
+            const DepthStencilStateDescription::StencilBehavior& back) override;
+        virtual void SetBlendEnabled(std::uint32_t attachment, bool enabled) override;
+
+        virtual void Draw(
+            std::uint32_t vertexCount, std::uint32_t instanceCount,
+            std::uint32_t vertexStart, std::uint32_t instanceStart) override;
+        virtual void DrawIndexed(
+            std::uint32_t indexCount, std::uint32_t instanceCount,
+            std::uint32_t indexStart, std::uint32_t vertexOffset,
+            std::uint32_t instanceStart) override;
+
+        virtual void DispatchMesh(std::uint32_t groupCountX,
+                                  std::uint32_t groupCountY,
+                                  std::uint32_t groupCountZ) override;
+    };
+
+    class CaptureComputeCmdEnc : public IComputeCommandEncoder {
+
+        CaptureCommandList* _cmdList;
+
+    public:
+        CaptureComputeCmdEnc(CaptureCommandList* cmdList) : _cmdList(cmdList) { }
+
+        virtual void SetPipeline(const common::sp<IComputePipeline>&) override;
+
+        virtual void SetComputeResourceSet(const common::sp<IResourceSet>& rs) override;
+        virtual void SetComputeResourceSet(IResourceSet* rs) override;
+        virtual void SetComputeMutableResourceSet(
+            const common::sp<IMutableResourceSet>& rs) override;
+        virtual void SetComputeResources(
+            IResourceLayout* layout,
+            std::span<const common::sp<IBindableResource>> resources) override;
+
+        virtual void SetDescriptorHeaps(
+            const common::sp<IResourceDescriptorHeap>& resourceHeap,
+            const common::sp<ISamplerDescriptorHeap>& samplerHeap) override;
+
+        virtual void SetPushConstants(
+            std::uint32_t pushConstantIndex,
+            std::span<const uint32_t> data,
+            std::uint32_t destOffsetIn32BitValues) override;
+
+        virtual void Dispatch(
+            std::uint32_t groupCountX,
+            std::uint32_t groupCountY,
+            std::uint32_t groupCountZ) override;
+    };
+
+    class CaptureTransferCmdEnc : public ITransferCommandEncoder {
+
+        CaptureCommandList* _cmdList;
+
+    public:
+        CaptureTransferCmdEnc(CaptureCommandList* cmdList) : _cmdList(cmdList) { }
+
+        virtual void CopyBuffer(
+            const common::sp<BufferRange>& source,
+            const common::sp<BufferRange>& destination,
+            std::uint32_t sizeInBytes) override;
+
+        virtual void CopyBufferToTexture(
+            const common::sp<BufferRange>& src,
+            std::uint32_t srcBytesPerRow,
+            std::uint32_t srcBytesPerImage,
+            const common::sp<ITextureView>& dst,
+            const Point3D& dstOrigin,
+            std::uint32_t dstMipLevel,
+            std::uint32_t dstBaseArrayLayer,
+            const Size3D& copySize) override;
+
+        virtual void CopyTextureToBuffer(
+            const common::sp<ITextureView>& src,
+            const Point3D& srcOrigin,
+            std::uint32_t srcMipLevel,
+            std::uint32_t srcBaseArrayLayer,
+            const common::sp<BufferRange>& dst,
+            std::uint32_t srcBytesPerRow,
+            std::uint32_t srcBytesPerImage,
+            const Size3D& copySize) override;
+
+        virtual void CopyTexture(
+            const common::sp<ITextureView>& src,
+            const Point3D& srcOrigin,
+            std::uint32_t srcMipLevel,
+            std::uint32_t srcBaseArrayLayer,
+            const common::sp<ITextureView>& dst,
+            const Point3D& dstOrigin,
+            std::uint32_t dstMipLevel,
+            std::uint32_t dstBaseArrayLayer,
+            const Size3D& copySize) override;
+
+        virtual bool GenerateMipmaps(const common::sp<ITextureView>& texture) override;
+    };
+
+    // Encodes every call into a command stream, written out as one record
+    // at submission, and forwards it to a command list of the inner device.
+    class CaptureCommandList : public ICommandList {
+
+        friend class CaptureRenderCmdEnc;
+        friend class CaptureComputeCmdEnc;
+        friend class CaptureTransferCmdEnc;
+
+        CaptureHandle _handle;
+        common::sp<ICommandList> _inner;
+
+        std::vector<std::uint8_t> _stream;
+        RecordWriter _w;
+        // Captured objects referenced by the stream stay alive, and keep
+        // their destruction record, until the next Begin()
+        std::vector<common::sp<common::RefCntBase>> _retained;
+
+        CaptureRenderCmdEnc _renderEnc;
+        CaptureComputeCmdEnc _computeEnc;
+        CaptureTransferCmdEnc _transferEnc;
+
+        IRenderCommandEncoder* _innerRender = nullptr;
+        IComputeCommandEncoder* _innerCompute = nullptr;
+        ITransferCommandEncoder* _innerTransfer = nullptr;
+
+        template<typename T>
+        void _Retain(const common::sp<T>& obj) {
+            if(obj) _retained.emplace_back(obj);
+        }
+        template<typename T>
+        void _Retain(T* obj) {
+            if(obj) _retained.push_back(common::ref_sp<common::RefCntBase>(obj));
+        }
+
+        void _WriteUsage(const PassResourceUsage& usage);
+        // Records the resources and returns the inner ones, both retained
+        std::vector<common::sp<IBindableResource>> _WriteResources(
+            IResourceLayout* layout,
+            std::span<const common::sp<IBindableResource>> resources);
+        std::vector<PassResourceAccess> _UnwrapUsage(const PassResourceUsage& usage);
+
+    public:
+        CaptureCommandList(
+            common::sp<CaptureDevice> dev, ObjectId id, common::sp<ICommandList> inner);
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        ICommandList* GetInner() const { return _inner.get(); }
+        std::span<const std::uint8_t> GetStream() const { return _stream; }
+
+        virtual void Begin() override;
+        virtual void End() override;
+
+        virtual IRenderCommandEncoder& BeginRenderPass(
+            const RenderPassAction& action,
+            const PassResourceUsage& usage = {}) override;
+        virtual IComputeCommandEncoder& BeginComputePass(
+            const PassResourceUsage& usage = {}) override;
+        virtual ITransferCommandEncoder& BeginTransferPass() override;
+
+        virtual void SetDebugName(const std::string& name) override;
+
+        virtual void EndPass() override;
+
+        virtual void Barrier(std::span<const alloy::BarrierOp> barriers) override;
+
+        virtual void PushDebugGroup(const std::string& name, const Color4f& color) override;
+        virtual void PopDebugGroup() override;
+        virtual void InsertDebugMarker(const std::string& name, const Color4f& color) override;
+    };
+
+} // namespace alloy::layers::Capture
@@ -0,0 +1,494 @@
+#include "CaptureDevice.hpp"
+#include "CapturedResources.hpp"
+#include "CaptureCommandList.hpp"
+
+#include "alloy/common/Common.hpp"
+
+namespace alloy
+{
+    common::sp<ICaptureDevice> ICaptureDevice::Make(
+        const common::sp<IGraphicsDevice>& dev,
+        const std::string& path
+    ) {
+        return layers::Capture::CaptureDevice::Make(dev, path);
+    }
+}
+
+namespace alloy::layers::Capture
+{
+    void CaptureCommandQueue::EncodeSignalEvent(IEvent* evt, uint64_t value) {
+        _dev->Record(Op::QueueSignal, [&](RecordWriter& w) {
+            w.Pod(_kind);
+            w.Pod(GetId(evt));
+            w.Pod(value);
+        });
+        _inner->EncodeSignalEvent(Unwrap(evt).get(), value);
+    }
+
+    void CaptureCommandQueue::EncodeWaitForEvent(IEvent* evt, uint64_t value) {
+        _dev->Record(Op::QueueWait, [&](RecordWriter& w) {
+            w.Pod(_kind);
+            w.Pod(GetId(evt));
+            w.Pod(value);
+        });
+        _inner->EncodeWaitForEvent(Unwrap(evt).get(), value);
+    }
+
+    void CaptureCommandQueue::SubmitCommand(ICommandList* cmd) {
+        auto* list = common::PtrCast<CaptureCommandList>(cmd);
+
+        // Host writes the GPU is about to read land ahead of the submission
+        _dev->FlushMappedBuffers();
+        _dev->Record(Op::Submit, [&](RecordWriter& w) {
+            w.Pod(_kind);
+            w.Pod(list->GetId());
+            w.Blob(list->GetStream());
+        });
+
+        _inner->SubmitCommand(list->GetInner());
+    }
+
+    common::sp<ICommandList> CaptureCommandQueue::CreateCommandList() {
+        auto inner = _inner->CreateCommandList();
+        if(!inner) return nullptr;
+
+        auto id = _dev->AllocateId();
+        _dev->Record(Op::CreateCommandList, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(_kind);
+        });
+        return common::sp<ICommandList>(
+            new CaptureCommandList(common::ref_sp(_dev), id, std::move(inner)));
+    }
+
+    CaptureDevice::CaptureDevice(const common::sp<IGraphicsDevice>& inner)
+        : _inner(inner)
+    {
+        _gfxQ = std::make_unique<CaptureCommandQueue>(
+            this, inner->GetGfxCommandQueue(), QueueKind::Graphics);
+        if(auto copyQ = inner->GetCopyCommandQueue())
+            _copyQ = std::make_unique<CaptureCommandQueue>(this, copyQ, QueueKind::Copy);
+        if(auto computeQ = inner->GetComputeCommandQueue())
+            _computeQ = std::make_unique<CaptureCommandQueue>(this, computeQ, QueueKind::Compute);
+    }
+
+    CaptureDevice::~CaptureDevice() {
+        _file.flush();
+    }
+
+    common::sp<ICaptureDevice> CaptureDevice::Make(
+        const common::sp<IGraphicsDevice>& dev,
+        const std::string& path
+    ) {
+        if(!dev) return nullptr;
+
+        common::sp<CaptureDevice> res(new CaptureDevice(dev));
+        res->_file.open(path, std::ios::binary | std::ios::trunc);
+        if(!res->_file) return nullptr;
+
+        FileHeader header{ kFileMagic, kFileVersion };
+        res->_file.write((const char*)&header, sizeof(header));
+        return res;
+    }
+
+    void CaptureDevice::_WriteRecord(Op op, std::span<const std::uint8_t> payload) {
+        RecordHeader header{ (std::uint16_t)op, 0, (std::uint32_t)payload.size() };
+
+        std::scoped_lock lock{_m_file};
+        _file.write((const char*)&header, sizeof(header));
+        _file.write((const char*)payload.data(), payload.size());
+    }
+
+    void CaptureDevice::RecordDestroy(ObjectId id) {
+        Record(Op::Destroy, [&](RecordWriter& w) { w.Pod(id); });
+    }
+
+    void CaptureDevice::RecordDebugName(ObjectId id, const std::string& name) {
+        Record(Op::SetDebugName, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.String(name);
+        });
+    }
+
+    void CaptureDevice::AddMappedBuffer(CapturedBuffer* buffer, void* mapped) {
+        std::scoped_lock lock{_m_mapped};
+        buffer->SetMapped(mapped);
+        _mappedBuffers.insert(buffer);
+    }
+
+    void CaptureDevice::RemoveMappedBuffer(CapturedBuffer* buffer, bool flush) {
+        std::scoped_lock lock{_m_mapped};
+        if(!_mappedBuffers.erase(buffer)) return;
+        if(flush) buffer->FlushWrites();
+        buffer->SetMapped(nullptr);
+    }
+
+    void CaptureDevice::FlushMappedBuffers() {
+        std::scoped_lock lock{_m_mapped};
+        for(auto* buffer : _mappedBuffers)
+            buffer->FlushWrites();
+    }
+
+    void CaptureDevice::EndFrame() {
+        FlushMappedBuffers();
+        Record(Op::EndFrame);
+    }
+
+    void CaptureDevice::Flush() {
+        std::scoped_lock lock{_m_file};
+        _file.flush();
+    }
+
+    ISwapChain::State CaptureDevice::PresentToSwapChain(ISwapChain* sc) {
+        FlushMappedBuffers();
+        Record(Op::Present, [&](RecordWriter& w) { w.Pod(GetId(sc)); });
+        return _inner->PresentToSwapChain(Unwrap(sc).get());
+    }
+
+    bool CaptureDevice::WaitForEvents(
+        std::span<const EventWait> waits,
+        bool waitAll,
+        uint32_t timeoutMs
+    ) {
+        std::vector<common::sp<IEvent>> inners;
+        std::vector<EventWait> innerWaits;
+        inners.reserve(waits.size());
+        innerWaits.reserve(waits.size());
+        for(auto& w : waits) {
+            inners.push_back(Unwrap(w.event));
+            innerWaits.push_back({ inners.back().get(), w.value });
+        }
+
+        if(!_inner->WaitForEvents(innerWaits, waitAll, timeoutMs))
+            return false;
+
+        for(size_t i = 0; i < waits.size(); i++) {
+            if(!waitAll && inners[i]->GetSignaledValue() < waits[i].value) continue;
+            Record(Op::EventWait, [&](RecordWriter& w) {
+                w.Pod(GetId(waits[i].event));
+                w.Pod(waits[i].value);
+            });
+        }
+        return true;
+    }
+
+    void CaptureDevice::WaitForIdle() {
+        _inner->WaitForIdle();
+        Record(Op::WaitForIdle);
+    }
+
+    common::sp<ITexture> CaptureDevice::CreateTexture(const ITexture::Description& description) {
+        auto inner = _inner->GetResourceFactory().CreateTexture(description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateTexture, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(description);
+        });
+        return common::sp<ITexture>(new CapturedTexture(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<IBuffer> CaptureDevice::CreateBuffer(const IBuffer::Description& description) {
+        auto inner = _inner->GetResourceFactory().CreateBuffer(description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateBuffer, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(description);
+        });
+        return common::sp<IBuffer>(new CapturedBuffer(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<IBuffer> CaptureDevice::CreatePlacedBuffer(
+        const common::sp<IMemoryHeap>& heap,
+        std::uint64_t offset,
+        const IBuffer::Description& description
+    ) {
+        auto inner = _inner->GetResourceFactory().CreatePlacedBuffer(heap, offset, description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateBuffer, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(description);
+        });
+        return common::sp<IBuffer>(new CapturedBuffer(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<ITexture> CaptureDevice::CreatePlacedTexture(
+        const common::sp<IMemoryHeap>& heap,
+        std::uint64_t offset,
+        const ITexture::Description& description
+    ) {
+        auto inner = _inner->GetResourceFactory().CreatePlacedTexture(heap, offset, description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateTexture, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(description);
+        });
+        return common::sp<ITexture>(new CapturedTexture(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<ISampler> CaptureDevice::CreateSampler(const ISampler::Description& description) {
+        auto inner = _inner->GetResourceFactory().CreateSampler(description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateSampler, [&](RecordWriter& w) {
+            w.Pod(id);
+            WriteSamplerDesc(w, description);
+        });
+        return common::sp<ISampler>(new CapturedSampler(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<IResourceSet> CaptureDevice::CreateResourceSet(
+        const IResourceSet::Description& description
+    ) {
+        IResourceSet::Description innerDesc{};
+        innerDesc.layout = Unwrap(description.layout);
+        for(auto& res : description.boundResources)
+            innerDesc.boundResources.push_back(UnwrapBindable(res));
+
+        auto inner = _inner->GetResourceFactory().CreateResourceSet(innerDesc);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateResourceSet, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(GetId(description.layout));
+            w.Pod<std::uint32_t>((std::uint32_t)description.boundResources.size());
+            for(auto& res : description.boundResources)
+                WriteResourceRef(w, res.get());
+        });
+        return common::sp<IResourceSet>(
+            new CapturedResourceSet(common::ref_sp(this), id, description, std::move(inner)));
+    }
+
+    common::sp<IMutableResourceSet> CaptureDevice::CreateMutableResourceSet(
+        const IMutableResourceSet::Description& description
+    ) {
+        IMutableResourceSet::Description innerDesc{};
+        innerDesc.layout = Unwrap(description.layout);
+        innerDesc.initialWrites = UnwrapWrites(description.initialWrites);
+
+        auto inner = _inner->GetResourceFactory().CreateMutableResourceSet(innerDesc);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateMutableResourceSet, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(GetId(description.layout));
+            WriteBindingWrites(w, description.initialWrites);
+        });
+        return common::sp<IMutableResourceSet>(
+            new CapturedMutableResourceSet(common::ref_sp(this), id, description, std::move(inner)));
+    }
+
+    common::sp<IResourceDescriptorHeap> CaptureDevice::CreateResourceDescriptorHeap(
+        const IResourceDescriptorHeap::Description& description
+    ) {
+        auto inner = _inner->GetResourceFactory().CreateResourceDescriptorHeap(description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateResourceDescriptorHeap, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(description);
+        });
+        return common::sp<IResourceDescriptorHeap>(
+            new CapturedResourceHeap(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<ISamplerDescriptorHeap> CaptureDevice::CreateSamplerDescriptorHeap(
+        const ISamplerDescriptorHeap::Description& description
+    ) {
+        auto inner = _inner->GetResourceFactory().CreateSamplerDescriptorHeap(description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateSamplerDescriptorHeap, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(description);
+        });
+        return common::sp<ISamplerDescriptorHeap>(
+            new CapturedSamplerHeap(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<IResourceLayout> CaptureDevice::CreateResourceLayout(
+        const IResourceLayout::Description& description
+    ) {
+        auto inner = _inner->GetResourceFactory().CreateResourceLayout(description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateResourceLayout, [&](RecordWriter& w) {
+            w.Pod(id);
+            WriteResourceLayoutDesc(w, description);
+        });
+        return common::sp<IResourceLayout>(
+            new CapturedResourceLayout(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<ISwapChain> CaptureDevice::CreateSwapChain(const ISwapChain::Description& description) {
+        auto inner = _inner->GetResourceFactory().CreateSwapChain(description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateSwapChain, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(description.initialWidth);
+            w.Pod(description.initialHeight);
+            w.Pod(description.backBufferCnt);
+            w.Bool(description.syncToVerticalBlank);
+            w.Bool(description.colorSrgb);
+        });
+        return common::sp<ISwapChain>(
+            new CapturedSwapChain(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<IShader> CaptureDevice::CreateShader(
+        const IShader::Description& description,
+        const std::span<const std::uint8_t>& il
+    ) {
+        auto inner = _inner->GetResourceFactory().CreateShader(description, il);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateShader, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(description.stage);
+            w.String(description.entryPoint);
+            w.Bool(description.enableDebug);
+            w.Blob(il);
+        });
+        return common::sp<IShader>(new CapturedShader(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<IGfxPipeline> CaptureDevice::CreateGraphicsPipeline(
+        const GraphicsPipelineDescription& description
+    ) {
+        auto innerDesc = description;
+        innerDesc.shaderSet.vertexShader = Unwrap(description.shaderSet.vertexShader);
+        innerDesc.shaderSet.fragmentShader = Unwrap(description.shaderSet.fragmentShader);
+        innerDesc.resourceLayout = Unwrap(description.resourceLayout);
+
+        auto inner = _inner->GetResourceFactory().CreateGraphicsPipeline(innerDesc);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateGraphicsPipeline, [&](RecordWriter& w) {
+            w.Pod(id);
+            WriteFixedFunctionState(w,
+                description.attachmentState,
+                description.depthStencilState,
+                description.rasterizerState,
+                description.primitiveTopology);
+            w.Pod(description.dynamicStates);
+            WriteVertexLayouts(w, description.shaderSet.vertexLayouts);
+            w.PodArray<SpecializationConstant>(description.shaderSet.specializations);
+            w.Pod(GetId(description.shaderSet.vertexShader));
+            w.Pod(GetId(description.shaderSet.fragmentShader));
+            w.Pod(GetId(description.resourceLayout));
+        });
+        return common::sp<IGfxPipeline>(
+            new CapturedGfxPipeline(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<IComputePipeline> CaptureDevice::CreateComputePipeline(
+        const ComputePipelineDescription& description
+    ) {
+        auto innerDesc = description;
+        innerDesc.computeShader = Unwrap(description.computeShader);
+        innerDesc.resourceLayout = Unwrap(description.resourceLayout);
+
+        auto inner = _inner->GetResourceFactory().CreateComputePipeline(innerDesc);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateComputePipeline, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(GetId(description.computeShader));
+            w.Pod(GetId(description.resourceLayout));
+            w.PodArray<SpecializationConstant>(description.specializations);
+        });
+        return common::sp<IComputePipeline>(
+            new CapturedComputePipeline(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<IMeshShaderPipeline> CaptureDevice::CreateMeshShaderPipeline(
+        const MeshShaderPipelineDescription& description
+    ) {
+        auto innerDesc = description;
+        innerDesc.taskShader = Unwrap(description.taskShader);
+        innerDesc.meshShader = Unwrap(description.meshShader);
+        innerDesc.fragmentShader = Unwrap(description.fragmentShader);
+        innerDesc.resourceLayout = Unwrap(description.resourceLayout);
+
+        auto inner = _inner->GetResourceFactory().CreateMeshShaderPipeline(innerDesc);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateMeshShaderPipeline, [&](RecordWriter& w) {
+            w.Pod(id);
+            WriteFixedFunctionState(w,
+                description.attachmentState,
+                description.depthStencilState,
+                description.rasterizerState,
+                description.primitiveTopology);
+            w.Pod(GetId(description.taskShader));
+            w.Pod(GetId(description.meshShader));
+            w.Pod(GetId(description.fragmentShader));
+            w.Pod(GetId(description.resourceLayout));
+            w.PodArray<SpecializationConstant>(description.specializations);
+        });
+        return common::sp<IMeshShaderPipeline>(
+            new CapturedMeshShaderPipeline(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<ITexture> CaptureDevice::WrapNativeTexture(
+        void* nativeHandle,
+        const ITexture::Description& description
+    ) {
+        auto inner = _inner->GetResourceFactory().WrapNativeTexture(nativeHandle, description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateTexture, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(inner->GetDesc());
+        });
+        return common::sp<ITexture>(new CapturedTexture(common::ref_sp(this), id, std::move(inner)));
+    }
+
+    common::sp<ITextureView> CaptureDevice::CreateTextureView(
+        const common::sp<ITexture>& texture,
+        const ITextureView::Description& description
+    ) {
+        auto inner = _inner->GetResourceFactory().CreateTextureView(Unwrap(texture), description);
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateTextureView, [&](RecordWriter& w) {
+            w.Pod(id);
+            w.Pod(GetId(texture));
+            w.Pod(description);
+        });
+        return common::sp<ITextureView>(new CapturedTextureView(
+            common::ref_sp(this), id,
+            common::SPCast<CapturedTexture>(texture), std::move(inner)));
+    }
+
+    common::sp<IEvent> CaptureDevice::CreateSyncEvent() {
+        auto inner = _inner->GetResourceFactory().CreateSyncEvent();
+        if(!inner) return nullptr;
+
+        auto id = AllocateId();
+        Record(Op::CreateSyncEvent, [&](RecordWriter& w) { w.Pod(id); });
+        return common::sp<IEvent>(new CapturedEvent(common::ref_sp(this), id, std::move(inner)));
+    }
+
+} // namespace alloy::layers::Capture
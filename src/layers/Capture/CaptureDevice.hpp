@@ -0,0 +1,201 @@
+#pragma once
+
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/GraphicsDevice.hpp"
+#include "alloy/ResourceFactory.hpp"
+#include "alloy/CommandQueue.hpp"
+#include "alloy/layers/Capture/ICaptureDevice.hpp"
+
+#include "CaptureFormat.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace alloy::layers::Capture
+{
+    class CaptureDevice;
+    class CapturedBuffer;
+
+    class CaptureCommandQueue : public ICommandQueue {
+
+        CaptureDevice* _dev;
+        ICommandQueue* _inner;
+        QueueKind _kind;
+
+    public:
+        CaptureCommandQueue(CaptureDevice* dev, ICommandQueue* inner, QueueKind kind)
+            : _dev(dev), _inner(inner), _kind(kind) { }
+
+        ICommandQueue* GetInner() const { return _inner; }
+        QueueKind GetKind() const { return _kind; }
+
+        virtual void EncodeSignalEvent(IEvent* evt, uint64_t value) override;
+        virtual void EncodeWaitForEvent(IEvent* evt, uint64_t value) override;
+
+        virtual void SubmitCommand(ICommandList* cmd) override;
+
+        virtual common::sp<ICommandList> CreateCommandList() override;
+
+        virtual void* GetNativeHandle() const override { return _inner->GetNativeHandle(); }
+    };
+
+    class CaptureDevice : public ICaptureDevice
+                        , public ResourceFactory
+    {
+        common::sp<IGraphicsDevice> _inner;
+
+        std::unique_ptr<CaptureCommandQueue> _gfxQ;
+        std::unique_ptr<CaptureCommandQueue> _copyQ;
+        std::unique_ptr<CaptureCommandQueue> _computeQ;
+
+        std::atomic<ObjectId> _nextId{1};
+
+        std::mutex _m_file;
+        std::ofstream _file;
+
+        // Buffers mapped since their last flush, diffed at every submit
+        std::mutex _m_mapped;
+        std::unordered_set<CapturedBuffer*> _mappedBuffers;
+
+        CaptureDevice(const common::sp<IGraphicsDevice>& inner);
+
+        void _WriteRecord(Op op, std::span<const std::uint8_t> payload);
+
+    public:
+        ~CaptureDevice() override;
+
+        static common::sp<ICaptureDevice> Make(
+            const common::sp<IGraphicsDevice>& dev,
+            const std::string& path);
+
+        IGraphicsDevice* GetInner() const { return _inner.get(); }
+
+        ObjectId AllocateId() { return _nextId.fetch_add(1, std::memory_order_relaxed); }
+
+        // Appends one record, its payload filled by fill(RecordWriter&)
+        template<typename Fn>
+        void Record(Op op, Fn&& fill) {
+            std::vector<std::uint8_t> payload;
+            RecordWriter w(payload);
+            fill(w);
+            _WriteRecord(op, payload);
+        }
+
+        void Record(Op op) { _WriteRecord(op, {}); }
+
+        void RecordDestroy(ObjectId id);
+        void RecordDebugName(ObjectId id, const std::string& name);
+
+        void AddMappedBuffer(CapturedBuffer* buffer, void* mapped);
+        // Flushes the buffer's pending writes first if flush is set
+        void RemoveMappedBuffer(CapturedBuffer* buffer, bool flush);
+        // Records what changed in every mapped buffer
+        void FlushMappedBuffers();
+
+    //ICaptureDevice
+    public:
+        virtual void EndFrame() override;
+        virtual void Flush() override;
+
+    //IGraphicsDevice
+    public:
+        virtual const Features& GetFeatures() const override { return _inner->GetFeatures(); }
+        virtual IPhysicalAdapter& GetAdapter() const override { return _inner->GetAdapter(); }
+
+        virtual void* GetNativeHandle() const override { return _inner->GetNativeHandle(); }
+
+        virtual ResourceFactory& GetResourceFactory() override { return *this; }
+
+        virtual ISwapChain::State PresentToSwapChain(ISwapChain* sc) override;
+
+        virtual ICommandQueue* GetGfxCommandQueue() override { return _gfxQ.get(); }
+        virtual ICommandQueue* GetCopyCommandQueue() override { return _copyQ.get(); }
+        virtual ICommandQueue* GetComputeCommandQueue() override { return _computeQ.get(); }
+
+        // Submissions still reach the inner device's command lists
+        virtual IGpuProfiler* GetGpuProfiler() override { return _inner->GetGpuProfiler(); }
+        virtual IBufferDefragmenter* GetBufferDefragmenter() override { return _inner->GetBufferDefragmenter(); }
+
+        virtual bool GetMemoryStats(MemoryStats& stats, bool detailed) override {
+            return _inner->GetMemoryStats(stats, detailed);
+        }
+        virtual std::string DumpMemoryStats(bool detailed) override { return _inner->DumpMemoryStats(detailed); }
+        virtual void SetMemoryBudgetCallback(MemoryBudgetCallback callback) override {
+            _inner->SetMemoryBudgetCallback(std::move(callback));
+        }
+
+        // Records the waits that completed, like CapturedEvent::WaitFromCPU
+        virtual bool WaitForEvents(std::span<const EventWait> waits, bool waitAll, uint32_t timeoutMs) override;
+        using IGraphicsDevice::WaitForEvents;
+
+        virtual void WaitForIdle() override;
+
+    //ResourceFactory
+    public:
+        #define CAPTURE_DECL_RF_CREATE_WITH_DESC(ResType) \
+            virtual common::sp<I##ResType> Create##ResType ( \
+                const I##ResType ::Description& description) override;
+
+        VLD_RF_FOR_EACH_RES(CAPTURE_DECL_RF_CREATE_WITH_DESC)
+
+        #undef CAPTURE_DECL_RF_CREATE_WITH_DESC
+
+        virtual common::sp<IShader> CreateShader(
+            const IShader::Description& description,
+            const std::span<const std::uint8_t>& il) override;
+
+        virtual common::sp<IGfxPipeline> CreateGraphicsPipeline(
+            const GraphicsPipelineDescription& description) override;
+
+        virtual common::sp<IComputePipeline> CreateComputePipeline(
+            const ComputePipelineDescription& description) override;
+
+        virtual common::sp<IMeshShaderPipeline> CreateMeshShaderPipeline(
+            const MeshShaderPipelineDescription& description) override;
+
+        // Recorded as a plain texture of the same description, the
+        // native contents aren't captured
+        virtual common::sp<ITexture> WrapNativeTexture(
+            void* nativeHandle,
+            const ITexture::Description& description) override;
+
+        using ResourceFactory::CreateTextureView;
+        virtual common::sp<ITextureView> CreateTextureView(
+            const common::sp<ITexture>& texture,
+            const ITextureView::Description& description) override;
+
+        virtual common::sp<IEvent> CreateSyncEvent() override;
+
+        // Heaps aren't recorded, placed resources replay as dedicated ones
+        virtual common::sp<IMemoryHeap> CreateMemoryHeap(
+            const IMemoryHeap::Description& description) override {
+            return _inner->GetResourceFactory().CreateMemoryHeap(description);
+        }
+
+        virtual IMemoryHeap::Placement GetPlacement(
+            const IBuffer::Description& description) override {
+            return _inner->GetResourceFactory().GetPlacement(description);
+        }
+        virtual IMemoryHeap::Placement GetPlacement(
+            const ITexture::Description& description) override {
+            return _inner->GetResourceFactory().GetPlacement(description);
+        }
+
+        virtual common::sp<IBuffer> CreatePlacedBuffer(
+            const common::sp<IMemoryHeap>& heap,
+            std::uint64_t offset,
+            const IBuffer::Description& description) override;
+        virtual common::sp<ITexture> CreatePlacedTexture(
+            const common::sp<IMemoryHeap>& heap,
+            std::uint64_t offset,
+            const ITexture::Description& description) override;
+    };
+
+} // namespace alloy::layers::Capture
@@ -0,0 +1,141 @@
+#include "CaptureFormat.hpp"
+
+namespace alloy::layers::Capture
+{
+    void WriteSamplerDesc(RecordWriter& w, const ISampler::Description& desc) {
+        w.Pod(desc.addressModeU);
+        w.Pod(desc.addressModeV);
+        w.Pod(desc.addressModeW);
+        w.Pod(desc.borderColor);
+        w.Pod(desc.filter);
+        w.Bool(desc.comparisonKind != nullptr);
+        w.Pod(desc.comparisonKind ? *desc.comparisonKind : ComparisonKind::Never);
+        w.Pod(desc.maximumAnisotropy);
+        w.Pod(desc.minimumLod);
+        w.Pod(desc.maximumLod);
+        w.Pod(desc.lodBias);
+    }
+
+    ISampler::Description ReadSamplerDesc(RecordReader& r, ComparisonKind& comparison) {
+        ISampler::Description desc{};
+        desc.addressModeU = r.Pod<ISampler::Description::AddressMode>();
+        desc.addressModeV = r.Pod<ISampler::Description::AddressMode>();
+        desc.addressModeW = r.Pod<ISampler::Description::AddressMode>();
+        desc.borderColor = r.Pod<ISampler::Description::BorderColor>();
+        desc.filter = r.Pod<ISampler::Description::SamplerFilter>();
+        bool hasComparison = r.Bool();
+        comparison = r.Pod<ComparisonKind>();
+        desc.comparisonKind = hasComparison ? &comparison : nullptr;
+        desc.maximumAnisotropy = r.Pod<float>();
+        desc.minimumLod = r.Pod<float>();
+        desc.maximumLod = r.Pod<float>();
+        desc.lodBias = r.Pod<float>();
+        return desc;
+    }
+
+    void WriteResourceLayoutDesc(RecordWriter& w, const IResourceLayout::Description& desc) {
+        w.PodArray<IResourceLayout::PushConstantDescription>(desc.pushConstants);
+        w.Pod<std::uint32_t>((std::uint32_t)desc.shaderResources.size());
+        for(auto& res : desc.shaderResources) {
+            w.Pod(res.bindingSlot);
+            w.Pod(res.bindingSpace);
+            w.Pod(res.bindingCount);
+            w.Pod(res.kind);
+            w.Flags(res.stages);
+            w.Bool(res.options.writable);
+        }
+        w.Bool(desc.useGlobalHeaps);
+        w.Bool(desc.inlineResources);
+    }
+
+    IResourceLayout::Description ReadResourceLayoutDesc(RecordReader& r) {
+        IResourceLayout::Description desc{};
+        desc.pushConstants = r.PodArray<IResourceLayout::PushConstantDescription>();
+        auto count = r.Pod<std::uint32_t>();
+        for(std::uint32_t i = 0; i < count && r.Ok(); i++) {
+            auto& res = desc.shaderResources.emplace_back();
+            res.bindingSlot = r.Pod<std::uint32_t>();
+            res.bindingSpace = r.Pod<std::uint32_t>();
+            res.bindingCount = r.Pod<std::uint32_t>();
+            res.kind = r.Pod<IBindableResource::ResourceKind>();
+            res.stages = r.Flags<IShader::Stage>();
+            res.options.writable = r.Bool();
+        }
+        desc.useGlobalHeaps = r.Bool();
+        desc.inlineResources = r.Bool();
+        return desc;
+    }
+
+    void WriteFixedFunctionState(
+        RecordWriter& w,
+        const AttachmentStateDescription& attachment,
+        const DepthStencilStateDescription& depthStencil,
+        const RasterizerStateDescription& rasterizer,
+        PrimitiveTopology topology
+    ) {
+        w.Pod(attachment.blendConstant);
+        w.Pod(attachment.sampleCount);
+        w.PodArray<AttachmentStateDescription::ColorAttachment>(attachment.colorAttachments);
+        w.Bool(attachment.depthStencilAttachment.has_value());
+        if(attachment.depthStencilAttachment)
+            w.Pod(*attachment.depthStencilAttachment);
+        w.Bool(attachment.alphaToCoverageEnabled);
+        w.Pod(depthStencil);
+        w.Pod(rasterizer);
+        w.Pod(topology);
+    }
+
+    void ReadFixedFunctionState(
+        RecordReader& r,
+        AttachmentStateDescription& attachment,
+        DepthStencilStateDescription& depthStencil,
+        RasterizerStateDescription& rasterizer,
+        PrimitiveTopology& topology
+    ) {
+        attachment.blendConstant = r.Pod<Color4f>();
+        attachment.sampleCount = r.Pod<SampleCount>();
+        attachment.colorAttachments = r.PodArray<AttachmentStateDescription::ColorAttachment>();
+        if(r.Bool())
+            attachment.depthStencilAttachment =
+                r.Pod<AttachmentStateDescription::DepthStencilAttachment>();
+        attachment.alphaToCoverageEnabled = r.Bool();
+        depthStencil = r.Pod<DepthStencilStateDescription>();
+        rasterizer = r.Pod<RasterizerStateDescription>();
+        topology = r.Pod<PrimitiveTopology>();
+    }
+
+    void WriteVertexLayouts(RecordWriter& w, const std::vector<VertexLayout>& layouts) {
+        w.Pod<std::uint32_t>((std::uint32_t)layouts.size());
+        for(auto& layout : layouts) {
+            w.Pod(layout.stride);
+            w.Pod(layout.instanceStepRate);
+            w.Pod<std::uint32_t>((std::uint32_t)layout.elements.size());
+            for(auto& elem : layout.elements) {
+                w.String(elem.name);
+                w.Pod(elem.semantic);
+                w.Pod(elem.format);
+                w.Pod(elem.offset);
+            }
+        }
+    }
+
+    std::vector<VertexLayout> ReadVertexLayouts(RecordReader& r) {
+        std::vector<VertexLayout> layouts;
+        auto count = r.Pod<std::uint32_t>();
+        for(std::uint32_t i = 0; i < count && r.Ok(); i++) {
+            auto& layout = layouts.emplace_back();
+            layout.stride = r.Pod<std::uint32_t>();
+            layout.instanceStepRate = r.Pod<std::uint32_t>();
+            auto elemCount = r.Pod<std::uint32_t>();
+            for(std::uint32_t j = 0; j < elemCount && r.Ok(); j++) {
+                auto& elem = layout.elements.emplace_back();
+                elem.name = r.String();
+                elem.semantic = r.Pod<VertexInputSemantic>();
+                elem.format = r.Pod<ShaderDataType>();
+                elem.offset = r.Pod<std::uint32_t>();
+            }
+        }
+        return layouts;
+    }
+
+} // namespace alloy::layers::Capture
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "alloy/common/BitFlags.hpp"
+#include "alloy/BindableResource.hpp"
+#include "alloy/Pipeline.hpp"
+#include "alloy/Sampler.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace alloy::layers::Capture
+{
+    // A capture file is a FileHeader followed by records until EOF. Each
+    // record is a RecordHeader and `size` bytes of payload.
+    //
+    // Plain structs are stored as their in-memory bytes, so a capture
+    // replays only on a build with the same ABI as the one that wrote it.
+    constexpr std::uint32_t kFileMagic = 0x50414341; // "ACAP"
+    constexpr std::uint32_t kFileVersion = 6;
+
+    struct FileHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+    };
+
+    struct RecordHeader {
+        std::uint16_t op;
+        std::uint16_t reserved;
+        std::uint32_t size;
+    };
+
+    // Assigned at creation, never reused. 0 is null.
+    using ObjectId = std::uint32_t;
+
+    // Queue index, matches IGpuProfiler::Scope::queue
+    enum class QueueKind : std::uint8_t {
+        Graphics, Copy, Compute,
+    };
+
+    // Kind tag of a serialized IBindableResource
+    enum class ResourceRefKind : std::uint8_t {
+        Null, BufferRange, TextureView, Sampler,
+    };
+
+    enum class Op : std::uint16_t {
+        // Device records
+        CreateBuffer,
+        CreateTexture,
+        CreateTextureView,
+        CreateSampler,
+        CreateShader,
+        CreateResourceLayout,
+        CreateResourceSet,
+        CreateMutableResourceSet,
+        CreateResourceDescriptorHeap,
+        CreateSamplerDescriptorHeap,
+        CreateGraphicsPipeline,
+        CreateComputePipeline,
+        CreateMeshShaderPipeline,
+        CreateSyncEvent,
+        CreateCommandList,
+        CreateSwapChain,
+        SwapChainBackBuffer,
+        ResizeSwapChain,
+        Destroy,
+        SetDebugName,
+
+        BufferData,
+        TextureData,
+        UpdateMutableResourceSet,
+        ResourceHeapWrite,
+        ResourceHeapClear,
+        SamplerHeapWrite,
+        SamplerHeapClear,
+
+        EventSignal,
+        EventWait,
+        QueueSignal,
+        QueueWait,
+        Submit,
+        Present,
+        EndFrame,
+        WaitForIdle,
+
+        // Command stream ops, packed back to back in a Submit payload
+        Begin,
+        End,
+        BeginRenderPass,
+        BeginComputePass,
+        BeginTransferPass,
+        EndPass,
+        Barrier,
+        PushDebugGroup,
+        PopDebugGroup,
+        InsertDebugMarker,
+        SetCommandListName,
+
+        SetGfxPipeline,
+        SetMeshShaderPipeline,
+        SetComputePipeline,
+        SetVertexBuffer,
+        SetIndexBuffer,
+        SetPushConstants,
+        SetResourceSet,
+        SetMutableResourceSet,
+        SetResources,
+        SetDescriptorHeaps,
+        SetViewports,
+        SetFullViewport,
+        SetScissorRects,
+        SetFullScissorRect,
+        SetCullMode,
+        SetDepthTest,
+        SetPrimitiveTopology,
+        SetStencilOp,
+        SetBlendEnabled,
+        Draw,
+        DrawIndexed,
+        DispatchMesh,
+        Dispatch,
+
+        CopyBuffer,
+        CopyBufferToTexture,
+        CopyTextureToBuffer,
+        CopyTexture,
+        GenerateMipmaps,
+    };
+
+    class RecordWriter {
+        std::vector<std::uint8_t>& _out;
+
+    public:
+        explicit RecordWriter(std::vector<std::uint8_t>& out) : _out(out) { }
+
+        void Bytes(const void* data, std::size_t size) {
+            auto* p = static_cast<const std::uint8_t*>(data);
+            _out.insert(_out.end(), p, p + size);
+        }
+
+        template<typename T>
+        void Pod(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            Bytes(&value, sizeof(T));
+        }
+
+        template<typename E>
+        void Flags(const common::BitFlags<E>& flags) {
+            std::uint64_t bits = 0;
+            for(std::size_t i = 0; i < flags.size(); i++)
+                if(flags[(E)i]) bits |= 1ull << i;
+            Pod(bits);
+        }
+
+        void Bool(bool value) { Pod<std::uint8_t>(value); }
+
+        void String(const std::string& s) {
+            Pod<std::uint32_t>((std::uint32_t)s.size());
+            Bytes(s.data(), s.size());
+        }
+
+        void Blob(std::span<const std::uint8_t> data) {
+            Pod<std::uint64_t>(data.size());
+            Bytes(data.data(), data.size());
+        }
+
+        template<typename T>
+        void PodArray(std::span<const T> values) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            Pod<std::uint32_t>((std::uint32_t)values.size());
+            Bytes(values.data(), values.size_bytes());
+        }
+
+        // Op tag followed by each argument as a plain struct
+        template<typename... Args>
+        void Emit(Op op, const Args&... args) {
+            Pod(op);
+            (Pod(args), ...);
+        }
+    };
+
+    // Reads past the end yield zeroes and clear Ok()
+    class RecordReader {
+        const std::uint8_t* _cur;
+        const std::uint8_t* _end;
+        bool _ok = true;
+
+    public:
+        explicit RecordReader(std::span<const std::uint8_t> data)
+            : _cur(data.data()), _end(data.data() + data.size()) { }
+
+        bool Ok() const { return _ok; }
+        bool AtEnd() const { return _cur >= _end; }
+
+        void Bytes(void* dst, std::size_t size) {
+            if((std::size_t)(_end - _cur) < size) {
+                _ok = false;
+                _cur = _end;
+                std::memset(dst, 0, size);
+                return;
+            }
+            std::memcpy(dst, _cur, size);
+            _cur += size;
+        }
+
+        std::span<const std::uint8_t> Span(std::size_t size) {
+            if((std::size_t)(_end - _cur) < size) {
+                _ok = false;
+                _cur = _end;
+                return {};
+            }
+            std::span<const std::uint8_t> res{ _cur, size };
+            _cur += size;
+            return res;
+        }
+
+        template<typename T>
+        T Pod() {
+            static_assert(std::is_trivially_copyable_v<T>);
+            T value;
+            Bytes(&value, sizeof(T));
+            return value;
+        }
+
+        template<typename E>
+        common::BitFlags<E> Flags() {
+            common::BitFlags<E> flags{};
+            auto bits = Pod<std::uint64_t>();
+            for(std::size_t i = 0; i < flags.size(); i++)
+                if(bits & (1ull << i)) flags.set((E)i);
+            return flags;
+        }
+
+        bool Bool() { return Pod<std::uint8_t>() != 0; }
+
+        std::string String() {
+            auto size = Pod<std::uint32_t>();
+            auto bytes = Span(size);
+            return { (const char*)bytes.data(), bytes.size() };
+        }
+
+        std::span<const std::uint8_t> Blob() {
+            return Span((std::size_t)Pod<std::uint64_t>());
+        }
+
+        template<typename T>
+        std::vector<T> PodArray() {
+            static_assert(std::is_trivially_copyable_v<T>);
+            auto count = Pod<std::uint32_t>();
+            auto bytes = Span((std::size_t)count * sizeof(T));
+            std::vector<T> res(bytes.size() / sizeof(T));
+            if(!res.empty()) std::memcpy(res.data(), bytes.data(), bytes.size());
+            return res;
+        }
+    };
+
+    // Value parts of object descriptions. Object references are written
+    // by the caller as ids.
+    void WriteSamplerDesc(RecordWriter& w, const ISampler::Description& desc);
+    // comparison receives the pointee of desc.comparisonKind
+    ISampler::Description ReadSamplerDesc(RecordReader& r, ComparisonKind& comparison);
+
+    void WriteResourceLayoutDesc(RecordWriter& w, const IResourceLayout::Description& desc);
+    IResourceLayout::Description ReadResourceLayoutDesc(RecordReader& r);
+
+    void WriteFixedFunctionState(
+        RecordWriter& w,
+        const AttachmentStateDescription& attachment,
+        const DepthStencilStateDescription& depthStencil,
+        const RasterizerStateDescription& rasterizer,
+        PrimitiveTopology topology);
+    void ReadFixedFunctionState(
+        RecordReader& r,
+        AttachmentStateDescription& attachment,
+        DepthStencilStateDescription& depthStencil,
+        RasterizerStateDescription& rasterizer,
+        PrimitiveTopology& topology);
+
+    void WriteVertexLayouts(RecordWriter& w, const std::vector<VertexLayout>& layouts);
+    std::vector<VertexLayout> ReadVertexLayouts(RecordReader& r);
+
+} // namespace alloy::layers::Capture
@@ -0,0 +1,901 @@
+#include "CaptureReplayer.hpp"
+
+#include "alloy/common/Common.hpp"
+#include "alloy/GpuProfiler.hpp"
+#include "alloy/ResourceFactory.hpp"
+#include "alloy/SyncObjects.hpp"
+
+#include <cstring>
+#include <utility>
+#include <variant>
+
+namespace alloy
+{
+    common::sp<ICaptureReplayer> ICaptureReplayer::Make(
+        const common::sp<IGraphicsDevice>& dev,
+        const std::string& path
+    ) {
+        return layers::Capture::CaptureReplayer::Make(dev, path);
+    }
+}
+
+namespace alloy::layers::Capture
+{
+    namespace {
+        std::uint64_t _ElapsedNs(std::chrono::steady_clock::time_point since) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - since).count();
+        }
+
+        // Builds alternative `index` of a descriptor write from whichever
+        // payload it carries
+        template<std::size_t I = 0>
+        ResourceDescriptorWrite _MakeDescriptor(
+            std::size_t index,
+            common::sp<BufferRange> buffer,
+            common::sp<ITextureView> texture
+        ) {
+            if constexpr (I < std::variant_size_v<ResourceDescriptorWrite>) {
+                if(index != I)
+                    return _MakeDescriptor<I + 1>(index, std::move(buffer), std::move(texture));
+
+                using T = std::variant_alternative_t<I, ResourceDescriptorWrite>;
+                if constexpr (requires(T t) { t.buffer; })
+                    return T{ std::move(buffer) };
+                else
+                    return T{ std::move(texture) };
+            } else {
+                return {};
+            }
+        }
+    }
+
+    CaptureReplayer::CaptureReplayer(const common::sp<IGraphicsDevice>& dev)
+        : _dev(dev)
+    { }
+
+    common::sp<ICaptureReplayer> CaptureReplayer::Make(
+        const common::sp<IGraphicsDevice>& dev,
+        const std::string& path
+    ) {
+        if(!dev) return nullptr;
+
+        common::sp<CaptureReplayer> res(new CaptureReplayer(dev));
+        res->_file.open(path, std::ios::binary);
+        if(!res->_file) return nullptr;
+
+        FileHeader header{};
+        res->_file.read((char*)&header, sizeof(header));
+        if(!res->_file || header.magic != kFileMagic || header.version != kFileVersion)
+            return nullptr;
+
+        res->_frameStart = Clock::now();
+        return res;
+    }
+
+    bool CaptureReplayer::_Fail(const std::string& error) {
+        if(_error.empty()) _error = error;
+        return false;
+    }
+
+    ICommandQueue* CaptureReplayer::_GetQueue(QueueKind kind) {
+        // Work of queues the replay device lacks goes to the graphics queue
+        ICommandQueue* queue = nullptr;
+        switch(kind) {
+            case QueueKind::Graphics: break;
+            case QueueKind::Copy: queue = _dev->GetCopyCommandQueue(); break;
+            case QueueKind::Compute: queue = _dev->GetComputeCommandQueue(); break;
+            default:
+                _Fail("unknown queue");
+                return nullptr;
+        }
+        return queue ? queue : _dev->GetGfxCommandQueue();
+    }
+
+    common::sp<BufferRange> CaptureReplayer::_ReadBufferRange(RecordReader& r) {
+        auto id = r.Pod<ObjectId>();
+        auto shape = r.Pod<BufferRange::Shape>();
+        auto kind = r.Pod<IBindableResource::ResourceKind>();
+
+        auto buffer = _Get<IBuffer>(id);
+        if(!buffer) return nullptr;
+
+        if(kind == IBindableResource::ResourceKind::StorageBuffer)
+            return BufferRange::MakeStructuredBuffer(buffer, shape);
+        return BufferRange::MakeByteBuffer(
+            buffer, (std::uint32_t)shape.GetOffsetInBytes(), (std::uint32_t)shape.GetSizeInBytes());
+    }
+
+    common::sp<IBindableResource> CaptureReplayer::_ReadResourceRef(RecordReader& r) {
+        switch(r.Pod<ResourceRefKind>()) {
+            case ResourceRefKind::BufferRange: return _ReadBufferRange(r);
+            case ResourceRefKind::TextureView: return _Get<ITextureView>(r.Pod<ObjectId>());
+            case ResourceRefKind::Sampler: return _Get<ISampler>(r.Pod<ObjectId>());
+            default: return nullptr;
+        }
+    }
+
+    std::vector<IMutableResourceSet::WriteBinding> CaptureReplayer::_ReadBindingWrites(
+        RecordReader& r
+    ) {
+        std::vector<IMutableResourceSet::WriteBinding> res(r.Pod<std::uint32_t>());
+        for(auto& write : res) {
+            if(!r.Ok()) break;
+            write.layoutSlot = r.Pod<std::uint32_t>();
+            write.firstArrayElement = r.Pod<std::uint32_t>();
+            write.resources.resize(r.Pod<std::uint32_t>());
+            for(auto& resource : write.resources) {
+                if(!r.Ok()) break;
+                resource = _ReadResourceRef(r);
+            }
+        }
+        return res;
+    }
+
+    std::vector<PassResourceAccess> CaptureReplayer::_ReadUsage(RecordReader& r) {
+        std::vector<PassResourceAccess> res(r.Pod<std::uint32_t>());
+        for(auto& access : res) {
+            if(!r.Ok()) break;
+            access.resource = _ReadResourceRef(r);
+            access.stages = r.Flags<PipelineStage>();
+            access.access = r.Flags<ResourceAccess>();
+        }
+        return res;
+    }
+
+    ResourceDescriptorWrite CaptureReplayer::_ReadDescriptor(RecordReader& r) {
+        auto index = r.Pod<std::uint8_t>();
+        if(index >= std::variant_size_v<ResourceDescriptorWrite>) {
+            _Fail("unknown descriptor kind");
+            return {};
+        }
+
+        // The alternative decides which payload follows
+        common::sp<BufferRange> buffer;
+        common::sp<ITextureView> texture;
+        auto kind = _MakeDescriptor(index, nullptr, nullptr);
+        std::visit([&](auto& desc) {
+            if constexpr (requires { desc.buffer; })
+                buffer = _ReadBufferRange(r);
+            else
+                texture = _Get<ITextureView>(r.Pod<ObjectId>());
+        }, kind);
+        return _MakeDescriptor(index, std::move(buffer), std::move(texture));
+    }
+
+    bool CaptureReplayer::ReplayFrame(FrameStats& stats) {
+        if(_done || !_error.empty()) return false;
+
+        stats = {};
+        stats.frameIdx = _frameIdx;
+
+        bool any = false;
+        for(;;) {
+            RecordHeader header{};
+            _file.read((char*)&header, sizeof(header));
+            if(_file.gcount() == 0) {
+                _done = true;
+                break;
+            }
+            if(!_file) return _Fail("truncated record header");
+
+            _payload.resize(header.size);
+            _file.read((char*)_payload.data(), header.size);
+            if(!_file) return _Fail("truncated record");
+
+            any = true;
+            RecordReader r(_payload);
+            bool frameEnd = false;
+            if(!_ReplayRecord((Op)header.op, r, stats, frameEnd)) return false;
+            if(!r.Ok()) return _Fail("malformed record, op " + std::to_string(header.op));
+            if(!_error.empty()) return false;
+            if(frameEnd) break;
+        }
+        if(!any) return false;
+
+        stats.wallNs = _ElapsedNs(_frameStart);
+        _frameStart = Clock::now();
+        _frameIdx++;
+        return true;
+    }
+
+    bool CaptureReplayer::_ReplayRecord(
+        Op op, RecordReader& r, FrameStats& stats, bool& frameEnd
+    ) {
+        auto& factory = _dev->GetResourceFactory();
+
+        switch(op) {
+            case Op::CreateBuffer: {
+                auto id = r.Pod<ObjectId>();
+                auto desc = r.Pod<IBuffer::Description>();
+                if(!r.Ok()) break;
+                return _Add(id, factory.CreateBuffer(desc), "buffer");
+            }
+            case Op::CreateTexture: {
+                auto id = r.Pod<ObjectId>();
+                auto desc = r.Pod<ITexture::Description>();
+                if(!r.Ok()) break;
+                return _Add(id, factory.CreateTexture(desc), "texture");
+            }
+            case Op::CreateTextureView: {
+                auto id = r.Pod<ObjectId>();
+                auto tex = _Get<ITexture>(r.Pod<ObjectId>());
+                auto desc = r.Pod<ITextureView::Description>();
+                if(!tex || !r.Ok()) break;
+                return _Add(id, factory.CreateTextureView(tex, desc), "texture view");
+            }
+            case Op::CreateSampler: {
+                auto id = r.Pod<ObjectId>();
+                ComparisonKind comparison;
+                auto desc = ReadSamplerDesc(r, comparison);
+                if(!r.Ok()) break;
+                return _Add(id, factory.CreateSampler(desc), "sampler");
+            }
+            case Op::CreateShader: {
+                auto id = r.Pod<ObjectId>();
+                IShader::Description desc{};
+                desc.stage = r.Pod<IShader::Stage>();
+                desc.entryPoint = r.String();
+                desc.enableDebug = r.Bool();
+                auto il = r.Blob();
+                if(!r.Ok()) break;
+                return _Add(id, factory.CreateShader(desc, il), "shader");
+            }
+            case Op::CreateResourceLayout: {
+                auto id = r.Pod<ObjectId>();
+                auto desc = ReadResourceLayoutDesc(r);
+                if(!r.Ok()) break;
+                return _Add(id, factory.CreateResourceLayout(desc), "resource layout");
+            }
+            case Op::CreateResourceSet: {
+                auto id = r.Pod<ObjectId>();
+                IResourceSet::Description desc{};
+                desc.layout = _Get<IResourceLayout>(r.Pod<ObjectId>());
+                desc.boundResources.resize(r.Pod<std::uint32_t>());
+                for(auto& res : desc.boundResources) {
+                    if(!r.Ok()) break;
+                    res = _ReadResourceRef(r);
+                }
+                if(!r.Ok() || !_error.empty()) break;
+                return _Add(id, factory.CreateResourceSet(desc), "resource set");
+            }
+            case Op::CreateMutableResourceSet: {
+                auto id = r.Pod<ObjectId>();
+                IMutableResourceSet::Description desc{};
+                desc.layout = _Get<IResourceLayout>(r.Pod<ObjectId>());
+                desc.initialWrites = _ReadBindingWrites(r);
+                if(!r.Ok() || !_error.empty()) break;
+                return _Add(id, factory.CreateMutableResourceSet(desc), "mutable resource set");
+            }
+            case Op::CreateResourceDescriptorHeap: {
+                auto id = r.Pod<ObjectId>();
+                auto desc = r.Pod<IResourceDescriptorHeap::Description>();
+                if(!r.Ok()) break;
+                return _Add(id, factory.CreateResourceDescriptorHeap(desc), "resource descriptor heap");
+            }
+            case Op::CreateSamplerDescriptorHeap: {
+                auto id = r.Pod<ObjectId>();
+                auto desc = r.Pod<ISamplerDescriptorHeap::Description>();
+                if(!r.Ok()) break;
+                return _Add(id, factory.CreateSamplerDescriptorHeap(desc), "sampler descriptor heap");
+            }
+            case Op::CreateGraphicsPipeline: {
+                auto id = r.Pod<ObjectId>();
+                GraphicsPipelineDescription desc{};
+                ReadFixedFunctionState(r,
+                    desc.attachmentState,
+                    desc.depthStencilState,
+                    desc.rasterizerState,
+                    desc.primitiveTopology);
+                desc.dynamicStates = r.Pod<DynamicStateDescription>();
+                desc.shaderSet.vertexLayouts = ReadVertexLayouts(r);
+                desc.shaderSet.specializations = r.PodArray<SpecializationConstant>();
+                desc.shaderSet.vertexShader = _Get<IShader>(r.Pod<ObjectId>());
+                desc.shaderSet.fragmentShader = _Get<IShader>(r.Pod<ObjectId>());
+                desc.resourceLayout = _Get<IResourceLayout>(r.Pod<ObjectId>());
+                if(!r.Ok() || !_error.empty()) break;
+                return _Add(id, factory.CreateGraphicsPipeline(desc), "graphics pipeline");
+            }
+            case Op::CreateComputePipeline: {
+                auto id = r.Pod<ObjectId>();
+                ComputePipelineDescription desc{};
+                desc.computeShader = _Get<IShader>(r.Pod<ObjectId>());
+                desc.resourceLayout = _Get<IResourceLayout>(r.Pod<ObjectId>());
+                desc.specializations = r.PodArray<SpecializationConstant>();
+                if(!r.Ok() || !_error.empty()) break;
+                return _Add(id, factory.CreateComputePipeline(desc), "compute pipeline");
+            }
+            case Op::CreateMeshShaderPipeline: {
+                auto id = r.Pod<ObjectId>();
+                MeshShaderPipelineDescription desc{};
+                ReadFixedFunctionState(r,
+                    desc.attachmentState,
+                    desc.depthStencilState,
+                    desc.rasterizerState,
+                    desc.primitiveTopology);
+                desc.taskShader = _Get<IShader>(r.Pod<ObjectId>());
+                desc.meshShader = _Get<IShader>(r.Pod<ObjectId>());
+                desc.fragmentShader = _Get<IShader>(r.Pod<ObjectId>());
+                desc.resourceLayout = _Get<IResourceLayout>(r.Pod<ObjectId>());
+                desc.specializations = r.PodArray<SpecializationConstant>();
+                if(!r.Ok() || !_error.empty()) break;
+                return _Add(id, factory.CreateMeshShaderPipeline(desc), "mesh shader pipeline");
+            }
+            case Op::CreateSyncEvent: {
+                auto id = r.Pod<ObjectId>();
+                if(!r.Ok()) break;
+                return _Add(id, factory.CreateSyncEvent(), "event");
+            }
+            case Op::CreateCommandList: {
+                auto id = r.Pod<ObjectId>();
+                auto kind = r.Pod<QueueKind>();
+                auto* queue = _GetQueue(kind);
+                if(!queue || !r.Ok()) break;
+                _listQueues[id] = kind;
+                return _Add(id, queue->CreateCommandList(), "command list");
+            }
+            case Op::CreateSwapChain:
+            case Op::ResizeSwapChain:
+                // Nothing to create, back buffers are announced separately
+                return true;
+            case Op::SwapChainBackBuffer: {
+                r.Pod<ObjectId>();
+                auto texId = r.Pod<ObjectId>();
+                auto texDesc = r.Pod<ITexture::Description>();
+                auto viewId = r.Pod<ObjectId>();
+                auto viewDesc = r.Pod<ITextureView::Description>();
+                if(!r.Ok()) break;
+
+                texDesc.usage.renderTarget = 1;
+                texDesc.usage.shareable = 0;
+                auto tex = factory.CreateTexture(texDesc);
+                if(!_Add(texId, tex, "offscreen back buffer")) return false;
+                return _Add(viewId, factory.CreateTextureView(tex, viewDesc), "back buffer view");
+            }
+            case Op::Destroy: {
+                auto id = r.Pod<ObjectId>();
+                _objects.erase(id);
+                _listQueues.erase(id);
+                return true;
+            }
+            case Op::SetDebugName: {
+                auto id = r.Pod<ObjectId>();
+                auto name = r.String();
+                auto it = _objects.find(id);
+                if(!r.Ok() || it == _objects.end()) break;
+
+                auto* obj = it->second.get();
+                if(auto* buffer = dynamic_cast<IBuffer*>(obj)) buffer->SetDebugName(name);
+                else if(auto* tex = dynamic_cast<ITexture*>(obj)) tex->SetDebugName(name);
+                else if(auto* sampler = dynamic_cast<ISampler*>(obj)) sampler->SetDebugName(name);
+                return true;
+            }
+
+            case Op::BufferData: {
+                auto buffer = _Get<IBuffer>(r.Pod<ObjectId>());
+                auto offset = r.Pod<std::uint64_t>();
+                auto data = r.Blob();
+                if(!buffer || !r.Ok()) break;
+                if(offset + data.size() > buffer->GetDesc().sizeInBytes)
+                    return _Fail("buffer upload out of range");
+
+                auto* mapped = static_cast<std::uint8_t*>(buffer->MapToCPU());
+                if(!mapped) return _Fail("failed to map buffer for upload");
+                std::memcpy(mapped + offset, data.data(), data.size());
+                buffer->UnMap();
+                return true;
+            }
+            case Op::TextureData: {
+                auto tex = _Get<ITexture>(r.Pod<ObjectId>());
+                auto mip = r.Pod<std::uint32_t>();
+                auto layer = r.Pod<std::uint32_t>();
+                auto origin = r.Pod<Point3D>();
+                auto size = r.Pod<Size3D>();
+                auto rowPitch = r.Pod<std::uint32_t>();
+                auto depthPitch = r.Pod<std::uint32_t>();
+                auto data = r.Blob();
+                if(!tex || !r.Ok()) break;
+                tex->WriteSubresource(mip, layer, origin, size, data.data(), rowPitch, depthPitch);
+                return true;
+            }
+            case Op::UpdateMutableResourceSet: {
+                auto set = _Get<IMutableResourceSet>(r.Pod<ObjectId>());
+                auto writes = _ReadBindingWrites(r);
+                if(!set || !r.Ok() || !_error.empty()) break;
+                set->Update(writes);
+                return true;
+            }
+            case Op::ResourceHeapWrite: {
+                auto heap = _Get<IResourceDescriptorHeap>(r.Pod<ObjectId>());
+                auto index = r.Pod<std::uint32_t>();
+                std::vector<ResourceDescriptorWrite> writes(r.Pod<std::uint32_t>());
+                for(auto& write : writes) {
+                    if(!r.Ok()) break;
+                    write = _ReadDescriptor(r);
+                }
+                if(!heap || !r.Ok() || !_error.empty()) break;
+                heap->WriteRange(ResourceDescriptorIndex{ index }, writes);
+                return true;
+            }
+            case Op::ResourceHeapClear: {
+                auto heap = _Get<IResourceDescriptorHeap>(r.Pod<ObjectId>());
+                auto index = r.Pod<std::uint32_t>();
+                auto count = r.Pod<std::uint32_t>();
+                if(!heap || !r.Ok()) break;
+                heap->ClearRange(ResourceDescriptorIndex{ index }, count);
+                return true;
+            }
+            case Op::SamplerHeapWrite: {
+                auto heap = _Get<ISamplerDescriptorHeap>(r.Pod<ObjectId>());
+                auto index = r.Pod<std::uint32_t>();
+                std::vector<SamplerDescriptorWrite> samplers(r.Pod<std::uint32_t>());
+                for(auto& sampler : samplers) {
+                    if(!r.Ok()) break;
+                    sampler = _Get<ISampler>(r.Pod<ObjectId>());
+                }
+                if(!heap || !r.Ok() || !_error.empty()) break;
+                heap->WriteRange(SamplerDescriptorIndex{ index }, samplers);
+                return true;
+            }
+            case Op::SamplerHeapClear: {
+                auto heap = _Get<ISamplerDescriptorHeap>(r.Pod<ObjectId>());
+                auto index = r.Pod<std::uint32_t>();
+                auto count = r.Pod<std::uint32_t>();
+                if(!heap || !r.Ok()) break;
+                heap->ClearRange(SamplerDescriptorIndex{ index }, count);
+                return true;
+            }
+
+            case Op::EventSignal: {
+                auto evt = _Get<IEvent>(r.Pod<ObjectId>());
+                auto value = r.Pod<std::uint64_t>();
+                if(!evt || !r.Ok()) break;
+                evt->SignalFromCPU(value);
+                return true;
+            }
+            case Op::EventWait: {
+                auto evt = _Get<IEvent>(r.Pod<ObjectId>());
+                auto value = r.Pod<std::uint64_t>();
+                if(!evt || !r.Ok()) break;
+                if(!evt->WaitFromCPU(value)) return _Fail("event wait failed");
+                return true;
+            }
+            case Op::QueueSignal:
+            case Op::QueueWait: {
+                auto* queue = _GetQueue(r.Pod<QueueKind>());
+                auto evt = _Get<IEvent>(r.Pod<ObjectId>());
+                auto value = r.Pod<std::uint64_t>();
+                if(!queue || !evt || !r.Ok()) break;
+                if(op == Op::QueueSignal) queue->EncodeSignalEvent(evt.get(), value);
+                else queue->EncodeWaitForEvent(evt.get(), value);
+                return true;
+            }
+            case Op::Submit: {
+                auto* queue = _GetQueue(r.Pod<QueueKind>());
+                auto list = _Get<ICommandList>(r.Pod<ObjectId>());
+                auto stream = r.Blob();
+                if(!queue || !list || !r.Ok()) break;
+
+                auto start = Clock::now();
+                if(!_ReplayStream(list.get(), stream, stats)) return false;
+                queue->SubmitCommand(list.get());
+                _inlineResources.clear();
+                stats.recordNs += _ElapsedNs(start);
+                stats.submits++;
+                return true;
+            }
+            case Op::Present:
+            case Op::EndFrame: {
+                if(auto* profiler = _dev->GetGpuProfiler())
+                    profiler->EndFrame();
+                frameEnd = true;
+                return true;
+            }
+            case Op::WaitForIdle:
+                _dev->WaitForIdle();
+                return true;
+
+            default:
+                return _Fail("unexpected op " + std::to_string((unsigned)op) + " in capture");
+        }
+
+        return _Fail("malformed record, op " + std::to_string((unsigned)op));
+    }
+
+    bool CaptureReplayer::_ReplayStream(
+        ICommandList* list, std::span<const std::uint8_t> stream, FrameStats& stats
+    ) {
+        RecordReader r(stream);
+
+        IRenderCommandEncoder* render = nullptr;
+        IComputeCommandEncoder* compute = nullptr;
+        ITransferCommandEncoder* transfer = nullptr;
+
+        std::vector<std::string> groups;
+        std::string passName;
+        auto passStart = Clock::now();
+        auto beginPass = [&](const char* kind) {
+            passName = groups.empty() ? kind : groups.back();
+            passStart = Clock::now();
+        };
+
+        while(!r.AtEnd() && r.Ok() && _error.empty()) {
+            auto op = r.Pod<Op>();
+
+            switch(op) {
+                case Op::Begin: list->Begin(); break;
+                case Op::End: list->End(); break;
+
+                case Op::BeginRenderPass: {
+                    beginPass("render");
+
+                    RenderPassAction action{};
+                    if(r.Bool()) {
+                        auto& depth = action.depthTargetAction.emplace();
+                        depth.target = _Get<ITextureView>(r.Pod<ObjectId>());
+                        depth.loadAction = r.Pod<LoadAction>();
+                        depth.storeAction = r.Pod<StoreAction>();
+                        depth.clearDepth = r.Pod<float>();
+                        depth.msaaResolveTarget = _Get<ITextureView>(r.Pod<ObjectId>());
+                        depth.msaaResolveMode = r.Pod<MSAADepthResolveMode>();
+                    }
+                    if(r.Bool()) {
+                        auto& stencil = action.stencilTargetAction.emplace();
+                        stencil.target = _Get<ITextureView>(r.Pod<ObjectId>());
+                        stencil.loadAction = r.Pod<LoadAction>();
+                        stencil.storeAction = r.Pod<StoreAction>();
+                        stencil.clearStencil = r.Pod<std::uint32_t>();
+                    }
+                    action.colorTargetActions.resize(r.Pod<std::uint32_t>());
+                    for(auto& color : action.colorTargetActions) {
+                        if(!r.Ok()) break;
+                        color.target = _Get<ITextureView>(r.Pod<ObjectId>());
+                        color.loadAction = r.Pod<LoadAction>();
+                        color.storeAction = r.Pod<StoreAction>();
+                        color.clearColor = r.Pod<Color4f>();
+                        color.msaaResolveTarget = _Get<ITextureView>(r.Pod<ObjectId>());
+                    }
+                    auto usage = _ReadUsage(r);
+                    if(!r.Ok() || !_error.empty()) break;
+
+                    render = &list->BeginRenderPass(action, usage);
+                    break;
+                }
+                case Op::BeginComputePass: {
+                    beginPass("compute");
+                    auto usage = _ReadUsage(r);
+                    if(!r.Ok() || !_error.empty()) break;
+                    compute = &list->BeginComputePass(usage);
+                    break;
+                }
+                case Op::BeginTransferPass:
+                    beginPass("transfer");
+                    transfer = &list->BeginTransferPass();
+                    break;
+                case Op::EndPass:
+                    list->EndPass();
+                    render = nullptr;
+                    compute = nullptr;
+                    transfer = nullptr;
+                    stats.passes.push_back({ std::move(passName), _ElapsedNs(passStart) });
+                    break;
+
+                case Op::Barrier: {
+                    std::vector<BarrierOp> barriers(r.Pod<std::uint32_t>());
+                    for(auto& barrier : barriers) {
+                        if(!r.Ok()) break;
+                        if(r.Pod<std::uint8_t>() == 0) {
+                            BufferBarrierOp buf{};
+                            buf.buffer = _ReadBufferRange(r);
+                            buf.from.stages = r.Flags<PipelineStage>();
+                            buf.from.access = r.Flags<ResourceAccess>();
+                            buf.to.stages = r.Flags<PipelineStage>();
+                            buf.to.access = r.Flags<ResourceAccess>();
+                            barrier = std::move(buf);
+                        } else {
+                            TextureBarrierOp tex{};
+                            tex.texture = _Get<ITextureView>(r.Pod<ObjectId>());
+                            tex.from.stages = r.Flags<PipelineStage>();
+                            tex.from.access = r.Flags<ResourceAccess>();
+                            tex.from.layout = r.Pod<TextureLayout>();
+                            tex.to.stages = r.Flags<PipelineStage>();
+                            tex.to.access = r.Flags<ResourceAccess>();
+                            tex.to.layout = r.Pod<TextureLayout>();
+                            if(r.Pod<std::uint8_t>()) {
+                                tex.queueTransfer.srcQueue = _GetQueue(r.Pod<QueueKind>());
+                                tex.queueTransfer.dstQueue = _GetQueue(r.Pod<QueueKind>());
+                            }
+                            barrier = std::move(tex);
+                        }
+                    }
+                    if(!r.Ok() || !_error.empty()) break;
+                    list->Barrier(barriers);
+                    break;
+                }
+
+                case Op::PushDebugGroup: {
+                    auto name = r.String();
+                    auto color = r.Pod<Color4f>();
+                    list->PushDebugGroup(name, color);
+                    groups.push_back(std::move(name));
+                    break;
+                }
+                case Op::PopDebugGroup:
+                    list->PopDebugGroup();
+                    if(!groups.empty()) groups.pop_back();
+                    break;
+                case Op::InsertDebugMarker: {
+                    auto name = r.String();
+                    auto color = r.Pod<Color4f>();
+                    list->InsertDebugMarker(name, color);
+                    break;
+                }
+                case Op::SetCommandListName:
+                    list->SetDebugName(r.String());
+                    break;
+
+                case Op::SetGfxPipeline: {
+                    auto pipeline = _Get<IGfxPipeline>(r.Pod<ObjectId>());
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetPipeline(pipeline);
+                    break;
+                }
+                case Op::SetMeshShaderPipeline: {
+                    auto pipeline = _Get<IMeshShaderPipeline>(r.Pod<ObjectId>());
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetPipeline(pipeline);
+                    break;
+                }
+                case Op::SetComputePipeline: {
+                    auto pipeline = _Get<IComputePipeline>(r.Pod<ObjectId>());
+                    if(!compute) return _Fail("compute command outside a compute pass");
+                    compute->SetPipeline(pipeline);
+                    break;
+                }
+                case Op::SetVertexBuffer:
+                case Op::SetIndexBuffer: {
+                    auto index = op == Op::SetVertexBuffer ? r.Pod<std::uint32_t>() : 0;
+                    auto format = op == Op::SetIndexBuffer ? r.Pod<IndexFormat>() : IndexFormat{};
+                    if(!render) return _Fail("render command outside a render pass");
+
+                    if(r.Bool()) {
+                        auto buffer = _Get<IBuffer>(r.Pod<ObjectId>());
+                        auto offset = r.Pod<std::uint64_t>();
+                        if(!r.Ok() || !_error.empty()) break;
+                        if(op == Op::SetVertexBuffer) render->SetVertexBuffer(index, buffer.get(), offset);
+                        else render->SetIndexBuffer(buffer.get(), format, offset);
+                    } else {
+                        auto range = _ReadBufferRange(r);
+                        if(!r.Ok() || !_error.empty()) break;
+                        if(op == Op::SetVertexBuffer) render->SetVertexBuffer(index, range);
+                        else render->SetIndexBuffer(range, format);
+                    }
+                    break;
+                }
+                case Op::SetPushConstants: {
+                    auto index = r.Pod<std::uint32_t>();
+                    auto offset = r.Pod<std::uint32_t>();
+                    auto data = r.PodArray<std::uint32_t>();
+                    if(!r.Ok()) break;
+                    if(render) render->SetPushConstants(index, data, offset);
+                    else if(compute) compute->SetPushConstants(index, data, offset);
+                    else return _Fail("push constants outside a pass");
+                    break;
+                }
+                case Op::SetResourceSet: {
+                    auto set = _Get<IResourceSet>(r.Pod<ObjectId>());
+                    auto raw = r.Bool();
+                    if(!r.Ok() || !_error.empty()) break;
+                    if(render) {
+                        if(raw) render->SetGraphicsResourceSet(set.get());
+                        else render->SetGraphicsResourceSet(set);
+                    } else if(compute) {
+                        if(raw) compute->SetComputeResourceSet(set.get());
+                        else compute->SetComputeResourceSet(set);
+                    } else {
+                        return _Fail("resource set bound outside a pass");
+                    }
+                    break;
+                }
+                case Op::SetMutableResourceSet: {
+                    auto set = _Get<IMutableResourceSet>(r.Pod<ObjectId>());
+                    if(!r.Ok() || !_error.empty()) break;
+                    if(render) render->SetGraphicsMutableResourceSet(set);
+                    else if(compute) compute->SetComputeMutableResourceSet(set);
+                    else return _Fail("resource set bound outside a pass");
+                    break;
+                }
+                case Op::SetResources: {
+                    auto layout = _Get<IResourceLayout>(r.Pod<ObjectId>());
+                    auto first = _inlineResources.size();
+                    auto count = r.Pod<std::uint32_t>();
+                    for(std::uint32_t i = 0; i < count && r.Ok(); i++)
+                        _inlineResources.push_back(_ReadResourceRef(r));
+                    if(!r.Ok() || !_error.empty()) break;
+
+                    std::span<const common::sp<IBindableResource>> resources {
+                        _inlineResources.data() + first, count };
+                    if(render) render->SetGraphicsResources(layout.get(), resources);
+                    else if(compute) compute->SetComputeResources(layout.get(), resources);
+                    else return _Fail("resources bound outside a pass");
+                    break;
+                }
+                case Op::SetDescriptorHeaps: {
+                    auto resourceHeap = _Get<IResourceDescriptorHeap>(r.Pod<ObjectId>());
+                    auto samplerHeap = _Get<ISamplerDescriptorHeap>(r.Pod<ObjectId>());
+                    if(!r.Ok() || !_error.empty()) break;
+                    if(render) render->SetDescriptorHeaps(resourceHeap, samplerHeap);
+                    else if(compute) compute->SetDescriptorHeaps(resourceHeap, samplerHeap);
+                    else return _Fail("descriptor heaps bound outside a pass");
+                    break;
+                }
+                case Op::SetViewports: {
+                    auto viewports = r.PodArray<Viewport>();
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetViewports(viewports);
+                    break;
+                }
+                case Op::SetFullViewport:
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetFullViewport();
+                    break;
+                case Op::SetScissorRects: {
+                    auto rects = r.PodArray<Rect>();
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetScissorRects(rects);
+                    break;
+                }
+                case Op::SetFullScissorRect:
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetFullScissorRect();
+                    break;
+                case Op::SetCullMode: {
+                    auto cullMode = r.Pod<RasterizerStateDescription::FaceCullMode>();
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetCullMode(cullMode);
+                    break;
+                }
+                case Op::SetDepthTest: {
+                    auto comparison = r.Pod<ComparisonKind>();
+                    auto testEnabled = r.Bool();
+                    auto writeEnabled = r.Bool();
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetDepthTest(testEnabled, writeEnabled, comparison);
+                    break;
+                }
+                case Op::SetPrimitiveTopology: {
+                    auto topology = r.Pod<PrimitiveTopology>();
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetPrimitiveTopology(topology);
+                    break;
+                }
+                case Op::SetStencilOp: {
+                    auto front = r.Pod<DepthStencilStateDescription::StencilBehavior>();
+                    auto back = r.Pod<DepthStencilStateDescription::StencilBehavior>();
+                    auto testEnabled = r.Bool();
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetStencilOp(testEnabled, front, back);
+                    break;
+                }
+                case Op::SetBlendEnabled: {
+                    auto attachment = r.Pod<std::uint32_t>();
+                    auto enabled = r.Bool();
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->SetBlendEnabled(attachment, enabled);
+                    break;
+                }
+
+                case Op::Draw: {
+                    auto vertexCount = r.Pod<std::uint32_t>();
+                    auto instanceCount = r.Pod<std::uint32_t>();
+                    auto vertexStart = r.Pod<std::uint32_t>();
+                    auto instanceStart = r.Pod<std::uint32_t>();
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->Draw(vertexCount, instanceCount, vertexStart, instanceStart);
+                    stats.draws++;
+                    break;
+                }
+                case Op::DrawIndexed: {
+                    auto indexCount = r.Pod<std::uint32_t>();
+                    auto instanceCount = r.Pod<std::uint32_t>();
+                    auto indexStart = r.Pod<std::uint32_t>();
+                    auto vertexOffset = r.Pod<std::uint32_t>();
+                    auto instanceStart = r.Pod<std::uint32_t>();
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->DrawIndexed(indexCount, instanceCount, indexStart, vertexOffset, instanceStart);
+                    stats.draws++;
+                    break;
+                }
+                case Op::DispatchMesh: {
+                    auto x = r.Pod<std::uint32_t>();
+                    auto y = r.Pod<std::uint32_t>();
+                    auto z = r.Pod<std::uint32_t>();
+                    if(!render) return _Fail("render command outside a render pass");
+                    render->DispatchMesh(x, y, z);
+                    stats.draws++;
+                    break;
+                }
+                case Op::Dispatch: {
+                    auto x = r.Pod<std::uint32_t>();
+                    auto y = r.Pod<std::uint32_t>();
+                    auto z = r.Pod<std::uint32_t>();
+                    if(!compute) return _Fail("compute command outside a compute pass");
+                    compute->Dispatch(x, y, z);
+                    stats.dispatches++;
+                    break;
+                }
+
+                case Op::CopyBuffer: {
+                    auto src = _ReadBufferRange(r);
+                    auto dst = _ReadBufferRange(r);
+                    auto size = r.Pod<std::uint32_t>();
+                    if(!r.Ok() || !_error.empty()) break;
+                    if(!transfer) return _Fail("transfer command outside a transfer pass");
+                    transfer->CopyBuffer(src, dst, size);
+                    break;
+                }
+                case Op::CopyBufferToTexture: {
+                    auto src = _ReadBufferRange(r);
+                    auto bytesPerRow = r.Pod<std::uint32_t>();
+                    auto bytesPerImage = r.Pod<std::uint32_t>();
+                    auto dst = _Get<ITextureView>(r.Pod<ObjectId>());
+                    auto origin = r.Pod<Point3D>();
+                    auto mip = r.Pod<std::uint32_t>();
+                    auto layer = r.Pod<std::uint32_t>();
+                    auto size = r.Pod<Size3D>();
+                    if(!r.Ok() || !_error.empty()) break;
+                    if(!transfer) return _Fail("transfer command outside a transfer pass");
+                    transfer->CopyBufferToTexture(
+                        src, bytesPerRow, bytesPerImage, dst, origin, mip, layer, size);
+                    break;
+                }
+                case Op::CopyTextureToBuffer: {
+                    auto src = _Get<ITextureView>(r.Pod<ObjectId>());
+                    auto origin = r.Pod<Point3D>();
+                    auto mip = r.Pod<std::uint32_t>();
+                    auto layer = r.Pod<std::uint32_t>();
+                    auto dst = _ReadBufferRange(r);
+                    auto bytesPerRow = r.Pod<std::uint32_t>();
+                    auto bytesPerImage = r.Pod<std::uint32_t>();
+                    auto size = r.Pod<Size3D>();
+                    if(!r.Ok() || !_error.empty()) break;
+                    if(!transfer) return _Fail("transfer command outside a transfer pass");
+                    transfer->CopyTextureToBuffer(
+                        src, origin, mip, layer, dst, bytesPerRow, bytesPerImage, size);
+                    break;
+                }
+                case Op::CopyTexture: {
+                    auto src = _Get<ITextureView>(r.Pod<ObjectId>());
+                    auto srcOrigin = r.Pod<Point3D>();
+                    auto srcMip = r.Pod<std::uint32_t>();
+                    auto srcLayer = r.Pod<std::uint32_t>();
+                    auto dst = _Get<ITextureView>(r.Pod<ObjectId>());
+                    auto dstOrigin = r.Pod<Point3D>();
+                    auto dstMip = r.Pod<std::uint32_t>();
+                    auto dstLayer = r.Pod<std::uint32_t>();
+                    auto size = r.Pod<Size3D>();
+                    if(!r.Ok() || !_error.empty()) break;
+                    if(!transfer) return _Fail("transfer command outside a transfer pass");
+                    transfer->CopyTexture(
+                        src, srcOrigin, srcMip, srcLayer, dst, dstOrigin, dstMip, dstLayer, size);
+                    break;
+                }
+                case Op::GenerateMipmaps: {
+                    auto tex = _Get<ITextureView>(r.Pod<ObjectId>());
+                    if(!r.Ok() || !_error.empty()) break;
+                    if(!transfer) return _Fail("transfer command outside a transfer pass");
+                    if(!transfer->GenerateMipmaps(tex))
+                        return _Fail("GenerateMipmaps unsupported for the texture format");
+                    break;
+                }
+
+                default:
+                    return _Fail("unexpected op " + std::to_string((unsigned)op) + " in command stream");
+            }
+        }
+
+        if(!r.Ok()) return _Fail("malformed command stream");
+        return _error.empty();
+    }
+
+} // namespace alloy::layers::Capture
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/layers/Capture/ICaptureReplayer.hpp"
+#include "alloy/BindableResource.hpp"
+#include "alloy/CommandList.hpp"
+#include "alloy/CommandQueue.hpp"
+#include "alloy/DescriptorHeap.hpp"
+
+#include "CaptureFormat.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace alloy::layers::Capture
+{
+    class CaptureReplayer : public ICaptureReplayer {
+
+        using Clock = std::chrono::steady_clock;
+
+        common::sp<IGraphicsDevice> _dev;
+        std::ifstream _file;
+        std::string _error;
+        bool _done = false;
+
+        std::vector<std::uint8_t> _payload;
+        std::unordered_map<ObjectId, common::sp<common::RefCntBase>> _objects;
+        std::unordered_map<ObjectId, QueueKind> _listQueues;
+        // Bound by SetResources, kept until the list is submitted
+        std::vector<common::sp<IBindableResource>> _inlineResources;
+
+        std::uint64_t _frameIdx = 0;
+        Clock::time_point _frameStart;
+
+        CaptureReplayer(const common::sp<IGraphicsDevice>& dev);
+
+        bool _Fail(const std::string& error);
+
+        // Null for id 0. Sets the error for ids not alive in the capture.
+        template<typename T>
+        common::sp<T> _Get(ObjectId id) {
+            if(!id) return nullptr;
+            auto it = _objects.find(id);
+            if(it == _objects.end()) {
+                _Fail("reference to unknown object " + std::to_string(id));
+                return nullptr;
+            }
+            return common::ref_sp(common::PtrCast<T>(it->second.get()));
+        }
+
+        template<typename T>
+        bool _Add(ObjectId id, const common::sp<T>& obj, const char* what) {
+            if(!obj) return _Fail(std::string("failed to create ") + what);
+            _objects[id] = obj;
+            return true;
+        }
+
+        ICommandQueue* _GetQueue(QueueKind kind);
+
+        common::sp<BufferRange> _ReadBufferRange(RecordReader& r);
+        common::sp<IBindableResource> _ReadResourceRef(RecordReader& r);
+        std::vector<IMutableResourceSet::WriteBinding> _ReadBindingWrites(RecordReader& r);
+        std::vector<PassResourceAccess> _ReadUsage(RecordReader& r);
+        ResourceDescriptorWrite _ReadDescriptor(RecordReader& r);
+
+        bool _ReplayRecord(Op op, RecordReader& r, FrameStats& stats, bool& frameEnd);
+        bool _ReplayStream(ICommandList* list, std::span<const std::uint8_t> stream, FrameStats& stats);
+
+    public:
+        static common::sp<ICaptureReplayer> Make(
+            const common::sp<IGraphicsDevice>& dev,
+            const std::string& path);
+
+        virtual bool ReplayFrame(FrameStats& stats) override;
+        virtual const std::string& GetError() const override { return _error; }
+    };
+
+} // namespace alloy::layers::Capture
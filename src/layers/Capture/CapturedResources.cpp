@@ -0,0 +1,466 @@
+#include "CapturedResources.hpp"
+#include "CaptureDevice.hpp"
+
+#include "alloy/Helpers.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <variant>
+
+namespace alloy::layers::Capture
+{
+    CaptureHandle::~CaptureHandle() {
+        if(_dev) _dev->RecordDestroy(_id);
+    }
+
+    CapturedBuffer::~CapturedBuffer() {
+        _handle.GetDevice()->RemoveMappedBuffer(this, false);
+    }
+
+    void* CapturedBuffer::MapToCPU() {
+        auto ptr = _inner->MapToCPU();
+        // Readback buffers only carry GPU writes
+        if(ptr && _inner->GetDesc().hostAccess != HostAccess::SystemMemoryPreferRead)
+            _handle.GetDevice()->AddMappedBuffer(this, ptr);
+        return ptr;
+    }
+
+    void CapturedBuffer::UnMap() {
+        _handle.GetDevice()->RemoveMappedBuffer(this, true);
+        _inner->UnMap();
+    }
+
+    void CapturedBuffer::FlushWrites() {
+        if(!_mapped) return;
+
+        auto* dev = _handle.GetDevice();
+        auto id = GetId();
+        std::size_t size = _inner->GetDesc().sizeInBytes;
+
+        auto record = [&](std::size_t begin, std::size_t end) {
+            dev->Record(Op::BufferData, [&](RecordWriter& w) {
+                w.Pod(id);
+                w.Pod<std::uint64_t>(begin);
+                w.Blob({ _shadow.data() + begin, end - begin });
+            });
+        };
+
+        if(_shadow.size() != size) {
+            _shadow.assign(_mapped, _mapped + size);
+            if(size) record(0, size);
+            return;
+        }
+
+        // Coalesce runs of changed pages into one record each
+        constexpr std::size_t kPageSize = 4096;
+        std::size_t runBegin = size;
+        for(std::size_t offset = 0; offset < size; offset += kPageSize) {
+            auto len = std::min(kPageSize, size - offset);
+            if(std::memcmp(_mapped + offset, _shadow.data() + offset, len) != 0) {
+                std::memcpy(_shadow.data() + offset, _mapped + offset, len);
+                if(runBegin == size) runBegin = offset;
+            } else if(runBegin != size) {
+                record(runBegin, offset);
+                runBegin = size;
+            }
+        }
+        if(runBegin != size) record(runBegin, size);
+    }
+
+    void CapturedBuffer::SetDebugName(const std::string& name) {
+        _handle.GetDevice()->RecordDebugName(GetId(), name);
+        _inner->SetDebugName(name);
+    }
+
+    void CapturedTexture::SetDebugName(const std::string& name) {
+        _handle.GetDevice()->RecordDebugName(GetId(), name);
+        _inner->SetDebugName(name);
+    }
+
+    void CapturedSampler::SetDebugName(const std::string& name) {
+        _handle.GetDevice()->RecordDebugName(GetId(), name);
+        _inner->SetDebugName(name);
+    }
+
+    void CapturedTexture::WriteSubresource(
+        uint32_t mipLevel,
+        uint32_t arrayLayer,
+        Point3D dstOrigin,
+        Size3D writeSize,
+        const void* src,
+        uint32_t srcRowPitch,
+        uint32_t srcDepthPitch
+    ) {
+        auto format = _inner->GetDesc().format;
+        std::uint32_t rowBytes = FormatHelpers::GetRowPitch(writeSize.width, format);
+        std::uint32_t rows = FormatHelpers::GetNumRows(writeSize.height, format);
+
+        _handle.GetDevice()->Record(Op::TextureData, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(mipLevel);
+            w.Pod(arrayLayer);
+            w.Pod(dstOrigin);
+            w.Pod(writeSize);
+            w.Pod(rowBytes);
+            w.Pod(rowBytes * rows);
+            w.Pod<std::uint64_t>((std::uint64_t)rowBytes * rows * writeSize.depth);
+            auto* base = static_cast<const std::uint8_t*>(src);
+            for(std::uint32_t z = 0; z < writeSize.depth; z++) {
+                for(std::uint32_t row = 0; row < rows; row++) {
+                    w.Bytes(base + (std::size_t)z * srcDepthPitch
+                                 + (std::size_t)row * srcRowPitch, rowBytes);
+                }
+            }
+        });
+
+        _inner->WriteSubresource(
+            mipLevel, arrayLayer, dstOrigin, writeSize, src, srcRowPitch, srcDepthPitch);
+    }
+
+    CapturedResourceLayout::CapturedResourceLayout(
+        common::sp<CaptureDevice> dev, ObjectId id, common::sp<IResourceLayout> inner
+    )
+        : IResourceLayout(inner->GetDesc())
+        , _handle(std::move(dev), id)
+        , _inner(std::move(inner))
+    {
+        for(auto& res : description.shaderResources) {
+            _slotOffsets.push_back(_resourceCount);
+            _resourceCount += res.bindingCount;
+        }
+    }
+
+    std::uint32_t CapturedResourceLayout::GetFlatIndex(
+        std::uint32_t layoutSlot, std::uint32_t arrayElement
+    ) const {
+        if(layoutSlot >= _slotOffsets.size()
+            || arrayElement >= description.shaderResources[layoutSlot].bindingCount)
+            return _resourceCount;
+        return _slotOffsets[layoutSlot] + arrayElement;
+    }
+
+    CapturedResourceSet::CapturedResourceSet(
+        common::sp<CaptureDevice> dev, ObjectId id,
+        const Description& desc, common::sp<IResourceSet> inner
+    )
+        : _handle(std::move(dev), id)
+        , _layout(common::SPCast<CapturedResourceLayout>(desc.layout))
+        , _inner(std::move(inner))
+        , _resources(desc.boundResources)
+    { }
+
+    IBindableResource* CapturedResourceSet::GetBoundResource(
+        uint32_t layoutSlot, uint32_t firstArrayElement
+    ) {
+        auto idx = _layout->GetFlatIndex(layoutSlot, firstArrayElement);
+        return idx < _resources.size() ? _resources[idx].get() : nullptr;
+    }
+
+    CapturedMutableResourceSet::CapturedMutableResourceSet(
+        common::sp<CaptureDevice> dev, ObjectId id,
+        const Description& desc, common::sp<IMutableResourceSet> inner
+    )
+        : _handle(std::move(dev), id)
+        , _layout(common::SPCast<CapturedResourceLayout>(desc.layout))
+        , _inner(std::move(inner))
+    {
+        _resources.resize(_layout->GetResourceCount());
+        _Apply(desc.initialWrites);
+    }
+
+    void CapturedMutableResourceSet::_Apply(std::span<const WriteBinding> writes) {
+        for(auto& write : writes) {
+            for(std::uint32_t i = 0; i < write.resources.size(); i++) {
+                auto idx = _layout->GetFlatIndex(write.layoutSlot, write.firstArrayElement + i);
+                if(idx < _resources.size()) _resources[idx] = write.resources[i];
+            }
+        }
+    }
+
+    IBindableResource* CapturedMutableResourceSet::GetBoundResource(
+        uint32_t layoutSlot, uint32_t firstArrayElement
+    ) {
+        auto idx = _layout->GetFlatIndex(layoutSlot, firstArrayElement);
+        return idx < _resources.size() ? _resources[idx].get() : nullptr;
+    }
+
+    void CapturedMutableResourceSet::Update(const std::span<const WriteBinding>& writes) {
+        _handle.GetDevice()->Record(Op::UpdateMutableResourceSet, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            WriteBindingWrites(w, writes);
+        });
+        auto innerWrites = UnwrapWrites(writes);
+        _inner->Update(innerWrites);
+        _Apply(writes);
+    }
+
+    namespace {
+        ResourceDescriptorWrite _UnwrapDescriptor(const ResourceDescriptorWrite& write) {
+            return std::visit([](auto& desc) -> ResourceDescriptorWrite {
+                using T = std::decay_t<decltype(desc)>;
+                if constexpr (requires { desc.buffer; })
+                    return T{ UnwrapRange(desc.buffer) };
+                else
+                    return T{ Unwrap(desc.texture) };
+            }, write);
+        }
+
+        void _WriteDescriptor(RecordWriter& w, const ResourceDescriptorWrite& write) {
+            w.Pod<std::uint8_t>((std::uint8_t)write.index());
+            std::visit([&](auto& desc) {
+                if constexpr (requires { desc.buffer; })
+                    WriteBufferRange(w, desc.buffer.get());
+                else
+                    w.Pod(GetId(desc.texture));
+            }, write);
+        }
+    }
+
+    void CapturedResourceHeap::Write(
+        ResourceDescriptorIndex index,
+        const ResourceDescriptorWrite& write
+    ) {
+        _handle.GetDevice()->Record(Op::ResourceHeapWrite, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(index.value);
+            w.Pod<std::uint32_t>(1);
+            _WriteDescriptor(w, write);
+        });
+        _inner->Write(index, _UnwrapDescriptor(write));
+    }
+
+    void CapturedResourceHeap::WriteRange(
+        ResourceDescriptorIndex firstIndex,
+        std::span<const ResourceDescriptorWrite> writes
+    ) {
+        _handle.GetDevice()->Record(Op::ResourceHeapWrite, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(firstIndex.value);
+            w.Pod<std::uint32_t>((std::uint32_t)writes.size());
+            for(auto& write : writes) _WriteDescriptor(w, write);
+        });
+
+        std::vector<ResourceDescriptorWrite> innerWrites;
+        innerWrites.reserve(writes.size());
+        for(auto& write : writes) innerWrites.push_back(_UnwrapDescriptor(write));
+        _inner->WriteRange(firstIndex, innerWrites);
+    }
+
+    void CapturedResourceHeap::Clear(ResourceDescriptorIndex index) {
+        _handle.GetDevice()->Record(Op::ResourceHeapClear, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(index.value);
+            w.Pod<std::uint32_t>(1);
+        });
+        _inner->Clear(index);
+    }
+
+    void CapturedResourceHeap::ClearRange(ResourceDescriptorIndex firstIndex, std::uint32_t count) {
+        _handle.GetDevice()->Record(Op::ResourceHeapClear, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(firstIndex.value);
+            w.Pod(count);
+        });
+        _inner->ClearRange(firstIndex, count);
+    }
+
+    void CapturedSamplerHeap::Write(
+        SamplerDescriptorIndex index,
+        const SamplerDescriptorWrite& sampler
+    ) {
+        _handle.GetDevice()->Record(Op::SamplerHeapWrite, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(index.value);
+            w.Pod<std::uint32_t>(1);
+            w.Pod(Capture::GetId(sampler));
+        });
+        _inner->Write(index, Unwrap(sampler));
+    }
+
+    void CapturedSamplerHeap::WriteRange(
+        SamplerDescriptorIndex firstIndex,
+        std::span<const SamplerDescriptorWrite> samplers
+    ) {
+        _handle.GetDevice()->Record(Op::SamplerHeapWrite, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(firstIndex.value);
+            w.Pod<std::uint32_t>((std::uint32_t)samplers.size());
+            for(auto& sampler : samplers) w.Pod(Capture::GetId(sampler));
+        });
+
+        std::vector<SamplerDescriptorWrite> innerSamplers;
+        innerSamplers.reserve(samplers.size());
+        for(auto& sampler : samplers) innerSamplers.push_back(Unwrap(sampler));
+        _inner->WriteRange(firstIndex, innerSamplers);
+    }
+
+    void CapturedSamplerHeap::Clear(SamplerDescriptorIndex index) {
+        _handle.GetDevice()->Record(Op::SamplerHeapClear, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(index.value);
+            w.Pod<std::uint32_t>(1);
+        });
+        _inner->Clear(index);
+    }
+
+    void CapturedSamplerHeap::ClearRange(SamplerDescriptorIndex firstIndex, std::uint32_t count) {
+        _handle.GetDevice()->Record(Op::SamplerHeapClear, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(firstIndex.value);
+            w.Pod(count);
+        });
+        _inner->ClearRange(firstIndex, count);
+    }
+
+    void CapturedEvent::SignalFromCPU(uint64_t signalValue) {
+        auto* dev = _handle.GetDevice();
+        // GPU work waiting on this may read mapped buffers
+        dev->FlushMappedBuffers();
+        dev->Record(Op::EventSignal, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(signalValue);
+        });
+        _inner->SignalFromCPU(signalValue);
+    }
+
+    bool CapturedEvent::WaitFromCPU(uint64_t expectedValue, uint32_t timeoutMs) {
+        if(!_inner->WaitFromCPU(expectedValue, timeoutMs))
+            return false;
+
+        _handle.GetDevice()->Record(Op::EventWait, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(expectedValue);
+        });
+        return true;
+    }
+
+    common::sp<ITextureView> CapturedSwapChain::GetBackBuffer() {
+        auto view = _inner->GetBackBuffer();
+        if(!view) return nullptr;
+
+        for(auto& [innerView, wrapped] : _backBuffers) {
+            if(innerView == view.get()) return wrapped;
+        }
+
+        auto dev = common::ref_sp(_handle.GetDevice());
+        auto innerTex = view->GetTextureObject();
+        auto tex = common::make_sp<CapturedTexture>(dev, dev->AllocateId(), innerTex);
+        auto wrapped = common::make_sp<CapturedTextureView>(dev, dev->AllocateId(), tex, view);
+
+        dev->Record(Op::SwapChainBackBuffer, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(tex->GetId());
+            w.Pod(innerTex->GetDesc());
+            w.Pod(wrapped->GetId());
+            w.Pod(view->GetDesc());
+        });
+
+        _backBuffers.emplace_back(view.get(), wrapped);
+        return wrapped;
+    }
+
+    void CapturedSwapChain::Resize(std::uint32_t width, std::uint32_t height) {
+        _handle.GetDevice()->Record(Op::ResizeSwapChain, [&](RecordWriter& w) {
+            w.Pod(GetId());
+            w.Pod(width);
+            w.Pod(height);
+        });
+        // Back buffers are recreated, new ones get new ids
+        _backBuffers.clear();
+        _inner->Resize(width, height);
+    }
+
+    common::sp<BufferRange> UnwrapRange(const common::sp<BufferRange>& range) {
+        if(!range) return nullptr;
+
+        auto inner = Unwrap(range->GetBufferObject());
+        auto& shape = range->GetShape();
+        if(range->GetResourceKind() == IBindableResource::ResourceKind::StorageBuffer)
+            return BufferRange::MakeStructuredBuffer(inner, shape);
+        return BufferRange::MakeByteBuffer(
+            inner, (std::uint32_t)shape.GetOffsetInBytes(), (std::uint32_t)shape.GetSizeInBytes());
+    }
+
+    common::sp<IBindableResource> UnwrapBindable(const common::sp<IBindableResource>& res) {
+        if(!res) return nullptr;
+
+        switch(res->GetResourceKind()) {
+            case IBindableResource::ResourceKind::UniformBuffer:
+            case IBindableResource::ResourceKind::StorageBuffer:
+                return UnwrapRange(common::SPCast<BufferRange>(res));
+            case IBindableResource::ResourceKind::Texture:
+                return Unwrap(common::PtrCast<ITextureView>(res.get()));
+            case IBindableResource::ResourceKind::Sampler:
+                return Unwrap(common::PtrCast<ISampler>(res.get()));
+            default:
+                return nullptr;
+        }
+    }
+
+    std::vector<IMutableResourceSet::WriteBinding> UnwrapWrites(
+        std::span<const IMutableResourceSet::WriteBinding> writes
+    ) {
+        std::vector<IMutableResourceSet::WriteBinding> res;
+        res.reserve(writes.size());
+        for(auto& write : writes) {
+            auto& innerWrite = res.emplace_back();
+            innerWrite.layoutSlot = write.layoutSlot;
+            innerWrite.firstArrayElement = write.firstArrayElement;
+            for(auto& resource : write.resources)
+                innerWrite.resources.push_back(UnwrapBindable(resource));
+        }
+        return res;
+    }
+
+    void WriteBufferRange(RecordWriter& w, const BufferRange* range) {
+        if(!range) {
+            w.Pod<ObjectId>(0);
+            w.Pod(BufferRange::Shape{});
+            w.Pod(IBindableResource::ResourceKind::UniformBuffer);
+            return;
+        }
+        w.Pod(GetId(range->GetBufferObject()));
+        w.Pod(range->GetShape());
+        w.Pod(range->GetResourceKind());
+    }
+
+    void WriteResourceRef(RecordWriter& w, IBindableResource* res) {
+        if(!res) {
+            w.Pod(ResourceRefKind::Null);
+            return;
+        }
+
+        switch(res->GetResourceKind()) {
+            case IBindableResource::ResourceKind::UniformBuffer:
+            case IBindableResource::ResourceKind::StorageBuffer:
+                w.Pod(ResourceRefKind::BufferRange);
+                WriteBufferRange(w, common::PtrCast<BufferRange>(res));
+                break;
+            case IBindableResource::ResourceKind::Texture:
+                w.Pod(ResourceRefKind::TextureView);
+                w.Pod(GetId(common::PtrCast<ITextureView>(res)));
+                break;
+            case IBindableResource::ResourceKind::Sampler:
+                w.Pod(ResourceRefKind::Sampler);
+                w.Pod(GetId(common::PtrCast<ISampler>(res)));
+                break;
+            default:
+                w.Pod(ResourceRefKind::Null);
+                break;
+        }
+    }
+
+    void WriteBindingWrites(
+        RecordWriter& w, std::span<const IMutableResourceSet::WriteBinding> writes
+    ) {
+        w.Pod<std::uint32_t>((std::uint32_t)writes.size());
+        for(auto& write : writes) {
+            w.Pod(write.layoutSlot);
+            w.Pod(write.firstArrayElement);
+            w.Pod<std::uint32_t>((std::uint32_t)write.resources.size());
+            for(auto& resource : write.resources)
+                WriteResourceRef(w, resource.get());
+        }
+    }
+
+} // namespace alloy::layers::Capture
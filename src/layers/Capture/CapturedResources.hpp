@@ -0,0 +1,431 @@
+#pragma once
+
+#include "alloy/common/Common.hpp"
+#include "alloy/common/RefCnt.hpp"
+#include "alloy/Buffer.hpp"
+#include "alloy/Texture.hpp"
+#include "alloy/Sampler.hpp"
+#include "alloy/Shader.hpp"
+#include "alloy/Pipeline.hpp"
+#include "alloy/BindableResource.hpp"
+#include "alloy/DescriptorHeap.hpp"
+#include "alloy/SwapChain.hpp"
+#include "alloy/SyncObjects.hpp"
+
+#include "CaptureFormat.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace alloy::layers::Capture
+{
+    class CaptureDevice;
+
+    // Id of a captured object, records its destruction
+    class CaptureHandle {
+        common::sp<CaptureDevice> _dev;
+        ObjectId _id;
+
+    public:
+        CaptureHandle(common::sp<CaptureDevice> dev, ObjectId id)
+            : _dev(std::move(dev)), _id(id) { }
+        ~CaptureHandle();
+
+        CaptureHandle(const CaptureHandle&) = delete;
+        CaptureHandle& operator=(const CaptureHandle&) = delete;
+
+        ObjectId GetId() const { return _id; }
+        CaptureDevice* GetDevice() const { return _dev.get(); }
+    };
+
+    class CapturedBuffer : public IBuffer {
+
+        CaptureHandle _handle;
+        common::sp<IBuffer> _inner;
+
+        // Guarded by the device's mapped buffer lock
+        std::uint8_t* _mapped = nullptr;
+        // Contents as of the last flush, empty before the first one
+        std::vector<std::uint8_t> _shadow;
+
+    public:
+        CapturedBuffer(common::sp<CaptureDevice> dev, ObjectId id, common::sp<IBuffer> inner)
+            : _handle(std::move(dev), id), _inner(std::move(inner)) { }
+        ~CapturedBuffer() override;
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<IBuffer>& GetInner() const { return _inner; }
+
+        // Both called with the device's mapped buffer lock held
+        void SetMapped(void* mapped) { _mapped = (std::uint8_t*)mapped; }
+        // Records the bytes changed since the last flush
+        void FlushWrites();
+
+        virtual const Description& GetDesc() const override { return _inner->GetDesc(); }
+        virtual void* MapToCPU() override;
+        virtual void UnMap() override;
+        virtual uint64_t GetNativeHandle() const override { return _inner->GetNativeHandle(); }
+        virtual std::uint64_t GetDeviceAddress() const override { return _inner->GetDeviceAddress(); }
+        virtual void SetDebugName(const std::string& name) override;
+        virtual std::string GetDebugName() override { return _inner->GetDebugName(); }
+    };
+
+    class CapturedTexture : public ITexture {
+
+        CaptureHandle _handle;
+        common::sp<ITexture> _inner;
+
+    public:
+        CapturedTexture(common::sp<CaptureDevice> dev, ObjectId id, common::sp<ITexture> inner)
+            : _handle(std::move(dev), id), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<ITexture>& GetInner() const { return _inner; }
+
+        virtual const Description& GetDesc() const override { return _inner->GetDesc(); }
+        virtual void* GetNativeHandle() const override { return _inner->GetNativeHandle(); }
+        virtual void SetDebugName(const std::string& name) override;
+
+        // Recorded with tightly packed rows
+        virtual void WriteSubresource(
+            uint32_t mipLevel,
+            uint32_t arrayLayer,
+            Point3D dstOrigin,
+            Size3D writeSize,
+            const void* src,
+            uint32_t srcRowPitch,
+            uint32_t srcDepthPitch
+        ) override;
+
+        virtual void ReadSubresource(
+            void* dst,
+            uint32_t dstRowPitch,
+            uint32_t dstDepthPitch,
+            uint32_t mipLevel,
+            uint32_t arrayLayer,
+            Point3D srcOrigin,
+            Size3D readSize
+        ) override {
+            _inner->ReadSubresource(
+                dst, dstRowPitch, dstDepthPitch, mipLevel, arrayLayer, srcOrigin, readSize);
+        }
+
+        virtual SubresourceLayout GetSubresourceLayout(
+            uint32_t mipLevel,
+            uint32_t arrayLayer,
+            SubresourceAspect aspect = SubresourceAspect::Color
+        ) override {
+            return _inner->GetSubresourceLayout(mipLevel, arrayLayer, aspect);
+        }
+    };
+
+    class CapturedTextureView : public ITextureView {
+
+        CaptureHandle _handle;
+        common::sp<CapturedTexture> _tex;
+        common::sp<ITextureView> _inner;
+
+    public:
+        CapturedTextureView(
+            common::sp<CaptureDevice> dev, ObjectId id,
+            common::sp<CapturedTexture> tex, common::sp<ITextureView> inner)
+            : _handle(std::move(dev), id), _tex(std::move(tex)), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<ITextureView>& GetInner() const { return _inner; }
+
+        virtual const Description& GetDesc() const override { return _inner->GetDesc(); }
+        virtual common::sp<ITexture> GetTextureObject() const override { return _tex; }
+    };
+
+    class CapturedSampler : public ISampler {
+
+        CaptureHandle _handle;
+        common::sp<ISampler> _inner;
+
+    public:
+        CapturedSampler(common::sp<CaptureDevice> dev, ObjectId id, common::sp<ISampler> inner)
+            : ISampler(inner->GetDesc()), _handle(std::move(dev), id), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<ISampler>& GetInner() const { return _inner; }
+
+        virtual void SetDebugName(const std::string& name) override;
+    };
+
+    class CapturedShader : public IShader {
+
+        CaptureHandle _handle;
+        common::sp<IShader> _inner;
+
+    public:
+        CapturedShader(common::sp<CaptureDevice> dev, ObjectId id, common::sp<IShader> inner)
+            : IShader(inner->GetDesc()), _handle(std::move(dev), id), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<IShader>& GetInner() const { return _inner; }
+
+        virtual const std::span<uint8_t> GetByteCode() override { return _inner->GetByteCode(); }
+    };
+
+    class CapturedResourceLayout : public IResourceLayout {
+
+        CaptureHandle _handle;
+        common::sp<IResourceLayout> _inner;
+        // Linear offset of each shaderResources entry
+        std::vector<std::uint32_t> _slotOffsets;
+        std::uint32_t _resourceCount = 0;
+
+    public:
+        CapturedResourceLayout(
+            common::sp<CaptureDevice> dev, ObjectId id, common::sp<IResourceLayout> inner);
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<IResourceLayout>& GetInner() const { return _inner; }
+
+        // Index into a flat array of every binding, or the resource count
+        // if out of range
+        std::uint32_t GetFlatIndex(std::uint32_t layoutSlot, std::uint32_t arrayElement) const;
+        std::uint32_t GetResourceCount() const { return _resourceCount; }
+
+        virtual void* GetNativeHandle() const override { return _inner->GetNativeHandle(); }
+    };
+
+    // Keeps the application's bindings, so GetBoundResource() hands back
+    // captured objects rather than the inner device's
+    class CapturedResourceSet : public IResourceSet {
+
+        CaptureHandle _handle;
+        common::sp<CapturedResourceLayout> _layout;
+        common::sp<IResourceSet> _inner;
+        std::vector<common::sp<IBindableResource>> _resources;
+
+    public:
+        CapturedResourceSet(
+            common::sp<CaptureDevice> dev, ObjectId id,
+            const Description& desc, common::sp<IResourceSet> inner);
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<IResourceSet>& GetInner() const { return _inner; }
+
+        virtual const IResourceLayout& GetLayout() const override { return *_layout; }
+        virtual IBindableResource* GetBoundResource(
+            uint32_t layoutSlot, uint32_t firstArrayElement) override;
+        virtual void* GetNativeHandle() const override { return _inner->GetNativeHandle(); }
+    };
+
+    class CapturedMutableResourceSet : public IMutableResourceSet {
+
+        CaptureHandle _handle;
+        common::sp<CapturedResourceLayout> _layout;
+        common::sp<IMutableResourceSet> _inner;
+        std::vector<common::sp<IBindableResource>> _resources;
+
+        void _Apply(std::span<const WriteBinding> writes);
+
+    public:
+        CapturedMutableResourceSet(
+            common::sp<CaptureDevice> dev, ObjectId id,
+            const Description& desc, common::sp<IMutableResourceSet> inner);
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<IMutableResourceSet>& GetInner() const { return _inner; }
+
+        virtual const IResourceLayout& GetLayout() const override { return *_layout; }
+        virtual IBindableResource* GetBoundResource(
+            uint32_t layoutSlot, uint32_t firstArrayElement) override;
+        virtual void Update(const std::span<const WriteBinding>& writes) override;
+        virtual void* GetNativeHandle() const override { return _inner->GetNativeHandle(); }
+    };
+
+    class CapturedResourceHeap : public IResourceDescriptorHeap {
+
+        CaptureHandle _handle;
+        common::sp<IResourceDescriptorHeap> _inner;
+
+    public:
+        CapturedResourceHeap(
+            common::sp<CaptureDevice> dev, ObjectId id, common::sp<IResourceDescriptorHeap> inner)
+            : _handle(std::move(dev), id), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<IResourceDescriptorHeap>& GetInner() const { return _inner; }
+
+        virtual const Description& GetDesc() const override { return _inner->GetDesc(); }
+
+        virtual void Write(
+            ResourceDescriptorIndex index,
+            const ResourceDescriptorWrite& write) override;
+        virtual void WriteRange(
+            ResourceDescriptorIndex firstIndex,
+            std::span<const ResourceDescriptorWrite> writes) override;
+        virtual void Clear(ResourceDescriptorIndex index) override;
+        virtual void ClearRange(ResourceDescriptorIndex firstIndex, std::uint32_t count) override;
+    };
+
+    class CapturedSamplerHeap : public ISamplerDescriptorHeap {
+
+        CaptureHandle _handle;
+        common::sp<ISamplerDescriptorHeap> _inner;
+
+    public:
+        CapturedSamplerHeap(
+            common::sp<CaptureDevice> dev, ObjectId id, common::sp<ISamplerDescriptorHeap> inner)
+            : _handle(std::move(dev), id), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<ISamplerDescriptorHeap>& GetInner() const { return _inner; }
+
+        virtual const Description& GetDesc() const override { return _inner->GetDesc(); }
+
+        virtual void Write(
+            SamplerDescriptorIndex index,
+            const SamplerDescriptorWrite& sampler) override;
+        virtual void WriteRange(
+            SamplerDescriptorIndex firstIndex,
+            std::span<const SamplerDescriptorWrite> samplers) override;
+        virtual void Clear(SamplerDescriptorIndex index) override;
+        virtual void ClearRange(SamplerDescriptorIndex firstIndex, std::uint32_t count) override;
+    };
+
+    class CapturedGfxPipeline : public IGfxPipeline {
+
+        CaptureHandle _handle;
+        common::sp<IGfxPipeline> _inner;
+
+    public:
+        CapturedGfxPipeline(common::sp<CaptureDevice> dev, ObjectId id, common::sp<IGfxPipeline> inner)
+            : _handle(std::move(dev), id), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<IGfxPipeline>& GetInner() const { return _inner; }
+    };
+
+    class CapturedComputePipeline : public IComputePipeline {
+
+        CaptureHandle _handle;
+        common::sp<IComputePipeline> _inner;
+
+    public:
+        CapturedComputePipeline(common::sp<CaptureDevice> dev, ObjectId id, common::sp<IComputePipeline> inner)
+            : _handle(std::move(dev), id), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<IComputePipeline>& GetInner() const { return _inner; }
+    };
+
+    class CapturedMeshShaderPipeline : public IMeshShaderPipeline {
+
+        CaptureHandle _handle;
+        common::sp<IMeshShaderPipeline> _inner;
+
+    public:
+        CapturedMeshShaderPipeline(common::sp<CaptureDevice> dev, ObjectId id, common::sp<IMeshShaderPipeline> inner)
+            : _handle(std::move(dev), id), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<IMeshShaderPipeline>& GetInner() const { return _inner; }
+    };
+
+    // CPU signals and successful CPU waits are recorded, polling isn't
+    class CapturedEvent : public IEvent {
+
+        CaptureHandle _handle;
+        common::sp<IEvent> _inner;
+
+    public:
+        CapturedEvent(common::sp<CaptureDevice> dev, ObjectId id, common::sp<IEvent> inner)
+            : _handle(std::move(dev), id), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<IEvent>& GetInner() const { return _inner; }
+
+        virtual uint64_t GetSignaledValue() override { return _inner->GetSignaledValue(); }
+        virtual void SignalFromCPU(uint64_t signalValue) override;
+        virtual bool WaitFromCPU(uint64_t expectedValue, uint32_t timeoutMs) override;
+        using IEvent::WaitFromCPU;
+        virtual void OnReached(uint64_t value, ReachedCallback callback) override {
+            _inner->OnReached(value, std::move(callback));
+        }
+    };
+
+    // Back buffers get ids when first handed out, and are replayed as
+    // offscreen render targets
+    class CapturedSwapChain : public ISwapChain {
+
+        CaptureHandle _handle;
+        common::sp<ISwapChain> _inner;
+
+        std::vector<std::pair<ITextureView*, common::sp<CapturedTextureView>>> _backBuffers;
+
+    public:
+        CapturedSwapChain(common::sp<CaptureDevice> dev, ObjectId id, common::sp<ISwapChain> inner)
+            : _handle(std::move(dev), id), _inner(std::move(inner)) { }
+
+        ObjectId GetId() const { return _handle.GetId(); }
+        const common::sp<ISwapChain>& GetInner() const { return _inner; }
+
+        virtual common::sp<ITextureView> GetBackBuffer() override;
+
+        virtual const Description& GetDesc() const override { return _inner->GetDesc(); }
+        virtual uint32_t GetBackBufferIndex() override { return _inner->GetBackBufferIndex(); }
+
+        virtual void Resize(std::uint32_t width, std::uint32_t height) override;
+
+        virtual bool IsSyncToVerticalBlank() const override { return _inner->IsSyncToVerticalBlank(); }
+        virtual void SetSyncToVerticalBlank(bool sync) override { _inner->SetSyncToVerticalBlank(sync); }
+
+        virtual std::uint32_t GetWidth() const override { return _inner->GetWidth(); }
+        virtual std::uint32_t GetHeight() const override { return _inner->GetHeight(); }
+    };
+
+    template<typename T> struct CapturedTypeOf;
+    template<> struct CapturedTypeOf<IBuffer> { using Type = CapturedBuffer; };
+    template<> struct CapturedTypeOf<ITexture> { using Type = CapturedTexture; };
+    template<> struct CapturedTypeOf<ITextureView> { using Type = CapturedTextureView; };
+    template<> struct CapturedTypeOf<ISampler> { using Type = CapturedSampler; };
+    template<> struct CapturedTypeOf<IShader> { using Type = CapturedShader; };
+    template<> struct CapturedTypeOf<IResourceLayout> { using Type = CapturedResourceLayout; };
+    template<> struct CapturedTypeOf<IResourceSet> { using Type = CapturedResourceSet; };
+    template<> struct CapturedTypeOf<IMutableResourceSet> { using Type = CapturedMutableResourceSet; };
+    template<> struct CapturedTypeOf<IResourceDescriptorHeap> { using Type = CapturedResourceHeap; };
+    template<> struct CapturedTypeOf<ISamplerDescriptorHeap> { using Type = CapturedSamplerHeap; };
+    template<> struct CapturedTypeOf<IGfxPipeline> { using Type = CapturedGfxPipeline; };
+    template<> struct CapturedTypeOf<IComputePipeline> { using Type = CapturedComputePipeline; };
+    template<> struct CapturedTypeOf<IMeshShaderPipeline> { using Type = CapturedMeshShaderPipeline; };
+    template<> struct CapturedTypeOf<IEvent> { using Type = CapturedEvent; };
+    template<> struct CapturedTypeOf<ISwapChain> { using Type = CapturedSwapChain; };
+
+    // Null maps to id 0
+    template<typename T>
+    ObjectId GetId(T* obj) {
+        return obj ? common::PtrCast<typename CapturedTypeOf<T>::Type>(obj)->GetId() : 0;
+    }
+
+    template<typename T>
+    ObjectId GetId(const common::sp<T>& obj) { return GetId(obj.get()); }
+
+    // The inner device's object, null stays null
+    template<typename T>
+    common::sp<T> Unwrap(T* obj) {
+        if(!obj) return nullptr;
+        return common::PtrCast<typename CapturedTypeOf<T>::Type>(obj)->GetInner();
+    }
+
+    template<typename T>
+    common::sp<T> Unwrap(const common::sp<T>& obj) { return Unwrap(obj.get()); }
+
+    common::sp<BufferRange> UnwrapRange(const common::sp<BufferRange>& range);
+    common::sp<IBindableResource> UnwrapBindable(const common::sp<IBindableResource>& res);
+    std::vector<IMutableResourceSet::WriteBinding> UnwrapWrites(
+        std::span<const IMutableResourceSet::WriteBinding> writes);
+
+    void WriteBufferRange(RecordWriter& w, const BufferRange* range);
+    void WriteResourceRef(RecordWriter& w, IBindableResource* res);
+    void WriteBindingWrites(
+        RecordWriter& w, std::span<const IMutableResourceSet::WriteBinding> writes);
+
+} // namespace alloy::layers::Capture
@@ -126,9 +126,10 @@ namespace alloy::utils {
         if (current->pNext != nullptr && current->pNext->isFree)
         {
             // Merge with the next block
-            current->size += current->pNext->size;
-            current->pNext = current->pNext->pNext;
-            delete current->pNext;
+            Block* next = current->pNext;
+            current->size += next->size;
+            current->pNext = next->pNext;
+            delete next;
         }
         
         // Case 2: Can merge with previous block
@@ -0,0 +1,106 @@
+#include "ChromeTraceWriter.hpp"
+
+#include <cstdio>
+#include <iomanip>
+
+namespace alloy::utils
+{
+    ChromeTraceWriter::ChromeTraceWriter()
+        : _first(true)
+    {
+        _out << std::fixed << std::setprecision(3);
+        _out << "{\"traceEvents\":[";
+    }
+
+    void ChromeTraceWriter::_Separate() {
+        if(!_first) _out << ',';
+        _first = false;
+    }
+
+    void ChromeTraceWriter::_WriteString(std::string_view str) {
+        _out << '"';
+        for(char c : str) {
+            switch(c) {
+            case '"':  _out << "\\\""; break;
+            case '\\': _out << "\\\\"; break;
+            case '\n': _out << "\\n"; break;
+            case '\r': _out << "\\r"; break;
+            case '\t': _out << "\\t"; break;
+            default:
+                if((unsigned char)c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+                    _out << buf;
+                } else {
+                    _out << c;
+                }
+            }
+        }
+        _out << '"';
+    }
+
+    void ChromeTraceWriter::TrackName(std::uint32_t tid, std::string_view name) {
+        _Separate();
+        _out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << tid
+             << ",\"args\":{\"name\":";
+        _WriteString(name);
+        _out << "}}";
+    }
+
+    // Leaves the event open for args. The format wants microseconds.
+    void ChromeTraceWriter::_BeginComplete(
+        std::string_view name,
+        std::uint32_t tid,
+        std::uint64_t beginNs,
+        std::uint64_t endNs
+    ) {
+        _Separate();
+        _out << "{\"ph\":\"X\",\"name\":";
+        _WriteString(name);
+        _out << ",\"pid\":0,\"tid\":" << tid
+             << ",\"ts\":" << (double)beginNs / 1000.0
+             << ",\"dur\":" << (double)(endNs - beginNs) / 1000.0;
+    }
+
+    void ChromeTraceWriter::Complete(
+        std::string_view name,
+        std::uint32_t tid,
+        std::uint64_t beginNs,
+        std::uint64_t endNs
+    ) {
+        _BeginComplete(name, tid, beginNs, endNs);
+        _out << '}';
+    }
+
+    void ChromeTraceWriter::Complete(
+        std::string_view name,
+        std::uint32_t tid,
+        std::uint64_t beginNs,
+        std::uint64_t endNs,
+        std::string_view argName,
+        std::uint64_t argValue
+    ) {
+        _BeginComplete(name, tid, beginNs, endNs);
+        _out << ",\"args\":{";
+        _WriteString(argName);
+        _out << ':' << argValue << "}}";
+    }
+
+    void ChromeTraceWriter::Counter(
+        std::string_view name,
+        std::uint64_t timeNs,
+        std::uint64_t value
+    ) {
+        _Separate();
+        _out << "{\"ph\":\"C\",\"name\":";
+        _WriteString(name);
+        _out << ",\"pid\":0,\"ts\":" << (double)timeNs / 1000.0
+             << ",\"args\":{\"value\":" << value << "}}";
+    }
+
+    std::string ChromeTraceWriter::Finish() {
+        _out << "],\"displayTimeUnit\":\"ns\"}";
+        return _out.str();
+    }
+
+} // namespace alloy::utils
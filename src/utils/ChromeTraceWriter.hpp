@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace alloy::utils
+{
+    // Writes Chrome trace event JSON, loadable in chrome://tracing and
+    // Perfetto. Everything goes to process 0, one track per tid.
+    // Times are in nanoseconds.
+    class ChromeTraceWriter
+    {
+        std::ostringstream _out;
+        bool _first;
+
+        void _Separate();
+        void _WriteString(std::string_view str);
+        void _BeginComplete(
+            std::string_view name,
+            std::uint32_t tid,
+            std::uint64_t beginNs,
+            std::uint64_t endNs);
+
+    public:
+        ChromeTraceWriter();
+
+        void TrackName(std::uint32_t tid, std::string_view name);
+
+        void Complete(
+            std::string_view name,
+            std::uint32_t tid,
+            std::uint64_t beginNs,
+            std::uint64_t endNs);
+        // With one integer argument shown in the event details
+        void Complete(
+            std::string_view name,
+            std::uint32_t tid,
+            std::uint64_t beginNs,
+            std::uint64_t endNs,
+            std::string_view argName,
+            std::uint64_t argValue);
+
+        void Counter(std::string_view name, std::uint64_t timeNs, std::uint64_t value);
+
+        // Closes the document, the writer can't be used afterwards.
+        std::string Finish();
+    };
+
+} // namespace alloy::utils
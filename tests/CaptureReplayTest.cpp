@@ -0,0 +1,202 @@
+#include "alloy/Context.hpp"
+#include "alloy/GraphicsDevice.hpp"
+#include "alloy/ResourceFactory.hpp"
+#include "alloy/CommandQueue.hpp"
+#include "alloy/CommandList.hpp"
+#include "alloy/SyncObjects.hpp"
+#include "alloy/backend/NullBackend.hpp"
+#include "alloy/layers/Capture/ICaptureDevice.hpp"
+#include "alloy/layers/Capture/ICaptureReplayer.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace alloy;
+
+#define CHECK(x) \
+    do { \
+        if(!(x)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+            std::abort(); \
+        } \
+    } while(0)
+
+namespace
+{
+    constexpr std::uint32_t kFrames = 3;
+    constexpr std::uint32_t kDrawsPerFrame = 4;
+
+    common::sp<IGraphicsDevice> MakeNullDevice() {
+        auto ctx = IContext::Create(Backend::Null);
+        CHECK(ctx);
+        auto dev = ctx->CreateDefaultDevice({});
+        CHECK(dev);
+        SetNullCommandLogEnabled(dev.get(), true);
+        return dev;
+    }
+
+    common::sp<IGfxPipeline> MakePipeline(ResourceFactory& factory) {
+        // The null backend takes any bytecode
+        const std::vector<std::uint8_t> code = { 0, 0, 0, 0 };
+
+        IShader::Description vsDesc{};
+        vsDesc.stage = IShader::Stage::Vertex;
+        vsDesc.entryPoint = "VSMain";
+        IShader::Description psDesc{};
+        psDesc.stage = IShader::Stage::Fragment;
+        psDesc.entryPoint = "PSMain";
+
+        GraphicsPipelineDescription desc{};
+        desc.resourceLayout = factory.CreateResourceLayout({});
+        desc.attachmentState.colorAttachments = {
+            AttachmentStateDescription::ColorAttachment::MakeOverrideBlend()
+        };
+        desc.attachmentState.colorAttachments.front().format = PixelFormat::R8_G8_B8_A8_UNorm;
+        desc.attachmentState.sampleCount = SampleCount::x1;
+        desc.rasterizerState.cullMode = RasterizerStateDescription::FaceCullMode::None;
+        desc.rasterizerState.fillMode = RasterizerStateDescription::PolygonFillMode::Solid;
+        desc.rasterizerState.frontFace = RasterizerStateDescription::FrontFace::Clockwise;
+        desc.rasterizerState.depthClipEnabled = true;
+        desc.primitiveTopology = PrimitiveTopology::TriangleList;
+        desc.shaderSet.vertexShader = factory.CreateShader(vsDesc, code);
+        desc.shaderSet.fragmentShader = factory.CreateShader(psDesc, code);
+        return factory.CreateGraphicsPipeline(desc);
+    }
+
+    common::sp<ITextureView> MakeTexture(
+        ResourceFactory& factory,
+        std::uint32_t size,
+        std::uint32_t mipLevels,
+        bool renderTarget
+    ) {
+        ITexture::Description desc{};
+        desc.type = ITexture::Description::Type::Texture2D;
+        desc.width = size;
+        desc.height = size;
+        desc.depth = 1;
+        desc.mipLevels = mipLevels;
+        desc.arrayLayers = 1;
+        desc.format = PixelFormat::R8_G8_B8_A8_UNorm;
+        desc.usage.sampled = 1;
+        desc.usage.renderTarget = renderTarget;
+        desc.sampleCount = SampleCount::x1;
+        return factory.CreateTextureView(factory.CreateTexture(desc));
+    }
+
+    // Records a few frames through the capture device. Returns what the
+    // wrapped device executed.
+    std::vector<std::uint32_t> Capture(const std::string& path) {
+        auto dev = MakeNullDevice();
+        auto capDev = ICaptureDevice::Make(dev, path);
+        CHECK(capDev);
+
+        auto& factory = capDev->GetResourceFactory();
+        auto pipeline = MakePipeline(factory);
+        CHECK(pipeline);
+        auto target = MakeTexture(factory, 64, 1, true);
+        auto texture = MakeTexture(factory, 16, 5, false);
+
+        IBuffer::Description bufDesc{};
+        bufDesc.sizeInBytes = 4096;
+        bufDesc.usage.vertexBuffer = 1;
+        bufDesc.hostAccess = HostAccess::SystemMemoryPreferWrite;
+        auto upload = factory.CreateBuffer(bufDesc);
+        bufDesc.hostAccess = HostAccess::None;
+        auto vb = factory.CreateBuffer(bufDesc);
+
+        RenderPassAction action{};
+        auto& color = action.colorTargetActions.emplace_back();
+        color.target = target;
+        color.loadAction = LoadAction::Clear;
+        color.storeAction = StoreAction::Store;
+        color.clearColor = { 0.f, 0.f, 0.f, 1.f };
+
+        auto* q = capDev->GetGfxCommandQueue();
+        auto cmd = q->CreateCommandList();
+
+        for(std::uint32_t frame = 0; frame < kFrames; frame++) {
+            // Picked up as an upload at submit
+            std::memset(upload->MapToCPU(), (int)frame + 1, bufDesc.sizeInBytes);
+
+            cmd->Begin();
+            cmd->PushDebugGroup("Upload", {});
+            auto& xfer = cmd->BeginTransferPass();
+            xfer.CopyBuffer(
+                BufferRange::MakeByteBuffer(upload),
+                BufferRange::MakeByteBuffer(vb), bufDesc.sizeInBytes);
+            xfer.CopyBufferToTexture(
+                BufferRange::MakeByteBuffer(upload), 16 * 4, 16 * 16 * 4,
+                texture, {0, 0, 0}, 0, 0, {16, 16, 1});
+            CHECK(xfer.GenerateMipmaps(texture));
+            cmd->EndPass();
+            cmd->PopDebugGroup();
+
+            cmd->InsertDebugMarker("Draws", {});
+            auto& enc = cmd->BeginRenderPass(action, {});
+            enc.SetPipeline(pipeline);
+            enc.SetFullViewport();
+            enc.SetFullScissorRect();
+            for(std::uint32_t i = 0; i < kDrawsPerFrame; i++) {
+                enc.SetVertexBuffer(0, vb.get(), i * 64);
+                enc.Draw(3, 1 + i, 0, 0);
+            }
+            cmd->EndPass();
+            cmd->End();
+
+            q->SubmitCommand(cmd.get());
+            capDev->EndFrame();
+        }
+        capDev->Flush();
+        return TakeNullCommandLog(dev.get());
+    }
+
+    std::vector<std::uint32_t> Replay(const std::string& path) {
+        auto dev = MakeNullDevice();
+        auto replayer = ICaptureReplayer::Make(dev, path);
+        CHECK(replayer);
+
+        std::uint32_t frames = 0;
+        std::uint32_t draws = 0;
+        ICaptureReplayer::FrameStats stats{};
+        while(replayer->ReplayFrame(stats)) {
+            if(stats.submits == 0) continue;
+            frames++;
+            draws += stats.draws;
+            CHECK(stats.submits == 1);
+        }
+        if(!replayer->GetError().empty())
+            std::fprintf(stderr, "replay: %s\n", replayer->GetError().c_str());
+        CHECK(replayer->GetError().empty());
+        CHECK(frames == kFrames);
+        CHECK(draws == kFrames * kDrawsPerFrame);
+
+        return TakeNullCommandLog(dev.get());
+    }
+
+    void TestRoundTrip() {
+        auto path = (std::filesystem::temp_directory_path() / "alloy_capture_replay_test.cap").string();
+
+        auto captured = Capture(path);
+        auto replayed = Replay(path);
+        std::filesystem::remove(path);
+
+        CHECK(!captured.empty());
+        if(captured != replayed) {
+            std::fprintf(stderr, "captured:\n%s\nreplayed:\n%s\n",
+                DumpNullCommandLog(captured).c_str(),
+                DumpNullCommandLog(replayed).c_str());
+        }
+        CHECK(captured == replayed);
+    }
+
+}
+
+int main() {
+    TestRoundTrip();
+    std::printf("ok\n");
+    return 0;
+}
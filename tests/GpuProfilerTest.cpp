@@ -0,0 +1,201 @@
+#include "alloy/Context.hpp"
+#include "alloy/GraphicsDevice.hpp"
+#include "alloy/GpuProfiler.hpp"
+#include "alloy/ResourceFactory.hpp"
+#include "alloy/CommandQueue.hpp"
+#include "alloy/CommandList.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace alloy;
+
+#define CHECK(x) \
+    do { \
+        if(!(x)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+            std::abort(); \
+        } \
+    } while(0)
+
+namespace
+{
+    common::sp<IGraphicsDevice> MakeNullDevice() {
+        auto ctx = IContext::Create(Backend::Null);
+        CHECK(ctx);
+        auto dev = ctx->CreateDefaultDevice({});
+        CHECK(dev);
+        return dev;
+    }
+
+    common::sp<IBuffer> MakeBuffer(ResourceFactory& factory, std::uint32_t size) {
+        IBuffer::Description desc{};
+        desc.sizeInBytes = size;
+        desc.usage.vertexBuffer = 1;
+        desc.hostAccess = HostAccess::None;
+        return factory.CreateBuffer(desc);
+    }
+
+    // Checks parent links, depths and that every child sits within its
+    // parent's time span.
+    void CheckTree(const IGpuProfiler::Frame& frame) {
+        for(std::uint32_t i = 0; i < frame.scopes.size(); i++) {
+            auto& scope = frame.scopes[i];
+            CHECK(scope.beginNs <= scope.endNs);
+            if(scope.parent == IGpuProfiler::kNoParent) {
+                CHECK(scope.depth == 0);
+                continue;
+            }
+            CHECK(scope.parent < i);
+            auto& parent = frame.scopes[scope.parent];
+            CHECK(scope.depth == parent.depth + 1);
+            CHECK(scope.queue == parent.queue);
+            CHECK(scope.beginNs >= parent.beginNs);
+            CHECK(scope.endNs <= parent.endNs);
+        }
+    }
+
+    void TestDisabled() {
+        auto dev = MakeNullDevice();
+        auto* profiler = dev->GetGpuProfiler();
+        CHECK(profiler);
+        CHECK(!profiler->IsEnabled());
+
+        auto* q = dev->GetGfxCommandQueue();
+        auto cmd = q->CreateCommandList();
+        cmd->Begin();
+        cmd->PushDebugGroup("Ignored", {});
+        cmd->PopDebugGroup();
+        cmd->End();
+        q->SubmitCommand(cmd.get());
+        profiler->EndFrame();
+
+        auto frames = profiler->CollectFrames();
+        CHECK(frames.size() == 1);
+        CHECK(frames[0].frameIdx == 0);
+        CHECK(frames[0].scopes.empty());
+    }
+
+    void TestScopes() {
+        auto dev = MakeNullDevice();
+        auto& factory = dev->GetResourceFactory();
+        auto* profiler = dev->GetGpuProfiler();
+        profiler->SetEnabled(true);
+
+        constexpr std::uint32_t kSize = 1 << 20;
+        auto src = MakeBuffer(factory, kSize);
+        auto dst = MakeBuffer(factory, kSize);
+
+        auto* gfxQ = dev->GetGfxCommandQueue();
+        auto* computeQ = dev->GetComputeCommandQueue();
+        auto gfxCmd = gfxQ->CreateCommandList();
+        auto computeCmd = computeQ->CreateCommandList();
+
+        // Nothing is ready before the frame ends
+        CHECK(profiler->CollectFrames().empty());
+
+        gfxCmd->Begin();
+        gfxCmd->PushDebugGroup("Frame", {});
+        auto& xfer = gfxCmd->BeginTransferPass();
+        gfxCmd->PushDebugGroup("Copies", {});
+        xfer.CopyBuffer(
+            BufferRange::MakeByteBuffer(src), BufferRange::MakeByteBuffer(dst), kSize);
+        xfer.CopyBuffer(
+            BufferRange::MakeByteBuffer(dst), BufferRange::MakeByteBuffer(src), kSize);
+        // Left open, ends with the pass
+        gfxCmd->PushDebugGroup("Unclosed", {});
+        gfxCmd->EndPass();
+        gfxCmd->PopDebugGroup();
+        // Unbalanced, ignored
+        gfxCmd->PopDebugGroup();
+        gfxCmd->End();
+        gfxQ->SubmitCommand(gfxCmd.get());
+
+        computeCmd->Begin();
+        computeCmd->BeginComputePass({});
+        computeCmd->EndPass();
+        computeCmd->End();
+        computeQ->SubmitCommand(computeCmd.get());
+
+        profiler->EndFrame();
+
+        // An empty frame after it
+        profiler->EndFrame();
+
+        auto frames = profiler->CollectFrames();
+        CHECK(frames.size() == 2);
+        CHECK(frames[0].frameIdx == 0);
+        CHECK(frames[1].frameIdx == 1);
+        CHECK(frames[1].scopes.empty());
+
+        auto& scopes = frames[0].scopes;
+        CHECK(scopes.size() == 5);
+        CheckTree(frames[0]);
+
+        const char* names[] = { "Frame", "Transfer pass", "Copies", "Unclosed", "Compute pass" };
+        const std::uint32_t parents[] = { IGpuProfiler::kNoParent, 0, 1, 2, IGpuProfiler::kNoParent };
+        const std::uint32_t queues[] = { 0, 0, 0, 0, 2 };
+        for(std::uint32_t i = 0; i < scopes.size(); i++) {
+            CHECK(scopes[i].name == names[i]);
+            CHECK(scopes[i].parent == parents[i]);
+            CHECK(scopes[i].queue == queues[i]);
+        }
+
+        // The copies are timed, the empty compute pass isn't
+        CHECK(scopes[2].endNs > scopes[2].beginNs);
+        CHECK(scopes[3].endNs == scopes[3].beginNs);
+        CHECK(scopes[1].endNs == scopes[3].endNs);
+        CHECK(scopes[4].endNs == scopes[4].beginNs);
+
+        // Each frame is returned once
+        CHECK(profiler->CollectFrames().empty());
+
+        auto trace = ExportChromeTrace(frames);
+        CHECK(trace.find("\"Graphics queue\"") != std::string::npos);
+        CHECK(trace.find("\"Compute queue\"") != std::string::npos);
+        for(auto* name : names) {
+            CHECK(trace.find("\"name\":\"" + std::string(name) + "\"") != std::string::npos);
+        }
+    }
+
+    void TestDisableMidFrame() {
+        auto dev = MakeNullDevice();
+        auto* profiler = dev->GetGpuProfiler();
+        profiler->SetEnabled(true);
+
+        auto* q = dev->GetCopyCommandQueue();
+        auto cmd = q->CreateCommandList();
+        cmd->Begin();
+        cmd->PushDebugGroup("Recorded while enabled", {});
+        cmd->PopDebugGroup();
+        cmd->End();
+
+        // Affects lists begun afterwards only
+        profiler->SetEnabled(false);
+        q->SubmitCommand(cmd.get());
+
+        cmd->Begin();
+        cmd->PushDebugGroup("Recorded while disabled", {});
+        cmd->PopDebugGroup();
+        cmd->End();
+        q->SubmitCommand(cmd.get());
+        profiler->EndFrame();
+
+        auto frames = profiler->CollectFrames();
+        CHECK(frames.size() == 1);
+        CHECK(frames[0].scopes.size() == 1);
+        CHECK(frames[0].scopes[0].name == "Recorded while enabled");
+        CHECK(frames[0].scopes[0].queue == 1);
+    }
+
+}
+
+int main() {
+    TestDisabled();
+    TestScopes();
+    TestDisableMidFrame();
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "alloy/common/Waitable.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace alloy::common;
+using namespace std::chrono_literals;
+
+// Run under -fsanitize=address or thread for the destroy-after-Wait cases
+#define CHECK(x) \
+    do { \
+        if(!(x)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+            std::abort(); \
+        } \
+    } while(0)
+
+namespace
+{
+    constexpr int kRounds = 20000;
+
+    // The waiter frees the latch as soon as Wait() returns, while the
+    // signaling thread may still be inside Signal()/LaunchComplete().
+    template<typename Latch, typename SignalFn, typename WaitFn>
+    void DestroyAfterWait(SignalFn signal, WaitFn wait) {
+        for(int i = 0; i < kRounds; i++) {
+            auto latch = std::make_unique<Latch>();
+            std::thread signaler([&signal, l = latch.get()]() { signal(*l); });
+            wait(*latch);
+            latch.reset();
+            signaler.join();
+        }
+    }
+
+    void TestDestroyAfterWait() {
+        DestroyAfterWait<ManualResetLatch>(
+            [](ManualResetLatch& l) { l.Signal(); },
+            [](ManualResetLatch& l) { l.Wait(); });
+        DestroyAfterWait<AutoResetLatch>(
+            [](AutoResetLatch& l) { l.Signal(); },
+            [](AutoResetLatch& l) { l.Wait(); });
+        DestroyAfterWait<CountingSemaphore>(
+            [](CountingSemaphore& s) { s.Release(); },
+            [](CountingSemaphore& s) { s.Acquire(); });
+
+        // These need their count set before the signaler runs
+        for(int i = 0; i < kRounds; i++) {
+            auto latch = std::make_unique<MultiObjectLatch>();
+            latch->AddLaunch();
+            std::thread signaler([l = latch.get()]() { l->LaunchComplete(); });
+            CHECK(!latch->WaitUntilTimeout(10s));
+            latch.reset();
+            signaler.join();
+        }
+        for(int i = 0; i < kRounds; i++) {
+            auto latch = std::make_unique<CountdownLatch>(1);
+            std::thread signaler([l = latch.get()]() { l->CountDown(); });
+            latch->Wait();
+            latch.reset();
+            signaler.join();
+        }
+    }
+
+    void TestTimeouts() {
+        AutoResetLatch autoReset;
+        CHECK(autoReset.WaitWithTimeout(1ms));
+        autoReset.Signal();
+        CHECK(!autoReset.WaitWithTimeout(1ms));
+        CHECK(!autoReset.IsSignaledForTest());
+
+        ManualResetLatch manualReset;
+        CHECK(manualReset.WaitWithTimeout(1ms));
+        manualReset.Signal();
+        CHECK(!manualReset.WaitWithTimeout(1ms));
+        manualReset.Wait();
+        manualReset.Reset();
+        CHECK(manualReset.WaitWithTimeout(1ms));
+
+        MultiObjectLatch multi;
+        CHECK(!multi.WaitUntilTimeout(1ms));
+        multi.AddLaunch(2);
+        CHECK(multi.WaitUntilTimeout(1ms));
+        multi.LaunchComplete(5);
+        CHECK(multi.QueryLaunchCnt() == 0);
+
+        CountingSemaphore sem(1);
+        CHECK(sem.TryAcquire());
+        CHECK(sem.AcquireWithTimeout(1ms));
+        sem.Release(2);
+        sem.Acquire();
+        CHECK(!sem.AcquireWithTimeout(1ms));
+        CHECK(!sem.TryAcquire());
+
+        CountdownLatch countdown(2);
+        CHECK(countdown.WaitWithTimeout(1ms));
+        countdown.CountDown();
+        countdown.CountDownAndWait();
+        CHECK(countdown.TryWait());
+    }
+
+    // Fork/join rounds the way the job system drives them
+    void TestForkJoin() {
+        constexpr int workerCnt = 8;
+        CountingSemaphore start;
+        MultiObjectLatch done;
+        std::atomic<bool> stop{false};
+        std::atomic<int> jobs{0};
+
+        std::vector<std::thread> workers;
+        for(int i = 0; i < workerCnt; i++) {
+            workers.emplace_back([&]() {
+                for(;;) {
+                    start.Acquire();
+                    if(stop.load()) return;
+                    jobs++;
+                    done.LaunchComplete();
+                }
+            });
+        }
+        for(int round = 0; round < 2000; round++) {
+            done.AddLaunch(workerCnt);
+            start.Release(workerCnt);
+            done.Wait();
+            CHECK(done.QueryLaunchCnt() == 0);
+        }
+        stop = true;
+        start.Release(workerCnt);
+        for(auto& t : workers) t.join();
+        CHECK(jobs == 2000 * workerCnt);
+    }
+
+}
+
+int main() {
+    TestTimeouts();
+    TestDestroyAfterWait();
+    TestForkJoin();
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "alloy/alloy.hpp"
+#include "alloy/GpuProfiler.hpp"
+#include "alloy/layers/Capture/ICaptureReplayer.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Replays a capture written by ICaptureDevice and reports CPU cost per
+// frame and per pass, plus GPU time per pass when the backend supports
+// timestamps.
+//
+//   alloy_replay [--backend=null|vulkan|dx12|metal] [--trace=out.json] capture.acap
+namespace {
+
+    void _PrintUsage() {
+        std::fprintf(stderr,
+            "usage: alloy_replay [--backend=null|vulkan|dx12|metal] [--trace=out.json] <capture>\n");
+    }
+
+    double _Ms(std::uint64_t ns) { return (double)ns / 1e6; }
+
+    void _PrintGpuFrames(std::span<const alloy::IGpuProfiler::Frame> frames) {
+        for(auto& frame : frames) {
+            std::printf("frame %llu gpu:\n", (unsigned long long)frame.frameIdx);
+            for(auto& scope : frame.scopes) {
+                std::printf("  %*s%-32s %8.3f ms\n",
+                    (int)scope.depth * 2, "", scope.name.c_str(),
+                    _Ms(scope.endNs - scope.beginNs));
+            }
+        }
+    }
+
+}
+
+int main(int argc, char** argv) {
+    alloy::Backend backend = alloy::Backend::Null;
+    std::string tracePath, capturePath;
+
+    for(int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if(arg.starts_with("--backend=")) {
+            auto name = arg.substr(std::string_view("--backend=").size());
+            if(name == "null") backend = alloy::Backend::Null;
+            else if(name == "vulkan") backend = alloy::Backend::Vulkan;
+            else if(name == "dx12") backend = alloy::Backend::DX12;
+            else if(name == "metal") backend = alloy::Backend::Metal;
+            else {
+                std::fprintf(stderr, "alloy_replay: unknown backend '%.*s'\n",
+                    (int)name.size(), name.data());
+                return 1;
+            }
+        } else if(arg.starts_with("--trace=")) {
+            tracePath = arg.substr(std::string_view("--trace=").size());
+        } else if(!arg.starts_with("--") && capturePath.empty()) {
+            capturePath = arg;
+        } else {
+            _PrintUsage();
+            return 1;
+        }
+    }
+    if(capturePath.empty()) {
+        _PrintUsage();
+        return 1;
+    }
+
+    auto ctx = alloy::IContext::Create(backend);
+    if(!ctx) {
+        std::fprintf(stderr, "alloy_replay: backend not available in this build\n");
+        return 1;
+    }
+    alloy::IGraphicsDevice::Options opts{};
+    auto dev = ctx->CreateDefaultDevice(opts);
+    if(!dev) {
+        std::fprintf(stderr, "alloy_replay: failed to create a device\n");
+        return 1;
+    }
+
+    auto* profiler = dev->GetGpuProfiler();
+    if(profiler) profiler->SetEnabled(true);
+
+    auto replayer = alloy::ICaptureReplayer::Make(dev, capturePath);
+    if(!replayer) {
+        std::fprintf(stderr, "alloy_replay: %s is not a readable capture\n", capturePath.c_str());
+        return 1;
+    }
+
+    std::vector<alloy::IGpuProfiler::Frame> gpuFrames;
+    std::uint64_t totalWallNs = 0, totalRecordNs = 0, frameCount = 0;
+
+    alloy::ICaptureReplayer::FrameStats stats;
+    while(replayer->ReplayFrame(stats)) {
+        std::printf("frame %llu: wall %.3f ms, record %.3f ms, %u submits, %u draws, %u dispatches\n",
+            (unsigned long long)stats.frameIdx, _Ms(stats.wallNs), _Ms(stats.recordNs),
+            stats.submits, stats.draws, stats.dispatches);
+        for(auto& pass : stats.passes)
+            std::printf("  %-34s %8.3f ms cpu\n", pass.name.c_str(), _Ms(pass.recordNs));
+
+        totalWallNs += stats.wallNs;
+        totalRecordNs += stats.recordNs;
+        frameCount++;
+
+        if(profiler) {
+            auto frames = profiler->CollectFrames();
+            _PrintGpuFrames(frames);
+            gpuFrames.insert(gpuFrames.end(), frames.begin(), frames.end());
+        }
+    }
+
+    if(!replayer->GetError().empty()) {
+        std::fprintf(stderr, "alloy_replay: replay stopped: %s\n", replayer->GetError().c_str());
+    }
+
+    dev->WaitForIdle();
+    if(profiler) {
+        auto frames = profiler->CollectFrames();
+        _PrintGpuFrames(frames);
+        gpuFrames.insert(gpuFrames.end(), frames.begin(), frames.end());
+    }
+
+    if(frameCount) {
+        std::printf("%llu frames, avg wall %.3f ms, avg record %.3f ms\n",
+            (unsigned long long)frameCount,
+            _Ms(totalWallNs / frameCount), _Ms(totalRecordNs / frameCount));
+    }
+
+    if(!tracePath.empty()) {
+        if(!profiler) {
+            std::fprintf(stderr, "alloy_replay: no GPU profiler on this backend, no trace written\n");
+        } else {
+            std::ofstream out(tracePath, std::ios::binary);
+            out << alloy::ExportChromeTrace(gpuFrames);
+        }
+    }
+
+    return replayer->GetError().empty() ? 0 : 1;
+}